@@ -0,0 +1,700 @@
+/*!
+ * \file        sccp_callgen.c
+ * \brief       SCCP Call Generator (scripted call flow load test)
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Registers a pool of simulated phones (see sim_phone_handle) and then drives scripted call flows (basic call, hold/resume, transfer,
+ * conference) between them at a configurable number of calls per second. Every call takes two or three idle phones from the pool and
+ * walks through the steps of the scenario. Each "wait" step measures the time between the preceding action (offhook, digits, softkey,
+ * onhook) and the CallState it expects, which gives the setup latency and the round trip of every stage of the call.
+ * OpenReceiveChannel is acknowledged with a local dummy rtp port, the rtp stream itself is never read.
+ *
+ * Build: cc -O2 -Wall -o sccp_callgen sccp_callgen.c
+ */
+#include "sccp_sim.h"
+#include <getopt.h>
+#include <signal.h>
+#include <arpa/inet.h>
+
+#define CALLGEN_MAX_ROLES 3
+#define CALLGEN_COOLDOWN 200000											/* us a phone stays out of the pool after a call, lets late messages settle */
+
+enum { A, B, C };												/* roles */
+
+typedef enum {
+	STEP_OFFHOOK,												/*!< OffHookMessage on the first line */
+	STEP_ONHOOK,												/*!< OnHookMessage, skipped when the phone is already onhook */
+	STEP_DIAL,												/*!< KeypadButton per digit of the extension of role 'arg' (+ end of dialing char) */
+	STEP_SOFTKEY,												/*!< SoftKeyEventMessage 'arg' on the current call */
+	STEP_WAIT,												/*!< wait for CallState 'arg' (received after the last action) */
+	STEP_WAIT_IDLE,												/*!< wait until all phones of the call are onhook */
+	STEP_TALK,												/*!< pause for the talk time */
+	STEP_END,
+} callgen_action_t;
+
+typedef struct {
+	callgen_action_t action;
+	int role;
+	uint32_t arg;
+	const char *label;											/*!< name of the latency sample (wait steps) */
+} callgen_step_t;
+
+typedef struct {
+	const char *name;
+	const char *description;
+	unsigned int roles;
+	const callgen_step_t *steps;
+} callgen_scenario_t;
+
+#define CALLGEN_CONNECT_AB \
+	{STEP_OFFHOOK, A, 0, NULL}, \
+	{STEP_WAIT, A, SIM_CALLSTATE_OFFHOOK, "A offhook -> dialtone"}, \
+	{STEP_DIAL, A, B, NULL}, \
+	{STEP_WAIT, B, SIM_CALLSTATE_RINGIN, "A dialed -> B ringing"}, \
+	{STEP_OFFHOOK, B, 0, NULL}, \
+	{STEP_WAIT, A, SIM_CALLSTATE_CONNECTED, "B answer -> A connected"}
+
+static const callgen_step_t basic_steps[] = {
+	CALLGEN_CONNECT_AB,
+	{STEP_TALK, A, 0, NULL},
+	{STEP_ONHOOK, A, 0, NULL},
+	{STEP_WAIT, B, SIM_CALLSTATE_ONHOOK, "A hangup -> B released"},
+	{STEP_END, A, 0, NULL},
+};
+
+static const callgen_step_t hold_steps[] = {
+	CALLGEN_CONNECT_AB,
+	{STEP_TALK, A, 0, NULL},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_HOLD, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_HOLD, "A hold -> held"},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_RESUME, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_CONNECTED, "A resume -> connected"},
+	{STEP_TALK, A, 0, NULL},
+	{STEP_ONHOOK, A, 0, NULL},
+	{STEP_WAIT, B, SIM_CALLSTATE_ONHOOK, "A hangup -> B released"},
+	{STEP_END, A, 0, NULL},
+};
+
+static const callgen_step_t transfer_steps[] = {
+	CALLGEN_CONNECT_AB,
+	{STEP_TALK, A, 0, NULL},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_TRANSFER, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_OFFHOOK, "A transfer -> dialtone"},
+	{STEP_DIAL, A, C, NULL},
+	{STEP_WAIT, C, SIM_CALLSTATE_RINGIN, "A dialed -> C ringing"},
+	{STEP_OFFHOOK, C, 0, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_CONNECTED, "C answer -> A connected"},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_TRANSFER, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_ONHOOK, "A transfer -> A released"},
+	{STEP_TALK, B, 0, NULL},
+	{STEP_ONHOOK, C, 0, NULL},
+	{STEP_WAIT, B, SIM_CALLSTATE_ONHOOK, "C hangup -> B released"},
+	{STEP_END, A, 0, NULL},
+};
+
+static const callgen_step_t conference_steps[] = {
+	CALLGEN_CONNECT_AB,
+	{STEP_TALK, A, 0, NULL},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_CONFRN, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_OFFHOOK, "A conference -> dialtone"},
+	{STEP_DIAL, A, C, NULL},
+	{STEP_WAIT, C, SIM_CALLSTATE_RINGIN, "A dialed -> C ringing"},
+	{STEP_OFFHOOK, C, 0, NULL},
+	{STEP_WAIT, A, SIM_CALLSTATE_CONNECTED, "C answer -> A connected"},
+	{STEP_SOFTKEY, A, SIM_SOFTKEY_CONFRN, NULL},
+	{STEP_WAIT, C, SIM_CALLSTATE_CONNECTED, "A join -> C conferenced"},
+	{STEP_TALK, A, 0, NULL},
+	{STEP_ONHOOK, C, 0, NULL},
+	{STEP_ONHOOK, B, 0, NULL},
+	{STEP_ONHOOK, A, 0, NULL},
+	{STEP_WAIT_IDLE, A, 0, "hangup -> all released"},
+	{STEP_END, A, 0, NULL},
+};
+
+static const callgen_scenario_t scenarios[] = {
+	{"basic", "A calls B, B answers, A hangs up", 2, basic_steps},
+	{"hold", "basic call, A puts B on hold and resumes", 2, hold_steps},
+	{"transfer", "A calls B, consults C and transfers B to C", 3, transfer_steps},
+	{"conference", "A calls B, adds C to an ad-hoc conference", 3, conference_steps},
+};
+
+/*!
+ * \brief Phone in the call pool
+ */
+typedef struct {
+	sim_phone_t phone;
+	int in_call;
+	uint64_t available_at;											/*!< end of the cooldown after the last call */
+	int rtp_sock;												/*!< dummy rtp socket announced in OpenReceiveChannelAck */
+	uint32_t rtp_addr;											/*!< network order */
+	uint16_t rtp_port;
+	uint32_t callref;											/*!< call reference of the current call (from CallState) */
+	uint32_t callstate;											/*!< last CallState received */
+	uint64_t callstate_at[SIM_CALLSTATE_MAX];								/*!< time the CallState was last received */
+} callgen_phone_t;
+
+typedef struct {
+	int active;
+	unsigned int phones[CALLGEN_MAX_ROLES];
+	unsigned int step;
+	uint64_t started;
+	uint64_t action_at;											/*!< time of the last action, waits are relative to this */
+	uint64_t talk_until;
+} callgen_call_t;
+
+typedef struct {
+	sim_samples_t latency;
+	unsigned int timeouts;
+} callgen_stepstats_t;
+
+static volatile int stop = 0;
+
+static struct {
+	const callgen_scenario_t *scenario;
+	callgen_phone_t *phones;
+	unsigned int num_phones;
+	unsigned int next_phone;
+	callgen_stepstats_t *stepstats;
+	uint64_t talktime;
+	uint64_t timeout;
+	char endchar;
+	unsigned int orc_acked;
+	unsigned int media_started;
+	unsigned int no_extension;
+	sim_samples_t call_duration;
+} callgen;
+
+static void callgen_signal(int sig)
+{
+	(void) sig;
+	stop = 1;
+}
+
+/*!
+ * \brief Bind the dummy rtp socket to the local address of the skinny connection
+ */
+static void callgen_open_rtp(callgen_phone_t * cp)
+{
+	struct sockaddr_in sin = { 0 };
+	socklen_t sinlen = sizeof(sin);
+
+	if (getsockname(cp->phone.sock, (struct sockaddr *) &sin, &sinlen) < 0 || sin.sin_family != AF_INET) {
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	}
+	sin.sin_port = 0;
+	cp->rtp_addr = sin.sin_addr.s_addr;
+	if ((cp->rtp_sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0 || bind(cp->rtp_sock, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+		perror("rtp socket");
+		exit(2);
+	}
+	sinlen = sizeof(sin);
+	getsockname(cp->rtp_sock, (struct sockaddr *) &sin, &sinlen);
+	cp->rtp_port = ntohs(sin.sin_port);
+}
+
+/*!
+ * \brief Acknowledge an OpenReceiveChannel (v3 layout below protocol 17, v17 layout from 17 on; see sccp_protocol_parseOpenReceiveChannelAck*)
+ */
+static void callgen_open_receive_channel_ack(callgen_phone_t * cp, const unsigned char *payload, size_t len)
+{
+	unsigned char ack[36] = { 0 };
+	uint32_t passthrupartyid = 0, callref = 0, word = 0;
+	size_t acklen = 0;
+
+	if (len >= 8) {
+		memcpy(&passthrupartyid, payload + 4, 4);							/* already little endian, echoed back as is */
+	}
+	if (len >= 28) {
+		memcpy(&callref, payload + 24, 4);
+	}
+	if (cp->phone.protocol < 17) {
+		memcpy(ack + 4, &cp->rtp_addr, 4);								/* bel_ipAddr */
+		word = htole32(cp->rtp_port);
+		memcpy(ack + 8, &word, 4);
+		memcpy(ack + 12, &passthrupartyid, 4);
+		memcpy(ack + 16, &callref, 4);
+		acklen = 20;
+	} else {
+		memcpy(ack + 8, &cp->rtp_addr, 4);								/* lel_ipv46 = 0, bel_ipAddr[16] */
+		word = htole32(cp->rtp_port);
+		memcpy(ack + 24, &word, 4);
+		memcpy(ack + 28, &passthrupartyid, 4);
+		memcpy(ack + 32, &callref, 4);
+		acklen = 36;
+	}
+	sim_phone_send(&cp->phone, SIM_OpenReceiveChannelAck, ack, acklen);
+	callgen.orc_acked++;
+}
+
+/*!
+ * \brief Handle the call related messages sim_phone_handle leaves to the tool
+ */
+static void callgen_handle(callgen_phone_t * cp, uint32_t mid, const unsigned char *payload, size_t len)
+{
+	uint32_t state = 0, callref = 0;
+
+	switch (mid) {
+		case SIM_CallStateMessage:
+			if (len < 12) {
+				break;
+			}
+			memcpy(&state, payload, 4);
+			memcpy(&callref, payload + 8, 4);
+			state = le32toh(state);
+			callref = le32toh(callref);
+			if (state < SIM_CALLSTATE_MAX) {
+				cp->callstate_at[state] = sim_now_us();
+			}
+			cp->callstate = state;
+			if (state != SIM_CALLSTATE_ONHOOK && state != SIM_CALLSTATE_HOLD) {
+				cp->callref = callref;
+			}
+			break;
+		case SIM_OpenReceiveChannel:
+			callgen_open_receive_channel_ack(cp, payload, len);
+			break;
+		case SIM_StartMediaTransmission:
+			callgen.media_started++;
+			break;
+		default:
+			break;
+	}
+}
+
+static void callgen_send_stimulus(callgen_phone_t * cp, uint32_t mid, uint32_t first, int with_line)
+{
+	uint32_t words[3] = { 0 };
+	size_t n = 0;
+
+	if (with_line) {
+		words[n++] = htole32(first);
+	}
+	words[n++] = htole32(cp->phone.lines[0]);
+	words[n++] = htole32(cp->callref);
+	sim_phone_send(&cp->phone, mid, words, n * sizeof(uint32_t));
+}
+
+static int callgen_dial(callgen_phone_t * cp, const char *extension)
+{
+	const char *digit = NULL;
+	uint32_t button = 0;
+
+	for (digit = extension; *digit; digit++) {
+		if (*digit >= '0' && *digit <= '9') {
+			button = *digit - '0';
+		} else if (*digit == '*') {
+			button = SIM_KEYPAD_STAR;
+		} else if (*digit == '#') {
+			button = SIM_KEYPAD_POUND;
+		} else {
+			continue;
+		}
+		callgen_send_stimulus(cp, SIM_KeypadButtonMessage, button, 1);
+	}
+	return 0;
+}
+
+/*!
+ * \brief Take idle phones from the pool for a new call
+ * \return 0 when not enough phones are available
+ */
+static int callgen_allocate(callgen_call_t * call, uint64_t now)
+{
+	unsigned int found = 0, tried = 0;
+
+	for (tried = 0; tried < callgen.num_phones && found < callgen.scenario->roles; tried++) {
+		unsigned int idx = callgen.next_phone;
+		callgen_phone_t *cp = &callgen.phones[idx];
+
+		callgen.next_phone = (callgen.next_phone + 1) % callgen.num_phones;
+		if (cp->phone.state == SIM_PHONE_REGISTERED && !cp->in_call && now >= cp->available_at && cp->phone.num_lines && cp->phone.extension[0]) {
+			call->phones[found++] = idx;
+		}
+	}
+	if (found < callgen.scenario->roles) {
+		return 0;
+	}
+	for (found = 0; found < callgen.scenario->roles; found++) {
+		callgen_phone_t *cp = &callgen.phones[call->phones[found]];
+
+		cp->in_call = 1;
+		cp->callref = 0;
+	}
+	call->active = 1;
+	call->step = 0;
+	call->started = call->action_at = now;
+	call->talk_until = 0;
+	return 1;
+}
+
+static void callgen_release(callgen_call_t * call, uint64_t now, int failed)
+{
+	unsigned int role = 0;
+
+	for (role = 0; role < callgen.scenario->roles; role++) {
+		callgen_phone_t *cp = &callgen.phones[call->phones[role]];
+
+		if (failed && cp->callstate != SIM_CALLSTATE_ONHOOK && cp->phone.sock >= 0) {
+			callgen_send_stimulus(cp, SIM_OnHookMessage, 0, 0);
+		}
+		cp->in_call = 0;
+		cp->available_at = now + (failed ? 10 : 1) * CALLGEN_COOLDOWN;
+	}
+	call->active = 0;
+}
+
+static int callgen_idle(callgen_call_t * call)
+{
+	unsigned int role = 0;
+
+	for (role = 0; role < callgen.scenario->roles; role++) {
+		if (callgen.phones[call->phones[role]].callstate != SIM_CALLSTATE_ONHOOK) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*!
+ * \brief Run the steps of a call until it has to wait for the switch
+ * \return -1 when the call failed, 1 when it completed, 0 while it is still running
+ */
+static int callgen_advance(callgen_call_t * call, uint64_t now)
+{
+	while (call->active) {
+		const callgen_step_t *step = &callgen.scenario->steps[call->step];
+		callgen_phone_t *cp = &callgen.phones[call->phones[step->role]];
+
+		switch (step->action) {
+			case STEP_OFFHOOK:
+				cp->callref = 0;
+				callgen_send_stimulus(cp, SIM_OffHookMessage, 0, 0);
+				call->action_at = now;
+				break;
+			case STEP_ONHOOK:
+				if (cp->callstate != SIM_CALLSTATE_ONHOOK) {
+					callgen_send_stimulus(cp, SIM_OnHookMessage, 0, 0);
+				}
+				call->action_at = now;
+				break;
+			case STEP_DIAL:
+				{
+					char number[SIM_MAX_DIRNUM + 2] = "";
+
+					snprintf(number, sizeof(number), "%s%c", callgen.phones[call->phones[step->arg]].phone.extension, callgen.endchar);
+					callgen_dial(cp, number);
+					call->action_at = now;
+				}
+				break;
+			case STEP_SOFTKEY:
+				callgen_send_stimulus(cp, SIM_SoftKeyEventMessage, step->arg, 1);
+				call->action_at = now;
+				break;
+			case STEP_WAIT:
+			case STEP_WAIT_IDLE:
+				if (step->action == STEP_WAIT ? cp->callstate_at[step->arg] >= call->action_at : callgen_idle(call)) {
+					sim_samples_add(&callgen.stepstats[call->step].latency, (step->action == STEP_WAIT ? cp->callstate_at[step->arg] : now) - call->action_at);
+					break;
+				}
+				if (now - call->action_at > callgen.timeout) {
+					callgen.stepstats[call->step].timeouts++;
+					callgen_release(call, now, 1);
+					return -1;
+				}
+				return 0;
+			case STEP_TALK:
+				if (!call->talk_until) {
+					call->talk_until = now + callgen.talktime;
+				}
+				if (now < call->talk_until) {
+					return 0;
+				}
+				call->talk_until = 0;
+				break;
+			case STEP_END:
+				sim_samples_add(&callgen.call_duration, now - call->started);
+				callgen_release(call, now, 0);
+				return 1;
+		}
+		call->step++;
+	}
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	unsigned int i = 0;
+
+	fprintf(stderr, "Usage: %s [-n phones] [-f first] [-p prefix] [-s scenario] [-c calls] [-r cps] [-t talktime] [-w timeout] [-P protocol] [-E char] [host[:port]]\n"
+		"  -n phones      number of phones in the pool (default 20)\n"
+		"  -f first       number of the first phone (default 1)\n"
+		"  -p prefix      device name prefix, the number is appended in hex up to 15 characters (default SEP0000)\n"
+		"  -s scenario    call flow to run (default basic)\n"
+		"  -c calls       number of calls to start (default 100)\n"
+		"  -r cps         calls started per second (default 1)\n"
+		"  -t talktime    milliseconds to stay connected (default 1000)\n"
+		"  -w timeout     seconds to wait for the expected CallState before a call counts as failed (default 5)\n"
+		"  -P protocol    skinny protocol version announced in the RegisterMessage (default 11)\n"
+		"  -E char        end of dialing character appended to the number, '-' for none (default #)\n"
+		"  host:port      chan_sccp to test (default 127.0.0.1:2000)\n"
+		"Scenarios:\n", name);
+	for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		fprintf(stderr, "  %-14s %s\n", scenarios[i].name, scenarios[i].description);
+	}
+}
+
+/*!
+ * \brief Receive and dispatch the messages of all phones (poll for at most timeout_ms)
+ */
+static int callgen_poll(struct pollfd *pfds, int timeout_ms, unsigned int *lost)
+{
+	unsigned char payload[SIM_MAX_PACKET];
+	unsigned int i = 0;
+
+	for (i = 0; i < callgen.num_phones; i++) {
+		pfds[i].fd = callgen.phones[i].phone.sock;
+		pfds[i].events = POLLIN;
+		pfds[i].revents = 0;
+	}
+	if (poll(pfds, callgen.num_phones, timeout_ms) < 0 && errno != EINTR) {
+		perror("poll");
+		return -1;
+	}
+	for (i = 0; i < callgen.num_phones; i++) {
+		callgen_phone_t *cp = &callgen.phones[i];
+		uint32_t mid = 0;
+		size_t len = sizeof(payload);
+		int res = 0;
+
+		if (!pfds[i].revents || cp->phone.sock < 0) {
+			continue;
+		}
+		if ((res = sim_recv(cp->phone.sock, &cp->phone.rb)) >= 0) {
+			while ((res = sim_next_message(&cp->phone.rb, &mid, payload, &len)) > 0) {
+				if (sim_phone_handle(&cp->phone, mid, payload, len) == SIM_PHONE_EVENT_UNHANDLED) {
+					callgen_handle(cp, mid, payload, len);
+				}
+				len = sizeof(payload);
+			}
+		}
+		if (res < 0 || cp->phone.state == SIM_PHONE_FAILED) {
+			fprintf(stderr, "%s: connection lost\n", cp->phone.name);
+			cp->phone.state = SIM_PHONE_FAILED;
+			sim_phone_close(&cp->phone);
+			(*lost)++;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt = 0;
+	unsigned int first = 1;
+	const char *prefix = "SEP0000";
+	const char *scenario = "basic";
+	unsigned int num_calls = 100;
+	double cps = 1;
+	unsigned int timeout = 5;
+	uint32_t protocol = 11;
+	char *hostport = strdup("127.0.0.1:2000");
+	const char *host = NULL;
+	const char *port = NULL;
+
+	struct pollfd *pfds = NULL;
+	callgen_call_t *calls = NULL;
+	unsigned int max_calls = 0;
+	unsigned int registered = 0, lost = 0, started = 0, completed = 0, failed = 0, blocked = 0, running = 0;
+	uint64_t start = 0, now = 0, last_report = 0, deadline = 0;
+	unsigned int i = 0, j = 0, num_steps = 0;
+	uint32_t messages_in = 0, messages_out = 0;
+
+	callgen.num_phones = 20;
+	callgen.talktime = 1000000;
+	callgen.endchar = '#';
+	while ((opt = getopt(argc, argv, "n:f:p:s:c:r:t:w:P:E:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				callgen.num_phones = atoi(optarg);
+				break;
+			case 'f':
+				first = atoi(optarg);
+				break;
+			case 'p':
+				prefix = optarg;
+				break;
+			case 's':
+				scenario = optarg;
+				break;
+			case 'c':
+				num_calls = atoi(optarg);
+				break;
+			case 'r':
+				cps = atof(optarg);
+				break;
+			case 't':
+				callgen.talktime = (uint64_t) atoi(optarg) * 1000;
+				break;
+			case 'w':
+				timeout = atoi(optarg);
+				break;
+			case 'P':
+				protocol = atoi(optarg);
+				break;
+			case 'E':
+				callgen.endchar = (optarg[0] == '-') ? '\0' : optarg[0];
+				break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if (optind < argc) {
+		free(hostport);
+		hostport = strdup(argv[optind]);
+	}
+	for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		if (!strcasecmp(scenario, scenarios[i].name)) {
+			callgen.scenario = &scenarios[i];
+		}
+	}
+	if (!callgen.scenario || callgen.num_phones < callgen.scenario->roles || cps <= 0 || strlen(prefix) >= 15) {
+		usage(argv[0]);
+		return 2;
+	}
+	for (num_steps = 0; callgen.scenario->steps[num_steps].action != STEP_END; num_steps++);
+	callgen.timeout = (uint64_t) timeout * 1000000ULL;
+	max_calls = callgen.num_phones / callgen.scenario->roles;
+	sim_split_hostport(hostport, &host, &port);
+	if (!(callgen.phones = calloc(callgen.num_phones, sizeof(callgen_phone_t))) || !(pfds = calloc(callgen.num_phones, sizeof(struct pollfd)))
+	    || !(calls = calloc(max_calls, sizeof(callgen_call_t))) || !(callgen.stepstats = calloc(num_steps, sizeof(callgen_stepstats_t)))) {
+		fprintf(stderr, "Out of memory\n");
+		return 2;
+	}
+	signal(SIGINT, callgen_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* register the pool */
+	printf("Registering %u phones against %s:%s\n", callgen.num_phones, host, port);
+	for (i = 0; i < callgen.num_phones; i++) {
+		callgen_phone_t *cp = &callgen.phones[i];
+
+		snprintf(cp->phone.name, sizeof(cp->phone.name), "%s%0*X", prefix, (int) (15 - strlen(prefix)), first + i);
+		cp->phone.protocol = protocol;
+		cp->phone.devicetype = SIM_DEVICETYPE_CISCO7960;
+		cp->callstate = SIM_CALLSTATE_ONHOOK;
+		cp->rtp_sock = -1;
+		if (sim_phone_register(&cp->phone, host, port) < 0) {
+			fprintf(stderr, "%s: could not connect\n", cp->phone.name);
+			continue;
+		}
+		callgen_open_rtp(cp);
+	}
+	deadline = sim_now_us() + 10000000ULL;
+	while (!stop && sim_now_us() < deadline) {
+		for (i = 0; i < callgen.num_phones && callgen.phones[i].phone.state != SIM_PHONE_REGISTERING; i++);
+		if (i == callgen.num_phones) {
+			break;
+		}
+		if (callgen_poll(pfds, 10, &lost) < 0) {
+			return 2;
+		}
+	}
+	for (i = 0; i < callgen.num_phones; i++) {
+		if (callgen.phones[i].phone.state == SIM_PHONE_REGISTERED) {
+			registered++;
+			if (!callgen.phones[i].phone.extension[0]) {
+				callgen.no_extension++;
+			}
+		}
+	}
+	printf("Registered: %u of %u phones (%u without a line extension)\n", registered, callgen.num_phones, callgen.no_extension);
+	if (registered - callgen.no_extension < callgen.scenario->roles) {
+		fprintf(stderr, "Not enough registered phones with a line to run scenario '%s'\n", callgen.scenario->name);
+		return 2;
+	}
+
+	/* generate the calls */
+	printf("Running %u '%s' calls at %.2f cps (%u calls at most in parallel)\n", num_calls, callgen.scenario->name, cps, max_calls);
+	start = last_report = sim_now_us();
+	while (!stop) {
+		now = sim_now_us();
+
+		while (started + blocked < num_calls && (now - start) >= (uint64_t) ((started + blocked) * 1000000.0 / cps)) {
+			for (i = 0; i < max_calls && calls[i].active; i++);
+			if (i < max_calls && callgen_allocate(&calls[i], now)) {
+				started++;
+				running++;
+			} else {
+				blocked++;
+			}
+		}
+
+		for (i = 0; i < max_calls; i++) {
+			int res = 0;
+
+			if (!calls[i].active) {
+				continue;
+			}
+			if ((res = callgen_advance(&calls[i], now)) > 0) {
+				completed++;
+				running--;
+			} else if (res < 0) {
+				failed++;
+				running--;
+			}
+		}
+		for (i = 0; i < callgen.num_phones; i++) {
+			sim_phone_keepalive(&callgen.phones[i].phone, now, 0);
+		}
+
+		if (started + blocked >= num_calls && !running) {
+			break;
+		}
+		if (now - last_report >= 1000000) {
+			printf("[%5.1fs] started: %u, running: %u, completed: %u, failed: %u, blocked: %u\n", (now - start) / 1000000.0, started, running, completed, failed, blocked);
+			fflush(stdout);
+			last_report = now;
+		}
+		if (callgen_poll(pfds, 5, &lost) < 0) {
+			break;
+		}
+	}
+	now = sim_now_us();
+
+	for (i = 0; i < callgen.num_phones; i++) {
+		messages_in += callgen.phones[i].phone.messages_in;
+		messages_out += callgen.phones[i].phone.messages_out;
+		sim_phone_close(&callgen.phones[i].phone);
+		if (callgen.phones[i].rtp_sock >= 0) {
+			close(callgen.phones[i].rtp_sock);
+		}
+	}
+
+	printf("\nScenario: %s, calls: %u, completed: %u, failed: %u, blocked (no idle phones): %u, connections lost: %u\n", callgen.scenario->name, num_calls, completed, failed, blocked, lost);
+	if (now > start) {
+		printf("Elapsed: %.1f s, completed: %.2f cps, messages in: %u, out: %u (incl. registration)\n", (now - start) / 1000000.0, completed * 1000000.0 / (double) (now - start), messages_in, messages_out);
+	}
+	printf("Media: %u OpenReceiveChannel acknowledged, %u StartMediaTransmission received\n", callgen.orc_acked, callgen.media_started);
+	for (j = 0; j < num_steps; j++) {
+		if (callgen.scenario->steps[j].label) {
+			sim_samples_print(&callgen.stepstats[j].latency, callgen.scenario->steps[j].label);
+			if (callgen.stepstats[j].timeouts) {
+				printf("  %u timed out\n", callgen.stepstats[j].timeouts);
+			}
+		}
+		sim_samples_free(&callgen.stepstats[j].latency);
+	}
+	sim_samples_print(&callgen.call_duration, "call duration");
+	sim_samples_free(&callgen.call_duration);
+
+	free(callgen.stepstats);
+	free(callgen.phones);
+	free(calls);
+	free(pfds);
+	free(hostport);
+	return (!failed && completed == num_calls) ? 0 : 1;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,255 @@
+/*!
+ * \file        sccp_fleet.c
+ * \brief       SCCP Phone Fleet Simulator (registration load test)
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Opens one connection per simulated phone, walks every phone through the registration sequence (see sim_phone_handle), keeps them
+ * registered with keepalives for a while and reports registration latency percentiles, keepalive round trips and failures.
+ *
+ * Build: cc -O2 -Wall -o sccp_fleet sccp_fleet.c
+ */
+#include "sccp_sim.h"
+#include <getopt.h>
+#include <signal.h>
+
+static volatile int stop = 0;
+
+static void fleet_signal(int sig)
+{
+	(void) sig;
+	stop = 1;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n phones] [-f first] [-p prefix] [-r rate] [-d duration] [-k keepalive] [-P protocol] [-T devicetype] [-w timeout] [-u] [host[:port]]\n"
+		"  -n phones      number of phones to simulate (default 10)\n"
+		"  -f first       number of the first phone (default 1)\n"
+		"  -p prefix      device name prefix, the number is appended in hex up to 15 characters (default SEP0000)\n"
+		"  -r rate        registrations started per second (default 0: all at once)\n"
+		"  -d duration    seconds to stay registered sending keepalives after the last phone registered (default 30)\n"
+		"  -k keepalive   keepalive interval in seconds (default: as requested in RegisterAck)\n"
+		"  -P protocol    skinny protocol version announced in the RegisterMessage (default 11)\n"
+		"  -T devicetype  skinny device type (default 7: Cisco 7960)\n"
+		"  -w timeout     seconds a registration may take before it counts as failed (default 10)\n"
+		"  -u             unregister the phones at the end\n"
+		"  host:port      chan_sccp to test (default 127.0.0.1:2000)\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt = 0;
+	unsigned int num_phones = 10;
+	unsigned int first = 1;
+	const char *prefix = "SEP0000";
+	double rate = 0;
+	unsigned int duration = 30;
+	uint32_t keepalive = 0;
+	uint32_t protocol = 11;
+	uint32_t devicetype = SIM_DEVICETYPE_CISCO7960;
+	unsigned int timeout = 10;
+	int unregister = 0;
+	char *hostport = strdup("127.0.0.1:2000");
+	const char *host = NULL;
+	const char *port = NULL;
+
+	sim_phone_t *phones = NULL;
+	struct pollfd *pfds = NULL;
+	sim_samples_t reg_latency = { 0 }, ack_latency = { 0 }, keepalive_rtt = { 0 };
+	unsigned int started = 0, registered = 0, rejected = 0, timedout = 0, closed = 0, connect_failed = 0, keepalives = 0;
+	uint64_t start = 0, now = 0, last_report = 0, last_registered = 0, done_at = 0;
+	unsigned char payload[SIM_MAX_PACKET];
+	unsigned int i = 0;
+
+	while ((opt = getopt(argc, argv, "n:f:p:r:d:k:P:T:w:uh")) != -1) {
+		switch (opt) {
+			case 'n':
+				num_phones = atoi(optarg);
+				break;
+			case 'f':
+				first = atoi(optarg);
+				break;
+			case 'p':
+				prefix = optarg;
+				break;
+			case 'r':
+				rate = atof(optarg);
+				break;
+			case 'd':
+				duration = atoi(optarg);
+				break;
+			case 'k':
+				keepalive = atoi(optarg);
+				break;
+			case 'P':
+				protocol = atoi(optarg);
+				break;
+			case 'T':
+				devicetype = atoi(optarg);
+				break;
+			case 'w':
+				timeout = atoi(optarg);
+				break;
+			case 'u':
+				unregister = 1;
+				break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if (optind < argc) {
+		free(hostport);
+		hostport = strdup(argv[optind]);
+	}
+	if (!num_phones || strlen(prefix) >= 15) {
+		usage(argv[0]);
+		return 2;
+	}
+	sim_split_hostport(hostport, &host, &port);
+	if (!(phones = calloc(num_phones, sizeof(sim_phone_t))) || !(pfds = calloc(num_phones, sizeof(struct pollfd)))) {
+		fprintf(stderr, "Out of memory\n");
+		return 2;
+	}
+	for (i = 0; i < num_phones; i++) {
+		snprintf(phones[i].name, sizeof(phones[i].name), "%s%0*X", prefix, (int) (15 - strlen(prefix)), first + i);
+		phones[i].sock = -1;
+		phones[i].protocol = protocol;
+		phones[i].devicetype = devicetype;
+	}
+	signal(SIGINT, fleet_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("Registering %u phones (%s .. %s) against %s:%s\n", num_phones, phones[0].name, phones[num_phones - 1].name, host, port);
+	start = last_report = sim_now_us();
+	while (!stop) {
+		now = sim_now_us();
+
+		/* start registrations according to the ramp */
+		while (started < num_phones && (rate <= 0 || (now - start) >= (uint64_t) (started * 1000000.0 / rate))) {
+			if (sim_phone_register(&phones[started], host, port) < 0) {
+				connect_failed++;
+			}
+			started++;
+		}
+
+		/* timeouts and keepalives */
+		for (i = 0; i < started; i++) {
+			sim_phone_t *phone = &phones[i];
+
+			if (phone->state == SIM_PHONE_REGISTERING && now > phone->connected && now - phone->connected > (uint64_t) timeout * 1000000ULL) {
+				phone->state = SIM_PHONE_FAILED;
+				sim_phone_close(phone);
+				timedout++;
+			}
+			sim_phone_keepalive(phone, now, keepalive);
+		}
+
+		if (started == num_phones && registered + rejected + timedout + closed + connect_failed >= num_phones) {
+			if (!done_at) {
+				done_at = now;
+				printf("All registrations finished after %.3f s, staying registered for %u s\n", (now - start) / 1000000.0, duration);
+			}
+			if (now - done_at >= (uint64_t) duration * 1000000ULL) {
+				break;
+			}
+		}
+
+		/* progress */
+		if (now - last_report >= 1000000) {
+			printf("[%5.1fs] started: %u, registered: %u, failed: %u, keepalives: %u\n", (now - start) / 1000000.0, started, registered, rejected + timedout + closed + connect_failed, keepalives);
+			fflush(stdout);
+			last_report = now;
+		}
+
+		/* network */
+		for (i = 0; i < started; i++) {
+			pfds[i].fd = phones[i].sock;
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+		}
+		if (poll(pfds, started, 10) < 0 && errno != EINTR) {
+			perror("poll");
+			break;
+		}
+		for (i = 0; i < started; i++) {
+			sim_phone_t *phone = &phones[i];
+			uint32_t mid = 0;
+			size_t len = sizeof(payload);
+			int res = 0;
+
+			if (!pfds[i].revents || phone->sock < 0) {
+				continue;
+			}
+			if (sim_recv(phone->sock, &phone->rb) < 0) {
+				if (phone->state != SIM_PHONE_FAILED) {
+					closed++;
+				}
+				phone->state = SIM_PHONE_FAILED;
+				sim_phone_close(phone);
+				continue;
+			}
+			while (phone->sock >= 0 && (res = sim_next_message(&phone->rb, &mid, payload, &len)) > 0) {
+				switch (sim_phone_handle(phone, mid, payload, len)) {
+					case SIM_PHONE_EVENT_REGISTER_ACK:
+						sim_samples_add(&ack_latency, phone->register_acked - phone->connected);
+						break;
+					case SIM_PHONE_EVENT_REGISTERED:
+						sim_samples_add(&reg_latency, phone->registered - phone->connected);
+						last_registered = phone->registered;
+						registered++;
+						break;
+					case SIM_PHONE_EVENT_REJECTED:
+						rejected++;
+						sim_phone_close(phone);
+						break;
+					case SIM_PHONE_EVENT_KEEPALIVE_ACK:
+						sim_samples_add(&keepalive_rtt, sim_now_us() - phone->keepalive_sent);
+						keepalives++;
+						break;
+					default:
+						break;
+				}
+				len = sizeof(payload);
+			}
+			if (res < 0) {
+				fprintf(stderr, "%s: framing error, closing\n", phone->name);
+				if (phone->state != SIM_PHONE_FAILED) {
+					closed++;
+				}
+				phone->state = SIM_PHONE_FAILED;
+				sim_phone_close(phone);
+			}
+		}
+	}
+
+	for (i = 0; i < started; i++) {
+		if (phones[i].sock >= 0 && unregister && phones[i].state == SIM_PHONE_REGISTERED) {
+			sim_phone_send(&phones[i], SIM_UnregisterMessage, NULL, 0);
+		}
+	}
+	if (unregister) {
+		sim_sleep_us(500000);										/* give chan_sccp some time to process the unregisters */
+	}
+	for (i = 0; i < started; i++) {
+		sim_phone_close(&phones[i]);
+	}
+
+	printf("\nPhones: %u, registered: %u, rejected: %u, timed out: %u, closed: %u, connect failed: %u\n", num_phones, registered, rejected, timedout, closed, connect_failed);
+	if (registered && last_registered > start) {
+		printf("Registration rate: %.1f registrations/s\n", registered * 1000000.0 / (double) (last_registered - start));
+	}
+	sim_samples_print(&ack_latency, "register -> registerack");
+	sim_samples_print(&reg_latency, "register -> registered");
+	sim_samples_print(&keepalive_rtt, "keepalive round trip");
+
+	sim_samples_free(&ack_latency);
+	sim_samples_free(&reg_latency);
+	sim_samples_free(&keepalive_rtt);
+	free(phones);
+	free(pfds);
+	free(hostport);
+	return (registered == num_phones) ? 0 : 1;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,310 @@
+/*!
+ * \file        sccp_framepath_bench.c
+ * \brief       SCCP Media Frame Path Microbenchmark
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Measures the per frame overhead chan_sccp adds in the pbx frame read/write callbacks (pbx_impl/ast113 rtp_read / rtp_write), before the
+ * frame is handed to / taken from the rtp instance. Two dispatch variants are driven over the same simulated channels:
+ *  - legacy:    the instance is worked out on every frame (check audio instance, switch on the fd number, check frame type/samples)
+ *  - framepath: the instance is taken from the table sccp_rtp precomputes (src/sccp_framepath.h, the code the callbacks use)
+ *
+ * The rtp instances are stubs (not inlined) which only count the frames they see, so what is measured is the dispatch itself plus the
+ * cache misses of touching one channel after the other, not the rtp stack. Both variants have to deliver exactly the same frames to
+ * the same instances, otherwise the benchmark aborts.
+ *
+ * Build (see README):
+ *  cc -O2 -Wall -Istandalone -I../../src -o sccp_framepath_bench sccp_framepath_bench.c
+ */
+#include "sccp_sim.h"
+#include <getopt.h>
+#include <inttypes.h>
+
+#include "config.h"
+#include <stdbool.h>
+#include <pthread.h>
+#include "define.h"
+#include "forward_declarations.h"
+#include "sccp_framepath.h"
+
+#if !defined(ARRAY_LEN)
+#define ARRAY_LEN(a) (size_t) (sizeof(a) / sizeof(0[a]))
+#endif
+
+#define BENCH_RTCP_INTERVAL 250											/* one rtcp report per 5 seconds of 20ms frames */
+
+typedef enum {
+	BENCH_FRAME_VOICE,
+	BENCH_FRAME_VIDEO,
+	BENCH_FRAME_CONTROL,
+} bench_frametype_t;
+
+typedef struct {
+	bench_frametype_t frametype;
+	int samples;
+} bench_frame_t;
+
+/* stub rtp instance, only counts */
+struct ast_rtp_instance {
+	uint64_t reads[2];											/*!< rtp, rtcp */
+	uint64_t writes;
+	uint64_t samples;											/*!< written, so that legacy and precomputed dispatch can be compared */
+};
+
+/*!
+ * \brief Simulated channel
+ * \note Roughly the layout of sccp_channel_t: the rtp structures the legacy path looks at sit in the middle of a large object, with the
+ * precomputed frame path next to them and the conference pointer somewhere else.
+ */
+typedef struct {
+	char head[512];
+	struct {
+		char lock[40];
+		PBX_RTP_TYPE *instance;
+		char state[280];
+	} audio, video;
+	sccp_framepath_t framepath;
+	char middle[1024];
+	void *conference;
+	char tail[256];
+} bench_channel_t;
+
+static bench_frame_t bench_voice = { BENCH_FRAME_VOICE, 160 };
+static bench_frame_t bench_rtcp = { BENCH_FRAME_CONTROL, 0 };
+static bench_frame_t bench_null = { BENCH_FRAME_CONTROL, 0 };
+
+static __attribute__ ((noinline)) bench_frame_t *bench_instance_read(PBX_RTP_TYPE * instance, int rtcp)
+{
+	instance->reads[rtcp]++;
+	return rtcp ? &bench_rtcp : &bench_voice;
+}
+
+static __attribute__ ((noinline)) int bench_instance_write(PBX_RTP_TYPE * instance, const bench_frame_t * frame)
+{
+	instance->writes++;
+	instance->samples += frame->samples;
+	return 0;
+}
+
+/* ================================================================================================================ legacy dispatch */
+static __attribute__ ((noinline)) bench_frame_t *bench_legacy_read(bench_channel_t * c, int fdno)
+{
+	bench_frame_t *frame = &bench_null;
+
+	if (!c->audio.instance) {
+		return frame;
+	}
+	switch (fdno) {
+		case 0:
+			frame = bench_instance_read(c->audio.instance, 0);
+			break;
+		case 1:
+			frame = bench_instance_read(c->audio.instance, 1);
+			break;
+		case 2:
+			frame = bench_instance_read(c->video.instance, 0);
+			break;
+		case 3:
+			frame = bench_instance_read(c->video.instance, 1);
+			break;
+		default:
+			break;
+	}
+	if (frame->frametype == BENCH_FRAME_VOICE) {
+		if (c->conference) {
+			frame->samples = 160;
+		}
+	}
+	return frame;
+}
+
+static __attribute__ ((noinline)) int bench_legacy_write(bench_channel_t * c, const bench_frame_t * frame)
+{
+	int res = 0;
+
+	switch (frame->frametype) {
+		case BENCH_FRAME_VOICE:
+			if (!frame->samples) {
+				fprintf(stderr, "voice frame without samples\n");
+			}
+			if (c->audio.instance) {
+				res = bench_instance_write(c->audio.instance, frame);
+			}
+			break;
+		default:
+			break;
+	}
+	return res;
+}
+
+/* ============================================================================================================= framepath dispatch */
+static __attribute__ ((noinline)) bench_frame_t *bench_framepath_read(bench_channel_t * c, int fdno)
+{
+	PBX_RTP_TYPE *instance = NULL;
+	bench_frame_t *frame = NULL;
+
+	if (dont_expect(!(instance = sccp_framepath_reader(&c->framepath, fdno)))) {
+		return &bench_null;
+	}
+	frame = bench_instance_read(instance, fdno & 1);
+	if (dont_expect(c->conference != NULL) && frame->frametype == BENCH_FRAME_VOICE) {
+		frame->samples = 160;
+	}
+	return frame;
+}
+
+static __attribute__ ((noinline)) int bench_framepath_write(bench_channel_t * c, const bench_frame_t * frame)
+{
+	if (do_expect(frame->frametype == BENCH_FRAME_VOICE && frame->samples && c->framepath.write_audio)) {
+		return bench_instance_write(c->framepath.write_audio, frame);
+	}
+	return bench_legacy_write(c, frame);
+}
+
+/* ======================================================================================================================= driver */
+typedef struct {
+	bench_frame_t *(*read) (bench_channel_t * c, int fdno);
+	int (*write) (bench_channel_t * c, const bench_frame_t * frame);
+	const char *name;
+} bench_variant_t;
+
+static const bench_variant_t bench_variants[] = {
+	{bench_legacy_read, bench_legacy_write, "legacy"},
+	{bench_framepath_read, bench_framepath_write, "framepath"},
+};
+
+typedef struct {
+	uint64_t frames;
+	uint64_t signature;
+	uint64_t elapsed_us;
+} bench_result_t;
+
+static bench_channel_t *bench_channels = NULL;
+static struct ast_rtp_instance *bench_instances = NULL;
+static unsigned int *bench_order = NULL;
+
+static void bench_setup(unsigned int channels, unsigned int video_percent, uint32_t seed)
+{
+	unsigned int i = 0, j = 0, tmp = 0;
+
+	bench_channels = calloc(channels, sizeof(bench_channel_t));
+	bench_instances = calloc(channels * 2, sizeof(struct ast_rtp_instance));
+	bench_order = calloc(channels, sizeof(unsigned int));
+	if (!bench_channels || !bench_instances || !bench_order) {
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+	srandom(seed);
+	for (i = 0; i < channels; i++) {
+		bench_channels[i].audio.instance = &bench_instances[i * 2];
+		if ((unsigned int) (random() % 100) < video_percent) {
+			bench_channels[i].video.instance = &bench_instances[i * 2 + 1];
+		}
+		sccp_framepath_set(&bench_channels[i].framepath, bench_channels[i].audio.instance, bench_channels[i].video.instance);
+		bench_order[i] = i;
+	}
+	for (i = channels - 1; i > 0; i--) {									// visit the channels in random order, like the pbx threads do
+		j = random() % (i + 1);
+		tmp = bench_order[i];
+		bench_order[i] = bench_order[j];
+		bench_order[j] = tmp;
+	}
+}
+
+static bench_result_t bench_run(const bench_variant_t * variant, unsigned int channels, unsigned int rounds)
+{
+	bench_result_t result = { 0, 0, 0 };
+	bench_channel_t *c = NULL;
+	bench_frame_t *frame = NULL;
+	unsigned int round = 0, i = 0;
+	uint64_t start = 0;
+
+	memset(bench_instances, 0, channels * 2 * sizeof(struct ast_rtp_instance));
+	start = sim_now_us();
+	for (round = 0; round < rounds; round++) {
+		for (i = 0; i < channels; i++) {
+			c = &bench_channels[bench_order[i]];
+			frame = variant->read(c, 0);
+			variant->write(c, frame);
+			result.frames += 2;
+			if (c->video.instance) {
+				variant->read(c, 2);
+				result.frames++;
+			}
+			if (dont_expect(round % BENCH_RTCP_INTERVAL == 0)) {
+				variant->read(c, 1);
+				result.frames++;
+			}
+		}
+	}
+	result.elapsed_us = sim_now_us() - start;
+	for (i = 0; i < channels * 2; i++) {
+		result.signature = (result.signature * 31) ^ bench_instances[i].reads[0];
+		result.signature = (result.signature * 31) ^ bench_instances[i].reads[1];
+		result.signature = (result.signature * 31) ^ bench_instances[i].writes;
+		result.signature = (result.signature * 31) ^ bench_instances[i].samples;
+	}
+	return result;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-c channels] [-r rounds] [-v video%%] [-s seed]\n", prog);
+	fprintf(stderr, " -c  number of simulated channels (default 2000)\n");
+	fprintf(stderr, " -r  number of 20ms frame rounds per variant (default 3000, one minute of audio)\n");
+	fprintf(stderr, " -v  percentage of channels with video (default 5)\n");
+	fprintf(stderr, " -s  seed for the channel order\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt = 0;
+	unsigned int channels = 2000, rounds = 3000, video_percent = 5, v = 0;
+	uint32_t seed = 1;
+	bench_result_t results[ARRAY_LEN(bench_variants)];
+
+	while ((opt = getopt(argc, argv, "c:r:v:s:h")) != -1) {
+		switch (opt) {
+			case 'c':
+				channels = strtoul(optarg, NULL, 10);
+				break;
+			case 'r':
+				rounds = strtoul(optarg, NULL, 10);
+				break;
+			case 'v':
+				video_percent = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if (!channels || !rounds || video_percent > 100) {
+		usage(argv[0]);
+		return 2;
+	}
+	bench_setup(channels, video_percent, seed);
+	printf("Frame path: %u channels (%u%% video), %u rounds, channel size %zu bytes\n", channels, video_percent, rounds, sizeof(bench_channel_t));
+
+	bench_run(&bench_variants[0], channels, rounds / 10 + 1);						// warm up
+	for (v = 0; v < ARRAY_LEN(bench_variants); v++) {
+		results[v] = bench_run(&bench_variants[v], channels, rounds);
+		printf("%-10s %" PRIu64 " frames in %.3f s: %.1f ns/frame, %.0f frames/s\n", bench_variants[v].name, results[v].frames, results[v].elapsed_us / 1000000.0,
+			results[v].elapsed_us * 1000.0 / results[v].frames, results[v].frames * 1000000.0 / (results[v].elapsed_us ? results[v].elapsed_us : 1));
+	}
+	for (v = 1; v < ARRAY_LEN(bench_variants); v++) {
+		if (results[v].signature != results[0].signature || results[v].frames != results[0].frames) {
+			fprintf(stderr, "%s delivered different frames than %s\n", bench_variants[v].name, bench_variants[0].name);
+			return 1;
+		}
+	}
+
+	free(bench_channels);
+	free(bench_instances);
+	free(bench_order);
+	return 0;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
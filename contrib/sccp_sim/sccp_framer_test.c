@@ -0,0 +1,560 @@
+/*!
+ * \file        sccp_framer_test.c
+ * \brief       SCCP Message Framer Fuzz and Throughput Harness
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Links the framer of chan-sccp-b (src/sccp_framer.c, the same ring buffer / header dissection / message tables the session receive path
+ * uses) without asterisk and drives it the way sccp_session does: recv() into the ring buffer, sccp_framer_next, sccp_framer_dissect_header,
+ * sccp_framer_getmsg, sccp_framer_consume.
+ *
+ * Every input is framed three times, as one block, byte by byte and in pseudo random chunks. The framer has to produce the same messages
+ * in all three runs, and every message handed out has to satisfy the invariants below, otherwise the harness aborts (which is what
+ * libFuzzer / AFL look for):
+ *  - the message view lies inside the ring buffer or is the bounce message
+ *  - msg->header.length is the known size of the message, or the packet length when the packet is shorter
+ *  - the message id handed out is the one received (unknown messages are not handed out at all)
+ *  - the ring buffer never runs full without a complete packet in it
+ *
+ * Build (see README):
+ *  awk -f ../../tools/gen_sccp_enum.awk < ../../src/sccp_enum.in
+ *  cc -O2 -Wall -I. -Istandalone -I../../src -o sccp_framer_test sccp_framer_test.c ../../src/sccp_framer.c
+ * libFuzzer:
+ *  clang -g -O1 -fsanitize=fuzzer,address -DSCCP_FRAMER_LIBFUZZER -I. -Istandalone -I../../src -o sccp_framer_fuzz sccp_framer_test.c ../../src/sccp_framer.c
+ */
+#include "sccp_sim.h"
+#include <getopt.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "define.h"
+#include "forward_declarations.h"
+#include "sccp_enum.h"
+#include "sccp_protocol.h"
+#include "sccp_framer.h"
+
+#if !defined(ARRAY_LEN)
+#define ARRAY_LEN(a) (size_t) (sizeof(a) / sizeof(0[a]))
+#endif
+
+#define FRAMER_MAX_INPUT (1024 * 1024)
+#define FRAMER_FNV_OFFSET 0xcbf29ce484222325ULL
+#define FRAMER_FNV_PRIME 0x100000001b3ULL
+
+typedef enum {
+	FRAMER_CHUNK_BLOCK,											/*!< everything at once (limited by the writable space) */
+	FRAMER_CHUNK_BYTE,											/*!< one byte per recv() */
+	FRAMER_CHUNK_RANDOM,											/*!< pseudo random chunk sizes */
+	FRAMER_CHUNK_FIXED,											/*!< fixed chunk size (benchmark) */
+} framer_chunking_t;
+
+/*!
+ * \brief Result of framing one input
+ */
+typedef struct {
+	uint64_t signature;											/*!< FNV-1a over message id, length and content of all messages handed out */
+	uint64_t messages;
+	uint64_t unknown;
+	uint64_t bytes;
+	uint64_t framed;											/*!< bytes of the packets handed out or discarded */
+	int invalid;												/*!< stream ended with an invalid length (session would close the connection) */
+} framer_result_t;
+
+static sccp_framer_ringbuffer_t *framer_rb = NULL;
+
+static inline uint64_t framer_fnv(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *ptr = data;
+	size_t i = 0;
+
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ ptr[i]) * FRAMER_FNV_PRIME;
+	}
+	return hash;
+}
+
+static void framer_fail(const char *what, const framer_result_t * result)
+{
+	fprintf(stderr, "framer invariant violated: %s (after %" PRIu64 " messages, %" PRIu64 " bytes)\n", what, result->messages, result->bytes);
+	abort();
+}
+
+/*!
+ * \brief Hand out all complete messages in the ring buffer, like process_buffer / session_buffer2msg do
+ * \return -1 when the stream became invalid
+ */
+static int framer_process(sccp_framer_ringbuffer_t * rb, framer_result_t * result, int verify)
+{
+	int packetlen = 0;
+
+	while ((packetlen = sccp_framer_next(rb)) != 0) {
+		sccp_header_t header = { 0 };
+		const sccp_msg_t *msg = NULL;
+		int known = 0, expected = 0;
+		uint32_t mid = 0;
+
+		if (packetlen == SCCP_FRAMER_INVALID_LENGTH) {
+			result->invalid = 1;
+			return -1;
+		}
+		sccp_framer_peek(rb, &header, SCCP_PACKET_HEADER);
+		mid = letohl(header.lel_messageId);
+		known = sccp_framer_dissect_header(&header);
+		if (known == SCCP_FRAMER_INVALID_LENGTH && verify) {
+			framer_fail("dissect_header rejected a length accepted by sccp_framer_next", result);
+		}
+		if (known < 0) {										/* session_buffer2msg discards these */
+			result->unknown++;
+			result->signature = framer_fnv(result->signature, &mid, sizeof(mid));
+			result->framed += packetlen;
+			sccp_framer_consume(rb, packetlen);
+			continue;
+		}
+		msg = sccp_framer_getmsg(rb, packetlen, known);
+		if (verify) {
+			expected = packetlen < known ? packetlen : known;
+			if (msg != &rb->bounce && ((const unsigned char *) msg < rb->data || (const unsigned char *) msg + expected > rb->data + SCCP_FRAMER_RINGBUFFER_SIZE)) {
+				framer_fail("message view outside of the ring buffer", result);
+			}
+			if (msg->header.length != (uint32_t) expected || expected > (int) SCCP_MAX_PACKET) {
+				framer_fail("patched header length", result);
+			}
+			if (letohl(msg->header.lel_messageId) != mid) {
+				framer_fail("message id changed", result);
+			}
+			result->signature = framer_fnv(result->signature, &mid, sizeof(mid));
+			result->signature = framer_fnv(result->signature, &expected, sizeof(expected));
+			if (expected > (int) SCCP_PACKET_HEADER) {
+				result->signature = framer_fnv(result->signature, &msg->data, expected - SCCP_PACKET_HEADER);
+			}
+		}
+		result->messages++;
+		result->framed += packetlen;
+		sccp_framer_consume(rb, packetlen);
+	}
+	return 0;
+}
+
+/*!
+ * \brief Feed one input through the framer
+ */
+static framer_result_t framer_run(const unsigned char *data, size_t len, framer_chunking_t chunking, size_t chunksize, int verify)
+{
+	sccp_framer_ringbuffer_t *rb = framer_rb;
+	framer_result_t result = { FRAMER_FNV_OFFSET, 0, 0, 0, 0, 0 };
+	uint32_t rnd = (uint32_t) len * 2654435761U + 1;
+	size_t offset = 0, space = 0, todo = 0;
+	unsigned char *ptr = NULL;
+
+	rb->head = rb->used = 0;
+	rb->last = NULL;
+	while (offset < len) {
+		if (!(space = sccp_framer_writable(rb, &ptr))) {
+			framer_fail("ring buffer full without a complete packet", &result);
+		}
+		switch (chunking) {
+			case FRAMER_CHUNK_BLOCK:
+				todo = len - offset;
+				break;
+			case FRAMER_CHUNK_BYTE:
+				todo = 1;
+				break;
+			case FRAMER_CHUNK_RANDOM:
+				rnd = rnd * 1103515245U + 12345U;
+				todo = 1 + (rnd >> 16) % 1500;
+				break;
+			case FRAMER_CHUNK_FIXED:
+				todo = chunksize;
+				break;
+		}
+		todo = todo < space ? todo : space;
+		todo = todo < len - offset ? todo : len - offset;
+		memcpy(ptr, data + offset, todo);								/* what recv() would do */
+		rb->used += todo;
+		offset += todo;
+		result.bytes += todo;
+		if (framer_process(rb, &result, verify) < 0) {
+			break;
+		}
+	}
+	return result;
+}
+
+/*!
+ * \brief Frame one input in three different ways and compare the results
+ * \return Result of the block run
+ */
+static framer_result_t framer_check(const unsigned char *data, size_t len)
+{
+	framer_result_t block, byte, random;
+
+	if (len > FRAMER_MAX_INPUT) {
+		len = FRAMER_MAX_INPUT;
+	}
+	block = framer_run(data, len, FRAMER_CHUNK_BLOCK, 0, 1);
+	byte = framer_run(data, len, FRAMER_CHUNK_BYTE, 0, 1);
+	random = framer_run(data, len, FRAMER_CHUNK_RANDOM, 0, 1);
+	if (block.signature != byte.signature || block.signature != random.signature || block.messages != byte.messages || block.messages != random.messages || block.invalid != byte.invalid || block.invalid != random.invalid) {
+		fprintf(stderr, "framing depends on chunking: block %" PRIu64 " msgs / %016" PRIx64 ", byte %" PRIu64 " msgs / %016" PRIx64 ", random %" PRIu64 " msgs / %016" PRIx64 "\n", block.messages, block.signature, byte.messages, byte.signature, random.messages, random.signature);
+		abort();
+	}
+	return block;
+}
+
+static void framer_init(void)
+{
+	if (!framer_rb && !(framer_rb = calloc(1, sizeof(sccp_framer_ringbuffer_t)))) {
+		fprintf(stderr, "Out of memory\n");
+		exit(2);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size);
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+	framer_init();
+	framer_check(data, size);
+	return 0;
+}
+
+#if !defined(SCCP_FRAMER_LIBFUZZER)
+/*!
+ * \brief Build a stream of valid messages (every known message id, full size, payload tagged with its sequence number)
+ */
+static size_t framer_build_stream(unsigned char *stream, size_t size, unsigned int repeat)
+{
+	size_t len = 0;
+	unsigned int i = 0, seq = 0;
+	uint32_t mid = 0;
+
+	for (i = 0; i < repeat; i++) {
+		for (mid = 0; mid <= SPCP_MESSAGE_HIGH_BOUNDARY; mid = (mid == SCCP_MESSAGE_HIGH_BOUNDARY) ? SPCP_MESSAGE_LOW_BOUNDARY : mid + 1) {
+			sccp_header_t header = { 0 };
+			int known = 0;
+
+			header.length = htolel(4);
+			header.lel_messageId = htolel(mid);
+			if ((known = sccp_framer_dissect_header(&header)) <= 0) {
+				continue;
+			}
+			if (len + known > size) {
+				return len;
+			}
+			header.length = htolel(known - 8);
+			memcpy(stream + len, &header, SCCP_PACKET_HEADER);
+			memset(stream + len + SCCP_PACKET_HEADER, (unsigned char) seq++, known - SCCP_PACKET_HEADER);
+			len += known;
+		}
+	}
+	return len;
+}
+
+/*!
+ * \brief Mutate an input (bit flips, byte overwrites, length field tampering, truncation, duplication of a slice)
+ */
+static size_t framer_mutate(unsigned char *data, size_t len, size_t maxlen, uint32_t * rnd)
+{
+	unsigned int count = 1 + rand_r(rnd) % 8, i = 0;
+
+	for (i = 0; i < count && len; i++) {
+		size_t pos = rand_r(rnd) % len;
+
+		switch (rand_r(rnd) % 6) {
+			case 0:
+				data[pos] ^= 1 << (rand_r(rnd) % 8);
+				break;
+			case 1:
+				data[pos] = rand_r(rnd);
+				break;
+			case 2:										/* tamper with a 32 bit field (length / protocol version / message id) */
+				{
+					static const uint32_t interesting[] = { 0, 1, 3, 4, 8, 0x7f, 0x80, 0xff, 0x100, 0xfff, 0x1000, 0x7fffffff, 0x80000000, 0xfffffff8, 0xfffffffc, 0xffffffff };
+					uint32_t value = interesting[rand_r(rnd) % ARRAY_LEN(interesting)];
+
+					pos &= ~(size_t) 3;
+					if (pos + 4 <= len) {
+						memcpy(data + pos, &value, 4);
+					}
+				}
+				break;
+			case 3:
+				len = pos + 1;
+				break;
+			case 4:										/* duplicate a slice */
+				{
+					size_t slice = 1 + rand_r(rnd) % 256;
+
+					if (pos + slice <= len && len + slice <= maxlen) {
+						memmove(data + pos + slice, data + pos, len - pos);
+						len += slice;
+					}
+				}
+				break;
+			case 5:										/* tweak a length field by a small amount */
+				{
+					uint32_t value = 0;
+
+					pos &= ~(size_t) 3;
+					if (pos + 4 <= len) {
+						memcpy(&value, data + pos, 4);
+						value = htolel(letohl(value) + (rand_r(rnd) % 17) - 8);
+						memcpy(data + pos, &value, 4);
+					}
+				}
+				break;
+		}
+	}
+	return len;
+}
+
+static int framer_read_file(const char *filename, unsigned char *buffer, size_t *len)
+{
+	FILE *fp = strcmp(filename, "-") ? fopen(filename, "rb") : stdin;
+
+	if (!fp) {
+		perror(filename);
+		return -1;
+	}
+	*len = fread(buffer, 1, FRAMER_MAX_INPUT, fp);
+	if (fp != stdin) {
+		fclose(fp);
+	}
+	return 0;
+}
+
+static int framer_write_corpus(const char *dir)
+{
+	unsigned char *stream = malloc(FRAMER_MAX_INPUT);
+	char filename[PATH_MAX];
+	size_t len = 0, offset = 0, packet = 0;
+	unsigned int count = 0;
+	FILE *fp = NULL;
+
+	if (!stream) {
+		return -1;
+	}
+	mkdir(dir, 0755);
+	len = framer_build_stream(stream, FRAMER_MAX_INPUT, 1);
+	for (offset = 0; offset < len; offset += packet, count++) {					/* one file per message, plus the complete stream */
+		uint32_t hdr_len = 0;
+
+		memcpy(&hdr_len, stream + offset, 4);
+		packet = letohl(hdr_len) + 8;
+		snprintf(filename, sizeof(filename), "%s/msg-%04x", dir, (unsigned int) letohl(((sccp_header_t *) (stream + offset))->lel_messageId));
+		if ((fp = fopen(filename, "wb"))) {
+			fwrite(stream + offset, 1, packet, fp);
+			fclose(fp);
+		}
+	}
+	snprintf(filename, sizeof(filename), "%s/stream", dir);
+	if ((fp = fopen(filename, "wb"))) {
+		fwrite(stream, 1, len, fp);
+		fclose(fp);
+	}
+	printf("Wrote %u seed files to %s\n", count + 1, dir);
+	free(stream);
+	return 0;
+}
+
+/*!
+ * \brief Pick a slice of at most maxlen bytes out of a seed, starting and ending at message boundaries
+ * \note cutting a stream at a random offset makes nearly every slice fail on its first header, never reaching the reassembly paths
+ * \return Length of the slice, the whole seed (up to maxlen) when it does not start with a complete packet
+ */
+static size_t framer_slice(const unsigned char *data, size_t len, size_t maxlen, size_t *from, uint32_t * rnd)
+{
+	size_t offset = 0, packet = 0, end = 0;
+	unsigned int packets = 0, pick = 0;
+	uint32_t hdr_len = 0;
+
+	for (offset = 0; offset + SCCP_PACKET_HEADER <= len; offset += packet, packets++) {		/* count the complete packets */
+		memcpy(&hdr_len, data + offset, 4);
+		packet = (size_t) letohl(hdr_len) + 8;
+		if (packet < SCCP_PACKET_HEADER || packet > maxlen || offset + packet > len) {
+			break;
+		}
+	}
+	*from = 0;
+	if (!packets) {
+		return len < maxlen ? len : maxlen;
+	}
+	pick = rand_r(rnd) % packets;
+	for (offset = 0; pick--; offset += packet) {
+		memcpy(&hdr_len, data + offset, 4);
+		packet = (size_t) letohl(hdr_len) + 8;
+	}
+	*from = offset;
+	for (end = offset; packets-- && end + SCCP_PACKET_HEADER <= len; end += packet) {		/* add packets while they fit */
+		memcpy(&hdr_len, data + end, 4);
+		packet = (size_t) letohl(hdr_len) + 8;
+		if (packet < SCCP_PACKET_HEADER || end + packet > len || end + packet - offset > maxlen) {
+			break;
+		}
+	}
+	return end - offset;
+}
+
+/*!
+ * \brief Built-in mutation fuzzer, seeded with the valid stream and the given inputs
+ */
+static int framer_fuzz(unsigned long iterations, uint32_t seed, unsigned char **seeds, size_t *seedlens, unsigned int numseeds)
+{
+	unsigned char *input = malloc(FRAMER_MAX_INPUT);
+	unsigned long i = 0;
+	uint64_t start = sim_now_us(), elapsed = 0, bytes = 0, framed = 0, messages = 0;
+	framer_result_t result;
+
+	if (!input) {
+		return 2;
+	}
+	printf("Fuzzing %lu iterations (seed %u, %u seed inputs)\n", iterations, seed, numseeds);
+	for (i = 0; i < iterations; i++) {
+		unsigned int which = rand_r(&seed) % numseeds;
+		size_t from = 0;
+		size_t len = framer_slice(seeds[which], seedlens[which], 8192, &from, &seed);	/* keep the inputs small, so that the byte by byte run stays fast */
+
+		memcpy(input, seeds[which] + from, len);
+		len = framer_mutate(input, len, 16384, &seed);
+		result = framer_check(input, len);
+		bytes += len;
+		framed += result.framed;
+		messages += result.messages;
+		if ((i + 1) % 100000 == 0) {
+			printf("  %lu iterations\n", i + 1);
+			fflush(stdout);
+		}
+	}
+	elapsed = sim_now_us() - start;
+	printf("Fuzzed %lu inputs (%" PRIu64 " bytes), framed %" PRIu64 " messages (%" PRIu64 " bytes) in %.2f s without violations\n", iterations, bytes, messages, framed, elapsed / 1000000.0);
+	free(input);
+	return 0;
+}
+
+/*!
+ * \brief Throughput of the framer in messages per second
+ */
+static int framer_benchmark(unsigned int seconds, size_t chunksize)
+{
+	unsigned char *stream = malloc(FRAMER_MAX_INPUT);
+	size_t len = 0;
+	uint64_t start = 0, elapsed = 0, messages = 0, bytes = 0, rounds = 0;
+	framer_result_t result;
+
+	if (!stream) {
+		return 2;
+	}
+	len = framer_build_stream(stream, FRAMER_MAX_INPUT, 4);
+	result = framer_run(stream, len, FRAMER_CHUNK_BLOCK, 0, 1);
+	if (result.unknown || result.invalid) {
+		fprintf(stderr, "benchmark stream does not frame cleanly\n");
+		return 1;
+	}
+	printf("Benchmark stream: %" PRIu64 " messages, %zu bytes, chunks of %zu bytes, %u s\n", result.messages, len, chunksize, seconds);
+	framer_rb->inplace = framer_rb->copied = 0;
+	start = sim_now_us();
+	do {
+		result = framer_run(stream, len, FRAMER_CHUNK_FIXED, chunksize, 0);
+		messages += result.messages;
+		bytes += result.bytes;
+		rounds++;
+	} while ((elapsed = sim_now_us() - start) < (uint64_t) seconds * 1000000ULL);
+	printf("Framed %" PRIu64 " messages (%" PRIu64 " bytes) in %.3f s: %.0f msgs/s, %.1f MB/s, %" PRIu64 " in place, %" PRIu64 " copied\n",
+		messages, bytes, elapsed / 1000000.0, messages * 1000000.0 / elapsed, (double) bytes / elapsed, framer_rb->inplace, framer_rb->copied);
+	free(stream);
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-b seconds] [-c chunksize] [-f iterations] [-s seed] [-w corpusdir] [input-file|- ...]\n"
+		"  -b seconds     throughput benchmark (messages per second)\n"
+		"  -c chunksize   bytes per recv() in the benchmark (default 1460)\n"
+		"  -f iterations  run the built-in mutation fuzzer (seeded with a valid stream and the given input files)\n"
+		"  -s seed        random seed for -f (default 1)\n"
+		"  -w corpusdir   write a seed corpus for libFuzzer / AFL\n"
+		"  input-file     frame the file (or stdin: -) and check the invariants (AFL: afl-fuzz -i in -o out -- %s @@)\n", name, name);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt = 0, res = 0;
+	unsigned int seconds = 0;
+	size_t chunksize = 1460;
+	unsigned long iterations = 0;
+	uint32_t seed = 1;
+	const char *corpusdir = NULL;
+	unsigned char **seeds = NULL;
+	size_t *seedlens = NULL;
+	unsigned int numseeds = 0, i = 0;
+
+	while ((opt = getopt(argc, argv, "b:c:f:s:w:h")) != -1) {
+		switch (opt) {
+			case 'b':
+				seconds = strtoul(optarg, NULL, 10);
+				break;
+			case 'c':
+				chunksize = strtoul(optarg, NULL, 10);
+				break;
+			case 'f':
+				iterations = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'w':
+				corpusdir = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if (!chunksize || (!seconds && !iterations && !corpusdir && optind >= argc)) {
+		usage(argv[0]);
+		return 2;
+	}
+	framer_init();
+	if (corpusdir && framer_write_corpus(corpusdir) < 0) {
+		return 2;
+	}
+
+	/* inputs given on the command line: check them, and use them as fuzzer seeds */
+	seeds = calloc(argc - optind + 1, sizeof(unsigned char *));
+	seedlens = calloc(argc - optind + 1, sizeof(size_t));
+	if (!seeds || !seedlens || !(seeds[0] = malloc(FRAMER_MAX_INPUT))) {
+		return 2;
+	}
+	seedlens[0] = framer_build_stream(seeds[0], FRAMER_MAX_INPUT, 1);
+	numseeds = 1;
+	for (i = optind; i < (unsigned int) argc; i++) {
+		if (!(seeds[numseeds] = malloc(FRAMER_MAX_INPUT)) || framer_read_file(argv[i], seeds[numseeds], &seedlens[numseeds]) < 0) {
+			return 2;
+		}
+		framer_check(seeds[numseeds], seedlens[numseeds]);
+		if (!iterations && !seconds) {
+			printf("%s: ok\n", argv[i]);
+		}
+		numseeds++;
+	}
+
+	if (iterations) {
+		res = framer_fuzz(iterations, seed, seeds, seedlens, numseeds);
+	}
+	if (!res && seconds) {
+		res = framer_benchmark(seconds, chunksize);
+	}
+
+	for (i = 0; i < numseeds; i++) {
+		free(seeds[i]);
+	}
+	free(seeds);
+	free(seedlens);
+	free(framer_rb);
+	return res;
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,410 @@
+/*!
+ * \file        sccp_replay.c
+ * \brief       SCCP Capture Decoder / Replay Tool
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Reads a capture file written by 'sccp capture start' and
+ *  - lists the records (-l)
+ *  - summarizes them per session / message id and checks the framing (default)
+ *  - replays the messages received from the devices against a running chan_sccp (-r host[:port]). Every captured session gets its own
+ *    connection. Replay is done in lockstep: before sending the next inbound message of a session, the tool waits until chan_sccp has sent
+ *    as many messages as it did in the capture. The message id's of the responses are compared against the capture and the time until the
+ *    responses have arrived is reported as latency.
+ *
+ * Build: cc -O2 -Wall -o sccp_replay sccp_replay.c
+ */
+#include "sccp_sim.h"
+#include <getopt.h>
+
+#define REPLAY_MAX_REPORTED_MISMATCHES 20
+
+typedef struct {
+	uint64_t timestamp;											/* us */
+	uint32_t session;
+	uint16_t direction;
+	uint32_t mid;
+	uint32_t len;
+	unsigned char *data;
+} replay_record_t;
+
+typedef struct {
+	uint32_t serial;
+	int sock;
+	sim_recvbuf_t rb;
+	uint32_t *outs;												/* message id's chan_sccp sent in the capture */
+	size_t num_outs;
+	size_t num_ins;
+	size_t sent_outs;											/* number of outs preceding the current position */
+	size_t received;
+	size_t target;												/* number of responses received once the last inbound message has been answered */
+	uint64_t last_sent;
+	uint64_t last_received;
+	uint64_t mismatches;
+	uint64_t extra;
+	uint64_t timeouts;
+	int closed;
+} replay_session_t;
+
+static replay_record_t *records = NULL;
+static size_t num_records = 0;
+static replay_session_t *sessions = NULL;
+static size_t num_sessions = 0;
+static uint64_t reported_mismatches = 0;
+
+/* ========================================================================================================================= Load */
+static int replay_load(const char *filename)
+{
+	FILE *file = fopen(filename, "r");
+	sim_capture_file_header_t fh;
+	sim_capture_record_header_t rh;
+	size_t size = 0;
+	uint32_t word = 0;
+
+	if (!file) {
+		fprintf(stderr, "Could not open '%s': %s\n", filename, strerror(errno));
+		return -1;
+	}
+	if (fread(&fh, sizeof(fh), 1, file) != 1 || memcmp(fh.magic, SIM_CAPTURE_MAGIC, sizeof(SIM_CAPTURE_MAGIC)) || le32toh(fh.lel_version) != SIM_CAPTURE_VERSION) {
+		fprintf(stderr, "'%s' is not a sccp capture file (version %d)\n", filename, SIM_CAPTURE_VERSION);
+		fclose(file);
+		return -1;
+	}
+	while (fread(&rh, sizeof(rh), 1, file) == 1) {
+		replay_record_t *record = NULL;
+
+		if (num_records == size) {
+			size = size ? size * 2 : 4096;
+			if (!(records = realloc(records, size * sizeof(replay_record_t)))) {
+				fprintf(stderr, "Out of memory\n");
+				fclose(file);
+				return -1;
+			}
+		}
+		record = &records[num_records];
+		record->timestamp = (uint64_t) le32toh(rh.lel_sec) * 1000000ULL + le32toh(rh.lel_usec);
+		record->session = le32toh(rh.lel_session);
+		record->direction = le16toh(rh.lel_direction);
+		record->len = le32toh(rh.lel_length);
+		if (record->len < SIM_PACKET_HEADER || record->len > SIM_MAX_PACKET || !(record->data = malloc(record->len))) {
+			fprintf(stderr, "Record %zu: invalid length %u, capture truncated here\n", num_records, record->len);
+			break;
+		}
+		if (fread(record->data, 1, record->len, file) != record->len) {
+			fprintf(stderr, "Record %zu: short read, capture truncated here\n", num_records);
+			free(record->data);
+			break;
+		}
+		memcpy(&word, record->data + 8, 4);
+		record->mid = le32toh(word);
+		num_records++;
+	}
+	fclose(file);
+	return 0;
+}
+
+static replay_session_t *replay_find_session(uint32_t serial)
+{
+	size_t i = 0;
+
+	for (i = 0; i < num_sessions; i++) {
+		if (sessions[i].serial == serial) {
+			return &sessions[i];
+		}
+	}
+	if (!(sessions = realloc(sessions, (num_sessions + 1) * sizeof(replay_session_t)))) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	memset(&sessions[num_sessions], 0, sizeof(replay_session_t));
+	sessions[num_sessions].serial = serial;
+	sessions[num_sessions].sock = -1;
+	return &sessions[num_sessions++];
+}
+
+static void replay_index_sessions(int only_session)
+{
+	size_t i = 0;
+	replay_session_t *session = NULL;
+
+	for (i = 0; i < num_records; i++) {
+		if (only_session >= 0 && records[i].session != (uint32_t) only_session) {
+			continue;
+		}
+		session = replay_find_session(records[i].session);
+		if (records[i].direction == SIM_CAPTURE_OUT) {
+			session->outs = realloc(session->outs, (session->num_outs + 1) * sizeof(uint32_t));
+			session->outs[session->num_outs++] = records[i].mid;
+		} else {
+			session->num_ins++;
+		}
+	}
+}
+
+/* ========================================================================================================================= List / Summary */
+static void replay_list(int only_session)
+{
+	size_t i = 0;
+	uint64_t start = num_records ? records[0].timestamp : 0;
+
+	printf("%-12s %-8s %-4s %-8s %-6s\n", "Time(ms)", "Session", "Dir", "Id", "Length");
+	for (i = 0; i < num_records; i++) {
+		if (only_session >= 0 && records[i].session != (uint32_t) only_session) {
+			continue;
+		}
+		printf("%-12.3f %-8u %-4s 0x%04x   %-6u\n", (records[i].timestamp - start) / 1000.0, records[i].session, records[i].direction == SIM_CAPTURE_IN ? "in" : "out", records[i].mid, records[i].len);
+	}
+}
+
+static void replay_summary(int only_session)
+{
+	size_t i = 0;
+	uint64_t in[0x10000] = { 0 };
+	uint64_t out[0x10000] = { 0 };
+	uint64_t framing_errors = 0;
+	uint32_t word = 0;
+
+	for (i = 0; i < num_records; i++) {
+		if (only_session >= 0 && records[i].session != (uint32_t) only_session) {
+			continue;
+		}
+		memcpy(&word, records[i].data, 4);
+		if (le32toh(word) + 8 != records[i].len) {
+			framing_errors++;
+		}
+		if (records[i].direction == SIM_CAPTURE_IN) {
+			in[records[i].mid & 0xFFFF]++;
+		} else {
+			out[records[i].mid & 0xFFFF]++;
+		}
+	}
+	printf("Records: %zu, Sessions: %zu, Duration: %.3f s, Framing errors: %ju\n\n", num_records, num_sessions, num_records ? (records[num_records - 1].timestamp - records[0].timestamp) / 1000000.0 : 0.0, (uintmax_t) framing_errors);
+	printf("%-8s %-10s %-10s\n", "Session", "In", "Out");
+	for (i = 0; i < num_sessions; i++) {
+		printf("%-8u %-10zu %-10zu\n", sessions[i].serial, sessions[i].num_ins, sessions[i].num_outs);
+	}
+	printf("\n%-8s %-10s %-10s\n", "Id", "In", "Out");
+	for (i = 0; i < 0x10000; i++) {
+		if (in[i] || out[i]) {
+			printf("0x%04zx   %-10ju %-10ju\n", i, (uintmax_t) in[i], (uintmax_t) out[i]);
+		}
+	}
+}
+
+/* ========================================================================================================================= Replay */
+static void replay_receive(replay_session_t * session, sim_samples_t * latency)
+{
+	uint32_t mid = 0;
+	int res = 0;
+
+	if (sim_recv(session->sock, &session->rb) < 0) {
+		session->closed = 1;
+	}
+	while ((res = sim_next_message(&session->rb, &mid, NULL, NULL)) > 0) {
+		session->last_received = sim_now_us();
+		if (session->received < session->num_outs) {
+			if (session->outs[session->received] != mid) {
+				session->mismatches++;
+				if (reported_mismatches++ < REPLAY_MAX_REPORTED_MISMATCHES) {
+					printf("session %u: response %zu: expected 0x%04x, received 0x%04x\n", session->serial, session->received, session->outs[session->received], mid);
+				}
+			}
+		} else {
+			session->extra++;
+		}
+		session->received++;
+		if (session->received == session->target) {
+			sim_samples_add(latency, session->last_received - session->last_sent);
+		}
+	}
+	if (res < 0) {
+		fprintf(stderr, "session %u: framing error in response stream\n", session->serial);
+		session->closed = 1;
+	}
+}
+
+/*!
+ * \brief Wait (at most until deadline) for data on any of the sessions and process it
+ */
+static int replay_poll(uint64_t deadline, sim_samples_t * latency)
+{
+	struct pollfd pfds[num_sessions];
+	uint64_t now = sim_now_us();
+	size_t i = 0;
+
+	for (i = 0; i < num_sessions; i++) {
+		pfds[i].fd = sessions[i].closed ? -1 : sessions[i].sock;
+		pfds[i].events = POLLIN;
+		pfds[i].revents = 0;
+	}
+	if (poll(pfds, num_sessions, deadline > now ? (int) ((deadline - now + 999) / 1000) : 0) < 0 && errno != EINTR) {
+		return -1;
+	}
+	for (i = 0; i < num_sessions; i++) {
+		if (pfds[i].revents) {
+			replay_receive(&sessions[i], latency);
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief Drain all sessions until 'session' has received 'wanted' messages (or timeout)
+ */
+static int replay_wait(replay_session_t * session, size_t wanted, int timeout_ms, sim_samples_t * latency)
+{
+	uint64_t deadline = sim_now_us() + (uint64_t) timeout_ms * 1000;
+
+	while (session->received < wanted && !session->closed && sim_now_us() < deadline) {
+		if (replay_poll(deadline, latency) < 0) {
+			return -1;
+		}
+	}
+	return session->received >= wanted ? 0 : -1;
+}
+
+static int replay_run(const char *target, int only_session, int timing, int timeout_ms)
+{
+	char *hostport = strdup(target);
+	const char *host = NULL;
+	const char *port = NULL;
+	replay_session_t *session = NULL;
+	sim_samples_t latency = { 0 };
+	uint64_t start = 0;
+	uint64_t sent = 0;
+	uint64_t mismatches = 0, extra = 0, timeouts = 0, missing = 0;
+	size_t i = 0, j = 0;
+
+	sim_split_hostport(hostport, &host, &port);
+	for (i = 0; i < num_sessions; i++) {
+		if ((sessions[i].sock = sim_connect(host, port)) < 0) {
+			fprintf(stderr, "Could not connect to %s:%s: %s\n", host, port, strerror(errno));
+			free(hostport);
+			return -1;
+		}
+	}
+
+	start = sim_now_us();
+	for (i = 0; i < num_records; i++) {
+		if (only_session >= 0 && records[i].session != (uint32_t) only_session) {
+			continue;
+		}
+		session = replay_find_session(records[i].session);
+		if (records[i].direction == SIM_CAPTURE_OUT) {
+			session->sent_outs++;
+			continue;
+		}
+		if (session->closed) {
+			continue;
+		}
+		if (session->received < session->sent_outs && replay_wait(session, session->sent_outs, timeout_ms, &latency) < 0) {
+			session->timeouts++;
+			session->received = session->sent_outs;						/* resync */
+		}
+		if (timing && i > 0) {
+			uint64_t due = start + (records[i].timestamp - records[0].timestamp);
+
+			while (sim_now_us() < due) {							/* keep processing responses while waiting */
+				replay_poll(due, &latency);
+			}
+		}
+		session->last_sent = sim_now_us();
+		if (sim_send_raw(session->sock, records[i].data, records[i].len) < 0) {
+			fprintf(stderr, "session %u: send failed: %s\n", session->serial, strerror(errno));
+			session->closed = 1;
+			continue;
+		}
+		session->target = session->sent_outs;
+		for (j = i + 1; j < num_records; j++) {							/* responses expected before the next inbound message */
+			if (records[j].session == session->serial) {
+				if (records[j].direction != SIM_CAPTURE_OUT) {
+					break;
+				}
+				session->target++;
+			}
+		}
+		sent++;
+	}
+	for (i = 0; i < num_sessions; i++) {									/* collect the responses to the last messages */
+		if (sessions[i].received < sessions[i].num_outs) {
+			replay_wait(&sessions[i], sessions[i].num_outs, timeout_ms, &latency);
+		}
+	}
+
+	for (i = 0; i < num_sessions; i++) {
+		mismatches += sessions[i].mismatches;
+		extra += sessions[i].extra;
+		timeouts += sessions[i].timeouts;
+		missing += sessions[i].received < sessions[i].num_outs ? sessions[i].num_outs - sessions[i].received : 0;
+		close(sessions[i].sock);
+	}
+	printf("\nReplayed %ju messages over %zu sessions in %.3f s (%.0f msg/s)\n", (uintmax_t) sent, num_sessions, (sim_now_us() - start) / 1000000.0, sent * 1000000.0 / (double) (sim_now_us() - start + 1));
+	printf("Responses: mismatched: %ju, missing: %ju, extra: %ju, timeouts: %ju\n", (uintmax_t) mismatches, (uintmax_t) missing, (uintmax_t) extra, (uintmax_t) timeouts);
+	sim_samples_print(&latency, "response latency");
+	sim_samples_free(&latency);
+	free(hostport);
+	return (mismatches || missing || timeouts) ? 1 : 0;
+}
+
+/* ========================================================================================================================= Main */
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-l] [-S session] [-r host[:port] [-t] [-w timeout_ms]] capture-file\n"
+		"  -l             list all records\n"
+		"  -S session     only use the records of this session serial number\n"
+		"  -r host:port   replay the inbound messages against chan_sccp (default port 2000)\n"
+		"  -t             keep the original timing between messages (default: as fast as chan_sccp responds)\n"
+		"  -w timeout_ms  time to wait for the expected responses (default 2000)\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt = 0;
+	int list = 0;
+	int timing = 0;
+	int timeout_ms = 2000;
+	int only_session = -1;
+	const char *target = NULL;
+	int res = 0;
+
+	while ((opt = getopt(argc, argv, "lS:r:tw:h")) != -1) {
+		switch (opt) {
+			case 'l':
+				list = 1;
+				break;
+			case 'S':
+				only_session = atoi(optarg);
+				break;
+			case 'r':
+				target = optarg;
+				break;
+			case 't':
+				timing = 1;
+				break;
+			case 'w':
+				timeout_ms = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 2;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (replay_load(argv[optind]) < 0) {
+		return 2;
+	}
+	replay_index_sessions(only_session);
+
+	if (list) {
+		replay_list(only_session);
+	} else if (target) {
+		res = replay_run(target, only_session, timing, timeout_ms);
+	} else {
+		replay_summary(only_session);
+	}
+	return res;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
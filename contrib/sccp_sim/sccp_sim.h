@@ -0,0 +1,563 @@
+/*!
+ * \file        sccp_sim.h
+ * \brief       SCCP Simulator Tools, shared helpers (skinny framing, sockets, timing, statistics)
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * These tools are deliberately standalone (no asterisk / chan_sccp headers), so that they can be build on any plain Linux box.
+ * Everything in here is static inline, every tool is a single translation unit.
+ */
+#pragma once
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <endian.h>
+
+#define SIM_PACKET_HEADER 12											/* length, protocolVer/reserved, messageId */
+#define SIM_MAX_PACKET 4096											/* upper bound, chan_sccp itself rejects anything above sizeof(sccp_msg_t) */
+
+/* message id's used by the tools (see src/sccp_protocol.h) */
+#define SIM_KeepAliveMessage			0x0000
+#define SIM_RegisterMessage			0x0001
+#define SIM_IpPortMessage			0x0002
+#define SIM_KeypadButtonMessage			0x0003
+#define SIM_StimulusMessage			0x0005
+#define SIM_OffHookMessage			0x0006
+#define SIM_OnHookMessage			0x0007
+#define SIM_ButtonTemplateReqMessage		0x000E
+#define SIM_CapabilitiesResMessage		0x0010
+#define SIM_SoftKeyTemplateReqMessage		0x0028
+#define SIM_SoftKeySetReqMessage		0x0025
+#define SIM_SoftKeyEventMessage			0x0026
+#define SIM_RegisterAvailableLinesMessage	0x002D
+#define SIM_OpenReceiveChannelAck		0x0022
+#define SIM_LineStatReqMessage			0x000B
+#define SIM_TimeDateReqMessage			0x000D
+#define SIM_UnregisterMessage			0x0027
+#define SIM_RegisterAckMessage			0x0081
+#define SIM_StartMediaTransmission		0x008A
+#define SIM_StopMediaTransmission		0x008B
+#define SIM_CallStateMessage			0x0111
+#define SIM_KeepAliveAckMessage			0x0100
+#define SIM_OpenReceiveChannel			0x0105
+#define SIM_CloseReceiveChannel			0x0106
+#define SIM_CapabilitiesReqMessage		0x009B
+#define SIM_ButtonTemplateMessage		0x0097
+#define SIM_SoftKeyTemplateResMessage		0x0108
+#define SIM_SoftKeySetResMessage		0x0109
+#define SIM_LineStatMessage			0x0092
+#define SIM_RegisterRejectMessage		0x009D
+#define SIM_Reset				0x009F
+#define SIM_DefineTimeDate			0x0094
+#define SIM_UnregisterAckMessage		0x0118
+
+#define SIM_BUTTONTYPE_LINE			0x09
+#define SIM_CODEC_G711_ALAW_64K			0x02
+#define SIM_CODEC_G711_ULAW_64K			0x04
+#define SIM_DEVICETYPE_CISCO7960		7
+#define SIM_MAX_LINES				42
+#define SIM_MAX_DIRNUM				24
+
+/* skinny_callstate (see src/sccp_enum.in) */
+#define SIM_CALLSTATE_OFFHOOK			1
+#define SIM_CALLSTATE_ONHOOK			2
+#define SIM_CALLSTATE_RINGOUT			3
+#define SIM_CALLSTATE_RINGIN			4
+#define SIM_CALLSTATE_CONNECTED			5
+#define SIM_CALLSTATE_BUSY			6
+#define SIM_CALLSTATE_CONGESTION		7
+#define SIM_CALLSTATE_HOLD			8
+#define SIM_CALLSTATE_PROCEED			12
+#define SIM_CALLSTATE_MAX			32
+
+/* SoftKeyEvent numbers: index into softkeysmap + 1 (see src/sccp_protocol.h / handle_soft_key_event) */
+#define SIM_SOFTKEY_NEWCALL			2
+#define SIM_SOFTKEY_HOLD			3
+#define SIM_SOFTKEY_TRANSFER			4
+#define SIM_SOFTKEY_ENDCALL			9
+#define SIM_SOFTKEY_RESUME			10
+#define SIM_SOFTKEY_ANSWER			11
+#define SIM_SOFTKEY_CONFRN			13
+
+/* KeypadButton values other than 0-9 (see handle_keypad_button) */
+#define SIM_KEYPAD_STAR				14
+#define SIM_KEYPAD_POUND			15
+
+/*!
+ * \brief Capture File Format (see src/sccp_capture.h, keep in sync)
+ */
+#define SIM_CAPTURE_MAGIC "SCCPCAP"
+#define SIM_CAPTURE_VERSION 1
+#define SIM_CAPTURE_IN 0
+#define SIM_CAPTURE_OUT 1
+
+typedef struct {
+	char magic[8];
+	uint32_t lel_version;
+	uint32_t lel_reserved;
+} sim_capture_file_header_t;
+
+typedef struct {
+	uint32_t lel_sec;
+	uint32_t lel_usec;
+	uint32_t lel_session;
+	uint16_t lel_direction;
+	uint16_t lel_reserved;
+	uint32_t lel_length;
+} sim_capture_record_header_t;
+
+/* ========================================================================================================================= Timing */
+static inline uint64_t sim_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static inline void sim_sleep_us(uint64_t usecs)
+{
+	struct timespec ts = { usecs / 1000000, (usecs % 1000000) * 1000 };
+
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+}
+
+/* ========================================================================================================================= Statistics */
+static inline int sim_cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*!
+ * \brief Latency Samples
+ */
+typedef struct {
+	uint64_t *values;
+	size_t count;
+	size_t size;
+} sim_samples_t;
+
+static inline void sim_samples_add(sim_samples_t * samples, uint64_t value)
+{
+	if (samples->count == samples->size) {
+		size_t size = samples->size ? samples->size * 2 : 1024;
+		uint64_t *values = realloc(samples->values, size * sizeof(uint64_t));
+
+		if (!values) {
+			return;
+		}
+		samples->values = values;
+		samples->size = size;
+	}
+	samples->values[samples->count++] = value;
+}
+
+/*!
+ * \brief Return a percentile (nearest rank), sorts the samples
+ */
+static inline uint64_t sim_samples_percentile(sim_samples_t * samples, unsigned int percent)
+{
+	size_t rank = 0;
+
+	if (!samples->count) {
+		return 0;
+	}
+	qsort(samples->values, samples->count, sizeof(uint64_t), sim_cmp_u64);
+	rank = (samples->count * percent + 99) / 100;
+	return samples->values[rank ? rank - 1 : 0];
+}
+
+static inline void sim_samples_print(sim_samples_t * samples, const char *name)
+{
+	printf("%-28s count:%-8zu p50:%-8ju p90:%-8ju p99:%-8ju max:%-8ju (us)\n", name, samples->count,
+		(uintmax_t) sim_samples_percentile(samples, 50), (uintmax_t) sim_samples_percentile(samples, 90),
+		(uintmax_t) sim_samples_percentile(samples, 99), (uintmax_t) sim_samples_percentile(samples, 100));
+}
+
+static inline void sim_samples_free(sim_samples_t * samples)
+{
+	free(samples->values);
+	memset(samples, 0, sizeof(*samples));
+}
+
+/* ========================================================================================================================= Sockets */
+/*!
+ * \brief Connect to host:port (blocking connect, non-blocking afterwards)
+ * \return socket or -1
+ */
+static inline int sim_connect(const char *host, const char *port)
+{
+	struct addrinfo hints = { 0 };
+	struct addrinfo *res = NULL;
+	int sock = -1;
+	int on = 1;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host, port, &hints, &res) != 0 || !res) {
+		return -1;
+	}
+	if ((sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol)) >= 0) {
+		if (connect(sock, res->ai_addr, res->ai_addrlen) < 0) {
+			close(sock);
+			sock = -1;
+		} else {
+			setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+			fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+		}
+	}
+	freeaddrinfo(res);
+	return sock;
+}
+
+/*!
+ * \brief Send a complete buffer (spins on EAGAIN, the messages are small)
+ */
+static inline int sim_send_raw(int sock, const void *data, size_t len)
+{
+	const unsigned char *ptr = data;
+	ssize_t res = 0;
+
+	while (len) {
+		res = send(sock, ptr, len, MSG_NOSIGNAL);
+		if (res < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				struct pollfd pfd = { sock, POLLOUT, 0 };
+
+				poll(&pfd, 1, 100);
+				continue;
+			}
+			return -1;
+		}
+		ptr += res;
+		len -= res;
+	}
+	return 0;
+}
+
+/*!
+ * \brief Frame and send a skinny message
+ * \param payload message data (without header), may be NULL when len is 0
+ */
+static inline int sim_send_message(int sock, uint32_t mid, const void *payload, size_t len)
+{
+	unsigned char buf[SIM_MAX_PACKET];
+	uint32_t word = 0;
+
+	if (len + SIM_PACKET_HEADER > sizeof(buf)) {
+		return -1;
+	}
+	word = htole32((uint32_t) len + 4);
+	memcpy(buf, &word, 4);
+	word = 0;
+	memcpy(buf + 4, &word, 4);
+	word = htole32(mid);
+	memcpy(buf + 8, &word, 4);
+	if (len) {
+		memcpy(buf + SIM_PACKET_HEADER, payload, len);
+	}
+	return sim_send_raw(sock, buf, len + SIM_PACKET_HEADER);
+}
+
+/*!
+ * \brief Receive Buffer, reassembles skinny messages from the tcp stream
+ */
+typedef struct {
+	unsigned char data[SIM_MAX_PACKET * 4];
+	size_t used;
+} sim_recvbuf_t;
+
+/*!
+ * \brief Read whatever is available on the socket
+ * \return bytes read, 0 when nothing was available, -1 on error/close
+ */
+static inline ssize_t sim_recv(int sock, sim_recvbuf_t * rb)
+{
+	ssize_t res = recv(sock, rb->data + rb->used, sizeof(rb->data) - rb->used, 0);
+
+	if (res == 0) {
+		return -1;
+	}
+	if (res < 0) {
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	}
+	rb->used += res;
+	return res;
+}
+
+/*!
+ * \brief Take the next complete message out of the receive buffer
+ * \param mid returns message id
+ * \param payload returns a copy of the message data (without header), may be NULL
+ * \param payload_len size of payload on input, number of bytes copied on output
+ * \return 1 when a message was returned, 0 when more data is needed, -1 on a framing error
+ */
+static inline int sim_next_message(sim_recvbuf_t * rb, uint32_t * mid, void *payload, size_t * payload_len)
+{
+	uint32_t word = 0;
+	size_t total = 0;
+	size_t len = 0;
+
+	if (rb->used < SIM_PACKET_HEADER) {
+		return 0;
+	}
+	memcpy(&word, rb->data, 4);
+	total = (size_t) le32toh(word) + 8;
+	if (total < SIM_PACKET_HEADER || total > SIM_MAX_PACKET) {
+		return -1;
+	}
+	if (rb->used < total) {
+		return 0;
+	}
+	memcpy(&word, rb->data + 8, 4);
+	*mid = le32toh(word);
+	len = total - SIM_PACKET_HEADER;
+	if (payload && payload_len) {
+		*payload_len = len < *payload_len ? len : *payload_len;
+		memcpy(payload, rb->data + SIM_PACKET_HEADER, *payload_len);
+	}
+	memmove(rb->data, rb->data + total, rb->used - total);
+	rb->used -= total;
+	return 1;
+}
+
+/* ========================================================================================================================= Phone */
+typedef enum {
+	SIM_PHONE_IDLE,
+	SIM_PHONE_REGISTERING,											/*!< Register sent, walking through the registration sequence */
+	SIM_PHONE_REGISTERED,											/*!< DefineTimeDate received (chan_sccp sets the device to RS_OK on TimeDateReq) */
+	SIM_PHONE_FAILED,
+} sim_phone_state_t;
+
+typedef enum {
+	SIM_PHONE_EVENT_NONE,
+	SIM_PHONE_EVENT_REGISTER_ACK,
+	SIM_PHONE_EVENT_REGISTERED,
+	SIM_PHONE_EVENT_REJECTED,
+	SIM_PHONE_EVENT_KEEPALIVE_ACK,
+	SIM_PHONE_EVENT_UNHANDLED,										/*!< not part of the registration sequence, left to the tool */
+} sim_phone_event_t;
+
+/*!
+ * \brief Simulated Phone
+ */
+typedef struct {
+	char name[16];
+	int sock;
+	sim_recvbuf_t rb;
+	sim_phone_state_t state;
+	uint32_t protocol;
+	uint32_t devicetype;
+	uint8_t lines[SIM_MAX_LINES];										/*!< line instances from the button template */
+	char extension[SIM_MAX_DIRNUM];										/*!< directory number of the first line (from LineStat) */
+	unsigned int num_lines;
+	unsigned int linestats_pending;
+	uint32_t keepalive_interval;										/*!< seconds, from RegisterAck */
+	uint64_t connected;											/*!< us */
+	uint64_t register_acked;
+	uint64_t registered;
+	uint64_t next_keepalive;
+	uint64_t keepalive_sent;
+	uint32_t messages_in;
+	uint32_t messages_out;
+} sim_phone_t;
+
+static inline int sim_phone_send(sim_phone_t * phone, uint32_t mid, const void *payload, size_t len)
+{
+	phone->messages_out++;
+	return sim_send_message(phone->sock, mid, payload, len);
+}
+
+static inline int sim_phone_send_u32(sim_phone_t * phone, uint32_t mid, uint32_t value)
+{
+	uint32_t lel_value = htole32(value);
+
+	return sim_phone_send(phone, mid, &lel_value, sizeof(lel_value));
+}
+
+/*!
+ * \brief Connect and send the RegisterMessage
+ */
+static inline int sim_phone_register(sim_phone_t * phone, const char *host, const char *port)
+{
+	unsigned char reg[80] = { 0 };										/* StationIdentifier, stationIpAddr, deviceType, maxStreams, activeStreams, phone_features, ... */
+	uint32_t word = 0;
+
+	phone->connected = sim_now_us();
+	if ((phone->sock = sim_connect(host, port)) < 0) {
+		phone->state = SIM_PHONE_FAILED;
+		return -1;
+	}
+	memcpy(reg, phone->name, strlen(phone->name));								/* deviceName[16] */
+	word = htole32(0x0100007F);										/* stationIpAddr 127.0.0.1 (network order bytes) */
+	memcpy(reg + 24, &word, 4);
+	word = htole32(phone->devicetype);
+	memcpy(reg + 28, &word, 4);
+	word = htole32(5);											/* maxStreams */
+	memcpy(reg + 32, &word, 4);
+	word = htole32(phone->protocol);									/* phone_features: protocol version in the low byte */
+	memcpy(reg + 40, &word, 4);
+	phone->state = SIM_PHONE_REGISTERING;
+	phone->num_lines = 0;
+	phone->linestats_pending = 0;
+	return sim_phone_send(phone, SIM_RegisterMessage, reg, sizeof(reg));
+}
+
+/*!
+ * \brief Send the request following the button template / last line stat
+ */
+static inline void sim_phone_finish_registration(sim_phone_t * phone)
+{
+	sim_phone_send_u32(phone, SIM_RegisterAvailableLinesMessage, phone->num_lines);
+	sim_phone_send(phone, SIM_TimeDateReqMessage, NULL, 0);
+}
+
+/*!
+ * \brief Drive the registration sequence the way a 79xx does (see handle_register / sccp_handle_message)
+ *
+ * Register -> RegisterAck + CapabilitiesReq -> CapabilitiesRes, ButtonTemplateReq -> ButtonTemplate -> SoftKeyTemplateReq, SoftKeySetReq,
+ * LineStatReq per line -> LineStat (all lines) -> RegisterAvailableLines, TimeDateReq -> DefineTimeDate
+ */
+static inline sim_phone_event_t sim_phone_handle(sim_phone_t * phone, uint32_t mid, const unsigned char *payload, size_t len)
+{
+	uint32_t word = 0;
+	unsigned int i = 0;
+
+	phone->messages_in++;
+	switch (mid) {
+		case SIM_RegisterAckMessage:
+			if (len >= 4) {
+				memcpy(&word, payload, 4);
+				phone->keepalive_interval = le32toh(word);
+			}
+			phone->register_acked = sim_now_us();
+			return SIM_PHONE_EVENT_REGISTER_ACK;
+		case SIM_CapabilitiesReqMessage:
+			{
+				unsigned char caps[4 + 2 * 16] = { 0 };					/* lel_count + 2 * MediaCapabilityStructure */
+
+				word = htole32(2);
+				memcpy(caps, &word, 4);
+				word = htole32(SIM_CODEC_G711_ULAW_64K);
+				memcpy(caps + 4, &word, 4);
+				word = htole32(40);
+				memcpy(caps + 8, &word, 4);
+				word = htole32(SIM_CODEC_G711_ALAW_64K);
+				memcpy(caps + 20, &word, 4);
+				word = htole32(40);
+				memcpy(caps + 24, &word, 4);
+				sim_phone_send(phone, SIM_CapabilitiesResMessage, caps, sizeof(caps));
+				sim_phone_send_u32(phone, SIM_ButtonTemplateReqMessage, 0);
+			}
+			return SIM_PHONE_EVENT_NONE;
+		case SIM_ButtonTemplateMessage:
+			if (len >= 12) {
+				uint32_t count = 0;
+
+				memcpy(&word, payload + 4, 4);
+				count = le32toh(word);
+				for (i = 0; i < count && 12 + i * 2 + 1 < len; i++) {
+					if (payload[12 + i * 2 + 1] == SIM_BUTTONTYPE_LINE && phone->num_lines < SIM_MAX_LINES) {
+						phone->lines[phone->num_lines++] = payload[12 + i * 2];
+					}
+				}
+			}
+			sim_phone_send(phone, SIM_SoftKeyTemplateReqMessage, NULL, 0);
+			sim_phone_send(phone, SIM_SoftKeySetReqMessage, NULL, 0);
+			phone->linestats_pending = phone->num_lines;
+			for (i = 0; i < phone->num_lines; i++) {
+				sim_phone_send_u32(phone, SIM_LineStatReqMessage, phone->lines[i]);
+			}
+			if (!phone->num_lines) {
+				sim_phone_finish_registration(phone);
+			}
+			return SIM_PHONE_EVENT_NONE;
+		case SIM_LineStatMessage:
+			if (len >= 4 + SIM_MAX_DIRNUM && phone->num_lines) {
+				memcpy(&word, payload, 4);
+				if (le32toh(word) == phone->lines[0]) {
+					memcpy(phone->extension, payload + 4, SIM_MAX_DIRNUM);
+					phone->extension[SIM_MAX_DIRNUM - 1] = '\0';
+				}
+			}
+			if (phone->state == SIM_PHONE_REGISTERING && phone->linestats_pending && --phone->linestats_pending == 0) {
+				sim_phone_finish_registration(phone);
+			}
+			return SIM_PHONE_EVENT_NONE;
+		case SIM_DefineTimeDate:
+			if (phone->state == SIM_PHONE_REGISTERING) {
+				phone->state = SIM_PHONE_REGISTERED;
+				phone->registered = sim_now_us();
+				phone->next_keepalive = phone->registered + (uint64_t) (phone->keepalive_interval ? phone->keepalive_interval : 30) * 1000000ULL;
+				return SIM_PHONE_EVENT_REGISTERED;
+			}
+			return SIM_PHONE_EVENT_NONE;
+		case SIM_RegisterRejectMessage:
+			phone->state = SIM_PHONE_FAILED;
+			return SIM_PHONE_EVENT_REJECTED;
+		case SIM_KeepAliveAckMessage:
+			return SIM_PHONE_EVENT_KEEPALIVE_ACK;
+		case SIM_KeepAliveMessage:										/* chan_sccp does not send these, answer anyway */
+			sim_phone_send(phone, SIM_KeepAliveAckMessage, NULL, 0);
+			return SIM_PHONE_EVENT_NONE;
+		default:
+			return SIM_PHONE_EVENT_UNHANDLED;
+	}
+}
+
+/*!
+ * \brief Send a keepalive when it is due
+ * \return 1 when a keepalive was sent
+ */
+static inline int sim_phone_keepalive(sim_phone_t * phone, uint64_t now, uint32_t interval_override)
+{
+	if (phone->state != SIM_PHONE_REGISTERED || now < phone->next_keepalive) {
+		return 0;
+	}
+	phone->keepalive_sent = now;
+	phone->next_keepalive = now + (uint64_t) (interval_override ? interval_override : (phone->keepalive_interval ? phone->keepalive_interval : 30)) * 1000000ULL;
+	sim_phone_send(phone, SIM_KeepAliveMessage, NULL, 0);
+	return 1;
+}
+
+static inline void sim_phone_close(sim_phone_t * phone)
+{
+	if (phone->sock >= 0) {
+		close(phone->sock);
+		phone->sock = -1;
+	}
+	phone->rb.used = 0;
+}
+
+/* ========================================================================================================================= Helpers */
+/*!
+ * \brief Split "host:port" (port defaults to 2000)
+ */
+static inline void sim_split_hostport(char *str, const char **host, const char **port)
+{
+	char *colon = strrchr(str, ':');
+
+	*host = str;
+	*port = "2000";
+	if (colon && colon == strchr(str, ':')) {								/* only split ipv4/hostname, leave ipv6 alone */
+		*colon = '\0';
+		*port = colon + 1;
+	}
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
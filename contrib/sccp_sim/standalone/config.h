@@ -0,0 +1,31 @@
+/*!
+ * \file        config.h
+ * \brief       Minimal stand-in for the configure generated src/config.h
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Only used to build sccp_framer_test on a tree which has not been configured (no asterisk available), when src/config.h exists that
+ * one is picked up instead. Contains just what sccp_protocol.h / sccp_framer.c / sccp_framepath.h need.
+ */
+#pragma once
+
+#define HAVE_BYTESWAP_H 1
+#define HAVE_BSWAP_16 1
+#define HAVE_BSWAP_32 1
+#define HAVE_BSWAP_64 1
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SCCP_LITTLE_ENDIAN 1
+#else
+#define SCCP_BIG_ENDIAN 1
+#endif
+#define ULONG unsigned long
+#define SCCP_MAX_EXTENSION 80
+#define PBX_RTP_TYPE struct ast_rtp_instance
+
+/* the tools only link a part of src/, declare the SCCP_INLINE helpers they do not link as plain externs (define.h keeps these) */
+#define gcc_inline __inline__
+#define SCCP_API extern
+#define SCCP_API_VISIBLE extern
+#define SCCP_INLINE SCCP_API
+#define SCCP_CALL
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -33,6 +33,11 @@
 #include "sccp_devstate.h"
 #endif
 #include "sccp_management.h"	// use __constructor__ to remove this entry
+#include "sccp_realtime.h"	// use __constructor__ to remove this entry
+#include "sccp_dialplan.h"	// use __constructor__ to remove this entry
+#include "sccp_calltrace.h"	// use __constructor__ to remove this entry
+#include "sccp_msgstats.h"	// use __constructor__ to remove this entry
+#include "sccp_capture.h"	// use __constructor__ to remove this entry
 #include <signal.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -182,6 +187,9 @@ boolean_t sccp_prePBXLoad(void)
 	GLOB(general_threadpool) = sccp_threadpool_init(THREADPOOL_MIN_SIZE);
 
 	sccp_event_module_start();
+	sccp_channel_module_start();
+	sccp_msgstats_module_start();
+	sccp_capture_module_start();
 #if defined(CS_DEVSTATE_FEATURE)
 	sccp_devstate_module_start();
 #endif
@@ -191,6 +199,12 @@ boolean_t sccp_prePBXLoad(void)
 #ifdef CS_SCCP_CONFERENCE
 	sccp_conference_module_start();
 #endif
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_start();
+#endif
+	sccp_dialplan_module_start();
+	sccp_rtp_module_start();
+	sccp_calltrace_module_start();
 	sccp_event_subscribe(SCCP_EVENT_FEATURE_CHANGED, sccp_device_featureChangedDisplay, TRUE);
 	sccp_event_subscribe(SCCP_EVENT_FEATURE_CHANGED, sccp_util_featureStorageBackend, TRUE);
 
@@ -367,9 +381,18 @@ int sccp_preUnload(void)
 #ifdef CS_SCCP_CONFERENCE
 	sccp_conference_module_stop();
 #endif
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_stop();
+#endif
+	sccp_dialplan_module_stop();
+	sccp_rtp_module_stop();
+	sccp_calltrace_module_stop();
 	sccp_softkey_clear();
 	sccp_hint_module_stop();
+	sccp_capture_module_stop();
+	sccp_msgstats_module_stop();
 	sccp_event_module_stop();
+	sccp_channel_module_stop();
 	sccp_threadpool_destroy(GLOB(general_threadpool));
 	sccp_refcount_destroy();
 
@@ -458,48 +458,31 @@ const char *pbx_getformatname_multiple(char *buf, size_t size, struct ast_format
 static PBX_FRAME_TYPE *sccp_wrapper_asterisk113_rtp_read(PBX_CHANNEL_TYPE * ast)
 {
 	//AUTO_RELEASE(sccp_channel_t, c , NULL);									// not following the refcount rules... channel is already retained
-	sccp_channel_t *c = NULL;
-	PBX_FRAME_TYPE *frame = &ast_null_frame;
+	sccp_channel_t *c = CS_AST_CHANNEL_PVT(ast);								// not following the refcount rules... channel is already retained
+	PBX_RTP_TYPE *instance = NULL;
+	PBX_FRAME_TYPE *frame = NULL;
+	int fdno = 0;
 
-	if (!(c = CS_AST_CHANNEL_PVT(ast))) {									// not following the refcount rules... channel is already retained
+	if (dont_expect(!c)) {
 		pbx_log(LOG_ERROR, "SCCP: (rtp_read) no channel pvt\n");
-		goto EXIT_FUNC;
+		return &ast_null_frame;
 	}
 
-	if (!c->rtp.audio.instance) {
-		pbx_log(LOG_NOTICE, "SCCP: (rtp_read) no rtp stream yet. skip\n");
-		goto EXIT_FUNC;
+	fdno = ast_channel_fdno(ast);
+	if (dont_expect(!(instance = sccp_framepath_reader(&c->rtp.framepath, fdno)))) {			// precomputed by sccp_rtp, see sccp_framepath.h
+		if (fdno < 2) {
+			pbx_log(LOG_NOTICE, "SCCP: (rtp_read) no rtp stream yet. skip\n");
+		}
+		return &ast_null_frame;
 	}
+	frame = ast_rtp_instance_read(instance, fdno & 1);							/* odd fds are the RTCP Control Channels */
 
-	switch (ast_channel_fdno(ast)) {
-
-		case 0:
-			frame = ast_rtp_instance_read(c->rtp.audio.instance, 0);					/* RTP Audio */
-			break;
-		case 1:
-			frame = ast_rtp_instance_read(c->rtp.audio.instance, 1);					/* RTCP Control Channel */
-			break;
-#ifdef CS_SCCP_VIDEO
-		case 2:
-			frame = ast_rtp_instance_read(c->rtp.video.instance, 0);					/* RTP Video */
-			break;
-		case 3:
-			frame = ast_rtp_instance_read(c->rtp.video.instance, 1);					/* RTCP Control Channel for video */
-			break;
-#endif
-		default:
-			break;
-	}
 	//sccp_log((DEBUGCAT_CORE))(VERBOSE_PREFIX_3 "%s: read format: ast->fdno: %d, frametype: %d, %s(%d)\n", DEV_ID_LOG(c->device), ast_channel_fdno(ast), frame->frametype, pbx_getformatname(frame->subclass), frame->subclass);
-	if (frame->frametype == AST_FRAME_VOICE) {
 #ifdef CS_SCCP_CONFERENCE
-		if (c->conference && (!ast_format_cache_is_slinear(ast_channel_readformat(ast)))) {
-			ast_set_read_format(ast, ast_format_slin96);
-		}
-#endif
+	if (dont_expect(c->conference != NULL) && frame->frametype == AST_FRAME_VOICE && !ast_format_cache_is_slinear(ast_channel_readformat(ast))) {
+		ast_set_read_format(ast, ast_format_slin96);
 	}
-
-EXIT_FUNC:
+#endif
 	return frame;
 }
 
@@ -830,6 +813,11 @@ static int sccp_wrapper_asterisk113_rtp_write(PBX_CHANNEL_TYPE * ast, PBX_FRAME_
 		return -1;
 	}
 
+	/* fast path: regular voice frame, instance precomputed by sccp_rtp (see sccp_framepath.h) */
+	if (do_expect(frame->frametype == AST_FRAME_VOICE && frame->samples && c->rtp.framepath.write_audio)) {
+		return ast_rtp_instance_write(c->rtp.framepath.write_audio, frame);
+	}
+
 	switch (frame->frametype) {
 		case AST_FRAME_VOICE:
 			// checking for samples to transmit
@@ -841,8 +829,8 @@ static int sccp_wrapper_asterisk113_rtp_write(PBX_CHANNEL_TYPE * ast, PBX_FRAME_
 					sccp_log((DEBUGCAT_PBX | DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "%s: Asterisk prodded channel %s.\n", c->currentDeviceId, pbx_channel_name(ast));
 				}
 			}
-			if (c->rtp.audio.instance) {
-				res = ast_rtp_instance_write(c->rtp.audio.instance, frame);
+			if (c->rtp.framepath.write_audio) {
+				res = ast_rtp_instance_write(c->rtp.framepath.write_audio, frame);
 			}
 			break;
 		case AST_FRAME_IMAGE:
@@ -2133,27 +2121,33 @@ static int sccp_wrapper_asterisk113_callerid_presentation(PBX_CHANNEL_TYPE *pbx_
 	return CALLERID_PRESENTATION_FORBIDDEN;
 }
 
-static boolean_t sccp_wrapper_asterisk113_createRtpInstance(constDevicePtr d, constChannelPtr c, sccp_rtp_t *rtp)
+static PBX_RTP_TYPE *sccp_wrapper_asterisk113_newRtpInstance(const struct sockaddr_storage *bindaddr)
 {
 	struct ast_sockaddr sock = { {0,} };
-	uint32_t tos = 0, cos = 0;
-	
-	if (!c || !d) {
-		return FALSE;
-	}
-	memcpy(&sock.ss, &GLOB(bindaddr), sizeof(struct sockaddr_storage));
-	if (GLOB(bindaddr).ss_family == AF_INET6) {
+
+	memcpy(&sock.ss, bindaddr, sizeof(struct sockaddr_storage));
+	if (bindaddr->ss_family == AF_INET6) {
 		sock.ss.ss_family = AF_INET6;
 		sock.len = sizeof(struct sockaddr_in6);
 	} else {
 		sock.ss.ss_family = AF_INET;
 		sock.len = sizeof(struct sockaddr_in);
 	}
+	return ast_rtp_instance_new("asterisk", sched, &sock, NULL);
+}
 
-	if ((rtp->instance = ast_rtp_instance_new("asterisk", sched, &sock, NULL))) {
+static boolean_t sccp_wrapper_asterisk113_createRtpInstance(constDevicePtr d, constChannelPtr c, sccp_rtp_t *rtp)
+{
+	uint32_t tos = 0, cos = 0;
+	boolean_t pooled = rtp->instance ? TRUE : FALSE;							/* pre-warmed instance taken from the rtp pool */
+	
+	if (!c || !d) {
+		return FALSE;
+	}
+	if (pooled || (rtp->instance = sccp_wrapper_asterisk113_newRtpInstance(&GLOB(bindaddr)))) {
 		struct ast_sockaddr instance_addr = { {0,} };
 		ast_rtp_instance_get_local_address(rtp->instance, &instance_addr);
-		sccp_log(DEBUGCAT_RTP) (VERBOSE_PREFIX_3 "%s: rtp server instance created at %s\n", c->designator, ast_sockaddr_stringify(&instance_addr));
+		sccp_log(DEBUGCAT_RTP) (VERBOSE_PREFIX_3 "%s: rtp server instance %s at %s\n", c->designator, pooled ? "taken from pool" : "created", ast_sockaddr_stringify(&instance_addr));
 	} else {
 		return FALSE;
 	}
@@ -3179,6 +3173,7 @@ const PbxInterface iPbx = {
 	rtp_stop:			ast_rtp_instance_stop(rtp),
 	rtp_codec:			NULL,
 	rtp_create_instance:		sccp_wrapper_asterisk113_createRtpInstance,
+	rtp_instance_new:		sccp_wrapper_asterisk113_newRtpInstance,
 	rtp_get_payloadType:		sccp_wrapper_asterisk113_get_payloadType,
 	rtp_get_sampleRate:		sccp_wrapper_asterisk113_get_sampleRate,
 	rtp_bridgePeers:		NULL,
@@ -3318,6 +3313,7 @@ const PbxInterface iPbx = {
 	.rtp_getUs 			= sccp_wrapper_asterisk113_rtpGetUs,
 	.rtp_stop			= ast_rtp_instance_stop,
 	.rtp_create_instance		= sccp_wrapper_asterisk113_createRtpInstance,
+	.rtp_instance_new		= sccp_wrapper_asterisk113_newRtpInstance,
 	.rtp_get_payloadType 		= sccp_wrapper_asterisk113_get_payloadType,
 	.rtp_get_sampleRate 		= sccp_wrapper_asterisk113_get_sampleRate,
 	.rtp_destroy 			= sccp_wrapper_asterisk113_destroyRTP,
@@ -88,6 +88,7 @@ typedef struct _PbxInterface {
 	void (*const rtp_stop) (PBX_RTP_TYPE *rtp);
 	int (*const rtp_codec) (sccp_channel_t * channel);
 	boolean_t(*const rtp_create_instance) (constDevicePtr d, constChannelPtr c, sccp_rtp_t *rtp);
+	PBX_RTP_TYPE *(*const rtp_instance_new) (const struct sockaddr_storage *bindaddr);			/*!< optional: create an unconfigured rtp instance bound to bindaddr (used by the rtp instance pool) */
 	uint8_t(*const rtp_get_payloadType) (const struct sccp_rtp * rtp, skinny_codec_t codec);
 	int(*const rtp_get_sampleRate) (skinny_codec_t codec);
 	uint8_t(*const rtp_bridgePeers) (PBX_CHANNEL_TYPE * c0, PBX_CHANNEL_TYPE * c1, int flags, struct ast_frame ** fo, PBX_CHANNEL_TYPE ** rc, int timeoutms);
@@ -29,6 +29,8 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_indicate.h"
 #include "sccp_line.h"
 #include "sccp_featureParkingLot.h"
+#include "sccp_msgstats.h"
+#include "sccp_callquality.h"
 
 /*!
  * \remarks
@@ -244,8 +246,26 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 		pbx_log(LOG_ERROR, "SCCP: Device is required to handle this message %s(%x), but none is provided. Exiting sccp_handle_message\n", msgtype2str(mid), mid);
 		return -3;
 	}
+	if (device) {
+		switch (mid) {
+			case StimulusMessage:
+			case OffHookMessage:
+			case OnHookMessage:
+			case OffHookWithCgpnMessage:
+			case SoftKeyEventMessage:
+			case HeadsetStatusMessage:
+			case AccessoryStatusMessage:
+				sccp_device_shadow_clear(device);						/* phone may have changed lamps/speaker/prompt/softkeys locally */
+				break;
+			default:
+				break;
+		}
+	}
 	if (messageMap_cb->messageHandler_cb) {
+		struct timeval start = pbx_tvnow();
+
 		messageMap_cb->messageHandler_cb(s, device, msg);
+		sccp_msgstats_handled(mid, ast_tvdiff_us(pbx_tvnow(), start));
 	}
 
 	if (device && sccp_device_getRegistrationState(device) == SKINNY_DEVICE_RS_PROGRESS && mid == device->protocol->registrationFinishedMessageId) {
@@ -1077,7 +1097,7 @@ static btnlist *sccp_make_button_template(devicePtr d)
 						    && btn[i].type == SCCP_BUTTONTYPE_MULTI				/* we can set our feature */
 						    ) {
 #ifdef CS_DYNAMIC_SPEEDDIAL
-							if (d->inuseprotocolversion >= 15) {
+							if (sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_BLF_SPEEDDIAL)) {
 								btn[i].type = SKINNY_BUTTONTYPE_BLFSPEEDDIAL;
 								buttonconfig->instance = btn[i].instance = speeddialInstance++;
 							} else 
@@ -1119,7 +1139,7 @@ static btnlist *sccp_make_button_template(devicePtr d)
 								break;
 
 							case SCCP_FEATURE_MONITOR:
-								if (d->inuseprotocolversion > 15) {
+								if (sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES)) {
 									btn[i].type = SKINNY_BUTTONTYPE_MULTIBLINKFEATURE;
 								} else {
 									btn[i].type = SKINNY_BUTTONTYPE_FEATURE;
@@ -1127,7 +1147,7 @@ static btnlist *sccp_make_button_template(devicePtr d)
 								break;
 
 							case SCCP_FEATURE_MULTIBLINK:
-								if (d->inuseprotocolversion >= 15) {
+								if (sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_MULTIBLINK)) {
 									btn[i].type = SKINNY_BUTTONTYPE_MULTIBLINKFEATURE;
 								} else {
 									btn[i].type = SKINNY_BUTTONTYPE_FEATURE;
@@ -1137,7 +1157,7 @@ static btnlist *sccp_make_button_template(devicePtr d)
 							case SCCP_FEATURE_PARKINGLOT:
 #ifdef CS_SCCP_PARK
 								if (iParkingLot.attachObserver && iParkingLot.attachObserver(buttonconfig->button.feature.options, d, buttonconfig->instance)) {
-									if (d->inuseprotocolversion > 15) {
+									if (sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES)) {
 										btn[i].type = SKINNY_BUTTONTYPE_MULTIBLINKFEATURE;
 										buttonconfig->button.feature.status = 0x010000;
 									} else {
@@ -3142,6 +3162,7 @@ void handle_keypad_button(constSessionPtr s, devicePtr d, constMessagePtr msg_in
 		}
 
 		/* add digit to dialed number */
+		sccp_calltrace_mark(&channel->calltrace, SCCP_CALLTRACE_FIRSTDIGIT);
 		channel->dialedNumber[len++] = resp;
 		channel->dialedNumber[len] = '\0';
 		sccp_channel_schedule_digittimout(channel, channel->enbloc.digittimeout);
@@ -3379,6 +3400,7 @@ void handle_open_receive_channel_ack(constSessionPtr s, devicePtr d, constMessag
 			return;
 		}
 
+		sccp_calltrace_mark(&channel->calltrace, SCCP_CALLTRACE_ORC_ACK);
 		sccp_log((DEBUGCAT_RTP)) (VERBOSE_PREFIX_3 "%s: Starting Phone RTP/UDP Transmission (State: %s[%d])\n", d->id, sccp_channelstate2str(channel->state), channel->state);
 		sccp_channel_setDevice(channel, d);
 		if (channel->rtp.audio.instance) {
@@ -3831,6 +3853,13 @@ void handle_ConnectionStatistics(constSessionPtr s, devicePtr device, constMessa
 			       (int) call_stats[SCCP_CALLSTATISTIC_AVG].concealed_seconds, (int) call_stats[SCCP_CALLSTATISTIC_AVG].severely_concealed_seconds);
 		pbx_str_append(&output_buf, buffersize, "       ]\n");
 		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s", pbx_str_buffer(output_buf));
+
+		// update rolling call quality histograms (device / line / global), mos only if the phone sent quality stats for this call
+		float reported_mos = 0;
+		if (!sccp_strlen_zero(QualityStats)) {
+			reported_mos = call_stats[SCCP_CALLSTATISTIC_LAST].avg_opinion_score_listening_quality > 0 ? call_stats[SCCP_CALLSTATISTIC_LAST].avg_opinion_score_listening_quality : call_stats[SCCP_CALLSTATISTIC_LAST].opinion_score_listening_quality;
+		}
+		sccp_callquality_add(d, &call_stats[SCCP_CALLSTATISTIC_LAST], reported_mos);
 	}
 }
 
@@ -4016,7 +4045,7 @@ void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 	 */
 	sccp_speed_t k;
 
-	if ((capabilities == 1 && d->inuseprotocolversion >= 15)) {
+	if ((capabilities == 1 && sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_BLF_SPEEDDIAL))) {
 		sccp_dev_speed_find_byindex(d, featureIndex, TRUE, &k);
 
 		if (k.valid) {
@@ -4059,7 +4088,7 @@ void handle_services_stat_req(constSessionPtr s, devicePtr d, constMessagePtr ms
 
 	if ((config = sccp_dev_serviceURL_find_byindex(d, urlIndex))) {
 		/* \todo move ServiceURLStatMessage impl to sccp_protocol.c */
-		if (d->inuseprotocolversion < 7) {
+		if (!sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_SERVICEURL_DYNAMIC)) {
 			REQ(msg_out, ServiceURLStatMessage);
 			msg_out->data.ServiceURLStatMessage.lel_serviceURLIndex = htolel(urlIndex);
 			sccp_copy_string(msg_out->data.ServiceURLStatMessage.URL, config->button.service.url, sccp_strlen(config->button.service.url) + 1);
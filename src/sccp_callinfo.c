@@ -45,8 +45,13 @@ enum callinfo_types {
 	VOICEMAILBOX,
 };
 
+#define SCCP_CALLINFO_DIRTY_ALL 0xffffffff
+#define SCCP_CALLINFO_DIRTY(_key) (1U << (_key))
+
 /*!
  * \brief SCCP CallInfo Structure
+ * \note content only holds fixed size fields (no pointers), so that it can be copied/cleared as a whole. The version and the encoded
+ * messages live outside of content, they describe this instance and are never copied.
  */
 struct sccp_callinfo {
 	pbx_rwlock_t lock;
@@ -55,9 +60,14 @@ struct sccp_callinfo {
 		uint32_t originalCdpnRedirectReason;								/*!< Original Called Party Redirect Reason */
 		uint32_t lastRedirectingReason;									/*!< Last Redirecting Reason */
 		sccp_callerid_presentation_t presentation;							/*!< Should this callerinfo be shown (privacy) */
-		boolean_t changed;										/*! Changes since last send */
+		uint32_t dirty;											/*!< Keys changed since last send (bitmask of SCCP_CALLINFO_DIRTY(key)) */
 		uint8_t callInstance;
 	} content;
+	uint32_t version;											/*!< Incremented on every change of content */
+	struct {
+		uint32_t version;										/*!< Version of the content msg was encoded from */
+		sccp_msg_t *msg;										/*!< Encoded message (per call fields left zero) */
+	} encoded[SCCP_CALLINFO_ENCODING_SENTINEL];								/*!< Encoded Message Cache */
 };														/*!< SCCP CallInfo Structure */
 
 #define sccp_callinfo_wrlock(x) pbx_rwlock_wrlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
@@ -100,18 +110,34 @@ static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 
 	/* by default we allow callerid presentation */
 	ci->content.presentation = CALLERID_PRESENTATION_ALLOWED;
-	ci->content.changed = TRUE;
+	ci->content.dirty = SCCP_CALLINFO_DIRTY_ALL;
 	ci->content.callInstance = callInstance;
+	ci->version = 1;
 
 	sccp_log(DEBUGCAT_CALLINFO) (VERBOSE_PREFIX_1 "SCCP: callinfo constructor: %p\n", ci);
 	return ci;
 }
 
+/*!
+ * \brief Drop all encoded messages (callinfo needs to be locked, or not shared anymore)
+ */
+static void callinfo_freeEncoded(sccp_callinfo_t * const ci)
+{
+	uint8_t encoding = 0;
+
+	for (encoding = 0; encoding < SCCP_CALLINFO_ENCODING_SENTINEL; encoding++) {
+		if (ci->encoded[encoding].msg) {
+			sccp_free(ci->encoded[encoding].msg);
+		}
+	}
+}
+
 static sccp_callinfo_t * const callinfo_Destructor(sccp_callinfo_t * * const ci)
 {
 	pbx_assert(ci != NULL && *ci != NULL);
 	//sccp_callinfo_wrlock(ci);
 	//sccp_callinfo_unlock(ci);
+	callinfo_freeEncoded(*ci);
 	pbx_rwlock_destroy(&(*ci)->lock);
 	sccp_free(*ci);
 	*ci = NULL;
@@ -119,6 +145,20 @@ static sccp_callinfo_t * const callinfo_Destructor(sccp_callinfo_t * * const ci)
 	return *ci;
 }
 
+/*!
+ * \brief Clear all fields, so that a pooled callinfo can be reused for a new call
+ */
+static void callinfo_Reset(sccp_callinfo_t * const ci, uint8_t callInstance)
+{
+	sccp_callinfo_wrlock(ci);
+	memset(&ci->content, 0, sizeof(struct ci_content));
+	ci->content.presentation = CALLERID_PRESENTATION_ALLOWED;
+	ci->content.dirty = SCCP_CALLINFO_DIRTY_ALL;
+	ci->content.callInstance = callInstance;
+	ci->version++;												/* cached encodings become stale */
+	sccp_callinfo_unlock(ci);
+}
+
 static sccp_callinfo_t * callinfo_CopyConstructor(const sccp_callinfo_t * const src_ci)
 {
 	/* observing locking order. not locking both callinfo objects at the same time, using a tmp as go between */
@@ -129,7 +169,7 @@ static sccp_callinfo_t * callinfo_CopyConstructor(const sccp_callinfo_t * const
 		}
 		sccp_callinfo_rdlock(src_ci);
 		memcpy(&tmp_ci->content, &src_ci->content, sizeof(struct ci_content));
-		tmp_ci->content.changed = TRUE;
+		tmp_ci->content.dirty = SCCP_CALLINFO_DIRTY_ALL;
 		sccp_callinfo_unlock(src_ci);
 
 		return tmp_ci;
@@ -151,7 +191,8 @@ static boolean_t callinfo_Copy(const sccp_callinfo_t * const src_ci, sccp_callin
 
 		sccp_callinfo_wrlock(dst_ci);
 		memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-		dst_ci->content.changed = TRUE;
+		dst_ci->content.dirty = SCCP_CALLINFO_DIRTY_ALL;
+		dst_ci->version++;
 		sccp_callinfo_unlock(dst_ci);
 
 		return TRUE;
@@ -167,6 +208,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 	pbx_assert(ci != NULL);
 
 	sccp_callinfo_key_t curkey = SCCP_CALLINFO_NONE;
+	uint32_t dirty = 0;
 	int changes = 0;
 
 	/*
@@ -189,6 +231,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 				uint new_value = va_arg(ap, uint);
 				if (new_value != ci->content.originalCdpnRedirectReason) {
 					ci->content.originalCdpnRedirectReason = new_value;
+					dirty |= SCCP_CALLINFO_DIRTY(curkey);
 					changes++;
 				}
 			}
@@ -198,6 +241,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 				uint new_value = va_arg(ap, uint);
 				if (new_value != ci->content.lastRedirectingReason) {
 					ci->content.lastRedirectingReason = new_value;
+					dirty |= SCCP_CALLINFO_DIRTY(curkey);
 					changes++;
 				}
 			}
@@ -207,6 +251,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 				sccp_callerid_presentation_t new_value = va_arg(ap, sccp_callerid_presentation_t);
 				if (new_value != ci->content.presentation) {
 					ci->content.presentation = new_value;
+					dirty |= SCCP_CALLINFO_DIRTY(curkey);
 					changes++;
 				}
 			}
@@ -240,6 +285,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 					}
 					if (!sccp_strequals(dstPtr, new_value)) {
 						sccp_copy_string(dstPtr, new_value, size);
+						dirty |= SCCP_CALLINFO_DIRTY(curkey);
 						changes++;
 						if (validPtr) {
 							*validPtr = sccp_strlen_zero(new_value) ? 0 : 1;
@@ -254,8 +300,9 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 	}
 
 	va_end(ap);
-	if (changes) {
-		ci->content.changed = TRUE;
+	if (dirty) {
+		ci->content.dirty |= dirty;
+		ci->version++;
 	}
 	sccp_callinfo_unlock(ci);
 
@@ -401,7 +448,8 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 	
 	sccp_callinfo_wrlock(dst_ci);
 	memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-	dst_ci->content.changed = TRUE;
+	dst_ci->content.dirty = SCCP_CALLINFO_DIRTY_ALL;
+	dst_ci->version++;
 	sccp_callinfo_unlock(dst_ci);
 	
 	if ((GLOB(debug) & (DEBUGCAT_CALLINFO)) != 0) {
@@ -518,7 +566,7 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 
 static int callinfo_Send(sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device, boolean_t force)
 {
-	if (ci->content.changed || force) {
+	if (ci->content.dirty || force) {
 		/* dependency on sccp_device.h should be fixed */
 		if (device && device->protocol && device->protocol->sendCallInfo) {
 			// using for to set the callsecuritystate is a temporary solution
@@ -526,7 +574,7 @@ static int callinfo_Send(sccp_callinfo_t * const ci, const uint32_t callid, cons
 			// when indicating connected it should change to SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
 			device->protocol->sendCallInfo(ci, callid, calltype, lineInstance, ci->content.callInstance, force ? SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED : SKINNY_CALLSECURITYSTATE_UNKNOWN, device);
 			sccp_callinfo_wrlock(ci);
-			ci->content.changed = FALSE;
+			ci->content.dirty = 0;
 			sccp_callinfo_unlock(ci);
 			return 1;
 		}
@@ -537,6 +585,72 @@ static int callinfo_Send(sccp_callinfo_t * const ci, const uint32_t callid, cons
 	return 0;
 }
 
+/*!
+ * \brief Send the callinfo to a device which does not own the call (shared line), leaves the dirty state of the callinfo alone
+ * \note Replaces sending a private copy of the callinfo, the encoded message is shared by all remote devices using the same encoding
+ */
+static int callinfo_SendRemote(const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device)
+{
+	if (device && device->protocol && device->protocol->sendCallInfo) {
+		device->protocol->sendCallInfo(ci, callid, calltype, lineInstance, ci->content.callInstance, SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED, device);
+		return 1;
+	}
+	return 0;
+}
+
+static sccp_msg_t *callinfo_GetEncoded(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, sccp_callinfo_encoder_t encoder, sccp_msg_t * const scratch)
+{
+	pbx_assert(ci != NULL && encoding < SCCP_CALLINFO_ENCODING_SENTINEL && encoder != NULL && scratch != NULL);
+	sccp_callinfo_t * const cache = (sccp_callinfo_t * const) ci;						/* discard const, the encoded messages are not part of the content */
+	sccp_msg_t *msg = NULL;
+	uint32_t version = 0;
+	size_t len = 0;
+
+	sccp_callinfo_rdlock(ci);
+	version = ci->version;
+	if (ci->encoded[encoding].msg && ci->encoded[encoding].version == version) {
+		len = letohl(ci->encoded[encoding].msg->header.length) + 8;
+		memcpy(scratch, ci->encoded[encoding].msg, len);
+		sccp_callinfo_unlock(ci);
+		return scratch;
+	}
+	sccp_callinfo_unlock(ci);
+
+	/* (re)encode outside of the lock, the encoder uses iCallInfo.Getter */
+	if (!(msg = encoder(ci))) {
+		return NULL;
+	}
+	len = letohl(msg->header.length) + 8;
+	if (len > SCCP_MAX_PACKET) {
+		pbx_log(LOG_ERROR, "%p: (sccp_callinfo_getEncoded) encoded message too long (%d)\n", ci, (int) len);
+		sccp_free(msg);
+		return NULL;
+	}
+	memcpy(scratch, msg, len);
+	sccp_callinfo_wrlock(cache);
+	if (cache->version == version) {									/* only keep it when nothing changed while encoding */
+		sccp_msg_t *stale = cache->encoded[encoding].msg;
+		cache->encoded[encoding].msg = msg;								/* the encoded message itself becomes the cached copy */
+		cache->encoded[encoding].version = version;
+		msg = stale;
+	}
+	sccp_callinfo_unlock(cache);
+	if (msg) {
+		sccp_free(msg);
+	}
+	sccp_log(DEBUGCAT_CALLINFO) (VERBOSE_PREFIX_3 "%p: (sccp_callinfo_getEncoded) encoded version:%d, encoding:%d, len:%d\n", ci, version, encoding, (int) len);
+	return scratch;
+}
+
+static uint32_t callinfo_GetVersion(const sccp_callinfo_t * const ci)
+{
+	uint32_t version = 0;
+
+	sccp_callinfo_rdlock(ci);
+	version = ci->version;
+	sccp_callinfo_unlock(ci);
+	return version;
+}
 
 static int callinfo_SetCalledParty(sccp_callinfo_t * const ci, const char name[StationMaxNameSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize])
 {
@@ -601,7 +715,8 @@ static gcc_inline boolean_t __GetCallInfoStr(const sccp_callinfo_t * const ci, p
 	if (ci->content.entries[HUNT_PILOT].NumberValid) {
 		pbx_str_append(buf, 0, " - huntPilot: %s <%s>, valid\n", ci->content.entries[HUNT_PILOT].Name, ci->content.entries[HUNT_PILOT].Number);
 	}
-	pbx_str_append(buf, 0, " - presentation: %s\n\n", sccp_callerid_presentation2str(ci->content.presentation));
+	pbx_str_append(buf, 0, " - presentation: %s\n", sccp_callerid_presentation2str(ci->content.presentation));
+	pbx_str_append(buf, 0, " - version: %d, dirty: 0x%x\n\n", ci->version, ci->content.dirty);
 	sccp_callinfo_unlock(ci);
 	return TRUE;
 }
@@ -619,6 +734,7 @@ static void callinfo_Print2log(const sccp_callinfo_t * const ci, const char *con
 const CallInfoInterface iCallInfo = {
 	callinfo_Constructor,
         callinfo_Destructor,
+        callinfo_Reset,
         callinfo_CopyConstructor,
 #if UNUSEDCODE // 2015-11-01
 	callinfo_Copy,
@@ -626,6 +742,9 @@ const CallInfoInterface iCallInfo = {
 	callinfo_Setter,
 	callinfo_CopyByKey,
 	callinfo_Send,
+	callinfo_SendRemote,
+	callinfo_GetEncoded,
+	callinfo_GetVersion,
 	callinfo_Getter,
 	callinfo_SetCalledParty,
 	callinfo_SetCallingParty,
@@ -637,6 +756,19 @@ const CallInfoInterface iCallInfo = {
 
 #if CS_TEST_FRAMEWORK
 #include <asterisk/test.h>
+static int callinfo_test_encoded = 0;
+static sccp_msg_t *callinfo_test_encoder(const sccp_callinfo_t * const ci)
+{
+	sccp_msg_t *msg = NULL;
+
+	callinfo_test_encoded++;
+	REQ(msg, CallInfoMessage);
+	if (msg) {
+		iCallInfo.Getter(ci, SCCP_CALLINFO_CALLEDPARTY_NAME, &msg->data.CallInfoMessage.calledPartyName, SCCP_CALLINFO_KEY_SENTINEL);
+	}
+	return msg;
+}
+
 AST_TEST_DEFINE(sccp_callinfo_tests)
 {
 	switch(cmd) {
@@ -768,6 +900,25 @@ AST_TEST_DEFINE(sccp_callinfo_tests)
 	pbx_test_validate(test, reason == 0);
 	citest2 = iCallInfo.Destructor(&citest2);
 	pbx_test_validate(test, citest2 == NULL);
+
+	pbx_test_status_update(test, "Callinfo Encoded Message Cache...\n");
+	uint32_t version = iCallInfo.GetVersion(citest);
+	callinfo_test_encoded = 0;
+	sccp_msg_t *msg1 = sccp_calloc(1, SCCP_MAX_PACKET);
+	sccp_msg_t *msg2 = sccp_calloc(1, SCCP_MAX_PACKET);
+	pbx_test_validate(test, msg1 != NULL && msg2 != NULL);
+	pbx_test_validate(test, iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V3, callinfo_test_encoder, msg1) == msg1);
+	pbx_test_validate(test, iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V3, callinfo_test_encoder, msg2) == msg2);
+	pbx_test_validate(test, callinfo_test_encoded == 1);
+	pbx_test_validate(test, !memcmp(msg1, msg2, letohl(msg1->header.length) + 8));
+	changes = iCallInfo.Setter(citest, SCCP_CALLINFO_CALLEDPARTY_NAME, "name", SCCP_CALLINFO_KEY_SENTINEL);
+	pbx_test_validate(test, changes == 0 && iCallInfo.GetVersion(citest) == version);
+	changes = iCallInfo.Setter(citest, SCCP_CALLINFO_CALLEDPARTY_NAME, "newname", SCCP_CALLINFO_KEY_SENTINEL);
+	pbx_test_validate(test, changes == 1 && iCallInfo.GetVersion(citest) == version + 1);
+	pbx_test_validate(test, iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V3, callinfo_test_encoder, msg2) == msg2 && callinfo_test_encoded == 2);
+	pbx_test_validate(test, !strcmp(msg2->data.CallInfoMessage.calledPartyName, "newname"));
+	sccp_free(msg1);
+	sccp_free(msg2);
 	
 	pbx_test_status_update(test, "Callinfo Test Destructor...\n");
 	citest = iCallInfo.Destructor(&citest);
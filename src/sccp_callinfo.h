@@ -23,10 +23,27 @@ __BEGIN_C_EXTERN__
 /* forward declaration */
 struct sccp_callinfo;
 
+/*!
+ * \brief Wire encodings of the callinfo, one cached message per encoding
+ */
+typedef enum {
+	SCCP_CALLINFO_ENCODING_V3,										/*!< CallInfoMessage (fixed size) */
+	SCCP_CALLINFO_ENCODING_V7,										/*!< CallInfoDynamicMessage, 12 strings */
+	SCCP_CALLINFO_ENCODING_V16,										/*!< CallInfoDynamicMessage, 15 strings */
+	SCCP_CALLINFO_ENCODING_SENTINEL,
+} sccp_callinfo_encoding_t;
+
+/*!
+ * \brief Protocol specific callinfo encoder, only fills in the fields taken from the callinfo (per call fields are left zero)
+ * \returns allocated message (owned by the caller), NULL on failure
+ */
+typedef sccp_msg_t *(*sccp_callinfo_encoder_t)(const sccp_callinfo_t * const ci);
+
 /* Definition of the functions associated with this type. */
 typedef struct tagCallInfo {
 	sccp_callinfo_t * const (*Constructor)(uint8_t callInstance);
 	sccp_callinfo_t * const (*Destructor)(sccp_callinfo_t * * const ci);
+	void (*Reset)(sccp_callinfo_t * const ci, uint8_t callInstance);
 	sccp_callinfo_t * (*CopyConstructor)(const sccp_callinfo_t * const src_ci);
 	
 	#if UNUSEDCODE // 2015-11-01
@@ -45,6 +62,20 @@ typedef struct tagCallInfo {
 	 * \brief send callinfo to device
 	 */
 	int (*Send)(sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device, boolean_t force);
+	/*
+	 * \brief always send callinfo to a (remote) device, without clearing the dirty state of the callinfo (no copy of the callinfo needed)
+	 */
+	int (*SendRemote)(const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device);
+	/*
+	 * \brief get the encoded message for this encoding, the encoder is only called when a field changed since the message was cached
+	 * \param scratch buffer of SCCP_MAX_PACKET bytes the cached message is copied into (for example per thread, send it using sccp_dev_sendStatic)
+	 * \returns scratch, NULL on failure
+	 */
+	sccp_msg_t *(*GetEncoded)(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, sccp_callinfo_encoder_t encoder, sccp_msg_t * const scratch);
+	/*
+	 * \brief version of the callinfo, incremented on every change
+	 */
+	uint32_t (*GetVersion)(const sccp_callinfo_t * const ci);
 
 	/*
 	 * \brief callinfo getter with variable number of arguments, destination parameter needs to be prodided by reference
@@ -0,0 +1,474 @@
+/*!
+ * \file        sccp_callquality.c
+ * \brief       SCCP Call Quality Statistics
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Aggregate the connection statistics phones report at the end of each call (jitter, loss, mos)
+ *              When to use:    Fed by handle_ConnectionStatistics, queried by 'sccp show callquality' / SCCPShowCallQuality
+ *              Relations:      Statistics are kept per device (sccp_device_t), per line (sccp_line_t) and globally
+ */
+
+/*!
+ * \section sccp_callquality Call Quality Statistics
+ *
+ * At the end of every call the phone is asked for its connection statistics (sccp_channel_StatisticsRequest). The response carries the
+ * packet counters, jitter and latency of the call and, on newer phones, the listening quality mos. Phones which do not report a mos get
+ * one estimated from latency, jitter and loss (simplified ITU-T G.107 e-model, assuming G.711 with packet loss concealment).
+ *
+ * Every device, every line and the global statistics hold a rolling window of SCCP_CALLQUALITY_SLOTS periods of
+ * SCCP_CALLQUALITY_SLOT_SECONDS. Each period keeps the number of calls, the sum and a fixed bucket histogram per metric, so memory use
+ * does not grow with the number of calls. A period is recycled the first time a call ends after it has rolled out of the window.
+ *
+ * By the time the response arrives the channel has usually been destroyed, so the line the call was on is remembered per device
+ * when the statistics are requested (SCCP_CALLQUALITY_PENDING outstanding requests per device).
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_callquality.h"
+#include "sccp_channel.h"
+#include "sccp_device.h"
+#include "sccp_line.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_CALLQUALITY_MOS_POOR 310										/* mos below 3.1: most users dissatisfied */
+
+/*!
+ * \brief Call Quality Metric Definition
+ * \note bounds are the exclusive upper bounds of the buckets, the last bucket is open ended
+ */
+static const struct sccp_callquality_metric {
+	const char *const name;
+	const char *const unit;
+	const uint32_t divisor;
+	const boolean_t higher_is_better;
+	const uint32_t bounds[SCCP_CALLQUALITY_BUCKETS - 1];
+	const char *const labels[SCCP_CALLQUALITY_BUCKETS];
+} callquality_metrics[SCCP_CALLQUALITY_SENTINEL] = {
+	/* *INDENT-OFF* */
+	[SCCP_CALLQUALITY_JITTER] = {"Jitter", "ms", 1, FALSE, {2, 5, 10, 20, 30, 50, 100}, {"<2", "<5", "<10", "<20", "<30", "<50", "<100", ">=100"}},
+	[SCCP_CALLQUALITY_LOSS] = {"Loss", "%", 100, FALSE, {1, 50, 100, 200, 300, 500, 1000}, {"0", "<0.5", "<1", "<2", "<3", "<5", "<10", ">=10"}},
+	[SCCP_CALLQUALITY_MOS] = {"MOS", "", 100, TRUE, {200, 250, SCCP_CALLQUALITY_MOS_POOR, 360, 380, 400, 420}, {"<2.0", "<2.5", "<3.1", "<3.6", "<3.8", "<4.0", "<4.2", ">=4.2"}},
+	/* *INDENT-ON* */
+};
+
+AST_MUTEX_DEFINE_STATIC(callquality_lock);									/* protects all sccp_callquality_t's and the pending requests */
+static sccp_callquality_t callquality_global;
+
+/*!
+ * \brief Preformatted Summary of a Rolling Window (for the cli tables)
+ */
+typedef struct {
+	char avg[SCCP_CALLQUALITY_SENTINEL][16];
+	const char *worst[SCCP_CALLQUALITY_SENTINEL];
+	uint32_t poor;
+} sccp_callquality_row_t;
+
+/* ========================================================================================================================= Private */
+static gcc_inline uint32_t callquality_period(void)
+{
+	return (uint32_t) (time(0) / SCCP_CALLQUALITY_SLOT_SECONDS);
+}
+
+static gcc_inline uint callquality_bucket(sccp_callquality_metric_t metric, uint32_t value)
+{
+	uint bucket = 0;
+
+	while (bucket < SCCP_CALLQUALITY_BUCKETS - 1 && value >= callquality_metrics[metric].bounds[bucket]) {
+		bucket++;
+	}
+	return bucket;
+}
+
+/*!
+ * \brief Estimate the listening quality mos of a call (simplified ITU-T G.107 e-model, G.711 with packet loss concealment)
+ * \param latency_ms round trip delay reported by the phone
+ * \param jitter_ms max jitter reported by the phone
+ * \param loss packet loss in 0.01%
+ * \return mos * 100
+ */
+static uint32_t callquality_estimate_mos(uint32_t latency_ms, uint32_t jitter_ms, uint32_t loss)
+{
+	double delay = latency_ms / 2.0 + jitter_ms * 2.0 + 10.0;						/* one way: half the round trip, jitter buffer, packetization */
+	double ppl = loss / 100.0;
+	double r = 93.2;
+
+	r -= 0.024 * delay;
+	if (delay > 177.3) {
+		r -= 0.11 * (delay - 177.3);
+	}
+	r -= 95.0 * ppl / (ppl + 25.1);										/* Ie,eff with Ie = 0, Bpl = 25.1 */
+	if (r <= 0) {
+		return 100;
+	}
+	if (r >= 100) {
+		return 450;
+	}
+	return (uint32_t) ((1 + 0.035 * r + 0.000007 * r * (r - 60) * (100 - r)) * 100 + 0.5);
+}
+
+/*!
+ * \brief Add a call to a rolling window
+ * \note needs to be called with callquality_lock held
+ */
+static void callquality_record(sccp_callquality_t * cq, uint32_t period, const uint32_t value[SCCP_CALLQUALITY_SENTINEL])
+{
+	sccp_callquality_slot_t *slot = &cq->slot[period % SCCP_CALLQUALITY_SLOTS];
+	uint metric = 0;
+
+	if (slot->period != period) {
+		memset(slot, 0, sizeof(sccp_callquality_slot_t));
+		slot->period = period;
+	}
+	slot->calls++;
+	for (metric = 0; metric < SCCP_CALLQUALITY_SENTINEL; metric++) {
+		slot->total[metric] += value[metric];
+		slot->histogram[metric][callquality_bucket(metric, value[metric])]++;
+	}
+}
+
+/*!
+ * \brief Sum up the periods of a rolling window which are still inside the window
+ */
+static void callquality_collect(const sccp_callquality_t * cq, uint32_t period, sccp_callquality_slot_t * sum)
+{
+	const sccp_callquality_slot_t *slot = NULL;
+	uint idx = 0, metric = 0, bucket = 0;
+
+	memset(sum, 0, sizeof(sccp_callquality_slot_t));
+	sum->period = period;
+	pbx_mutex_lock(&callquality_lock);
+	for (idx = 0; idx < SCCP_CALLQUALITY_SLOTS; idx++) {
+		slot = &cq->slot[idx];
+		if (!slot->calls || period - slot->period >= SCCP_CALLQUALITY_SLOTS) {
+			continue;
+		}
+		sum->calls += slot->calls;
+		for (metric = 0; metric < SCCP_CALLQUALITY_SENTINEL; metric++) {
+			sum->total[metric] += slot->total[metric];
+			for (bucket = 0; bucket < SCCP_CALLQUALITY_BUCKETS; bucket++) {
+				sum->histogram[metric][bucket] += slot->histogram[metric][bucket];
+			}
+		}
+	}
+	pbx_mutex_unlock(&callquality_lock);
+}
+
+/*!
+ * \brief Return the bucket the worst 10% of the calls reach (highest jitter/loss, lowest mos)
+ */
+static uint callquality_worst10(const sccp_callquality_slot_t * sum, sccp_callquality_metric_t metric)
+{
+	uint32_t wanted = (sum->calls + 9) / 10;
+	uint32_t seen = 0;
+	uint idx = 0, bucket = 0;
+
+	for (idx = 0; idx < SCCP_CALLQUALITY_BUCKETS; idx++) {
+		bucket = callquality_metrics[metric].higher_is_better ? idx : SCCP_CALLQUALITY_BUCKETS - 1 - idx;
+		seen += sum->histogram[metric][bucket];
+		if (seen >= wanted) {
+			break;
+		}
+	}
+	return bucket;
+}
+
+static void callquality_row(const sccp_callquality_slot_t * sum, sccp_callquality_row_t * row)
+{
+	uint metric = 0, bucket = 0;
+
+	row->poor = 0;
+	for (metric = 0; metric < SCCP_CALLQUALITY_SENTINEL; metric++) {
+		if (sum->calls) {
+			snprintf(row->avg[metric], sizeof(row->avg[metric]), "%.2f", (double) sum->total[metric] / sum->calls / callquality_metrics[metric].divisor);
+			row->worst[metric] = callquality_metrics[metric].labels[callquality_worst10(sum, metric)];
+		} else {
+			sccp_copy_string(row->avg[metric], "-", sizeof(row->avg[metric]));
+			row->worst[metric] = "-";
+		}
+	}
+	for (bucket = 0; bucket < SCCP_CALLQUALITY_BUCKETS - 1 && callquality_metrics[SCCP_CALLQUALITY_MOS].bounds[bucket] <= SCCP_CALLQUALITY_MOS_POOR; bucket++) {
+		row->poor += sum->histogram[SCCP_CALLQUALITY_MOS][bucket];
+	}
+}
+
+/*!
+ * \brief Print the non empty buckets of a histogram as "<bucket>:<calls>" pairs
+ */
+static void callquality_histogram2str(const sccp_callquality_slot_t * sum, sccp_callquality_metric_t metric, char *buf, size_t size)
+{
+	uint bucket = 0;
+	size_t len = 0;
+
+	buf[0] = '\0';
+	for (bucket = 0; bucket < SCCP_CALLQUALITY_BUCKETS && len < size; bucket++) {
+		if (sum->histogram[metric][bucket]) {
+			len += snprintf(buf + len, size - len, "%s%s:%u", len ? " " : "", callquality_metrics[metric].labels[bucket], sum->histogram[metric][bucket]);
+		}
+	}
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Remember which line a statistics request belongs to
+ * \note called when the connection statistics are requested at the end of a call
+ */
+void sccp_callquality_expect(devicePtr d, constChannelPtr channel)
+{
+	sccp_callquality_pending_t *pending = NULL;
+	uint idx = 0;
+
+	if (!channel->line) {
+		return;
+	}
+	pbx_mutex_lock(&callquality_lock);
+	for (idx = 0; idx < SCCP_CALLQUALITY_PENDING; idx++) {
+		if (!d->callquality_pending[idx].callid || d->callquality_pending[idx].callid == channel->callid) {
+			pending = &d->callquality_pending[idx];
+			break;
+		}
+	}
+	if (!pending) {
+		pending = &d->callquality_pending[channel->callid % SCCP_CALLQUALITY_PENDING];			/* response(s) never came, reuse */
+	}
+	pending->callid = channel->callid;
+	sccp_copy_string(pending->linename, channel->line->name, sizeof(pending->linename));
+	pbx_mutex_unlock(&callquality_lock);
+}
+
+/*!
+ * \brief Add the connection statistics of a call to the device, line and global statistics
+ * \param d Device which sent the statistics
+ * \param stats Parsed statistics of the last call (d->call_statistics[SCCP_CALLSTATISTIC_LAST])
+ * \param reported_mos Listening quality mos reported by the phone (0 = not reported, will be estimated)
+ */
+void sccp_callquality_add(devicePtr d, const sccp_call_statistics_t * stats, float reported_mos)
+{
+	uint32_t value[SCCP_CALLQUALITY_SENTINEL] = { 0 };
+	uint32_t period = callquality_period();
+	uint32_t expected = stats->packets_received + stats->packets_lost;
+	char linename[StationMaxNameSize] = "";
+	uint idx = 0;
+
+	if (!expected && !stats->packets_sent) {
+		return;												/* call without media */
+	}
+	value[SCCP_CALLQUALITY_JITTER] = stats->jitter;
+	value[SCCP_CALLQUALITY_LOSS] = expected ? (uint32_t) ((uint64_t) stats->packets_lost * 10000 / expected) : 0;
+	if (reported_mos > 0 && reported_mos <= 5) {
+		value[SCCP_CALLQUALITY_MOS] = (uint32_t) (reported_mos * 100 + 0.5);
+	} else {
+		value[SCCP_CALLQUALITY_MOS] = callquality_estimate_mos(stats->latency, stats->jitter, value[SCCP_CALLQUALITY_LOSS]);
+	}
+
+	pbx_mutex_lock(&callquality_lock);
+	for (idx = 0; idx < SCCP_CALLQUALITY_PENDING; idx++) {
+		if (stats->num && d->callquality_pending[idx].callid == stats->num) {
+			sccp_copy_string(linename, d->callquality_pending[idx].linename, sizeof(linename));
+			memset(&d->callquality_pending[idx], 0, sizeof(sccp_callquality_pending_t));
+			break;
+		}
+	}
+	pbx_mutex_unlock(&callquality_lock);
+	if (sccp_strlen_zero(linename) && stats->num) {
+		AUTO_RELEASE(sccp_channel_t, c , sccp_channel_find_byid(stats->num));
+		if (c && c->line) {
+			sccp_copy_string(linename, c->line->name, sizeof(linename));
+		}
+	}
+	AUTO_RELEASE(sccp_line_t, l , !sccp_strlen_zero(linename) ? sccp_line_find_byname(linename, FALSE) : NULL);
+
+	pbx_mutex_lock(&callquality_lock);
+	callquality_record(&callquality_global, period, value);
+	callquality_record(&d->callquality, period, value);
+	if (l) {
+		callquality_record(&l->callquality, period, value);
+	}
+	pbx_mutex_unlock(&callquality_lock);
+
+	sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: (callquality) call %u on line %s: jitter %ums, loss %u.%02u%%, mos %u.%02u (%s)\n", d->id, stats->num, l ? l->name : "<unknown>",
+		value[SCCP_CALLQUALITY_JITTER], value[SCCP_CALLQUALITY_LOSS] / 100, value[SCCP_CALLQUALITY_LOSS] % 100, value[SCCP_CALLQUALITY_MOS] / 100, value[SCCP_CALLQUALITY_MOS] % 100, (reported_mos > 0 && reported_mos <= 5) ? "reported" : "estimated");
+}
+
+/* ========================================================================================================================= CLI */
+static int callquality_show_detail(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, const char *what, const sccp_callquality_t * cq)
+{
+	int local_line_total = 0;
+	sccp_callquality_slot_t sum;
+	sccp_callquality_row_t row;
+	char histogram[SCCP_CALLQUALITY_BUCKETS * 20] = "";
+	uint metric = 0;
+
+	callquality_collect(cq, callquality_period(), &sum);
+	callquality_row(&sum, &row);
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\nCall quality of %s over the last %d hours: %u calls, %u with mos below %.1f\n", what, SCCP_CALLQUALITY_SLOTS * SCCP_CALLQUALITY_SLOT_SECONDS / 3600, sum.calls, row.poor, SCCP_CALLQUALITY_MOS_POOR / 100.0);
+		CLI_AMI_OUTPUT(fd, s, "Worst10: bucket reached by the worst 10%% of the calls, histogram as <bucket>:<calls>\n");
+	}
+#define CLI_AMI_TABLE_NAME CallQuality
+#define CLI_AMI_TABLE_PER_ENTRY_NAME CallQualityMetric
+#define CLI_AMI_TABLE_ITERATOR for(metric = 0; metric < SCCP_CALLQUALITY_SENTINEL; metric++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		callquality_histogram2str(&sum, metric, histogram, sizeof(histogram));								\
+
+#define CLI_AMI_TABLE_AFTER_ITERATION
+
+#define CLI_AMI_TABLE_FIELDS 															\
+		CLI_AMI_TABLE_FIELD(Metric,		"-8.8",		s,	8,	callquality_metrics[metric].name)			\
+		CLI_AMI_TABLE_FIELD(Unit,		"-4.4",		s,	4,	callquality_metrics[metric].unit)			\
+		CLI_AMI_TABLE_FIELD(Calls,		"-8",		u,	8,	sum.calls)						\
+		CLI_AMI_TABLE_FIELD(Avg,		"-8.8",		s,	8,	row.avg[metric])					\
+		CLI_AMI_TABLE_FIELD(Worst10,		"-8.8",		s,	8,	row.worst[metric])					\
+		CLI_AMI_TABLE_FIELD(Histogram,		"-70.70",	s,	70,	histogram)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
+static int callquality_show_devices(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m)
+{
+	int local_line_total = 0;
+	uint32_t period = callquality_period();
+	sccp_callquality_slot_t sum;
+	sccp_callquality_row_t row;
+
+#define CLI_AMI_TABLE_NAME CallQualityDevices
+#define CLI_AMI_TABLE_PER_ENTRY_NAME CallQualityDevice
+
+#define CLI_AMI_TABLE_LIST_ITER_TYPE sccp_device_t
+#define CLI_AMI_TABLE_LIST_ITER_HEAD &GLOB(devices)
+#define CLI_AMI_TABLE_LIST_ITER_VAR list_dev
+#define CLI_AMI_TABLE_LIST_LOCK SCCP_RWLIST_RDLOCK
+#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_RWLIST_TRAVERSE
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		callquality_collect(&list_dev->callquality, period, &sum);									\
+		if (sum.calls) {														\
+			callquality_row(&sum, &row);
+
+#define CLI_AMI_TABLE_AFTER_ITERATION 														\
+		}
+#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_RWLIST_UNLOCK
+
+#define CLI_AMI_TABLE_FIELDS 															\
+		CLI_AMI_TABLE_FIELD(Device,		"-16.16",	s,	16,	list_dev->id)						\
+		CLI_AMI_TABLE_FIELD(Calls,		"-8",		u,	8,	sum.calls)						\
+		CLI_AMI_TABLE_FIELD(AvgJitter,		"-9.9",		s,	9,	row.avg[SCCP_CALLQUALITY_JITTER])			\
+		CLI_AMI_TABLE_FIELD(WrstJitter,		"-10.10",	s,	10,	row.worst[SCCP_CALLQUALITY_JITTER])			\
+		CLI_AMI_TABLE_FIELD(AvgLoss,		"-7.7",		s,	7,	row.avg[SCCP_CALLQUALITY_LOSS])				\
+		CLI_AMI_TABLE_FIELD(WrstLoss,		"-8.8",		s,	8,	row.worst[SCCP_CALLQUALITY_LOSS])			\
+		CLI_AMI_TABLE_FIELD(AvgMOS,		"-6.6",		s,	6,	row.avg[SCCP_CALLQUALITY_MOS])				\
+		CLI_AMI_TABLE_FIELD(WrstMOS,		"-7.7",		s,	7,	row.worst[SCCP_CALLQUALITY_MOS])			\
+		CLI_AMI_TABLE_FIELD(Poor,		"-6",		u,	6,	row.poor)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
+static int callquality_show_lines(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m)
+{
+	int local_line_total = 0;
+	uint32_t period = callquality_period();
+	sccp_callquality_slot_t sum;
+	sccp_callquality_row_t row;
+
+#define CLI_AMI_TABLE_NAME CallQualityLines
+#define CLI_AMI_TABLE_PER_ENTRY_NAME CallQualityLine
+
+#define CLI_AMI_TABLE_LIST_ITER_TYPE sccp_line_t
+#define CLI_AMI_TABLE_LIST_ITER_HEAD &GLOB(lines)
+#define CLI_AMI_TABLE_LIST_ITER_VAR list_line
+#define CLI_AMI_TABLE_LIST_LOCK SCCP_RWLIST_RDLOCK
+#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_RWLIST_TRAVERSE
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		callquality_collect(&list_line->callquality, period, &sum);									\
+		if (sum.calls) {														\
+			callquality_row(&sum, &row);
+
+#define CLI_AMI_TABLE_AFTER_ITERATION 														\
+		}
+#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_RWLIST_UNLOCK
+
+#define CLI_AMI_TABLE_FIELDS 															\
+		CLI_AMI_TABLE_FIELD(Line,		"-16.16",	s,	16,	list_line->name)					\
+		CLI_AMI_TABLE_FIELD(Calls,		"-8",		u,	8,	sum.calls)						\
+		CLI_AMI_TABLE_FIELD(AvgJitter,		"-9.9",		s,	9,	row.avg[SCCP_CALLQUALITY_JITTER])			\
+		CLI_AMI_TABLE_FIELD(WrstJitter,		"-10.10",	s,	10,	row.worst[SCCP_CALLQUALITY_JITTER])			\
+		CLI_AMI_TABLE_FIELD(AvgLoss,		"-7.7",		s,	7,	row.avg[SCCP_CALLQUALITY_LOSS])				\
+		CLI_AMI_TABLE_FIELD(WrstLoss,		"-8.8",		s,	8,	row.worst[SCCP_CALLQUALITY_LOSS])			\
+		CLI_AMI_TABLE_FIELD(AvgMOS,		"-6.6",		s,	6,	row.avg[SCCP_CALLQUALITY_MOS])				\
+		CLI_AMI_TABLE_FIELD(WrstMOS,		"-7.7",		s,	7,	row.worst[SCCP_CALLQUALITY_MOS])			\
+		CLI_AMI_TABLE_FIELD(Poor,		"-6",		u,	6,	row.poor)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
+/*!
+ * \brief Show Call Quality Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_callquality(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	const char *type = argc > 3 ? argv[3] : "";
+	const char *name = argc > 4 ? argv[4] : "";
+	char what[StationMaxNameSize + 8] = "";
+
+	if (argc < 3 || argc > 5) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (sccp_strlen_zero(type)) {
+		return callquality_show_detail(fd, totals, s, m, "all devices", &callquality_global);
+	}
+	if (sccp_strcaseequals(type, "devices")) {
+		return callquality_show_devices(fd, totals, s, m);
+	}
+	if (sccp_strcaseequals(type, "lines")) {
+		return callquality_show_lines(fd, totals, s, m);
+	}
+	if (sccp_strlen_zero(name)) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (sccp_strcaseequals(type, "device")) {
+		AUTO_RELEASE(sccp_device_t, d , sccp_device_find_byid(name, FALSE));
+
+		if (!d) {
+			CLI_AMI_RETURN_ERROR(fd, s, m, "Can't find device %s\n", name);			/* explicit return */
+		}
+		snprintf(what, sizeof(what), "device %s", d->id);
+		return callquality_show_detail(fd, totals, s, m, what, &d->callquality);
+	}
+	if (sccp_strcaseequals(type, "line")) {
+		AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byname(name, FALSE));
+
+		if (!l) {
+			CLI_AMI_RETURN_ERROR(fd, s, m, "Can't find line %s\n", name);			/* explicit return */
+		}
+		snprintf(what, sizeof(what), "line %s", l->name);
+		return callquality_show_detail(fd, totals, s, m, what, &l->callquality);
+	}
+	return RESULT_SHOWUSAGE;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,59 @@
+/*!
+ * \file        sccp_callquality.h
+ * \brief       SCCP Call Quality Statistics Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+struct mansession;
+struct message;
+
+__BEGIN_C_EXTERN__
+#define SCCP_CALLQUALITY_SLOTS 8										/* rolling window of 8 slots ... */
+#define SCCP_CALLQUALITY_SLOT_SECONDS (3 * 3600)								/* ... of 3 hours each (last 24 hours) */
+#define SCCP_CALLQUALITY_BUCKETS 8
+#define SCCP_CALLQUALITY_PENDING 4										/* statistics requests awaiting a response per device */
+
+/*!
+ * \brief Call Quality Metrics
+ */
+typedef enum {
+	SCCP_CALLQUALITY_JITTER,										/*!< max jitter reported by the phone (ms) */
+	SCCP_CALLQUALITY_LOSS,											/*!< packet loss (0.01%) */
+	SCCP_CALLQUALITY_MOS,											/*!< listening quality mos, reported or estimated (0.01) */
+	SCCP_CALLQUALITY_SENTINEL
+} sccp_callquality_metric_t;
+
+/*!
+ * \brief Call Quality Statistics Slot (one period of the rolling window)
+ */
+typedef struct sccp_callquality_slot {
+	uint32_t period;											/*!< time / SCCP_CALLQUALITY_SLOT_SECONDS this slot holds */
+	uint32_t calls;												/*!< number of calls in this period */
+	uint32_t total[SCCP_CALLQUALITY_SENTINEL];								/*!< sum per metric, for the average */
+	uint32_t histogram[SCCP_CALLQUALITY_SENTINEL][SCCP_CALLQUALITY_BUCKETS];				/*!< histogram per metric */
+} sccp_callquality_slot_t;
+
+/*!
+ * \brief Call Quality Statistics (fixed size, embedded in device and line)
+ */
+typedef struct sccp_callquality {
+	sccp_callquality_slot_t slot[SCCP_CALLQUALITY_SLOTS];
+} sccp_callquality_t;
+
+/*!
+ * \brief Outstanding Connection Statistics Request (the channel is usually gone by the time the response arrives)
+ */
+typedef struct sccp_callquality_pending {
+	uint32_t callid;
+	char linename[StationMaxNameSize];
+} sccp_callquality_pending_t;
+
+SCCP_API void SCCP_CALL sccp_callquality_expect(devicePtr d, constChannelPtr channel);
+SCCP_API void SCCP_CALL sccp_callquality_add(devicePtr d, const sccp_call_statistics_t * stats, float reported_mos);
+
+SCCP_API int SCCP_CALL sccp_show_callquality(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,324 @@
+/*!
+ * \file        sccp_calltrace.c
+ * \brief       SCCP Call Setup Tracing
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Find out where call setup time is spent (dialplan, pbx, rtp open, waiting for the phone)
+ *              When to use:    Milestones are marked by the channel/pbx/actions code, the timeline is aggregated when the channel is destroyed
+ *              Relations:      Shown by 'sccp show stats callsetup' / SCCPShowStatsCallSetup
+ */
+
+/*!
+ * \section sccp_calltrace Call Setup Tracing
+ *
+ * Every channel carries a small timeline (sccp_calltrace_t), holding the monotonic time at which the call first reached each of the
+ * milestones in sccp_calltrace_milestone_t. Marking a milestone is a single store into the channel, no locks are involved.
+ *
+ * When the channel is destroyed, the time between pairs of milestones (the phases below) is added to a histogram per phase. Phases of
+ * which one of the milestones was never reached (inbound calls have no dialing, calls which were never answered have no connected, ...)
+ * are skipped. Durations are recorded in log2 buckets of milliseconds (bucket 0: < 1ms, bucket n: [2^(n-1), 2^n) ms, last bucket:
+ * everything above).
+ *
+ * When 'calltrace_threshold' is set, the timeline of every call of which one of the phases not depending on the user (dialplan, pbx,
+ * post dial delay, phone rtp open, media start) took longer than the threshold is logged.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_calltrace.h"
+#include "sccp_channel.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_CALLTRACE_HISTOGRAM_BUCKETS 16
+
+/*!
+ * \brief Call Setup Phase (time between two milestones)
+ */
+typedef struct sccp_calltrace_phase {
+	const char *const name;
+	const sccp_calltrace_milestone_t from;
+	const sccp_calltrace_milestone_t to;
+	const boolean_t user;											/*!< Depends on the user, not used for the threshold */
+} sccp_calltrace_phase_t;
+
+static const sccp_calltrace_phase_t calltrace_phases[] = {
+	{"dialtone",		SCCP_CALLTRACE_OFFHOOK,		SCCP_CALLTRACE_FIRSTDIGIT,	TRUE},
+	{"dialing",		SCCP_CALLTRACE_FIRSTDIGIT,	SCCP_CALLTRACE_DIALCOMPLETE,	TRUE},
+	{"dialplan",		SCCP_CALLTRACE_DIALCOMPLETE,	SCCP_CALLTRACE_PBXSTART,	FALSE},
+	{"pbx",			SCCP_CALLTRACE_PBXSTART,	SCCP_CALLTRACE_RINGING,		FALSE},
+	{"postdial",		SCCP_CALLTRACE_DIALCOMPLETE,	SCCP_CALLTRACE_RINGING,		FALSE},
+	{"rtpopen",		SCCP_CALLTRACE_ORC_SENT,	SCCP_CALLTRACE_ORC_ACK,		FALSE},
+	{"mediastart",		SCCP_CALLTRACE_ORC_ACK,		SCCP_CALLTRACE_SMT_SENT,	FALSE},
+	{"answer",		SCCP_CALLTRACE_RINGING,		SCCP_CALLTRACE_CONNECTED,	TRUE},
+};
+#define SCCP_CALLTRACE_PHASES ARRAY_LEN(calltrace_phases)
+
+static const char *const calltrace_milestones[SCCP_CALLTRACE_SENTINEL] = {
+	"offhook", "firstdigit", "dialcomplete", "pbxstart", "ringing", "orc_sent", "orc_ack", "smt_sent", "connected",
+};
+
+/*!
+ * \brief Call Setup Statistics per Phase
+ */
+typedef struct sccp_calltrace_counter {
+	uint64_t count;												/*!< Number of calls which went through this phase */
+	uint64_t total_ms;											/*!< Total time spent in this phase */
+	uint64_t max_ms;											/*!< Longest time spent in this phase */
+	uint64_t histogram[SCCP_CALLTRACE_HISTOGRAM_BUCKETS];							/*!< Duration histogram */
+} sccp_calltrace_counter_t;
+
+AST_MUTEX_DEFINE_STATIC(calltrace_lock);									/* protects calltrace_stats, outlives module stop */
+static struct {
+	sccp_calltrace_counter_t phases[SCCP_CALLTRACE_PHASES];
+	uint64_t calls;												/*!< Number of calls traced */
+	uint64_t slow;												/*!< Number of calls above calltrace_threshold */
+	time_t since;
+} calltrace_stats;
+
+static boolean_t calltrace_running = FALSE;
+
+/* ========================================================================================================================= Private */
+static gcc_inline uint calltrace_ms2bucket(uint64_t msecs)
+{
+	uint bucket = 0;
+
+	while (msecs && bucket < SCCP_CALLTRACE_HISTOGRAM_BUCKETS - 1) {
+		msecs >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+/*!
+ * \brief Return the upper bound (in ms) of the bucket containing the requested percentile
+ * \note the last bucket is open ended, for this one the longest duration ever seen is returned
+ */
+static uint64_t calltrace_percentile(const sccp_calltrace_counter_t * counter, uint percent)
+{
+	uint64_t wanted = (counter->count * percent + 99) / 100;
+	uint64_t seen = 0;
+	uint bucket = 0;
+
+	if (!counter->count) {
+		return 0;
+	}
+	for (bucket = 0; bucket < SCCP_CALLTRACE_HISTOGRAM_BUCKETS - 1; bucket++) {
+		seen += counter->histogram[bucket];
+		if (seen >= wanted) {
+			break;
+		}
+	}
+	return (bucket < SCCP_CALLTRACE_HISTOGRAM_BUCKETS - 1) ? (1ULL << bucket) : counter->max_ms;
+}
+
+/*!
+ * \brief Print the non empty buckets of a histogram as "<upper bound ms>:<count>" pairs
+ */
+static void calltrace_histogram2str(const sccp_calltrace_counter_t * counter, char *buf, size_t size)
+{
+	uint bucket = 0;
+	size_t len = 0;
+
+	buf[0] = '\0';
+	for (bucket = 0; bucket < SCCP_CALLTRACE_HISTOGRAM_BUCKETS && len < size; bucket++) {
+		if (!counter->histogram[bucket]) {
+			continue;
+		}
+		if (bucket < SCCP_CALLTRACE_HISTOGRAM_BUCKETS - 1) {
+			len += snprintf(buf + len, size - len, "%s<%llu:%llu", len ? " " : "", 1ULL << bucket, (unsigned long long) counter->histogram[bucket]);
+		} else {
+			len += snprintf(buf + len, size - len, "%s>=%llu:%llu", len ? " " : "", 1ULL << (bucket - 1), (unsigned long long) counter->histogram[bucket]);
+		}
+	}
+}
+
+/*!
+ * \brief Log the timeline of a call, relative to the first milestone reached
+ */
+static void calltrace_log(constChannelPtr channel, const sccp_calltrace_t * ct, uint64_t start)
+{
+	char buf[512] = "";
+	size_t len = 0;
+	uint milestone = 0;
+
+	for (milestone = 0; milestone < SCCP_CALLTRACE_SENTINEL && len < sizeof(buf); milestone++) {
+		if (ct->at[milestone]) {
+			len += snprintf(buf + len, sizeof(buf) - len, "%s%s:+%llums", len ? ", " : "", calltrace_milestones[milestone], (unsigned long long) ((ct->at[milestone] - start) / 1000));
+		}
+	}
+	pbx_log(LOG_NOTICE, "%s: (calltrace) slow call setup (threshold %dms): %s\n", channel->designator, GLOB(calltrace_threshold), buf);
+}
+
+/* ========================================================================================================================= Module Start/Stop */
+/*!
+ * \brief starting call setup tracing
+ */
+void sccp_calltrace_module_start(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting call setup tracing\n");
+	pbx_mutex_lock(&calltrace_lock);
+	memset(&calltrace_stats, 0, sizeof(calltrace_stats));
+	calltrace_stats.since = time(0);
+	calltrace_running = TRUE;
+	pbx_mutex_unlock(&calltrace_lock);
+}
+
+/*!
+ * \brief stopping call setup tracing
+ */
+void sccp_calltrace_module_stop(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Stopping call setup tracing\n");
+	pbx_mutex_lock(&calltrace_lock);
+	calltrace_running = FALSE;
+	pbx_mutex_unlock(&calltrace_lock);
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Add the call setup timeline of a channel to the statistics
+ * \note called from the channel destructor
+ */
+void sccp_calltrace_finish(constChannelPtr channel)
+{
+	const sccp_calltrace_t *ct = &channel->calltrace;
+	uint64_t duration_ms[SCCP_CALLTRACE_PHASES] = { 0 };
+	boolean_t reached[SCCP_CALLTRACE_PHASES] = { FALSE };
+	sccp_calltrace_counter_t *counter = NULL;
+	uint64_t start = 0;
+	uint64_t threshold = GLOB(calltrace_threshold) > 0 ? (uint64_t) GLOB(calltrace_threshold) : 0;
+	boolean_t slow = FALSE;
+	uint idx = 0;
+
+	if (!calltrace_running) {
+		return;
+	}
+	for (idx = 0; idx < SCCP_CALLTRACE_SENTINEL; idx++) {
+		if (ct->at[idx] && (!start || ct->at[idx] < start)) {
+			start = ct->at[idx];
+		}
+	}
+	if (!start) {
+		return;												/* channel never got anywhere */
+	}
+	for (idx = 0; idx < SCCP_CALLTRACE_PHASES; idx++) {
+		const sccp_calltrace_phase_t *phase = &calltrace_phases[idx];
+
+		if (ct->at[phase->from] && ct->at[phase->to] >= ct->at[phase->from]) {
+			reached[idx] = TRUE;
+			duration_ms[idx] = (ct->at[phase->to] - ct->at[phase->from]) / 1000;
+			if (threshold && !phase->user && duration_ms[idx] >= threshold) {
+				slow = TRUE;
+			}
+		}
+	}
+
+	pbx_mutex_lock(&calltrace_lock);
+	if (calltrace_running) {
+		for (idx = 0; idx < SCCP_CALLTRACE_PHASES; idx++) {
+			if (reached[idx]) {
+				counter = &calltrace_stats.phases[idx];
+				counter->count++;
+				counter->total_ms += duration_ms[idx];
+				if (duration_ms[idx] > counter->max_ms) {
+					counter->max_ms = duration_ms[idx];
+				}
+				counter->histogram[calltrace_ms2bucket(duration_ms[idx])]++;
+			}
+		}
+		calltrace_stats.calls++;
+		if (slow) {
+			calltrace_stats.slow++;
+		}
+	}
+	pbx_mutex_unlock(&calltrace_lock);
+
+	if (slow) {
+		calltrace_log(channel, ct, start);
+	}
+}
+
+/* ========================================================================================================================= CLI */
+/*!
+ * \brief Show Call Setup Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_calltrace(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	sccp_calltrace_counter_t stats[SCCP_CALLTRACE_PHASES];
+	sccp_calltrace_counter_t *counter = NULL;
+	char histogram[SCCP_CALLTRACE_HISTOGRAM_BUCKETS * 24] = "";
+	uint64_t calls = 0, slow = 0;
+	boolean_t reset = FALSE;
+	time_t since = 0;
+	uint idx = 0;
+
+	if (argc < 4 || argc > 5) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc == 5 && !sccp_strlen_zero(argv[4])) {
+		if (!sccp_strcaseequals(argv[4], "reset") && !sccp_true(argv[4])) {
+			return RESULT_SHOWUSAGE;
+		}
+		reset = TRUE;
+	}
+	if (!calltrace_running) {
+		CLI_AMI_RETURN_ERROR(fd, s, m, "%s", "Call setup statistics not available\n");
+	}
+
+	pbx_mutex_lock(&calltrace_lock);
+	memcpy(stats, calltrace_stats.phases, sizeof(stats));
+	calls = calltrace_stats.calls;
+	slow = calltrace_stats.slow;
+	since = calltrace_stats.since;
+	if (reset) {
+		memset(calltrace_stats.phases, 0, sizeof(calltrace_stats.phases));
+		calltrace_stats.calls = calltrace_stats.slow = 0;
+		calltrace_stats.since = time(0);
+	}
+	pbx_mutex_unlock(&calltrace_lock);
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\nCall setup statistics since %d seconds%s: %llu calls traced, %llu above threshold (%dms).\n", (int) (time(0) - since), reset ? " (now reset)" : "", (unsigned long long) calls, (unsigned long long) slow, GLOB(calltrace_threshold));
+		CLI_AMI_OUTPUT(fd, s, "Durations in milliseconds (p50/p90/p99/max: upper bound of log2 bucket), histogram as <upper bound>:<calls>\n");
+	}
+#define CLI_AMI_TABLE_NAME CallSetupStatistics
+#define CLI_AMI_TABLE_PER_ENTRY_NAME CallSetupPhase
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < SCCP_CALLTRACE_PHASES; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		counter = &stats[idx];														\
+		calltrace_histogram2str(counter, histogram, sizeof(histogram));									\
+
+#define CLI_AMI_TABLE_AFTER_ITERATION
+
+#define CLI_AMI_TABLE_FIELDS 															\
+		CLI_AMI_TABLE_FIELD(Phase,		"-10.10",	s,	10,	calltrace_phases[idx].name)				\
+		CLI_AMI_TABLE_FIELD(From,		"-12.12",	s,	12,	calltrace_milestones[calltrace_phases[idx].from])	\
+		CLI_AMI_TABLE_FIELD(To,			"-12.12",	s,	12,	calltrace_milestones[calltrace_phases[idx].to])		\
+		CLI_AMI_TABLE_FIELD(Calls,		"-8",		ju,	8,	(uintmax_t) counter->count)				\
+		CLI_AMI_TABLE_FIELD(AvgMs,		"-7",		ju,	7,	(uintmax_t) (counter->count ? counter->total_ms / counter->count : 0))	\
+		CLI_AMI_TABLE_FIELD(P50Ms,		"-7",		ju,	7,	(uintmax_t) calltrace_percentile(counter, 50))		\
+		CLI_AMI_TABLE_FIELD(P90Ms,		"-7",		ju,	7,	(uintmax_t) calltrace_percentile(counter, 90))		\
+		CLI_AMI_TABLE_FIELD(P99Ms,		"-7",		ju,	7,	(uintmax_t) calltrace_percentile(counter, 99))		\
+		CLI_AMI_TABLE_FIELD(MaxMs,		"-7",		ju,	7,	(uintmax_t) counter->max_ms)				\
+		CLI_AMI_TABLE_FIELD(Histogram,		"-60.60",	s,	60,	histogram)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,65 @@
+/*!
+ * \file        sccp_calltrace.h
+ * \brief       SCCP Call Setup Tracing Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+#include <time.h>
+
+struct mansession;
+struct message;
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief Call Setup Milestones
+ */
+typedef enum {
+	SCCP_CALLTRACE_OFFHOOK,											/*!< new outgoing call (offhook / speeddial / redial) */
+	SCCP_CALLTRACE_FIRSTDIGIT,										/*!< first digit entered */
+	SCCP_CALLTRACE_DIALCOMPLETE,										/*!< number complete, softswitch entered */
+	SCCP_CALLTRACE_PBXSTART,										/*!< pbx thread started on the dialed extension */
+	SCCP_CALLTRACE_RINGING,											/*!< remote side ringing (ringout) / phone ringing (inbound) */
+	SCCP_CALLTRACE_ORC_SENT,										/*!< OpenReceiveChannel sent to the phone */
+	SCCP_CALLTRACE_ORC_ACK,											/*!< OpenReceiveChannelAck received */
+	SCCP_CALLTRACE_SMT_SENT,										/*!< StartMediaTransmission sent to the phone */
+	SCCP_CALLTRACE_CONNECTED,										/*!< call connected */
+	SCCP_CALLTRACE_SENTINEL
+} sccp_calltrace_milestone_t;
+
+/*!
+ * \brief Call Setup Timeline (one per channel)
+ */
+typedef struct sccp_calltrace {
+	uint64_t at[SCCP_CALLTRACE_SENTINEL];									/*!< Monotonic time (us) the milestone was first reached, 0 = never */
+} sccp_calltrace_t;
+
+static gcc_inline uint64_t sccp_calltrace_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000ULL + (uint64_t) ts.tv_nsec / 1000ULL;
+}
+
+/*!
+ * \brief Record that a call reached a milestone (only the first time counts)
+ * \note no locking, every milestone is written once by the thread handling that step of the call
+ */
+static gcc_inline void sccp_calltrace_mark(const sccp_calltrace_t * const calltrace, sccp_calltrace_milestone_t milestone)
+{
+	sccp_calltrace_t *ct = (sccp_calltrace_t *) calltrace;							/* discard const, the timeline is not part of the channel state */
+
+	if (!ct->at[milestone]) {
+		ct->at[milestone] = sccp_calltrace_now();
+	}
+}
+
+SCCP_API void SCCP_CALL sccp_calltrace_module_start(void);
+SCCP_API void SCCP_CALL sccp_calltrace_module_stop(void);
+SCCP_API void SCCP_CALL sccp_calltrace_finish(constChannelPtr channel);
+
+SCCP_API int SCCP_CALL sccp_show_calltrace(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,338 @@
+/*!
+ * \file        sccp_capture.c
+ * \brief       SCCP Session Capture
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Write the raw skinny messages exchanged with the devices to a binary capture file
+ *              When to use:    Debugging / regression testing under load, where DEBUGCAT_MESSAGE would be too expensive
+ *              Relations:      Fed by the session layer (receive/send), controlled by 'sccp capture' / SCCPCapture, read by contrib/sccp_sim/sccp_replay
+ */
+
+/*!
+ * \section sccp_capture Session Capture
+ *
+ * The session threads only append a record header and the message bytes to an in-memory buffer (one short locked memcpy). A dedicated writer
+ * thread swaps this buffer against a spare one and writes it to disk, so the session threads never wait on file I/O. When the writer can not
+ * keep up and the buffer is full, records are dropped (and counted) instead of slowing down the sessions.
+ *
+ * Capture can be limited to one device (by device name) or one ip-address. Sessions cache the result of this filter per capture generation.
+ * Note: When filtering on device name, the messages received before the device is attached to the session (the RegisterMessage) are not
+ * captured, filter on ip-address to include those.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_capture.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include "sccp_netsock.h"
+#include "sccp_utils.h"
+#include <asterisk/paths.h>
+
+#define SCCP_CAPTURE_BUFFER_SIZE (1024 * 1024)
+#define SCCP_CAPTURE_FLUSH_INTERVAL 250										/* ms */
+
+volatile boolean_t sccp_capture_active = FALSE;
+volatile uint32_t sccp_capture_generation = 0;
+
+AST_MUTEX_DEFINE_STATIC(capture_lock);
+static struct {
+	pbx_cond_t cond;											/*!< Wakes up the writer thread */
+	pthread_t writer;
+	boolean_t stop;												/*!< Tell the writer thread to finish */
+	FILE *file;
+	char filename[SCCP_PATH_MAX];
+	char filter[INET6_ADDRSTRLEN + StationMaxDeviceNameSize];						/*!< Device name or ip-address, empty for all sessions */
+	unsigned char *buffer;											/*!< Buffer the sessions are appending to */
+	unsigned char *spare;											/*!< Buffer owned by the writer (NULL while writing) */
+	size_t fill;
+	time_t started;
+	uint64_t records;
+	uint64_t bytes;
+	uint64_t dropped;
+	uint64_t written;
+	uint32_t write_errors;
+} capture;
+
+/* ========================================================================================================================= Private */
+static void *capture_writer_thread(void *data)
+{
+	unsigned char *buffer = NULL;
+	size_t len = 0;
+	struct timeval tv;
+	struct timespec ts;
+
+	pbx_mutex_lock(&capture_lock);
+	while (!capture.stop || capture.fill) {
+		if (!capture.fill) {
+			tv = ast_tvadd(ast_tvnow(), ast_samp2tv(SCCP_CAPTURE_FLUSH_INTERVAL, 1000));
+			ts.tv_sec = tv.tv_sec;
+			ts.tv_nsec = tv.tv_usec * 1000;
+			pbx_cond_timedwait(&capture.cond, &capture_lock, &ts);
+			continue;
+		}
+		buffer = capture.buffer;									/* swap buffers, the sessions continue on the spare one */
+		len = capture.fill;
+		capture.buffer = capture.spare;
+		capture.spare = NULL;
+		capture.fill = 0;
+		pbx_mutex_unlock(&capture_lock);
+
+		if (fwrite(buffer, 1, len, capture.file) != len) {
+			pbx_log(LOG_ERROR, "SCCP: (capture_writer_thread) Writing to capture file '%s' failed: %s\n", capture.filename, strerror(errno));
+			len = 0;
+			capture.write_errors++;
+		}
+		fflush(capture.file);
+
+		pbx_mutex_lock(&capture_lock);
+		capture.spare = buffer;
+		capture.written += len;
+	}
+	pbx_mutex_unlock(&capture_lock);
+	return NULL;
+}
+
+/*!
+ * \brief Start Capturing
+ * \note called with capture_lock held
+ */
+static int capture_start(const char *filename, const char *filter)
+{
+	sccp_capture_file_header_t header = { SCCP_CAPTURE_MAGIC, htolel(SCCP_CAPTURE_VERSION), 0 };
+
+	if (sccp_capture_active || capture.file) {								/* capture.file is still set while a stop is in progress */
+		pbx_log(LOG_WARNING, "SCCP: Capture already running to '%s'\n", capture.filename);
+		return -1;
+	}
+	if (filename[0] == '/') {
+		sccp_copy_string(capture.filename, filename, sizeof(capture.filename));
+	} else {
+		snprintf(capture.filename, sizeof(capture.filename), "%s/%s", ast_config_AST_LOG_DIR, filename);
+	}
+	sccp_copy_string(capture.filter, filter ? filter : "", sizeof(capture.filter));
+
+	capture.buffer = sccp_malloc(SCCP_CAPTURE_BUFFER_SIZE);
+	capture.spare = sccp_malloc(SCCP_CAPTURE_BUFFER_SIZE);
+	if (!capture.buffer || !capture.spare) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		goto FAILED;
+	}
+	if (!(capture.file = fopen(capture.filename, "w"))) {
+		pbx_log(LOG_ERROR, "SCCP: Could not open capture file '%s': %s\n", capture.filename, strerror(errno));
+		goto FAILED;
+	}
+	if (fwrite(&header, sizeof(header), 1, capture.file) != 1) {
+		pbx_log(LOG_ERROR, "SCCP: Could not write to capture file '%s': %s\n", capture.filename, strerror(errno));
+		goto FAILED;
+	}
+	capture.fill = 0;
+	capture.stop = FALSE;
+	capture.records = capture.bytes = capture.dropped = capture.written = 0;
+	capture.write_errors = 0;
+	capture.started = time(0);
+	if (pbx_pthread_create(&capture.writer, NULL, capture_writer_thread, NULL)) {
+		pbx_log(LOG_ERROR, "SCCP: Could not start capture writer thread\n");
+		goto FAILED;
+	}
+	sccp_capture_generation++;
+	sccp_capture_active = TRUE;
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Capturing %s%s to '%s'\n", sccp_strlen_zero(capture.filter) ? "all sessions" : "sessions matching ", capture.filter, capture.filename);
+	return 0;
+
+FAILED:
+	if (capture.file) {
+		fclose(capture.file);
+		capture.file = NULL;
+	}
+	if (capture.buffer) {
+		sccp_free(capture.buffer);
+		capture.buffer = NULL;
+	}
+	if (capture.spare) {
+		sccp_free(capture.spare);
+		capture.spare = NULL;
+	}
+	return -1;
+}
+
+/*!
+ * \brief Stop Capturing, writing out what is still buffered
+ * \note called with capture_lock held, drops the lock while waiting for the writer thread
+ */
+static void capture_stop(void)
+{
+	if (!sccp_capture_active) {
+		return;
+	}
+	sccp_capture_active = FALSE;
+	sccp_capture_generation++;
+	capture.stop = TRUE;
+	pbx_cond_signal(&capture.cond);
+	pbx_mutex_unlock(&capture_lock);
+	pthread_join(capture.writer, NULL);
+	pbx_mutex_lock(&capture_lock);
+
+	fclose(capture.file);
+	capture.file = NULL;
+	sccp_free(capture.buffer);
+	capture.buffer = NULL;
+	sccp_free(capture.spare);
+	capture.spare = NULL;
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Capture to '%s' stopped (records: %ju, dropped: %ju)\n", capture.filename, (uintmax_t) capture.records, (uintmax_t) capture.dropped);
+}
+
+/* ========================================================================================================================= Module Start/Stop */
+/*!
+ * \brief starting session capture
+ */
+void sccp_capture_module_start(void)
+{
+	memset(&capture, 0, sizeof(capture));
+	pbx_cond_init(&capture.cond, NULL);
+}
+
+/*!
+ * \brief stopping session capture
+ */
+void sccp_capture_module_stop(void)
+{
+	pbx_mutex_lock(&capture_lock);
+	capture_stop();
+	pbx_mutex_unlock(&capture_lock);
+	pbx_cond_destroy(&capture.cond);
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Does a session match the current capture filter
+ * \param deviceId Device Name attached to the session (or NULL)
+ * \param sin Remote Address of the session
+ * \return TRUE when the session should be captured
+ */
+boolean_t sccp_capture_matches(const char *deviceId, const struct sockaddr_storage *sin)
+{
+	boolean_t res = FALSE;
+
+	pbx_mutex_lock(&capture_lock);
+	if (sccp_capture_active) {
+		if (sccp_strlen_zero(capture.filter)) {
+			res = TRUE;
+		} else if (deviceId && sccp_strcaseequals(capture.filter, deviceId)) {
+			res = TRUE;
+		} else if (sin && sccp_strequals(capture.filter, sccp_netsock_stringify_addr(sin))) {
+			res = TRUE;
+		}
+	}
+	pbx_mutex_unlock(&capture_lock);
+	return res;
+}
+
+/*!
+ * \brief Append a message to the capture
+ * \param session Session Serial Number
+ * \param direction Direction
+ * \param data Message Bytes (as on the wire)
+ * \param len Length of data
+ * \param data2 Second part of the Message (when it wraps around the end of the receive ring buffer), can be NULL
+ * \param len2 Length of data2
+ */
+void sccp_capture_record(uint32_t session, sccp_capture_direction_t direction, const void *data, size_t len, const void *data2, size_t len2)
+{
+	sccp_capture_record_header_t header;
+	size_t needed = sizeof(header) + len + len2;
+	struct timeval now;
+
+	pbx_mutex_lock(&capture_lock);
+	if (!sccp_capture_active || !capture.buffer) {
+		pbx_mutex_unlock(&capture_lock);
+		return;
+	}
+	if (capture.fill + needed > SCCP_CAPTURE_BUFFER_SIZE) {
+		capture.dropped++;										/* writer can not keep up, never block the session */
+		pbx_mutex_unlock(&capture_lock);
+		return;
+	}
+	now = pbx_tvnow();											/* taken under the lock, so that records are written in time order */
+	header.lel_sec = htolel((uint32_t) now.tv_sec);
+	header.lel_usec = htolel((uint32_t) now.tv_usec);
+	header.lel_session = htolel(session);
+	header.lel_direction = htoles((uint16_t) direction);
+	header.lel_reserved = 0;
+	header.lel_length = htolel((uint32_t) (len + len2));
+
+	memcpy(capture.buffer + capture.fill, &header, sizeof(header));
+	memcpy(capture.buffer + capture.fill + sizeof(header), data, len);
+	if (data2 && len2) {
+		memcpy(capture.buffer + capture.fill + sizeof(header) + len, data2, len2);
+	}
+	capture.fill += needed;
+	capture.records++;
+	capture.bytes += needed;
+	if (capture.fill > SCCP_CAPTURE_BUFFER_SIZE / 2) {
+		pbx_cond_signal(&capture.cond);
+	}
+	pbx_mutex_unlock(&capture_lock);
+}
+
+/* ========================================================================================================================= CLI */
+/*!
+ * \brief Start/Stop/Show Session Capture
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_cli_capture(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int res = 0;
+
+	if (argc < 3 || argc > 5 || sccp_strlen_zero(argv[2])) {
+		return RESULT_SHOWUSAGE;
+	}
+
+	pbx_mutex_lock(&capture_lock);
+	if (sccp_strcaseequals(argv[2], "start")) {
+		if (argc < 4 || sccp_strlen_zero(argv[3])) {
+			pbx_mutex_unlock(&capture_lock);
+			return RESULT_SHOWUSAGE;
+		}
+		res = capture_start(argv[3], argc > 4 ? argv[4] : NULL);
+	} else if (sccp_strcaseequals(argv[2], "stop")) {
+		capture_stop();
+	} else if (!sccp_strcaseequals(argv[2], "status")) {
+		pbx_mutex_unlock(&capture_lock);
+		return RESULT_SHOWUSAGE;
+	}
+	if (res) {
+		pbx_mutex_unlock(&capture_lock);
+		CLI_AMI_RETURN_ERROR(fd, s, m, "Could not start capture to '%s'\n", argv[3]);
+	}
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: Capture %s\r\n", sccp_capture_active ? "running" : "stopped");
+		astman_append(s, "File: %s\r\n", capture.filename);
+		astman_append(s, "Filter: %s\r\n", capture.filter);
+		astman_append(s, "Records: %ju\r\n", (uintmax_t) capture.records);
+		astman_append(s, "Dropped: %ju\r\n", (uintmax_t) capture.dropped);
+		local_line_total += 6;
+		totals->lines = local_line_total;
+	} else {
+		CLI_AMI_OUTPUT(fd, s, "Capture %s%s%s\n", sccp_capture_active ? "running" : "stopped", sccp_strlen_zero(capture.filename) ? "" : ", file: ", capture.filename);
+		if (!sccp_strlen_zero(capture.filename)) {
+			CLI_AMI_OUTPUT(fd, s, "Filter: %s, Since: %d seconds\n", sccp_strlen_zero(capture.filter) ? "all sessions" : capture.filter, (int) (time(0) - capture.started));
+			CLI_AMI_OUTPUT(fd, s, "Records: %ju, Bytes: %ju, Written: %ju, Dropped: %ju, Write Errors: %u\n", (uintmax_t) capture.records, (uintmax_t) capture.bytes, (uintmax_t) capture.written, (uintmax_t) capture.dropped, capture.write_errors);
+		}
+	}
+	pbx_mutex_unlock(&capture_lock);
+	return RESULT_SUCCESS;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
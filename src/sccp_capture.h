@@ -0,0 +1,53 @@
+/*!
+ * \file        sccp_capture.h
+ * \brief       SCCP Session Capture Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+/*!
+ * \brief Capture File Format
+ *
+ * file   := sccp_capture_file_header_t record*
+ * record := sccp_capture_record_header_t <length bytes of skinny message, exactly as seen on the wire>
+ *
+ * All fields are stored little endian. This layout is also used by contrib/sccp_sim/sccp_replay.c, keep them in sync.
+ */
+#define SCCP_CAPTURE_MAGIC "SCCPCAP"
+#define SCCP_CAPTURE_VERSION 1
+
+typedef enum {
+	SCCP_CAPTURE_IN = 0,											/*!< Received from the device */
+	SCCP_CAPTURE_OUT = 1,											/*!< Sent to the device */
+} sccp_capture_direction_t;
+
+typedef struct {
+	char magic[8];												/*!< SCCP_CAPTURE_MAGIC (nul terminated) */
+	uint32_t lel_version;											/*!< SCCP_CAPTURE_VERSION */
+	uint32_t lel_reserved;
+} sccp_capture_file_header_t;
+
+typedef struct {
+	uint32_t lel_sec;											/*!< Timestamp (seconds) */
+	uint32_t lel_usec;											/*!< Timestamp (microseconds) */
+	uint32_t lel_session;											/*!< Session Serial Number */
+	uint16_t lel_direction;											/*!< sccp_capture_direction_t */
+	uint16_t lel_reserved;
+	uint32_t lel_length;											/*!< Number of message bytes following */
+} sccp_capture_record_header_t;
+
+__BEGIN_C_EXTERN__
+extern volatile boolean_t sccp_capture_active;									/*!< Checked (without lock) before anything else in the session hot path */
+extern volatile uint32_t sccp_capture_generation;								/*!< Incremented whenever capture is started/stopped, sessions cache their filter match per generation */
+
+SCCP_API void SCCP_CALL sccp_capture_module_start(void);
+SCCP_API void SCCP_CALL sccp_capture_module_stop(void);
+
+SCCP_API boolean_t SCCP_CALL sccp_capture_matches(const char *deviceId, const struct sockaddr_storage *sin);
+SCCP_API void SCCP_CALL sccp_capture_record(uint32_t session, sccp_capture_direction_t direction, const void *data, size_t len, const void *data2, size_t len2);
+
+SCCP_API int SCCP_CALL sccp_cli_capture(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -34,10 +34,12 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include <asterisk/callerid.h>			// sccp_channel, sccp_callinfo
 #include <asterisk/pbx.h>			// AST_EXTENSION_NOT_INUSE
 
-static uint32_t callCount = 1;
+#define SCCP_CHANNEL_POOL_SIZE 16
+
+static volatile CAS32_TYPE callCount = 1;
 void __sccp_channel_destroy(sccp_channel_t * channel);
 
-AST_MUTEX_DEFINE_STATIC(callCountLock);
+AST_MUTEX_DEFINE_STATIC(callCountLock);										/* only used when the platform has no atomic operations */
 
 /*!
  * \brief Private Channel Data Structure
@@ -47,8 +49,122 @@ struct sccp_private_channel_data {
 	sccp_linedevices_t *linedevice;
 	sccp_callinfo_t * callInfo;
 	boolean_t microphone;											/*!< Flag to mute the microphone when calling a baby phone */
+	struct sccp_private_channel_data *next;									/*!< Next idle entry in channel_pool */
 };
 
+/*!
+ * \brief Pool of idle private channel data, each with a callinfo already attached
+ * \note the sccp_channel_t objects themselves are pooled by refcount (see sccp_refcount_pool_setSize)
+ */
+static struct {
+	sccp_mutex_t lock;
+	struct sccp_private_channel_data *first;
+	int size;
+	boolean_t running;
+} channel_pool;
+
+/*!
+ * \brief Take private channel data (with a cleared callinfo) out of the pool, allocate new ones when the pool is empty
+ */
+static struct sccp_private_channel_data *sccp_channel_privateData_get(uint8_t callInstance)
+{
+	struct sccp_private_channel_data *private_data = NULL;
+
+	sccp_mutex_lock(&channel_pool.lock);
+	if ((private_data = channel_pool.first)) {
+		channel_pool.first = private_data->next;
+		channel_pool.size--;
+	}
+	sccp_mutex_unlock(&channel_pool.lock);
+
+	if (private_data) {
+		private_data->next = NULL;
+		iCallInfo.Reset(private_data->callInfo, callInstance);
+	} else {
+		if (!(private_data = sccp_calloc(sizeof *private_data, 1))) {
+			return NULL;
+		}
+		if (!(private_data->callInfo = iCallInfo.Constructor(callInstance))) {
+			sccp_free(private_data);
+			return NULL;
+		}
+	}
+	/* assign private_data default values */
+	private_data->microphone = TRUE;
+	return private_data;
+}
+
+/*!
+ * \brief Return private channel data to the pool, or free it when the pool is full
+ */
+static void sccp_channel_privateData_put(struct sccp_private_channel_data *private_data)
+{
+	sccp_callinfo_t *callInfo = private_data->callInfo;
+
+	if (callInfo && channel_pool.running) {
+		memset(private_data, 0, sizeof *private_data);
+		private_data->callInfo = callInfo;
+		sccp_mutex_lock(&channel_pool.lock);
+		if (channel_pool.running && channel_pool.size < SCCP_CHANNEL_POOL_SIZE) {
+			private_data->next = channel_pool.first;
+			channel_pool.first = private_data;
+			channel_pool.size++;
+			private_data = NULL;
+		}
+		sccp_mutex_unlock(&channel_pool.lock);
+	}
+	if (private_data) {
+		if (callInfo) {
+			iCallInfo.Destructor(&callInfo);
+		}
+		sccp_free(private_data);
+	}
+}
+
+/*!
+ * \brief starting channel pool
+ */
+void sccp_channel_module_start(void)
+{
+	struct sccp_private_channel_data *private_data = NULL;
+
+	sccp_mutex_init(&channel_pool.lock);
+	channel_pool.first = NULL;
+	channel_pool.size = 0;
+	channel_pool.running = TRUE;
+	while (channel_pool.size < SCCP_CHANNEL_POOL_SIZE && (private_data = sccp_calloc(sizeof *private_data, 1))) {
+		if (!(private_data->callInfo = iCallInfo.Constructor(0))) {
+			sccp_free(private_data);
+			break;
+		}
+		private_data->next = channel_pool.first;
+		channel_pool.first = private_data;
+		channel_pool.size++;
+	}
+	sccp_refcount_pool_setSize(SCCP_REF_CHANNEL, sizeof(sccp_channel_t), SCCP_CHANNEL_POOL_SIZE);
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_2 "SCCP: Started channel pool (%d channels)\n", channel_pool.size);
+}
+
+/*!
+ * \brief stopping channel pool
+ */
+void sccp_channel_module_stop(void)
+{
+	struct sccp_private_channel_data *private_data = NULL;
+
+	sccp_refcount_pool_setSize(SCCP_REF_CHANNEL, sizeof(sccp_channel_t), 0);
+	sccp_mutex_lock(&channel_pool.lock);
+	channel_pool.running = FALSE;
+	while ((private_data = channel_pool.first)) {
+		channel_pool.first = private_data->next;
+		iCallInfo.Destructor(&private_data->callInfo);
+		sccp_free(private_data);
+	}
+	channel_pool.size = 0;
+	sccp_mutex_unlock(&channel_pool.lock);
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_2 "SCCP: Stopped channel pool\n");
+}
+
 /*!
  * \brief Set Microphone State
  * \param channel SCCP Channel
@@ -91,8 +207,7 @@ static void sccp_channel_setMicrophoneState(sccp_channel_t * channel, boolean_t
  * \callgraph
  * \callergraph
  *
- * \lock
- *  - callCountLock
+ * \note channel objects and private data (including callinfo) are taken from the channel pool when available
  */
 channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 {
@@ -105,28 +220,25 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 		pbx_log(LOG_ERROR, "SCCP: Could not retain line to create a channel on it, giving up!\n");
 		return NULL;
 	}
-	if (sccp_strlen_zero(refLine->name) || sccp_strlen_zero(refLine->context) || !pbx_context_find(refLine->context)) {
+	/* the context lookup is only done once per (re)load of the line, see sccp_line_pre_reload */
+	if (sccp_strlen_zero(refLine->name) || sccp_strlen_zero(refLine->context) || (!refLine->contextExists && !(refLine->contextExists = pbx_context_find(refLine->context) ? TRUE : FALSE))) {
 		pbx_log(LOG_ERROR, "SCCP: line with empty name, empty context or non-existent context provided, aborting creation of new channel\n");
+		sccp_line_release(&refLine);								// explicit release
 		return NULL;
 	}
 	if (device && !device->session) {
 		pbx_log(LOG_ERROR, "SCCP: Tried to open channel on device %s without a session\n", device->id);
+		sccp_line_release(&refLine);								// explicit release
 		return NULL;
 	}
 
-	int32_t callid;
+	uint32_t callid;
 	char designator[32];
-	sccp_mutex_lock(&callCountLock);
-	if (callCount < 0xFFFFFFFF) {						/* callcount limit should be reset at his upper limit :) */
-		callid = callCount++;
-	} else {
-		pbx_log(LOG_NOTICE, "%s: CallId re-starting at 00000001\n", device->id);
-		callCount = 1;
-		callid = callCount;
+	while ((callid = (uint32_t) ATOMIC_INCR(&callCount, 1, &callCountLock)) == 0) {			/* callcount wraps at its upper limit, 0 is not a valid callid */
+		pbx_log(LOG_NOTICE, "SCCP: CallId re-starting at 00000001\n");
 	}
 	snprintf(designator, 32, "SCCP/%s-%08X", refLine->name, callid);
 	uint8_t callInstance = refLine->statistic.numberOfActiveChannels + refLine->statistic.numberOfHeldChannels + 1;
-	sccp_mutex_unlock(&callCountLock);
 	do {
 		/* allocate new channel */
 		channel = (sccp_channel_t *) sccp_refcount_object_alloc(sizeof(sccp_channel_t), SCCP_REF_CHANNEL, designator, __sccp_channel_destroy);
@@ -138,18 +250,11 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 		sccp_refcount_addWeakParent(channel, refLine);
 #endif
 		/* allocate resources */
-		private_data = sccp_calloc(sizeof *private_data, 1);
+		private_data = sccp_channel_privateData_get(callInstance);
 		if (!private_data) {
 			pbx_log(LOG_ERROR, "%s: No memory to allocate channel private data on line %s\n", l->id, l->name);
 			break;
 		}
-		/* assign private_data default values */
-		private_data->microphone = TRUE;
-		private_data->device = NULL;
-		private_data->callInfo = iCallInfo.Constructor(callInstance);
-		if (!private_data->callInfo) {
-			break;
-		}
 		
 		/* assigning immutable values */
 		*(struct sccp_private_channel_data **)&channel->privateData = private_data;
@@ -204,10 +309,7 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 
 	/* something went wrong, cleaning up */
 	if (private_data) {
-		if (private_data->callInfo) {
-			iCallInfo.Destructor(&private_data->callInfo);
-		}
-		sccp_free(private_data);
+		sccp_channel_privateData_put(private_data);
 	}
 	if (channel) {
 		sccp_channel_release(&channel);							// explicit release
@@ -581,6 +683,7 @@ void sccp_channel_StatisticsRequest(sccp_channel_t * channel)
 	if (!d) {
 		return;
 	}
+	sccp_callquality_expect(d, channel);
 	d->protocol->sendConnectionStatisticsReq(d, channel, SKINNY_STATSPROCESSING_CLEAR);
 	sccp_log((DEBUGCAT_CHANNEL + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Device is Requesting CallStatisticsAndClear\n", d->id);
 }
@@ -638,6 +741,7 @@ void sccp_channel_openReceiveChannel(constChannelPtr channel)
 		sccp_rtp_updateNatRemotePhone(channel, audio);
 	}
 		
+	sccp_calltrace_mark(&channel->calltrace, SCCP_CALLTRACE_ORC_SENT);
 	d->protocol->sendOpenReceiveChannel(d, channel);
 #ifdef CS_SCCP_VIDEO
 	if (sccp_device_isVideoSupported(d) && channel->videomode == SCCP_VIDEO_MODE_AUTO) {
@@ -833,6 +937,7 @@ void sccp_channel_startMediaTransmission(constChannelPtr channel)
 	}
 
 	audio->mediaTransmissionState |= SCCP_RTP_STATUS_PROGRESS;
+	sccp_calltrace_mark(&channel->calltrace, SCCP_CALLTRACE_SMT_SENT);
 	d->protocol->sendStartMediaTransmission(d, channel);
 
 	char buf1[NI_MAXHOST + NI_MAXSERV];
@@ -1280,6 +1385,7 @@ channelPtr sccp_channel_newcall(constLinePtr l, constDevicePtr device, const cha
 		pbx_log(LOG_ERROR, "%s: Can't allocate SCCP channel for line %s\n", device->id, l->name);
 		return NULL;
 	}
+	sccp_calltrace_mark(&channel->calltrace, SCCP_CALLTRACE_OFFHOOK);
 
 	channel->softswitch_action = SCCP_SOFTSWITCH_DIAL;							/* softswitch will catch the number to be dialed */
 	channel->ss_data = 0;											/* nothing to pass to action */
@@ -1881,6 +1987,7 @@ void __sccp_channel_destroy(sccp_channel_t * channel)
 	}
 
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "Destroying channel %s\n", channel->designator);
+	sccp_calltrace_finish(channel);
 	AUTO_RELEASE(sccp_device_t, d , sccp_channel_getDevice(channel));
 	if (d) {
 		sccp_channel_closeAllMediaTransmitAndReceive(d, channel);
@@ -1891,10 +1998,6 @@ void __sccp_channel_destroy(sccp_channel_t * channel)
 		sccp_rtp_destroy(channel);
 	}
 
-	if (channel->privateData->callInfo) {
-		iCallInfo.Destructor(&channel->privateData->callInfo);
-	}
-	
 	if (channel->owner) {
 		if (iPbx.removeTimingFD) {
 			iPbx.removeTimingFD(channel->owner); 
@@ -1905,7 +2008,10 @@ void __sccp_channel_destroy(sccp_channel_t * channel)
 	/* destroy immutables, by casting away const */
 	sccp_free(*(char **)&channel->musicclass);
 	sccp_free(*(char **)&channel->designator);
-	sccp_free(*(struct sccp_private_channel_data **)&channel->privateData);
+	if (channel->privateData) {
+		sccp_channel_privateData_put(*(struct sccp_private_channel_data **)&channel->privateData);
+		*(struct sccp_private_channel_data **)&channel->privateData = NULL;
+	}
 	sccp_line_release((sccp_line_t **)&channel->line);
 	/* */
 	
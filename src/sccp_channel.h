@@ -13,6 +13,7 @@
 #pragma once
 
 #include "sccp_device.h"
+#include "sccp_calltrace.h"
 
 #define sccp_channel_retain(_x)		sccp_refcount_retain_type(sccp_channel_t, _x)
 #define sccp_channel_release(_x)	sccp_refcount_release_type(sccp_channel_t, _x)
@@ -85,8 +86,10 @@ struct sccp_channel {
 		sccp_rtp_t audio;										/*!< Asterisk RTP */
 		sccp_rtp_t video;										/*!< Video RTP session */
 		//sccp_rtp_t text;										/*!< Video RTP session */
+		sccp_framepath_t framepath;									/*!< Precomputed rtp dispatch for the pbx frame read/write callbacks */
 		uint8_t peer_dtmfmode;
 	} rtp;
+	sccp_calltrace_t calltrace;										/*!< Call setup timeline */
 
 	skinny_ringtype_t ringermode;										/*!< Ringer Mode */
 
@@ -124,6 +127,8 @@ struct sccp_selectedchannel {
 	SCCP_LIST_ENTRY (sccp_selectedchannel_t) list;								/*!< Selected Channel Linked List Entry */
 };														/*!< SCCP Selected Channel Structure */
 /* live cycle */
+SCCP_API void SCCP_CALL sccp_channel_module_start(void);
+SCCP_API void SCCP_CALL sccp_channel_module_stop(void);
 SCCP_API channelPtr SCCP_CALL sccp_channel_allocate(constLinePtr l, constDevicePtr device);			// device is optional
 SCCP_API channelPtr SCCP_CALL sccp_channel_getEmptyChannel(constLinePtr l, constDevicePtr d, channelPtr maybe_c, uint8_t calltype, PBX_CHANNEL_TYPE * parentChannel, const void *ids);	// retrieve or allocate new channel
 SCCP_API channelPtr SCCP_CALL sccp_channel_newcall(constLinePtr l, constDevicePtr device, const char *dial, uint8_t calltype, PBX_CHANNEL_TYPE * parentChannel, const void *ids);
@@ -60,6 +60,12 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_features.h"
 #include "sccp_mwi.h"
 #include "sccp_hint.h"
+#include "sccp_realtime.h"
+#include "sccp_dialplan.h"
+#include "sccp_msgstats.h"
+#include "sccp_calltrace.h"
+#include "sccp_callquality.h"
+#include "sccp_capture.h"
 #include "sys/stat.h"
 #include <asterisk/cli.h>
 #include <asterisk/paths.h>
@@ -756,6 +762,8 @@ static int sccp_show_device(int fd, sccp_cli_totals_t *totals, struct mansession
 	sccp_hostname_t *hostname;
 	sccp_accessory_t activeAccessory = sccp_device_getActiveAccessory(d);
 	sccp_accessorystate_t activeAccessoryState = sccp_device_getAccessoryStatus(d, activeAccessory);
+	uint32_t shadow_checked = 0, shadow_suppressed = 0;
+	sccp_device_shadow_getStats(d, &shadow_checked, &shadow_suppressed);
 
 	SCCP_LIST_TRAVERSE(&d->permithosts, hostname, list) {
 		ast_str_append(&permithost_buf, DEFAULT_PBX_STR_BUFFERSIZE, "%s ", hostname->name);
@@ -781,6 +789,7 @@ static int sccp_show_device(int fd, sccp_cli_totals_t *totals, struct mansession
 	CLI_AMI_OUTPUT_PARAM("Keepalive",		CLI_AMI_LIST_WIDTH, "%d", d->keepalive);
 	CLI_AMI_OUTPUT_PARAM("Registration state",	CLI_AMI_LIST_WIDTH, "%s", skinny_registrationstate2str(sccp_device_getRegistrationState(d)));
 	CLI_AMI_OUTPUT_PARAM("State",			CLI_AMI_LIST_WIDTH, "%s", sccp_devicestate2str(sccp_device_getDeviceState(d)));
+	CLI_AMI_OUTPUT_PARAM("Suppressed Messages",	CLI_AMI_LIST_WIDTH, "%u of %u unchanged", shadow_suppressed, shadow_checked);
 	CLI_AMI_OUTPUT_PARAM("MWI light",		CLI_AMI_LIST_WIDTH, "%s(%d)", skinny_lampmode2str(d->mwilamp), d->mwilamp);
 	CLI_AMI_OUTPUT_PARAM("MWI handset light", 	CLI_AMI_LIST_WIDTH, "%s", sccp_dec2binstr(binstr, 40, d->mwilight));
 	CLI_AMI_OUTPUT_PARAM("MWI During call",		CLI_AMI_LIST_WIDTH, "%s", d->mwioncall ? "keep on" : "turn off");
@@ -1498,6 +1507,155 @@ CLI_AMI_ENTRY(show_mwi_subscriptions, sccp_show_mwi_subscriptions, "Show all SCC
 #undef CLI_COMPLETE
 #undef AMI_COMMAND
 #undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ---------------------------------------------------------------------------------------------REALTIME CACHE- */
+    // sccp_show_realtime_cache / sccp_realtime_cache_flush implementation in sccp_realtime.c, because of access to private struct
+#ifdef CS_SCCP_REALTIME
+static char cli_show_realtime_cache_usage[] = "Usage: sccp show realtime cache\n" "	Show SCCP Realtime Lookup Cache statistics.\n";
+static char ami_show_realtime_cache_usage[] = "Usage: SCCPShowRealtimeCache\n" "Show SCCP Realtime Lookup Cache statistics.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "realtime", "cache"
+#define AMI_COMMAND "SCCPShowRealtimeCache"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_realtime_cache, sccp_show_realtime_cache, "Show SCCP Realtime Lookup Cache statistics", cli_show_realtime_cache_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+static char cli_realtime_cache_invalidate_usage[] = "Usage: sccp realtime cache invalidate [all|device|line|<table>] [name]\n" "	Invalidate SCCP Realtime Lookup Cache entries.\n";
+static char ami_realtime_cache_invalidate_usage[] = "Usage: SCCPRealtimeCacheInvalidate\n" "Invalidate SCCP Realtime Lookup Cache entries.\n\n" "Optional PARAMS: Table=[all|device|line|<table>], Name\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "realtime", "cache", "invalidate"
+#define AMI_COMMAND "SCCPRealtimeCacheInvalidate"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Table", "Name"
+CLI_AMI_ENTRY(realtime_cache_invalidate, sccp_realtime_cache_flush, "Invalidate SCCP Realtime Lookup Cache entries", cli_realtime_cache_invalidate_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#endif														// CS_SCCP_REALTIME
+
+    /* --------------------------------------------------------------------------------------------MESSAGE STATS- */
+    // sccp_show_msgstats implementation in sccp_msgstats.c, because of access to private struct
+static char cli_show_msgstats_usage[] = "Usage: sccp show stats messages [reset]\n" "	Show SCCP message counters and handler latencies per message type. When 'reset' is given, the counters are reset after showing them.\n";
+static char ami_show_msgstats_usage[] = "Usage: SCCPShowStatsMessages\n" "Show SCCP message counters and handler latencies per message type.\n\n" "Optional PARAMS: Reset=yes\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "stats", "messages"
+#define AMI_COMMAND "SCCPShowStatsMessages"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Reset"
+CLI_AMI_ENTRY(show_msgstats, sccp_show_msgstats, "Show SCCP message statistics", cli_show_msgstats_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ------------------------------------------------------------------------------------------CALL SETUP STATS- */
+    // sccp_show_calltrace implementation in sccp_calltrace.c, because of access to private struct
+static char cli_show_calltrace_usage[] = "Usage: sccp show stats callsetup [reset]\n" "	Show SCCP call setup durations per phase (dialing, dialplan, pbx, phone rtp open, media start, answer). When 'reset' is given, the statistics are reset after showing them.\n";
+static char ami_show_calltrace_usage[] = "Usage: SCCPShowStatsCallSetup\n" "Show SCCP call setup durations per phase.\n\n" "Optional PARAMS: Reset=yes\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "stats", "callsetup"
+#define AMI_COMMAND "SCCPShowStatsCallSetup"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Reset"
+CLI_AMI_ENTRY(show_calltrace, sccp_show_calltrace, "Show SCCP call setup statistics", cli_show_calltrace_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ------------------------------------------------------------------------------------------CALL QUALITY STATS- */
+    // sccp_show_callquality implementation in sccp_callquality.c, because of access to private struct
+static char cli_show_callquality_usage[] = "Usage: sccp show callquality [devices|lines|device <deviceId>|line <lineName>]\n" "	Show jitter, packet loss and mos histograms of the calls of the last 24 hours (all devices, per device or per line), as reported by the phones at the end of each call.\n" "	'devices' / 'lines' list a summary of every device / line which had calls.\n";
+static char ami_show_callquality_usage[] = "Usage: SCCPShowCallQuality\n" "Show jitter, packet loss and mos histograms of the calls of the last 24 hours.\n\n" "Optional PARAMS: Type=[devices|lines|device|line], Name=[<deviceId>|<lineName>]\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "callquality"
+#define AMI_COMMAND "SCCPShowCallQuality"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Type", "Name"
+CLI_AMI_ENTRY(show_callquality, sccp_show_callquality, "Show SCCP call quality statistics", cli_show_callquality_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ---------------------------------------------------------------------------------------------SESSION CAPTURE- */
+    // sccp_cli_capture implementation in sccp_capture.c, because of access to private struct
+static char cli_capture_usage[] = "Usage: sccp capture start <filename> [<deviceId>|<ip-address>]\n" "       sccp capture stop|status\n" "	Capture the skinny messages of all sessions (or only those of one device / ip-address) to a binary file (relative to the asterisk log directory).\n" "	Replay / decode the file with contrib/sccp_sim/sccp_replay.\n";
+static char ami_capture_usage[] = "Usage: SCCPCapture\n" "Start/Stop capturing skinny messages to a binary file.\n\n" "PARAMS: Command=start|stop|status\n" "Optional PARAMS: File, Filter\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "capture"
+#define AMI_COMMAND "SCCPCapture"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Command", "File", "Filter"
+CLI_AMI_ENTRY(capture, sccp_cli_capture, "Capture SCCP session messages", cli_capture_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ---------------------------------------------------------------------------------------------DIALPLAN CACHE- */
+    // sccp_show_dialplan_cache / sccp_dialplan_cache_flush implementation in sccp_dialplan.c, because of access to private struct
+static char cli_show_dialplan_cache_usage[] = "Usage: sccp show dialplan cache\n" "	Show SCCP Dialplan Match Cache statistics.\n";
+static char ami_show_dialplan_cache_usage[] = "Usage: SCCPShowDialplanCache\n" "Show SCCP Dialplan Match Cache statistics.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "dialplan", "cache"
+#define AMI_COMMAND "SCCPShowDialplanCache"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_dialplan_cache, sccp_show_dialplan_cache, "Show SCCP Dialplan Match Cache statistics", cli_show_dialplan_cache_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+static char cli_dialplan_cache_flush_usage[] = "Usage: sccp dialplan cache flush [all|<context>]\n" "	Flush SCCP Dialplan Match Cache entries.\n";
+static char ami_dialplan_cache_flush_usage[] = "Usage: SCCPDialplanCacheFlush\n" "Flush SCCP Dialplan Match Cache entries.\n\n" "Optional PARAMS: Context=[all|<context>]\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "dialplan", "cache", "flush"
+#define AMI_COMMAND "SCCPDialplanCacheFlush"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Context"
+CLI_AMI_ENTRY(dialplan_cache_flush, sccp_dialplan_cache_flush, "Flush SCCP Dialplan Match Cache entries", cli_dialplan_cache_flush_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+
+    /* ---------------------------------------------------------------------------------------------------RTP POOL- */
+    // sccp_show_rtp_pool implementation in sccp_rtp.c, because of access to private struct
+static char cli_show_rtp_pool_usage[] = "Usage: sccp show rtp pool\n" "	Show SCCP RTP Instance Pool statistics.\n";
+static char ami_show_rtp_pool_usage[] = "Usage: SCCPShowRtpPool\n" "Show SCCP RTP Instance Pool statistics.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "rtp", "pool"
+#define AMI_COMMAND "SCCPShowRtpPool"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_rtp_pool, sccp_show_rtp_pool, "Show SCCP RTP Instance Pool statistics", cli_show_rtp_pool_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
 
     /* ---------------------------------------------------------------------------------------------CONFERENCE FUNCTIONS- */
@@ -3453,6 +3611,17 @@ static struct pbx_cli_entry cli_entries[] = {
 	AST_CLI_DEFINE(cli_show_conference, "Show SCCP Conference Info."),
 	AST_CLI_DEFINE(cli_conference_command, "SCCP Conference Commands."),
 #endif
+#ifdef CS_SCCP_REALTIME
+	AST_CLI_DEFINE(cli_show_realtime_cache, "Show realtime lookup cache statistics."),
+	AST_CLI_DEFINE(cli_realtime_cache_invalidate, "Invalidate realtime lookup cache entries."),
+#endif
+	AST_CLI_DEFINE(cli_show_dialplan_cache, "Show dialplan match cache statistics."),
+	AST_CLI_DEFINE(cli_dialplan_cache_flush, "Flush dialplan match cache entries."),
+	AST_CLI_DEFINE(cli_show_rtp_pool, "Show rtp instance pool statistics."),
+	AST_CLI_DEFINE(cli_show_msgstats, "Show message statistics."),
+	AST_CLI_DEFINE(cli_show_calltrace, "Show call setup statistics."),
+	AST_CLI_DEFINE(cli_show_callquality, "Show call quality statistics."),
+	AST_CLI_DEFINE(cli_capture, "Capture session messages."),
 	AST_CLI_DEFINE(cli_show_hint_lineStates, "Show all hint lineStates"),
 	AST_CLI_DEFINE(cli_show_hint_subscriptions, "Show all hint subscriptions")
 };
@@ -3496,6 +3665,17 @@ int sccp_register_cli(void)
 	res |= pbx_manager_register("SCCPShowConference", _MAN_REP_FLAGS, manager_show_conference, "show conference", ami_conference_usage);
 	res |= pbx_manager_register("SCCPConference", _MAN_REP_FLAGS, manager_conference_command, "conference commands", ami_conference_command_usage);
 #endif
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_register("SCCPShowRealtimeCache", _MAN_REP_FLAGS, manager_show_realtime_cache, "show realtime cache", ami_show_realtime_cache_usage);
+	res |= pbx_manager_register("SCCPRealtimeCacheInvalidate", _MAN_COM_FLAGS, manager_realtime_cache_invalidate, "invalidate realtime cache", ami_realtime_cache_invalidate_usage);
+#endif
+	res |= pbx_manager_register("SCCPShowDialplanCache", _MAN_REP_FLAGS, manager_show_dialplan_cache, "show dialplan cache", ami_show_dialplan_cache_usage);
+	res |= pbx_manager_register("SCCPDialplanCacheFlush", _MAN_COM_FLAGS, manager_dialplan_cache_flush, "flush dialplan cache", ami_dialplan_cache_flush_usage);
+	res |= pbx_manager_register("SCCPShowRtpPool", _MAN_REP_FLAGS, manager_show_rtp_pool, "show rtp pool", ami_show_rtp_pool_usage);
+	res |= pbx_manager_register("SCCPShowStatsMessages", _MAN_REP_FLAGS, manager_show_msgstats, "show message statistics", ami_show_msgstats_usage);
+	res |= pbx_manager_register("SCCPShowStatsCallSetup", _MAN_REP_FLAGS, manager_show_calltrace, "show call setup statistics", ami_show_calltrace_usage);
+	res |= pbx_manager_register("SCCPShowCallQuality", _MAN_REP_FLAGS, manager_show_callquality, "show call quality statistics", ami_show_callquality_usage);
+	res |= pbx_manager_register("SCCPCapture", _MAN_COM_FLAGS, manager_capture, "capture session messages", ami_capture_usage);
 	res |= pbx_manager_register("SCCPShowHintLineStates", _MAN_REP_FLAGS, manager_show_hint_lineStates, "show hint lineStates", ami_show_hint_lineStates_usage);
 	res |= pbx_manager_register("SCCPShowHintSubscriptions", _MAN_REP_FLAGS, manager_show_hint_subscriptions, "show hint subscriptions", ami_show_hint_subscriptions_usage);
 	res |= pbx_manager_register("SCCPShowRefcount", _MAN_REP_FLAGS, manager_show_refcount, "show refcount", ami_show_refcount_usage);
@@ -3535,6 +3715,17 @@ int sccp_unregister_cli(void)
 	res |= pbx_manager_unregister("SCCPShowConference");
 	res |= pbx_manager_unregister("SCCPConference");
 #endif
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_unregister("SCCPShowRealtimeCache");
+	res |= pbx_manager_unregister("SCCPRealtimeCacheInvalidate");
+#endif
+	res |= pbx_manager_unregister("SCCPShowDialplanCache");
+	res |= pbx_manager_unregister("SCCPDialplanCacheFlush");
+	res |= pbx_manager_unregister("SCCPShowRtpPool");
+	res |= pbx_manager_unregister("SCCPShowStatsMessages");
+	res |= pbx_manager_unregister("SCCPShowStatsCallSetup");
+	res |= pbx_manager_unregister("SCCPShowCallQuality");
+	res |= pbx_manager_unregister("SCCPCapture");
 	res |= pbx_manager_unregister("SCCPShowHintLineStates");
 	res |= pbx_manager_unregister("SCCPShowHintSubscriptions");
 	res |= pbx_manager_unregister("SCCPShowRefcount");
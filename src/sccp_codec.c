@@ -114,7 +114,7 @@ gcc_inline const char *codec2name(skinny_codec_t value)
 	_ARR2STR(skinny_codecs, codec, value, name);
 }
 
-gcc_inline const skinny_payload_type_t codec2type(skinny_codec_t value)
+gcc_inline skinny_payload_type_t codec2type(skinny_codec_t value)
 {
         uint32_t i;
         for (i = 0; i < ARRAY_LEN(skinny_codecs); i++) {
@@ -259,6 +259,30 @@ boolean_t sccp_codec_isCompatible(skinny_codec_t codec, const skinny_codec_t cap
 	return FALSE;
 }
 
+/*!
+ * \brief Fill a Codec Set from a Skinny Codec Array (up to the first SKINNY_CODEC_NONE)
+ */
+void sccp_codecset_fromArray(sccp_codecset_t * set, const skinny_codec_t codecs[], int length)
+{
+	int x = 0;
+
+	memset(set, 0, sizeof(sccp_codecset_t));
+	for (x = 0; x < length && codecs[x] != SKINNY_CODEC_NONE; x++) {
+		sccp_codecset_add(set, codecs[x]);
+	}
+}
+
+/*!
+ * \brief Is codec part of set / codecs (codecs outside the range of a codec set are looked up in the array)
+ */
+static gcc_inline boolean_t codecset_contains(const sccp_codecset_t * set, skinny_codec_t codec, const skinny_codec_t codecs[], int length)
+{
+	if (do_expect(sccp_codecset_inRange(codec))) {
+		return sccp_codecset_has(set, codec);
+	}
+	return sccp_codec_isCompatible(codec, codecs, length);
+}
+
 /*!
  * \brief get smallest common denominator codecset
  * intersection of two sets
@@ -266,13 +290,13 @@ boolean_t sccp_codec_isCompatible(skinny_codec_t codec, const skinny_codec_t cap
 void sccp_codec_reduceSet(skinny_codec_t base[SKINNY_MAX_CAPABILITIES], const skinny_codec_t reduceByCodecs[SKINNY_MAX_CAPABILITIES])
 {
 	skinny_codec_t temp[SKINNY_MAX_CAPABILITIES] = {0};
-	uint8_t x = 0, y = 0, z = 0;
+	sccp_codecset_t reduceBy;
+	uint8_t x = 0, z = 0;
+
+	sccp_codecset_fromArray(&reduceBy, reduceByCodecs, SKINNY_MAX_CAPABILITIES);
 	for (x = 0; x < SKINNY_MAX_CAPABILITIES && (z+1) < SKINNY_MAX_CAPABILITIES && base[x] != SKINNY_CODEC_NONE; x++) {
-		for (y = 0; y < SKINNY_MAX_CAPABILITIES && (z+1) < SKINNY_MAX_CAPABILITIES && reduceByCodecs[y] != SKINNY_CODEC_NONE; y++) {
-			if (base[x] == reduceByCodecs[y]) {
-				temp[z++] = base[x];
-				break;
-			}
+		if (codecset_contains(&reduceBy, base[x], reduceByCodecs, SKINNY_MAX_CAPABILITIES)) {
+			temp[z++] = base[x];
 		}
 	}
 	memcpy(base, temp, sizeof(skinny_codec_t) * SKINNY_MAX_CAPABILITIES);
@@ -284,25 +308,17 @@ void sccp_codec_reduceSet(skinny_codec_t base[SKINNY_MAX_CAPABILITIES], const sk
  */
 void sccp_codec_combineSets(skinny_codec_t base[SKINNY_MAX_CAPABILITIES], const skinny_codec_t addCodecs[SKINNY_MAX_CAPABILITIES])
 {
-	uint8_t x = 0, y = 0, z = 0, demarquation = SKINNY_MAX_CAPABILITIES;
-	for (y = 0; y < SKINNY_MAX_CAPABILITIES && addCodecs[y] != SKINNY_CODEC_NONE; y++) {
-		boolean_t found = FALSE;
-		for (x = 0; x < demarquation && base[x] != SKINNY_CODEC_NONE; x++) {
-			if (base[x] == addCodecs[y]) {
-				found = TRUE;
-				break;
-			}
-		}
-		while (!found && z < SKINNY_MAX_CAPABILITIES) {
-			if (base[z] == SKINNY_CODEC_NONE) {
-				if (demarquation) {		// don't check against newly added codecs
-					demarquation = z;
-				}
-				base[z] = addCodecs[y];
-				break;
-			}
-			z++;
+	sccp_codecset_t present;
+	uint8_t y = 0, z = 0;
+
+	for (z = 0; z < SKINNY_MAX_CAPABILITIES && base[z] != SKINNY_CODEC_NONE; z++);				// z: first free entry
+	sccp_codecset_fromArray(&present, base, z);
+	for (y = 0; y < SKINNY_MAX_CAPABILITIES && z < SKINNY_MAX_CAPABILITIES && addCodecs[y] != SKINNY_CODEC_NONE; y++) {
+		if (codecset_contains(&present, addCodecs[y], base, z)) {
+			continue;
 		}
+		sccp_codecset_add(&present, addCodecs[y]);
+		base[z++] = addCodecs[y];
 	}
 }
 
@@ -313,83 +329,56 @@ void sccp_codec_combineSets(skinny_codec_t base[SKINNY_MAX_CAPABILITIES], const
  *  - Best Match If Found
  *  - If not it returns the first jointCapability
  *  - Else SKINNY_CODEC_NONE
+ *
+ * \note The capabilities are turned into codec sets, a single pass over the preferences then collects the preference ranks
+ * which are capable / joint with the remote peer, the best one is the lowest rank (first bit set).
  */
 skinny_codec_t sccp_codec_findBestJoint(const skinny_codec_t ourPreferences[], int pLength, const skinny_codec_t ourCapabilities[], int cLength, const skinny_codec_t remotePeerCapabilities[], int rLength)
 {
-	uint8_t r, c, p;
-	skinny_codec_t firstJointCapability = SKINNY_CODEC_NONE;						/*!< used to get a default value */
+	sccp_codecset_t capabilities;
+	sccp_codecset_t remoteCapabilities;
+	uint32_t capableRanks = 0;										/*!< bit p: ourPreferences[p] is one of our capabilities */
+	uint32_t jointRanks = 0;										/*!< bit p: ourPreferences[p] is also a remote capability */
+	boolean_t remoteEmpty = (rLength == 0 || remotePeerCapabilities[0] == SKINNY_CODEC_NONE) ? TRUE : FALSE;
+	skinny_codec_t bestCodec = SKINNY_CODEC_NONE;
+	int p = 0;
 
 	sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "pLength %d, cLength: %d, rLength: %d\n", pLength, cLength, rLength);
 
-	//char pref_buf[256];
-	//sccp_codec_multiple2str(pref_buf, sizeof(pref_buf) - 1, ourPreferences, (int)pLength);
-	//char cap_buf[256];
-	//sccp_codec_multiple2str(cap_buf, sizeof(pref_buf) - 1, ourCapabilities, cLength);
-	//char remote_cap_buf[256];
-	//sccp_codec_multiple2str(remote_cap_buf, sizeof(remote_cap_buf) - 1, remotePeerCapabilities, rLength);
-	//sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "ourPref %s\nourCap: %s\nremoteCap: %s\n", pref_buf, cap_buf, remote_cap_buf);
-
 	/** check if we have a preference codec list */
 	if (pLength == 0 || ourPreferences[0] == SKINNY_CODEC_NONE) {
 		/* using remote capabilities to */
 		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "We got an empty preference codec list (exiting)\n");
 		return SKINNY_CODEC_NONE;
-
 	}
 
-	/* iterate over our codec preferences */
-	for (p = 0; p < pLength; p++) {
-		if (ourPreferences[p] == SKINNY_CODEC_NONE) {
-			sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "no more preferences at position %d\n", p);
-			break;
-		}
-		/* no more preferences */
-		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "preference: %d(%s)\n", ourPreferences[p], codec2name(ourPreferences[p]));
+	sccp_codecset_fromArray(&capabilities, ourCapabilities, cLength);
+	sccp_codecset_fromArray(&remoteCapabilities, remotePeerCapabilities, rLength);
 
-		/* check if we are capable to handle this codec */
-		for (c = 0; c < cLength; c++) {
-			if (ourCapabilities[c] == SKINNY_CODEC_NONE) {
-				/* we reached the end of valide codecs, because we found the first NONE codec */
-				sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) ("Breaking at capability: %d\n", c);
-				break;
-			}
-
-			sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "preference: %d(%s), capability: %d(%s)\n", ourPreferences[p], codec2name(ourPreferences[p]), ourCapabilities[c], codec2name(ourCapabilities[c]));
-
-			/* we have no capabilities from the remote party, use the best codec from ourPreferences */
-			if (ourPreferences[p] == ourCapabilities[c]) {
-				if (firstJointCapability == SKINNY_CODEC_NONE) {
-					firstJointCapability = ourPreferences[p];
-					sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "found first firstJointCapability %d(%s)\n", firstJointCapability, codec2name(firstJointCapability));
-				}
-
-				if (rLength == 0 || remotePeerCapabilities[0] == SKINNY_CODEC_NONE) {
-					sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "Empty remote Capabilities, using bestCodec from firstJointCapability %d(%s)\n", firstJointCapability, codec2name(firstJointCapability));
-					return firstJointCapability;
-				} 
-					/* using capabilities from remote party, that matches our preferences & capabilities */
-					for (r = 0; r < rLength; r++) {
-						if (remotePeerCapabilities[r] == SKINNY_CODEC_NONE) {
-							sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) ("Breaking at remotePeerCapability: %d\n", c);
-							break;
-						}
-						sccp_log_and((DEBUGCAT_CODEC + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "preference: %d(%s), capability: %d(%s), remoteCapability: " UI64FMT "(%s)\n", ourPreferences[p], codec2name(ourPreferences[p]), ourCapabilities[c], codec2name(ourCapabilities[c]), (ULONG) remotePeerCapabilities[r], codec2name(remotePeerCapabilities[r]));
-						if (ourPreferences[p] == remotePeerCapabilities[r]) {
-							sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "found bestCodec as joint capability with remote peer %d(%s)\n", ourPreferences[p], codec2name(ourPreferences[p]));
-							return ourPreferences[p];
-						}
-					}
-				
+	/* preference lists are SKINNY_MAX_CAPABILITIES long, which fits the rank masks */
+	for (p = 0; p < pLength && p < 32 && ourPreferences[p] != SKINNY_CODEC_NONE; p++) {
+		if (codecset_contains(&capabilities, ourPreferences[p], ourCapabilities, cLength)) {
+			capableRanks |= (uint32_t) 1 << p;
+			if (codecset_contains(&remoteCapabilities, ourPreferences[p], remotePeerCapabilities, rLength)) {
+				jointRanks |= (uint32_t) 1 << p;
 			}
 		}
 	}
 
-	if (firstJointCapability != SKINNY_CODEC_NONE) {
-		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "did not find joint capability with remote device, using first joint capability %d(%s)\n", firstJointCapability, codec2name(firstJointCapability));
-		return firstJointCapability;
+	if (!capableRanks) {
+		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "no joint capability with preference codec list\n");
+		return SKINNY_CODEC_NONE;
 	}
-
-	sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "no joint capability with preference codec list\n");
-	return 0;
+	if (remoteEmpty) {
+		bestCodec = ourPreferences[__builtin_ctz(capableRanks)];
+		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "Empty remote Capabilities, using bestCodec from firstJointCapability %d(%s)\n", bestCodec, codec2name(bestCodec));
+	} else if (jointRanks) {
+		bestCodec = ourPreferences[__builtin_ctz(jointRanks)];
+		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "found bestCodec as joint capability with remote peer %d(%s)\n", bestCodec, codec2name(bestCodec));
+	} else {
+		bestCodec = ourPreferences[__builtin_ctz(capableRanks)];
+		sccp_log((DEBUGCAT_CODEC)) (VERBOSE_PREFIX_3 "did not find joint capability with remote device, using first joint capability %d(%s)\n", bestCodec, codec2name(bestCodec));
+	}
+	return bestCodec;
 }
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
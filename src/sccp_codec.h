@@ -126,7 +126,7 @@ extern const struct skinny_codec skinny_codecs[];
 SCCP_API uint8_t SCCP_CALL sccp_codec_getArrayLen(void);
 SCCP_INLINE const char * SCCP_CALL codec2str(skinny_codec_t value);
 SCCP_INLINE const char * SCCP_CALL codec2name(skinny_codec_t value);
-SCCP_INLINE const skinny_payload_type_t codec2type(skinny_codec_t value);
+SCCP_INLINE skinny_payload_type_t codec2type(skinny_codec_t value);
 SCCP_API char * SCCP_CALL sccp_codec_multiple2str(char *buf, size_t size, const skinny_codec_t * codecs, const int clength);
 SCCP_API int SCCP_CALL sccp_codec_parseAllowDisallow(skinny_codec_t * skinny_codec_prefs, const char *list, int allowing);
 SCCP_API boolean_t SCCP_CALL sccp_codec_isCompatible(skinny_codec_t codec, const skinny_codec_t capabilities[], uint8_t length);
@@ -134,5 +134,40 @@ SCCP_API void SCCP_CALL sccp_codec_reduceSet(skinny_codec_t base[SKINNY_MAX_CAPA
 SCCP_API void SCCP_CALL sccp_codec_combineSets(skinny_codec_t base[SKINNY_MAX_CAPABILITIES], const skinny_codec_t addCodecs[SKINNY_MAX_CAPABILITIES]);
 SCCP_API skinny_codec_t SCCP_CALL sccp_codec_findBestJoint(const skinny_codec_t ourPreferences[], int pLength, const skinny_codec_t ourCapabilities[], int cLength, const skinny_codec_t remotePeerCapabilities[], int rLength);
 
+/*!
+ * \brief SKINNY Codec Set (bitmask indexed by skinny_codec_t value)
+ * \note The order (preference) of codecs stays in the skinny_codec_t arrays, the set is used to test membership / intersect / unite them
+ */
+#define SCCP_CODECSET_WORDS ((SKINNY_CODEC_V150_LC_SSE / 64) + 1)
+typedef struct {
+	uint64_t bits[SCCP_CODECSET_WORDS];
+} sccp_codecset_t;
+
+static gcc_inline boolean_t sccp_codecset_inRange(skinny_codec_t codec)
+{
+	return ((unsigned int) codec < SCCP_CODECSET_WORDS * 64) ? TRUE : FALSE;
+}
+
+static gcc_inline void sccp_codecset_add(sccp_codecset_t * set, skinny_codec_t codec)
+{
+	if (sccp_codecset_inRange(codec)) {
+		set->bits[codec >> 6] |= (uint64_t) 1 << (codec & 63);
+	}
+}
+
+static gcc_inline boolean_t sccp_codecset_has(const sccp_codecset_t * set, skinny_codec_t codec)
+{
+	return (sccp_codecset_inRange(codec) && (set->bits[codec >> 6] & ((uint64_t) 1 << (codec & 63)))) ? TRUE : FALSE;
+}
+
+static gcc_inline void sccp_codecset_remove(sccp_codecset_t * set, skinny_codec_t codec)
+{
+	if (sccp_codecset_inRange(codec)) {
+		set->bits[codec >> 6] &= ~((uint64_t) 1 << (codec & 63));
+	}
+}
+
+SCCP_API void SCCP_CALL sccp_codecset_fromArray(sccp_codecset_t * set, const skinny_codec_t codecs[], int length);
+
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -92,6 +92,8 @@
 #include "sccp_session.h"
 #include "sccp_utils.h"
 #include "sccp_devstate.h"
+#include "sccp_realtime.h"
+#include "sccp_dialplan.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -242,34 +244,182 @@ static const SCCPConfigSegment *sccp_find_segment(const sccp_config_segment_t se
 }
 
 /*!
- * \brief Find of SCCP Config Options
+ * \brief SCCP Config Option Index Entry
+ * \note name points into the (constant) option name and is not null-terminated, len holds the length of the alias
  */
-static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+typedef struct SCCPConfigOptionIndexEntry {
+	const char *name;
+	size_t len;
+	const SCCPConfigOption *option;
+} SCCPConfigOptionIndexEntry;
+
+/*!
+ * \brief SCCP Config Option Index (per segment)
+ *
+ * Sorted (case-insensitive) table containing every alias of every option, plus the full "alias1|alias2" name,
+ * built once at module load, so that sccp_find_config can use a binary search instead of scanning and tokenizing
+ * the complete option array for every variable.
+ */
+static struct {
+	SCCPConfigOptionIndexEntry *entries;
+	size_t size;
+} sccpConfigOptionIndex[ARRAY_LEN(sccpConfigSegments)];
+
+static int sccp_config_index_keycmp(const char *key, size_t keylen, const SCCPConfigOptionIndexEntry *entry)
+{
+	int res = strncasecmp(key, entry->name, keylen < entry->len ? keylen : entry->len);
+
+	if (!res) {
+		res = (keylen > entry->len) - (keylen < entry->len);
+	}
+	return res;
+}
+
+static int sccp_config_index_sortcmp(const void *a, const void *b)
+{
+	const SCCPConfigOptionIndexEntry *entry_a = (const SCCPConfigOptionIndexEntry *) a;
+	const SCCPConfigOptionIndexEntry *entry_b = (const SCCPConfigOptionIndexEntry *) b;
+	int res = sccp_config_index_keycmp(entry_a->name, entry_a->len, entry_b);
+
+	if (!res) {												/* keep table order for duplicate names (first entry wins) */
+		res = (entry_a->option > entry_b->option) - (entry_a->option < entry_b->option);
+	}
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_config_build_option_index(void)
 {
+	uint8_t segment_idx = 0;
 	long unsigned int i = 0;
-	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
-	const SCCPConfigOption *config = sccpConfigSegment->config;
+	size_t entry_cnt = 0;
+	const char *start = NULL;
+	const char *end = NULL;
+
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		const SCCPConfigSegment *sccpConfigSegment = &sccpConfigSegments[segment_idx];
+		const SCCPConfigOption *config = sccpConfigSegment->config;
+
+		/* count all aliases, adding the full name of multi-alias options */
+		entry_cnt = 0;
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			entry_cnt++;
+			if (strchr(config[i].name, '|')) {
+				entry_cnt++;
+				for (start = config[i].name; (start = strchr(start, '|')); start++) {
+					entry_cnt++;
+				}
+			}
+		}
+		if (!(sccpConfigOptionIndex[segment_idx].entries = (SCCPConfigOptionIndexEntry *) sccp_calloc(entry_cnt, sizeof(SCCPConfigOptionIndexEntry)))) {
+			pbx_log(LOG_ERROR, "SCCP: (sccp_config_build_option_index) Memory allocation error, falling back to linear config option lookup for segment '%s'\n", sccpConfigSegment->name);
+			sccpConfigOptionIndex[segment_idx].size = 0;
+			continue;
+		}
 
-	char delims[] = "|";
+		entry_cnt = 0;
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			SCCPConfigOptionIndexEntry *entries = sccpConfigOptionIndex[segment_idx].entries;
+
+			for (start = config[i].name; start; start = end ? end + 1 : NULL) {
+				end = strchr(start, '|');
+				entries[entry_cnt].name = start;
+				entries[entry_cnt].len = end ? (size_t) (end - start) : strlen(start);
+				entries[entry_cnt].option = &config[i];
+				entry_cnt++;
+			}
+			if (strchr(config[i].name, '|')) {
+				entries[entry_cnt].name = config[i].name;
+				entries[entry_cnt].len = strlen(config[i].name);
+				entries[entry_cnt].option = &config[i];
+				entry_cnt++;
+			}
+		}
+		qsort(sccpConfigOptionIndex[segment_idx].entries, entry_cnt, sizeof(SCCPConfigOptionIndexEntry), sccp_config_index_sortcmp);
+		sccpConfigOptionIndex[segment_idx].size = entry_cnt;
+	}
+}
+
+static void __attribute__((destructor)) sccp_config_destroy_option_index(void)
+{
+	uint8_t segment_idx = 0;
+
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		if (sccpConfigOptionIndex[segment_idx].entries) {
+			sccp_free(sccpConfigOptionIndex[segment_idx].entries);
+		}
+		sccpConfigOptionIndex[segment_idx].size = 0;
+	}
+}
+
+/*!
+ * \brief Find of SCCP Config Options by scanning the option array
+ * \note fallback for when the option index could not be built, reference for the option index test
+ */
+static const SCCPConfigOption *sccp_find_config_linear(const sccp_config_segment_t segment, const char *name)
+{
+	long unsigned int i = 0;
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigOption *config = NULL;
 	char *token = NULL;
-	char *config_name = NULL;
+	char *saveptr = NULL;
 
+	if (!sccpConfigSegment || !name) {
+		return NULL;
+	}
+	config = sccpConfigSegment->config;
 	for (i = 0; i < sccpConfigSegment->config_size; i++) {
-		if (strstr(config[i].name, delims) != NULL) {
-			config_name = pbx_strdupa(config[i].name);
-			token = strtok(config_name, delims);
-			while (token != NULL) {
+		if (strstr(config[i].name, "|") != NULL) {
+			char *config_name = pbx_strdupa(config[i].name);
+			for (token = strtok_r(config_name, "|", &saveptr); token; token = strtok_r(NULL, "|", &saveptr)) {
 				if (!strcasecmp(token, name)) {
 					return &config[i];
 				}
-				token = strtok(NULL, delims);
 			}
 		}
 		if (!strcasecmp(config[i].name, name)) {
 			return &config[i];
 		}
 	}
+	return NULL;
+}
 
+/*!
+ * \brief Find of SCCP Config Options
+ * \note uses a binary search on the alias index built by sccp_config_build_option_index, falls back to sccp_find_config_linear when
+ * the index is not available
+ */
+static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+{
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigOptionIndexEntry *entries = NULL;
+	size_t keylen = 0;
+	size_t low = 0;
+	size_t high = 0;
+	size_t mid = 0;
+	int res = 0;
+
+	if (!sccpConfigSegment || !name) {
+		return NULL;
+	}
+	if (!sccpConfigOptionIndex[sccpConfigSegment - sccpConfigSegments].entries) {
+		return sccp_find_config_linear(segment, name);
+	}
+	entries = sccpConfigOptionIndex[sccpConfigSegment - sccpConfigSegments].entries;
+	keylen = strlen(name);
+	high = sccpConfigOptionIndex[sccpConfigSegment - sccpConfigSegments].size;
+
+	while (low < high) {											/* lower bound, so that duplicate names return the first table entry */
+		mid = low + (high - low) / 2;
+		res = sccp_config_index_keycmp(name, keylen, &entries[mid]);
+		if (res > 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (low < sccpConfigOptionIndex[sccpConfigSegment - sccpConfigSegments].size && !sccp_config_index_keycmp(name, keylen, &entries[low])) {
+		return entries[low].option;
+	}
 	return NULL;
 }
 
@@ -281,9 +431,10 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 	char delims[] = "|";
 	char option_name[strlen(configOptionName) + 2];
 	char *token = NULL;
+	char *saveptr = NULL;
 	
 	snprintf(option_name, sizeof(option_name), "%s%s", configOptionName, delims);
-	token = strtok(option_name, delims);
+	token = strtok_r(option_name, delims, &saveptr);
 	while (token != NULL) {
 		sccp_log_and((DEBUGCAT_CONFIG + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_4 "Token %s/%s\n", option_name, token);
 		for (v = cat_root; v; v = v->next) {
@@ -306,7 +457,7 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 				}
 			}
 		}
-		token = strtok(NULL, delims);
+		token = strtok_r(NULL, delims, &saveptr);
 	}
 EXIT:
 	return out;
@@ -1218,6 +1369,7 @@ sccp_value_changed_t sccp_config_parse_hotline_context(void *dest, const size_t
 			sccp_free(hotline->line->context);
 		}
 		hotline->line->context = pbx_strdup(value);
+		hotline->line->contextExists = FALSE;
 	}
 	return changed;
 }
@@ -2132,6 +2284,86 @@ sccp_value_changed_t sccp_config_addButton(sccp_buttonconfig_list_t *buttonconfi
 	return SCCP_CONFIG_CHANGE_CHANGED;
 }
 
+/*!
+ * \brief Apply Line Configuration from Asterisk Variable, without assigning a line id
+ * \note does not touch any global state, so it can be run for multiple lines in parallel
+ */
+static sccp_configurationchange_t __sccp_config_applyLineConfiguration(sccp_line_t * l, PBX_VARIABLE_TYPE * v)
+{
+	sccp_configurationchange_t res = SCCP_CONFIG_NOUPDATENEEDED;
+	boolean_t SetEntries[ARRAY_LEN(sccpLineConfigOptions)] = { FALSE };
+	PBX_VARIABLE_TYPE *cat_root = v;
+
+	for (; v; v = v->next) {
+		res |= sccp_config_object_setValue(l, cat_root, v->name, v->value, v->lineno, SCCP_CONFIG_LINE_SEGMENT, SetEntries);
+	}
+
+	sccp_config_set_defaults(l, SCCP_CONFIG_LINE_SEGMENT, SetEntries);
+
+	return res;
+}
+
+/*!
+ * \brief Fingerprint of the [general] section, used as seed for the device and line fingerprints (defaults are inherited from [general])
+ */
+static uint64_t sccp_config_general_fingerprint = 0;
+
+/*!
+ * \brief Calculate a fingerprint (64-bit FNV-1a) over all name/value pairs of a config section
+ * \note Only saves work on reload: an unchanged fingerprint keeps the existing device/line object. On the first load there are no
+ * existing objects yet, so every section is still parsed and applied.
+ * \param v Asterisk Variable
+ * \param seed Seed Fingerprint
+ * \return Fingerprint, never 0 (0 is reserved for 'unknown')
+ */
+static uint64_t sccp_config_fingerprint(PBX_VARIABLE_TYPE * v, uint64_t seed)
+{
+	uint64_t hash = 14695981039346656037ULL ^ seed;
+	const unsigned char *c = NULL;
+
+	for (; v; v = v->next) {
+		for (c = (const unsigned char *) v->name; *c; c++) {
+			hash = (hash ^ *c) * 1099511628211ULL;
+		}
+		hash = (hash ^ '=') * 1099511628211ULL;
+		for (c = (const unsigned char *) v->value; *c; c++) {
+			hash = (hash ^ *c) * 1099511628211ULL;
+		}
+		hash = (hash ^ '\n') * 1099511628211ULL;
+	}
+	return hash ? hash : 1;
+}
+
+/*!
+ * \brief Keep the current device configuration during reload, because the section did not change
+ * \param d SCCP Device
+ */
+static void sccp_config_keepDevice(sccp_device_t * d)
+{
+	sccp_buttonconfig_t *config = NULL;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		config->pendingDelete = 0;
+		config->pendingUpdate = 0;
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+	d->pendingUpdate = 0;
+	d->pendingDelete = 0;
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: device configuration unchanged, skip applying\n", d->id);
+}
+
+/*!
+ * \brief Keep the current line configuration during reload, because the section did not change
+ * \param l SCCP Line
+ */
+static void sccp_config_keepLine(sccp_line_t * l)
+{
+	l->pendingUpdate = 0;
+	l->pendingDelete = 0;
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: line configuration unchanged, skip applying\n", l->name);
+}
+
 /*!
  * \brief Build Line
  * \param l SCCP Line
@@ -2145,7 +2377,7 @@ sccp_value_changed_t sccp_config_addButton(sccp_buttonconfig_list_t *buttonconfi
  */
 static void sccp_config_buildLine(sccp_line_t * l, PBX_VARIABLE_TYPE * v, const char *lineName, boolean_t isRealtime)
 {
-	sccp_configurationchange_t res = sccp_config_applyLineConfiguration(l, v);
+	sccp_configurationchange_t res = __sccp_config_applyLineConfiguration(l, v);			/* line id gets assigned when the line is published */
 
 #ifdef CS_SCCP_REALTIME
 	l->realtime = isRealtime;
@@ -2308,6 +2540,7 @@ boolean_t sccp_config_general(sccp_readingtype_t readingtype)
 	}
 
 	sccp_configurationchange_t res = sccp_config_applyGlobalConfiguration(v);
+	sccp_config_general_fingerprint = sccp_config_fingerprint(v, 0);
 
 	/* setup bind-port */
 	if (!sccp_netsock_getPort(&GLOB(bindaddr))) {
@@ -2379,6 +2612,170 @@ void cleanup_stale_contexts(char *new, char *old)
 	}
 }
 
+#define SCCP_CONFIG_MAX_WORKERS 32										/* upper limit of config worker threads */
+#define SCCP_CONFIG_SECTIONS_PER_WORKER 16									/* don't start a thread for less than this number of sections */
+
+/*!
+ * \brief Staged device/line section
+ */
+typedef struct sccp_config_staged_section sccp_config_staged_section_t;
+struct sccp_config_staged_section {
+	sccp_config_segment_t segment;										/*!< SCCP_CONFIG_DEVICE_SEGMENT or SCCP_CONFIG_LINE_SEGMENT */
+	sccp_device_t *device;											/*!< retained device (device segment) */
+	sccp_line_t *line;											/*!< retained line (line segment) */
+	PBX_VARIABLE_TYPE *v;
+	const char *cat;
+	uint64_t fingerprint;
+	boolean_t isNew;											/*!< object still needs to be published to the global list */
+	sccp_nat_t nat;												/*!< nat status before reload */
+	sccp_config_staged_section_t *duplicate;								/*!< next section with the same name, applied after this one on the same object */
+};
+
+/*!
+ * \brief Staging Area for device/line sections which are applied in parallel
+ */
+typedef struct sccp_config_staging {
+	sccp_mutex_t lock;
+	size_t next;												/*!< index of the next section to be applied */
+	size_t size;
+	sccp_config_staged_section_t **sections;
+} sccp_config_staging_t;
+
+/*!
+ * \brief Apply a staged section and the duplicate sections merged into it, in config file order
+ * \note only touches the staged object itself, linking and publishing is done afterwards by sccp_config_publishStagedSection
+ */
+static void sccp_config_applyStagedSection(sccp_config_staged_section_t *section)
+{
+	for (; section; section = section->duplicate) {
+		if (SCCP_CONFIG_DEVICE_SEGMENT == section->segment) {
+			sccp_config_buildDevice(section->device, section->v, section->cat, FALSE);
+		} else {
+			sccp_config_buildLine(section->line, section->v, section->cat, FALSE);
+		}
+	}
+}
+
+/*!
+ * \brief Config Worker, applies staged sections until none are left
+ * \note runs on a dedicated thread (not on the general threadpool), as the caller holds the globals lock while waiting for it
+ */
+static void *sccp_config_applyWorker(void *data)
+{
+	sccp_config_staging_t *staging = data;
+	size_t idx = 0;
+
+	while (1) {
+		sccp_mutex_lock(&staging->lock);
+		idx = staging->next++;
+		sccp_mutex_unlock(&staging->lock);
+		if (idx >= staging->size) {
+			break;
+		}
+		sccp_config_applyStagedSection(staging->sections[idx]);
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Number of config worker threads to start (besides the calling thread), based on the number of online cores
+ */
+static int sccp_config_numWorkers(size_t sections)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t workers = cores > 1 ? (size_t) cores : 1;
+
+	if (workers > SCCP_CONFIG_MAX_WORKERS) {
+		workers = SCCP_CONFIG_MAX_WORKERS;
+	}
+	if (workers > sections / SCCP_CONFIG_SECTIONS_PER_WORKER) {
+		workers = sections / SCCP_CONFIG_SECTIONS_PER_WORKER;
+	}
+	return workers > 1 ? (int) workers - 1 : 0;
+}
+
+/*!
+ * \brief Find an earlier staged section for the same device/line
+ * \note duplicate sections used to be applied one after the other on the same object (merged, last value wins), chaining them
+ * keeps it that way and keeps two threads from applying to the same object
+ */
+static sccp_config_staged_section_t *sccp_config_findStagedSection(sccp_config_staged_section_t **sections, size_t size, sccp_config_segment_t segment, const char *cat)
+{
+	size_t idx = 0;
+
+	for (idx = 0; idx < size; idx++) {
+		if (sections[idx]->segment == segment && sccp_strcaseequals(sections[idx]->cat, cat)) {
+			return sections[idx];
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Merge a section into an earlier staged section with the same name
+ * \return TRUE when the section was handled as a duplicate
+ */
+static boolean_t sccp_config_mergeDuplicateSection(sccp_config_staged_section_t **sections, size_t size, sccp_config_segment_t segment, PBX_VARIABLE_TYPE *v, const char *cat)
+{
+	sccp_config_staged_section_t *first = sccp_config_findStagedSection(sections, size, segment, cat);
+	sccp_config_staged_section_t *last = first;
+	sccp_config_staged_section_t *section = NULL;
+
+	if (!first) {
+		return FALSE;
+	}
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "SCCP: (sccp_config_readDevicesLines) duplicate %s section [%s], merged into the previous one\n", SCCP_CONFIG_DEVICE_SEGMENT == segment ? "device" : "line", cat);
+	if (!(section = sccp_calloc(1, sizeof(sccp_config_staged_section_t)))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return TRUE;
+	}
+	section->segment = segment;
+	section->device = first->device ? sccp_device_retain(first->device) : NULL;
+	section->line = first->line ? sccp_line_retain(first->line) : NULL;
+	section->v = v;
+	section->cat = cat;
+	while (last->duplicate) {
+		last = last->duplicate;
+	}
+	last->duplicate = section;
+	first->fingerprint = 0;											/* fingerprint covers only one section, always re-apply on reload */
+	return TRUE;
+}
+
+/*!
+ * \brief Link and publish an applied section to the global lists (serial step)
+ */
+static void sccp_config_publishStagedSection(sccp_config_staged_section_t *section)
+{
+	if (SCCP_CONFIG_DEVICE_SEGMENT == section->segment) {
+		sccp_device_t *device = section->device;
+
+		device->config_fingerprint = section->fingerprint;
+		if (section->isNew) {
+			sccp_device_addToGlobals(device);
+		}
+		/* load saved settings from ast db */
+		sccp_config_restoreDeviceFeatureStatus(device);
+
+		/* restore current nat status, if device does not get restarted */
+		if (0 == device->pendingDelete && sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE) {
+			if (SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == section->nat || SCCP_NAT_AUTO_OFF == section->nat || SCCP_NAT_AUTO_ON == section->nat)) {
+				device->nat = section->nat;
+			}
+		}
+	} else {
+		sccp_line_t *line = section->line;
+
+		line->config_fingerprint = section->fingerprint;
+		if (sccp_strlen_zero(line->id)) {
+			snprintf(line->id, sizeof(line->id), "%04d", SCCP_LIST_GETSIZE(&GLOB(lines)));
+		}
+		if (section->isNew) {
+			sccp_line_addToGlobals(line);								/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when released */
+		}
+	}
+}
+
 /*!
  * \brief Read Lines from the Config File
  *
@@ -2398,7 +2795,16 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 	PBX_VARIABLE_TYPE *v = NULL;
 	uint8_t device_count = 0;
 	uint8_t line_count = 0;
+	uint unchanged_count = 0;
 	sccp_device_t *d = NULL;
+	sccp_config_staging_t staging = { .next = 0 };
+	sccp_config_staged_section_t *section = NULL;
+	sccp_config_staged_section_t *duplicate = NULL;
+	SCCP_VECTOR(, sccp_config_staged_section_t *) sections;
+	pthread_t workers[SCCP_CONFIG_MAX_WORKERS];
+	int num_workers = 0;
+	int worker = 0;
+	size_t idx = 0;
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Loading Devices and Lines from config\n");
 
@@ -2416,7 +2822,12 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		pbx_log(LOG_NOTICE, "SCCP: (sccp_config_readDevicesLines) Unable to load config file sccp.conf, SCCP disabled\n");
 		return;
 	}
+	if (SCCP_VECTOR_INIT(&sections, 64) != 0) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
 
+	/* phase 1: find or create the objects for all changed sections and stage them */
 	while ((cat = pbx_category_browse(GLOB(cfg), cat))) {
 
 		const char *utype;
@@ -2438,6 +2849,10 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 				continue;
 			} else {
 				v = ast_variable_browse(GLOB(cfg), cat);
+				if (sccp_config_mergeDuplicateSection(sections.elems, SCCP_VECTOR_SIZE(&sections), SCCP_CONFIG_DEVICE_SEGMENT, v, cat)) {
+					continue;
+				}
+				uint64_t fingerprint = sccp_config_fingerprint(v, sccp_config_general_fingerprint);
 
 				// Try to find out if we have the device already on file.
 				// However, do not look into realtime, since
@@ -2445,12 +2860,14 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 				// thus causing an infinite loop / recursion.
 				AUTO_RELEASE(sccp_device_t, device, sccp_device_find_byid(cat, FALSE));
 				sccp_nat_t nat = SCCP_NAT_AUTO;
+				boolean_t isNew = FALSE;
 
-				/* create new device with default values */
+				/* create new device with default values (published after it has been configured) */
 				if (!device) {
-					device = sccp_device_create(cat);
-					// sccp_copy_string(d->id, cat, sizeof(d->id));         /* set device name */
-					sccp_device_addToGlobals(device);
+					if (!(device = sccp_device_create(cat))) {
+						continue;
+					}
+					isNew = TRUE;
 					device_count++;
 				} else {
 					if (device->pendingDelete) {
@@ -2458,16 +2875,26 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 						device->pendingDelete = 0;
 					}
 				}
-				sccp_config_buildDevice(device, v, cat, FALSE);
 				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found device %d: %s\n", device_count, cat);
-				/* load saved settings from ast db */
-				sccp_config_restoreDeviceFeatureStatus(device);
-				
-				/* restore current nat status, if device does not get restarted */
-				if (0 == device->pendingDelete && sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE) {
-					if (SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == nat || SCCP_NAT_AUTO_OFF == nat || SCCP_NAT_AUTO_ON == nat)) {
+				if (readingtype == SCCP_CONFIG_READRELOAD && !isNew && device->config_fingerprint == fingerprint) {
+					sccp_config_keepDevice(device);
+					unchanged_count++;
+					sccp_config_restoreDeviceFeatureStatus(device);
+					if (sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE && SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == nat || SCCP_NAT_AUTO_OFF == nat || SCCP_NAT_AUTO_ON == nat)) {
 						device->nat = nat;
 					}
+				} else if ((section = sccp_calloc(1, sizeof(sccp_config_staged_section_t)))) {
+					section->segment = SCCP_CONFIG_DEVICE_SEGMENT;
+					section->device = sccp_device_retain(device);
+					section->v = v;
+					section->cat = cat;
+					section->fingerprint = fingerprint;
+					section->isNew = isNew;
+					section->nat = nat;
+					if (SCCP_VECTOR_APPEND(&sections, section) != 0) {
+						sccp_device_release(&section->device);				/* explicit release */
+						sccp_free(section);
+					}
 				}
 			}
 		} else if (!strcasecmp(utype, "line")) {
@@ -2481,18 +2908,38 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			line_count++;
 
 			v = ast_variable_browse(GLOB(cfg), cat);
+			if (sccp_config_mergeDuplicateSection(sections.elems, SCCP_VECTOR_SIZE(&sections), SCCP_CONFIG_LINE_SEGMENT, v, cat)) {
+				continue;
+			}
+			uint64_t fingerprint = sccp_config_fingerprint(v, sccp_config_general_fingerprint);
 			AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byname(cat, FALSE));
+			boolean_t isNew = FALSE;
 
 			/* check if we have this line already */
-			//    SCCP_RWLIST_WRLOCK(&GLOB(lines));
 			if (l) {
+				if (readingtype == SCCP_CONFIG_READRELOAD && l->config_fingerprint == fingerprint) {
+					sccp_config_keepLine(l);
+					unchanged_count++;
+					continue;
+				}
 				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found line %d: %s, do update\n", line_count, cat);
-				sccp_config_buildLine(l, v, cat, FALSE);
 			} else if ((l = sccp_line_create(cat))) {
-				sccp_config_buildLine(l, v, cat, FALSE);
-				sccp_line_addToGlobals(l);						/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when l is released */
+				isNew = TRUE;
+			} else {
+				continue;
+			}
+			if ((section = sccp_calloc(1, sizeof(sccp_config_staged_section_t)))) {
+				section->segment = SCCP_CONFIG_LINE_SEGMENT;
+				section->line = sccp_line_retain(l);
+				section->v = v;
+				section->cat = cat;
+				section->fingerprint = fingerprint;
+				section->isNew = isNew;
+				if (SCCP_VECTOR_APPEND(&sections, section) != 0) {
+					sccp_line_release(&section->line);					/* explicit release */
+					sccp_free(section);
+				}
 			}
-			//    SCCP_RWLIST_UNLOCK(&GLOB(lines));
 
 		} else if (!strcasecmp(utype, "softkeyset")) {
 			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "parsing softkey [%s]\n", cat);
@@ -2508,7 +2955,53 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 	}
 	sccp_config_add_default_softkeyset();
 
+	/* phase 2: apply the staged sections in parallel, they are independent until they get linked */
+	/* dedicated worker threads: the general threadpool is shared with jobs which might need GLOB(lock), held by our caller */
+	sccp_mutex_init(&staging.lock);
+	staging.sections = sections.elems;
+	staging.size = SCCP_VECTOR_SIZE(&sections);
+	num_workers = sccp_config_numWorkers(staging.size);
+	for (worker = 0; worker < num_workers; worker++) {
+		if (pbx_pthread_create(&workers[worker], NULL, sccp_config_applyWorker, &staging)) {
+			break;
+		}
+	}
+	num_workers = worker;
+	sccp_config_applyWorker(&staging);									/* take part ourselves, finishes all sections when no worker could be started */
+	for (worker = 0; worker < num_workers; worker++) {
+		pthread_join(workers[worker], NULL);
+	}
+	sccp_mutex_destroy(&staging.lock);
+
+	/* phase 3: link and publish (serial, in config file order) */
+	for (idx = 0; idx < SCCP_VECTOR_SIZE(&sections); idx++) {
+		section = SCCP_VECTOR_GET(&sections, idx);
+		sccp_config_publishStagedSection(section);
+		for (; section; section = duplicate) {
+			duplicate = section->duplicate;
+			if (section->device) {
+				sccp_device_release(&section->device);					/* explicit release */
+			}
+			if (section->line) {
+				sccp_line_release(&section->line);					/* explicit release */
+			}
+			sccp_free(section);
+		}
+	}
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "SCCP: applied %d device/line sections using %d threads\n", (int) SCCP_VECTOR_SIZE(&sections), num_workers + 1);
+	SCCP_VECTOR_FREE(&sections);
+
+	/* line contexts might have changed */
+	sccp_dialplan_cache_invalidate(NULL);
+
+	/* rtp_pool_size / bindaddr might have changed */
+	sccp_rtp_pool_reload();
+
 #ifdef CS_SCCP_REALTIME
+	/* drop cached realtime lookups, the database might have changed as well, and start prefetching (if enabled) */
+	sccp_realtime_cache_invalidate(NULL, NULL);
+	sccp_realtime_prefetch_start();
+
 	/* reload realtime lines */
 	sccp_configurationchange_t res = SCCP_CONFIG_NOUPDATENEEDED;
 	PBX_VARIABLE_TYPE *rv = NULL;
@@ -2530,7 +3023,15 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 					}
 					line->pendingDelete = 0;
 
+					uint64_t fingerprint = sccp_config_fingerprint(rv, sccp_config_general_fingerprint);
+					if (line->config_fingerprint == fingerprint) {
+						sccp_config_keepLine(line);
+						unchanged_count++;
+						pbx_variables_destroy(rv);
+						break;
+					}
 					res = sccp_config_applyLineConfiguration(line, rv);
+					line->config_fingerprint = fingerprint;
 					/* check if we did some changes that needs a device update */
 					if (GLOB(reload_in_progress) && res & SCCP_CONFIG_NEEDDEVICERESET) {
 						line->pendingUpdate = 1;
@@ -2561,7 +3062,15 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 					}
 					device->pendingDelete = 0;
 
+					uint64_t fingerprint = sccp_config_fingerprint(rv, sccp_config_general_fingerprint);
+					if (device->config_fingerprint == fingerprint) {
+						sccp_config_keepDevice(device);
+						unchanged_count++;
+						pbx_variables_destroy(rv);
+						break;
+					}
 					res = sccp_config_applyDeviceConfiguration(device, rv);
+					device->config_fingerprint = fingerprint;
 					/* check if we did some changes that needs a device update */
 					if (GLOB(reload_in_progress) && res & SCCP_CONFIG_NEEDDEVICERESET) {
 						device->pendingUpdate = 1;
@@ -2592,6 +3101,7 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		GLOB(pendingUpdate) = 0;
 	}
 	GLOB(pendingUpdate) = 0;
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "SCCP: %u device/line sections unchanged since last load, skipped\n", unchanged_count);
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Checking Reading Type\n");
 	if (readingtype == SCCP_CONFIG_READRELOAD) {
@@ -2620,15 +3130,7 @@ void sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
  */
 sccp_configurationchange_t sccp_config_applyLineConfiguration(sccp_line_t * l, PBX_VARIABLE_TYPE * v)
 {
-	sccp_configurationchange_t res = SCCP_CONFIG_NOUPDATENEEDED;
-	boolean_t SetEntries[ARRAY_LEN(sccpLineConfigOptions)] = { FALSE };
-	PBX_VARIABLE_TYPE *cat_root = v;
-
-	for (; v; v = v->next) {
-		res |= sccp_config_object_setValue(l, cat_root, v->name, v->value, v->lineno, SCCP_CONFIG_LINE_SEGMENT, SetEntries);
-	}
-
-	sccp_config_set_defaults(l, SCCP_CONFIG_LINE_SEGMENT, SetEntries);
+	sccp_configurationchange_t res = __sccp_config_applyLineConfiguration(l, v);
 
 	if (sccp_strlen_zero(l->id)) {
 		snprintf(l->id, sizeof(l->id), "%04d", SCCP_LIST_GETSIZE(&GLOB(lines)));
@@ -3495,6 +3997,72 @@ AST_TEST_DEFINE(sccp_config_base_functions)
 	return AST_TEST_PASS;
 }
 
+AST_TEST_DEFINE(sccp_config_option_index)
+{
+	uint8_t segment_idx = 0;
+	long unsigned int i = 0;
+	int loop = 0;
+	int loops = 1000;
+	char *alias = NULL;
+	char *saveptr = NULL;
+	const SCCPConfigOption *option = NULL;
+	struct timeval start;
+	int64_t linear_us = 0;
+	int64_t index_us = 0;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "OptionIndex";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config option lookup test/benchmark";
+			info->description = "chan-sccp-b config option index lookups compared to linear scan";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pbx_test_status_update(test, "Verify option index against linear lookup...\n");
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		const SCCPConfigSegment *sccpConfigSegment = &sccpConfigSegments[segment_idx];
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			option = &sccpConfigSegment->config[i];
+			pbx_test_validate(test, sccp_find_config(sccpConfigSegment->segment, option->name) == sccp_find_config_linear(sccpConfigSegment->segment, option->name));
+			char *names = pbx_strdupa(option->name);
+			for (alias = strtok_r(names, "|", &saveptr); alias; alias = strtok_r(NULL, "|", &saveptr)) {
+				pbx_test_validate(test, sccp_find_config(sccpConfigSegment->segment, alias) == sccp_find_config_linear(sccpConfigSegment->segment, alias));
+			}
+		}
+	}
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "ALLOW") == sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "disallow|allow"));
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "nonexistent_option") == NULL);
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "allo") == NULL);
+
+	/* benchmark, only reported: wall clock timings are not reliable enough to fail a test on */
+	pbx_test_status_update(test, "Benchmark lookup of all options in all segments (%d loops)...\n", loops);
+	start = pbx_tvnow();
+	for (loop = 0; loop < loops; loop++) {
+		for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+			for (i = 0; i < sccpConfigSegments[segment_idx].config_size; i++) {
+				option = sccp_find_config_linear(sccpConfigSegments[segment_idx].segment, sccpConfigSegments[segment_idx].config[i].name);
+			}
+		}
+	}
+	linear_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	start = pbx_tvnow();
+	for (loop = 0; loop < loops; loop++) {
+		for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+			for (i = 0; i < sccpConfigSegments[segment_idx].config_size; i++) {
+				option = sccp_find_config(sccpConfigSegments[segment_idx].segment, sccpConfigSegments[segment_idx].config[i].name);
+			}
+		}
+	}
+	index_us = ast_tvdiff_us(pbx_tvnow(), start);
+	pbx_test_status_update(test, "linear lookup: %" PRId64 " us, indexed lookup: %" PRId64 " us (%.1fx)\n", linear_us, index_us, index_us ? (double) linear_us / index_us : 0.0);
+
+	return AST_TEST_PASS;
+}
+
 AST_TEST_DEFINE(sccp_config_multientry)
 {
 	switch(cmd) {
@@ -3605,6 +4173,7 @@ static void __attribute__((constructor)) sccp_register_tests(void)
 	AST_TEST_REGISTER(sccp_config_base_functions);
 	AST_TEST_REGISTER(sccp_config_multientry);
 	AST_TEST_REGISTER(sccp_config_tokenized_default);
+	AST_TEST_REGISTER(sccp_config_option_index);
 	//AST_TEST_REGISTER(sccp_config_setValue);
 	//AST_TEST_REGISTER(sccp_config_setDefault);
 }
@@ -3614,6 +4183,7 @@ static void __attribute__((destructor)) sccp_unregister_tests(void)
 	AST_TEST_UNREGISTER(sccp_config_base_functions);
 	AST_TEST_UNREGISTER(sccp_config_multientry);
 	AST_TEST_UNREGISTER(sccp_config_tokenized_default);
+	AST_TEST_UNREGISTER(sccp_config_option_index);
 	//AST_TEST_UNREGISTER(sccp_config_setValue);
 	//AST_TEST_UNREGISTER(sccp_config_setDefault);
 }
@@ -54,6 +54,9 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 	{"externrefresh", 		G_OBJ_REF(externrefresh), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,  					SCCP_CONFIG_NEEDDEVICERESET,		"60",				"Expire time in seconds for the hostname (dns resolution)\n"},
 	{"firstdigittimeout", 		G_OBJ_REF(firstdigittimeout), 		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"16",				"Dialing timeout for the 1st digit\n"},
 	{"digittimeout", 		G_OBJ_REF(digittimeout), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"8",				"More digits\n"},
+	{"dialplan_cache_ttl", 		G_OBJ_REF(dialplan_cache_ttl), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Number of seconds the result of a dialplan match for a (partially) dialed number is kept in memory, so that overlap dialing does not need to ask the pbx on every digit (0 = disabled)\n"},
+	{"rtp_pool_size", 		G_OBJ_REF(rtp_pool_size), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Number of audio rtp instances which are created and bound in advance, so that call setup does not have to wait for them (0 = disabled, max 128)\n"},
+	{"calltrace_threshold", 	G_OBJ_REF(calltrace_threshold), 	TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Log the call setup timeline (dialplan, pbx, phone rtp open, media start) of calls where one of these phases took longer than this number of milliseconds (0 = disabled). See 'sccp show stats callsetup'\n"},
 	{"digittimeoutchar", 		G_OBJ_REF(digittimeoutchar), 		TYPE_CHAR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"#",				"You can force the channel to dial with this char in the dialing state\n"},
 	{"recorddigittimeoutchar", 	G_OBJ_REF(recorddigittimeoutchar), 	TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"You can force the channel to dial with this char in the dialing state\n"},
 	{"simulate_enbloc",	 	G_OBJ_REF(simulate_enbloc), 		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"yes",				"Use simulated enbloc dialing to speedup connection when dialing while onhook (older phones)\n"},
@@ -116,6 +119,9 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 #ifdef CS_SCCP_REALTIME
 	{"devicetable", 		G_OBJ_REF(realtimedevicetable), 	TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpdevice",			"datebasetable for devices\n"},
 	{"linetable", 			G_OBJ_REF(realtimelinetable), 		TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpline",			"datebasetable for lines\n"},
+	{"realtime_cache_ttl", 		G_OBJ_REF(realtime_cache_ttl), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Number of seconds a realtime device/line lookup result is kept in memory before the database is queried again (0 = disabled)\n"},
+	{"realtime_prefetch", 		G_OBJ_REF(realtime_prefetch), 		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Load all devicetable/linetable rows into the realtime lookup cache using one query per table, in the background at startup/reload and every N seconds after that (0 = disabled)\n"},
+	{"realtime_negative_ttl", 	G_OBJ_REF(realtime_negative_ttl), 	TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"0",				"Number of seconds an unknown device/line name is remembered as 'not found', to protect the database against unknown devices repeatedly trying to register (0 = disabled)\n"},
 #endif
 	{"meetme", 			G_OBJ_REF(meetme), 			TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"yes",				"enable/disable conferencing via meetme (on/off), make sure you have one of the meetme apps mentioned below activated in module.conf\n"
 																																	"when switching meetme=on it will search for the first of these three possible meetme applications and set these defaults\n"
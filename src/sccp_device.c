@@ -30,6 +30,7 @@
 #include "sccp_atomic.h"
 #include "sccp_devstate.h"
 #include "sccp_featureParkingLot.h"
+#include "sccp_realtime.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -47,6 +48,20 @@ int sccp_device_destroy(const void *ptr);
 /*!
  * \brief Private Device Data Structure
  */
+#define SCCP_DEVICE_SHADOW_ENTRIES 32
+#define SCCP_DEVICE_SHADOW_PAYLOAD 64
+
+/*!
+ * \brief Last sent value of an idempotent message (keyed by message id, instance and callid)
+ */
+typedef struct sccp_device_shadow_entry {
+	sccp_mid_t mid;												/*!< Message Id (0 = unused entry) */
+	uint32_t instance;											/*!< Line/Stimulus Instance */
+	uint32_t callid;											/*!< Call Reference */
+	uint32_t length;											/*!< Payload Length */
+	unsigned char payload[SCCP_DEVICE_SHADOW_PAYLOAD];							/*!< Payload as sent */
+} sccp_device_shadow_entry_t;
+
 struct sccp_private_device_data {
 	sccp_mutex_t lock;
 	
@@ -54,6 +69,13 @@ struct sccp_private_device_data {
 	sccp_devicestate_t deviceState;											/*!< Device State */
 
 	skinny_registrationstate_t registrationState;
+
+	struct {
+		sccp_device_shadow_entry_t entries[SCCP_DEVICE_SHADOW_ENTRIES];					/*!< Shadow of idempotent messages sent to the device */
+		uint8_t next;											/*!< Next entry to be replaced when full */
+		uint32_t checked;										/*!< Number of messages checked against the shadow */
+		uint32_t suppressed;										/*!< Number of messages suppressed because nothing changed */
+	} shadow;
 };
 
 #define sccp_private_lock(x) sccp_mutex_lock(&((struct sccp_private_device_data * const)(x))->lock)			/* discard const */
@@ -522,6 +544,7 @@ int sccp_device_setRegistrationState(constDevicePtr d, const skinny_registration
 	sccp_private_lock(d->privateData);
 	if (state != d->privateData->registrationState) {
 		d->privateData->registrationState = state;
+		memset(d->privateData->shadow.entries, 0, sizeof(d->privateData->shadow.entries));		/* the phone forgets its state on (re-)registration */
 		changed=1;
 	}
 	sccp_private_unlock(d->privateData);
@@ -530,6 +553,126 @@ int sccp_device_setRegistrationState(constDevicePtr d, const skinny_registration
 	return changed;
 }
 
+/*!
+ * \brief Forget everything we know about the output state of the device
+ * \note To be called when the phone might have changed its state locally (for example on hook/stimulus/softkey events)
+ */
+void sccp_device_shadow_clear(constDevicePtr d)
+{
+	if (!d || !d->privateData) {
+		return;
+	}
+	sccp_private_lock(d->privateData);
+	memset(d->privateData->shadow.entries, 0, sizeof(d->privateData->shadow.entries));
+	sccp_private_unlock(d->privateData);
+}
+
+void sccp_device_shadow_getStats(constDevicePtr d, uint32_t *checked, uint32_t *suppressed)
+{
+	pbx_assert(d != NULL && d->privateData != NULL);
+
+	sccp_private_lock(d->privateData);
+	*checked = d->privateData->shadow.checked;
+	*suppressed = d->privateData->shadow.suppressed;
+	sccp_private_unlock(d->privateData);
+}
+
+/*!
+ * \brief Check an outgoing message against the shadow of last sent values
+ * \return TRUE when the message would not change anything on the device and can be dropped
+ *
+ * \note Only idempotent messages are considered. Messages which are replies to a request made by the device (like LineStat) are never suppressed.
+ */
+static boolean_t sccp_device_shadow_suppress(constDevicePtr d, const sccp_msg_t * msg)
+{
+	sccp_mid_t mid = letohl(msg->header.lel_messageId);
+	uint32_t length = letohl(msg->header.length) - 4;
+	uint32_t instance = 0;
+	uint32_t callid = 0;
+	boolean_t forget = FALSE;
+	boolean_t suppress = FALSE;
+	sccp_device_shadow_entry_t *entry = NULL;
+	sccp_device_shadow_entry_t *unused = NULL;
+	uint8_t idx = 0;
+
+	switch (mid) {
+		case SetLampMessage:
+			instance = (letohl(msg->data.SetLampMessage.lel_stimulus) << 16) | (letohl(msg->data.SetLampMessage.lel_stimulusInstance) & 0xFFFF);
+			break;
+		case SetRingerMessage:
+		case SetSpeakerModeMessage:
+		case ActivateCallPlaneMessage:
+			break;
+		case DeactivateCallPlaneMessage:
+			forget = TRUE;										/* call plane is gone, the next activate has to be sent */
+			break;
+		case SelectSoftKeysMessage:
+			instance = letohl(msg->data.SelectSoftKeysMessage.lel_lineInstance);
+			callid = letohl(msg->data.SelectSoftKeysMessage.lel_callReference);
+			break;
+		case DisplayPromptStatusMessage:
+			instance = letohl(msg->data.DisplayPromptStatusMessage.lel_lineInstance);
+			callid = letohl(msg->data.DisplayPromptStatusMessage.lel_callReference);
+			forget = msg->data.DisplayPromptStatusMessage.lel_messageTimeout ? TRUE : FALSE;		/* prompt will disappear by itself */
+			break;
+		case DisplayDynamicPromptStatusMessage:
+			instance = letohl(msg->data.DisplayDynamicPromptStatusMessage.lel_lineInstance);
+			callid = letohl(msg->data.DisplayDynamicPromptStatusMessage.lel_callReference);
+			forget = msg->data.DisplayDynamicPromptStatusMessage.lel_messageTimeout ? TRUE : FALSE;
+			break;
+		case ClearPromptStatusMessage:
+			instance = letohl(msg->data.ClearPromptStatusMessage.lel_lineInstance);
+			callid = letohl(msg->data.ClearPromptStatusMessage.lel_callReference);
+			forget = TRUE;
+			break;
+		default:
+			return FALSE;
+	}
+	if (length > SCCP_DEVICE_SHADOW_PAYLOAD) {
+		forget = TRUE;
+	}
+
+	sccp_private_lock(d->privateData);
+	for (idx = 0; idx < SCCP_DEVICE_SHADOW_ENTRIES; idx++) {
+		sccp_device_shadow_entry_t *cur = &d->privateData->shadow.entries[idx];
+
+		if (!cur->mid) {
+			if (!unused) {
+				unused = cur;
+			}
+		} else if (cur->instance == instance && cur->callid == callid && (cur->mid == mid || (forget && (cur->mid == DisplayPromptStatusMessage || cur->mid == DisplayDynamicPromptStatusMessage)) || (mid == DeactivateCallPlaneMessage && cur->mid == ActivateCallPlaneMessage))) {
+			if (forget) {
+				cur->mid = 0;										/* prompt / call plane is going to be replaced/cleared */
+				continue;
+			}
+			entry = cur;
+			break;
+		}
+	}
+	if (!forget) {
+		d->privateData->shadow.checked++;
+		if (entry && entry->length == length && !memcmp(entry->payload, &msg->data, length)) {
+			d->privateData->shadow.suppressed++;
+			suppress = TRUE;
+		} else {
+			if (!entry) {
+				entry = unused ? unused : &d->privateData->shadow.entries[d->privateData->shadow.next++ % SCCP_DEVICE_SHADOW_ENTRIES];
+			}
+			entry->mid = mid;
+			entry->instance = instance;
+			entry->callid = callid;
+			entry->length = length;
+			memcpy(entry->payload, &msg->data, length);
+		}
+	}
+	sccp_private_unlock(d->privateData);
+
+	if (suppress) {
+		sccp_log((DEBUGCAT_MESSAGE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: >> Suppressed unchanged message %s\n", d->id, msgtype2str(mid));
+	}
+	return suppress;
+}
+
 /* ======================================================================================================== end getters / setters for privateData */
 
 /*!
@@ -1219,6 +1362,10 @@ int sccp_dev_send(constDevicePtr d, sccp_msg_t * msg)
 	int result = -1;
 
 	if (d && d->session && msg) {
+		if (d->privateData && sccp_device_shadow_suppress(d, msg)) {
+			sccp_free(msg);
+			return 0;
+		}
 		sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Send message %s\n", d->id, msgtype2str(letohl(msg->header.lel_messageId)));
 		result = sccp_session_send(d, msg);
 	} else {
@@ -1227,6 +1374,26 @@ int sccp_dev_send(constDevicePtr d, sccp_msg_t * msg)
 	return result;
 }
 
+/*!
+ * \brief Send SCCP Message to Device, without taking ownership of the message
+ * \param d SCCP Device
+ * \param msg SCCP Message (for example built by sccp_msg_encoder, remains owned by the caller)
+ * \return Status as int
+ */
+int sccp_dev_sendStatic(constDevicePtr d, sccp_msg_t * msg)
+{
+	int result = -1;
+
+	if (d && d->session && msg) {
+		if (d->privateData && sccp_device_shadow_suppress(d, msg)) {
+			return 0;
+		}
+		sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Send message %s\n", d->id, msgtype2str(letohl(msg->header.lel_messageId)));
+		result = sccp_session_sendStatic(d->session, msg);
+	}
+	return result;
+}
+
 /*!
  * \brief Send an SCCP message to a device
  * \param d SCCP Device
@@ -1493,12 +1660,17 @@ void sccp_dev_set_cplane(constDevicePtr device, uint8_t lineInstance, int status
  */
 void sccp_dev_deactivate_cplane(constDevicePtr d)
 {
+	sccp_msg_t *msg = NULL;
+
 	if (!d) {
 		sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "Null device for deactivate callplane\n");
 		return;
 	}
-
-	sccp_dev_sendmsg(d, DeactivateCallPlaneMessage);
+	REQCMD(msg, DeactivateCallPlaneMessage);
+	if (!msg) {
+		return;
+	}
+	sccp_dev_send(d, msg);											/* through the shadow, which forgets the last ActivateCallPlane */
 	sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Send deactivate call plane\n", d->id);
 }
 
@@ -3247,7 +3419,7 @@ sccp_device_t *sccp_device_find_realtime(const char *name)
 	if (sccp_strlen_zero(GLOB(realtimedevicetable)) || sccp_strlen_zero(name)) {
 		return NULL;
 	}
-	if ((variable = pbx_load_realtime(GLOB(realtimedevicetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(GLOB(realtimedevicetable), name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Device '%s' found in realtime table '%s'\n", name, GLOB(realtimedevicetable));
 
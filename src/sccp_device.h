@@ -10,6 +10,7 @@
  *
  */
 #pragma once
+#include "sccp_callquality.h"
 
 #define sccp_device_retain(_x)		sccp_refcount_retain_type(sccp_device_t, _x)
 #define sccp_device_release(_x)		sccp_refcount_release_type(sccp_device_t, _x)
@@ -316,6 +317,8 @@ struct sccp_device {
 	} messageStack;
 	
 	sccp_call_statistics_t call_statistics[2];								/*!< Call statistics */
+	sccp_callquality_t callquality;										/*!< Rolling call quality histograms */
+	sccp_callquality_pending_t callquality_pending[SCCP_CALLQUALITY_PENDING];				/*!< Outstanding connection statistics requests */
 	char *softkeyDefinition;										/*!< requested softKey configuration */
 	sccp_softKeySetConfiguration_t *softkeyset;								/*!< Allow for a copy of the softkeyset, if any of the softkeys needs to be redefined, for example for urihook/uriaction */
 
@@ -345,6 +348,7 @@ struct sccp_device {
 
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this will contain the updated line struct once reloaded from config to update the line when unused */
+	uint64_t config_fingerprint;										/*!< fingerprint of the configuration last applied to this device (0 = unknown) */
 };
 
 // Number of additional keys per addon -FS
@@ -396,6 +400,8 @@ SCCP_API const SCCP_CALL sccp_devicestate_t sccp_device_getDeviceState(constDevi
 SCCP_API int SCCP_CALL sccp_device_setDeviceState(constDevicePtr d, const sccp_devicestate_t state);
 SCCP_API const SCCP_CALL skinny_registrationstate_t sccp_device_getRegistrationState(constDevicePtr d);
 SCCP_API int SCCP_CALL sccp_device_setRegistrationState(constDevicePtr d, const skinny_registrationstate_t state);
+SCCP_API void SCCP_CALL sccp_device_shadow_clear(constDevicePtr d);
+SCCP_API void SCCP_CALL sccp_device_shadow_getStats(constDevicePtr d, uint32_t *checked, uint32_t *suppressed);
 /* ======================================================================================================== end getters / setters for privateData */
 
 /* live cycle */
@@ -452,6 +458,7 @@ SCCP_API void SCCP_CALL sccp_device_sendcallstate(constDevicePtr d, uint8_t inst
 SCCP_API void SCCP_CALL sccp_device_sendCallHistoryDisposition(constDevicePtr d, uint8_t lineInstance, uint32_t callid, skinny_callHistoryDisposition_t disposition);
 
 SCCP_API int SCCP_CALL sccp_dev_send(constDevicePtr d, sccp_msg_t * msg);
+SCCP_API int SCCP_CALL sccp_dev_sendStatic(constDevicePtr d, sccp_msg_t * msg);
 #if UNUSEDCODE // 2015-11-01
 SCCP_API int SCCP_CALL sccp_device_check_ringback(devicePtr d);
 #endif
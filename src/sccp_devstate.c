@@ -239,23 +239,10 @@ void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, c
 void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber)
 {
 	pbx_assert(subscriber->device != NULL);
-	sccp_msg_t *msg = NULL;
-
-	if (subscriber->device->inuseprotocolversion >= 15) {
-		REQ(msg, FeatureStatDynamicMessage);
-		msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
-		msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-	} else {
-		REQ(msg, FeatureStatMessage);
-		msg->data.FeatureStatMessage.lel_featureIndex = htolel(subscriber->instance);
-		msg->data.FeatureStatMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
-	}
 
-	sccp_dev_send(subscriber->device, msg);
+	if (subscriber->device->protocol) {
+		subscriber->device->protocol->sendFeatureStatus(subscriber->device, subscriber->instance, SKINNY_BUTTONTYPE_FEATURE, deviceState->featureState, subscriber->label);
+	}
 }
 
 //void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
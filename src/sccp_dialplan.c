@@ -0,0 +1,483 @@
+/*!
+ * \file        sccp_dialplan.c
+ * \brief       SCCP Dialplan Match Cache
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Remember whether a (partially) dialed number matches the dialplan, per context
+ *              When to use:    Instead of calling iPbx.extension_status directly, while the user is dialing
+ *              Relations:      Used by sccp_pbx_helper and sccp_pbx_softswitch
+ */
+
+/*!
+ * \section sccp_dialplan Dialplan Match Cache
+ *
+ * During overlap dialing every digit the user enters results in a call to iPbx.extension_status, which asks the pbx whether the number
+ * dialed so far exists, can match or matches more in the context of the channel. Each of these calls walks the patterns of the context
+ * (and its includes) several times. Because users dial the same prefixes all day long, the results are kept in a prefix trie per
+ * context/callerid (patterns can match on callerid as well), built lazily while numbers are being dialed:
+ *  - only numbers consisting of "0123456789*#+ABCD" are cached, anything else is passed to the pbx directly
+ *  - only positive results (match more / exact match) are cached, so that newly created (dynamic) extensions are found immediately
+ *  - the pickup extension of the channel (features config) is passed to the pbx directly, as its result differs per channel
+ *  - results live for 'dialplan_cache_ttl' seconds (default 0, disabled)
+ *  - every trie is built for a cache generation, which is advanced when the pbx reports a reload (manager Reload event, dialplan reload),
+ *    stale tries are dropped before they are used again
+ *
+ * Changes which are not announced by a reload (CLI 'dialplan add extension', realtime / lua switches) are only picked up after the ttl
+ * expired. The cache is flushed on 'sccp reload' and can be flushed (completely or per context) via CLI/AMI.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_dialplan.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_DIALPLAN_CACHE_BUCKETS 64
+#define SCCP_DIALPLAN_CACHE_MAX_NODES 32768
+#define SCCP_DIALPLAN_DIGITS "0123456789*#+ABCD"
+#define SCCP_DIALPLAN_DIGITS_LEN (sizeof(SCCP_DIALPLAN_DIGITS) - 1)
+
+/*!
+ * \brief Dialplan Cache Trie Node (one per dialed prefix)
+ */
+typedef struct sccp_dialplan_node sccp_dialplan_node_t;
+struct sccp_dialplan_node {
+	sccp_dialplan_node_t *children[SCCP_DIALPLAN_DIGITS_LEN];						/*!< Next digit, indexed by position in SCCP_DIALPLAN_DIGITS */
+	time_t expires;												/*!< Time at which the cached status becomes stale, 0 when nothing is cached for this prefix */
+	sccp_extension_status_t status;										/*!< Cached Extension Status */
+};
+
+/*!
+ * \brief Dialplan Cache Trie Root (one per context/callerid)
+ */
+typedef struct sccp_dialplan_root sccp_dialplan_root_t;
+struct sccp_dialplan_root {
+	sccp_dialplan_root_t *next;										/*!< Next root in bucket */
+	unsigned int hash;											/*!< Hash of context + callerid */
+	uint32_t generation;											/*!< Cache generation the trie has been built for */
+	int nodes;												/*!< Number of nodes below root */
+	sccp_dialplan_node_t trie;										/*!< Empty prefix */
+	char *context;												/*!< Context Name */
+	char *cid_num;												/*!< Callerid Number */
+};
+
+/*!
+ * \brief Dialplan Cache Statistics
+ */
+static struct {
+	sccp_mutex_t lock;											/*!< Only used when the platform has no atomic operations */
+	volatile CAS32_TYPE hits;
+	volatile CAS32_TYPE misses;
+	volatile CAS32_TYPE bypassed;
+	volatile CAS32_TYPE stored;
+	volatile CAS32_TYPE reloaded;
+	volatile CAS32_TYPE flushed;
+	int nodes;												/*!< Protected by cache_lock */
+} cache_stats;
+
+static ast_rwlock_t cache_lock;
+static sccp_dialplan_root_t *cache_buckets[SCCP_DIALPLAN_CACHE_BUCKETS];
+static boolean_t cache_running = FALSE;
+static volatile CAS32_TYPE cache_generation = 0;								/* advanced on every pbx reload */
+
+/* ========================================================================================================================= Helpers */
+static unsigned int sccp_dialplan_cache_hash(const char *context, const char *cid_num)
+{
+	unsigned int hash = 5381;
+
+	for (; *context; context++) {
+		hash = ((hash << 5) + hash) ^ (unsigned char) *context;
+	}
+	hash = ((hash << 5) + hash) ^ '/';
+	for (; *cid_num; cid_num++) {
+		hash = ((hash << 5) + hash) ^ (unsigned char) *cid_num;
+	}
+	return hash;
+}
+
+static gcc_inline int sccp_dialplan_digit_index(char digit)
+{
+	const char *pos = digit ? strchr(SCCP_DIALPLAN_DIGITS, digit) : NULL;
+
+	return pos ? (int) (pos - SCCP_DIALPLAN_DIGITS) : -1;
+}
+
+static boolean_t sccp_dialplan_cacheable(const char *number)
+{
+	for (; *number; number++) {
+		if (sccp_dialplan_digit_index(*number) < 0) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*!
+ * \brief Free all nodes below node
+ * \return Number of nodes freed
+ */
+static int sccp_dialplan_trie_clear(sccp_dialplan_node_t * node)
+{
+	uint idx = 0;
+	int freed = 0;
+
+	for (idx = 0; idx < SCCP_DIALPLAN_DIGITS_LEN; idx++) {
+		if (node->children[idx]) {
+			freed += sccp_dialplan_trie_clear(node->children[idx]) + 1;
+			sccp_free(node->children[idx]);
+			node->children[idx] = NULL;
+		}
+	}
+	node->expires = 0;
+	return freed;
+}
+
+static void sccp_dialplan_root_destroy(sccp_dialplan_root_t * root)
+{
+	cache_stats.nodes -= sccp_dialplan_trie_clear(&root->trie);
+	sccp_free(root->context);
+	sccp_free(root->cid_num);
+	sccp_free(root);
+}
+
+/*!
+ * \brief Find the trie for context/callerid in its bucket
+ * \note cache_lock needs to be held
+ */
+static sccp_dialplan_root_t *sccp_dialplan_cache_find(const char *context, const char *cid_num, unsigned int hash)
+{
+	sccp_dialplan_root_t *root = NULL;
+
+	for (root = cache_buckets[hash % SCCP_DIALPLAN_CACHE_BUCKETS]; root; root = root->next) {
+		if (root->hash == hash && sccp_strequals(root->context, context) && sccp_strequals(root->cid_num, cid_num)) {
+			break;
+		}
+	}
+	return root;
+}
+
+/*!
+ * \brief Remove all tries (of one context)
+ * \note cache_lock needs to be write locked
+ */
+static int sccp_dialplan_cache_remove(const char *context)
+{
+	sccp_dialplan_root_t **rootp = NULL, *root = NULL;
+	uint bucket = 0;
+	int removed = 0;
+
+	for (bucket = 0; bucket < SCCP_DIALPLAN_CACHE_BUCKETS; bucket++) {
+		rootp = &cache_buckets[bucket];
+		while ((root = *rootp)) {
+			if (!context || sccp_strequals(root->context, context)) {
+				*rootp = root->next;
+				removed += root->nodes;
+				sccp_dialplan_root_destroy(root);
+			} else {
+				rootp = &root->next;
+			}
+		}
+	}
+	return removed;
+}
+
+/*!
+ * \brief Store the status of a dialed number in the trie for context/callerid
+ */
+static void sccp_dialplan_cache_store(const char *context, const char *cid_num, unsigned int hash, uint32_t generation, const char *number, sccp_extension_status_t status, time_t expires)
+{
+	sccp_dialplan_root_t *root = NULL;
+	sccp_dialplan_node_t *node = NULL;
+	int idx = 0;
+
+	pbx_rwlock_wrlock(&cache_lock);
+	if (generation != (uint32_t) ATOMIC_FETCH(&cache_generation, &cache_stats.lock)) {			/* pbx reloaded while we were asking it */
+		pbx_rwlock_unlock(&cache_lock);
+		return;
+	}
+	if (cache_stats.nodes + (int) strlen(number) > SCCP_DIALPLAN_CACHE_MAX_NODES) {
+		sccp_log((DEBUGCAT_PBX)) (VERBOSE_PREFIX_3 "SCCP: (dialplan_cache) reached %d nodes, flushing\n", cache_stats.nodes);
+		sccp_dialplan_cache_remove(NULL);
+		ATOMIC_INCR(&cache_stats.flushed, 1, &cache_stats.lock);
+	}
+	if (!(root = sccp_dialplan_cache_find(context, cid_num, hash))) {
+		if (!(root = sccp_calloc(1, sizeof(sccp_dialplan_root_t)))) {
+			pbx_rwlock_unlock(&cache_lock);
+			return;
+		}
+		root->hash = hash;
+		root->generation = generation;
+		root->context = pbx_strdup(context);
+		root->cid_num = pbx_strdup(cid_num);
+		root->next = cache_buckets[hash % SCCP_DIALPLAN_CACHE_BUCKETS];
+		cache_buckets[hash % SCCP_DIALPLAN_CACHE_BUCKETS] = root;
+	} else if (root->generation != generation) {
+		/* pbx has been reloaded since this trie was filled */
+		cache_stats.nodes -= sccp_dialplan_trie_clear(&root->trie);
+		root->nodes = 0;
+		root->generation = generation;
+		ATOMIC_INCR(&cache_stats.reloaded, 1, &cache_stats.lock);
+	}
+	for (node = &root->trie; *number; number++) {
+		idx = sccp_dialplan_digit_index(*number);
+		if (!node->children[idx]) {
+			if (!(node->children[idx] = sccp_calloc(1, sizeof(sccp_dialplan_node_t)))) {
+				pbx_rwlock_unlock(&cache_lock);
+				return;
+			}
+			root->nodes++;
+			cache_stats.nodes++;
+		}
+		node = node->children[idx];
+	}
+	node->status = status;
+	node->expires = expires;
+	ATOMIC_INCR(&cache_stats.stored, 1, &cache_stats.lock);
+	pbx_rwlock_unlock(&cache_lock);
+}
+
+/* ========================================================================================================================= Module Start/Stop */
+/*!
+ * \brief starting dialplan match cache
+ */
+void sccp_dialplan_module_start(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting dialplan match cache\n");
+	pbx_rwlock_init_notracking(&cache_lock);
+	memset(&cache_stats, 0, sizeof(cache_stats));
+	sccp_mutex_init(&cache_stats.lock);
+	memset(cache_buckets, 0, sizeof(cache_buckets));
+	cache_running = TRUE;
+}
+
+/*!
+ * \brief stopping dialplan match cache
+ */
+void sccp_dialplan_module_stop(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Stopping dialplan match cache\n");
+	sccp_dialplan_cache_invalidate(NULL);
+	cache_running = FALSE;
+	pbx_rwlock_destroy(&cache_lock);
+	sccp_mutex_destroy(&cache_stats.lock);
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Check if the number dialed on channel exists, can match or matches more in the channel's context, using the dialplan match cache
+ * \param channel SCCP Channel
+ * \return Extension Status
+ */
+sccp_extension_status_t sccp_dialplan_extension_status(constChannelPtr channel)
+{
+	sccp_dialplan_root_t *root = NULL;
+	sccp_dialplan_node_t *node = NULL;
+	sccp_extension_status_t status = SCCP_EXTENSION_NOTEXISTS;
+	boolean_t found = FALSE;
+	const char *context = NULL;
+	const char *cid_num = NULL;
+	const char *number = channel->dialedNumber;
+	char pickupexten[SCCP_MAX_EXTENSION] = "";
+	uint32_t generation = 0;
+	unsigned int hash = 0;
+	time_t now = 0;
+
+	if (!cache_running || GLOB(dialplan_cache_ttl) <= 0) {
+		return iPbx.extension_status(channel);
+	}
+	if (!channel->owner || !channel->line || !iPbx.getChannelContext || sccp_strlen_zero(context = iPbx.getChannelContext(channel)) || sccp_strlen_zero(number) || !sccp_dialplan_cacheable(number)) {
+		ATOMIC_INCR(&cache_stats.bypassed, 1, &cache_stats.lock);
+		return iPbx.extension_status(channel);
+	}
+	if (iPbx.getPickupExtension && iPbx.getPickupExtension(channel, pickupexten) && sccp_strcaseequals(pickupexten, number)) {
+		ATOMIC_INCR(&cache_stats.bypassed, 1, &cache_stats.lock);					/* pickup extension is per channel, not per context */
+		return iPbx.extension_status(channel);
+	}
+	cid_num = channel->line->cid_num ? channel->line->cid_num : "";
+	hash = sccp_dialplan_cache_hash(context, cid_num);
+	generation = (uint32_t) ATOMIC_FETCH(&cache_generation, &cache_stats.lock);
+	now = time(NULL);
+
+	pbx_rwlock_rdlock(&cache_lock);
+	if ((root = sccp_dialplan_cache_find(context, cid_num, hash)) && root->generation == generation) {
+		for (node = &root->trie; node && *number; number++) {
+			node = node->children[sccp_dialplan_digit_index(*number)];
+		}
+		if (node && node->expires > now) {
+			status = node->status;
+			found = TRUE;
+		}
+	}
+	pbx_rwlock_unlock(&cache_lock);
+
+	if (found) {
+		ATOMIC_INCR(&cache_stats.hits, 1, &cache_stats.lock);
+		sccp_log((DEBUGCAT_PBX)) (VERBOSE_PREFIX_3 "%s: (dialplan_cache) %s@%s cached as %s\n", channel->designator, channel->dialedNumber, context, sccp_extension_status2str(status));
+		return status;
+	}
+
+	ATOMIC_INCR(&cache_stats.misses, 1, &cache_stats.lock);
+	status = iPbx.extension_status(channel);
+	if (status != SCCP_EXTENSION_NOTEXISTS) {
+		sccp_dialplan_cache_store(context, cid_num, hash, generation, channel->dialedNumber, status, now + GLOB(dialplan_cache_ttl));
+	}
+	return status;
+}
+
+/*!
+ * \brief Advance the cache generation, the tries built so far are dropped before they are used again
+ * \note called when the pbx reports a reload, which might have changed the dialplan
+ */
+void sccp_dialplan_cache_reloaded(void)
+{
+	ATOMIC_INCR(&cache_generation, 1, &cache_stats.lock);
+}
+
+/*!
+ * \brief Invalidate dialplan match cache entries
+ * \param context Context Name (NULL for all contexts)
+ * \return Number of trie nodes removed
+ */
+int sccp_dialplan_cache_invalidate(const char *context)
+{
+	int removed = 0;
+
+	if (!cache_running) {
+		return 0;
+	}
+	pbx_rwlock_wrlock(&cache_lock);
+	removed = sccp_dialplan_cache_remove(context);
+	pbx_rwlock_unlock(&cache_lock);
+	if (!context) {
+		sccp_dialplan_cache_reloaded();								/* keep results being looked up right now out */
+	}
+
+	sccp_log((DEBUGCAT_PBX)) (VERBOSE_PREFIX_3 "SCCP: (dialplan_cache) invalidated %d entries (context: %s)\n", removed, context ? context : "all");
+	return removed;
+}
+
+/* ========================================================================================================================= CLI/AMI */
+/*!
+ * \brief Count the nodes below node holding a (still valid) status
+ * \note cache_lock needs to be held
+ */
+static void sccp_dialplan_trie_count(const sccp_dialplan_node_t * node, time_t now, int *valid, int *stale)
+{
+	uint idx = 0;
+
+	if (node->expires > now) {
+		(*valid)++;
+	} else if (node->expires) {
+		(*stale)++;
+	}
+	for (idx = 0; idx < SCCP_DIALPLAN_DIGITS_LEN; idx++) {
+		if (node->children[idx]) {
+			sccp_dialplan_trie_count(node->children[idx], now, valid, stale);
+		}
+	}
+}
+
+/*!
+ * \brief Show Dialplan Match Cache Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_dialplan_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	sccp_dialplan_root_t *root = NULL;
+	int local_line_total = 0;
+	int tries = 0, nodes = 0, valid = 0, stale = 0;
+	int hits = 0, lookups = 0;
+	uint bucket = 0;
+	time_t now = time(NULL);
+	const char *actionid = "";
+
+	if (cache_running) {
+		pbx_rwlock_rdlock(&cache_lock);
+		for (bucket = 0; bucket < SCCP_DIALPLAN_CACHE_BUCKETS; bucket++) {
+			for (root = cache_buckets[bucket]; root; root = root->next) {
+				tries++;
+				sccp_dialplan_trie_count(&root->trie, now, &valid, &stale);
+			}
+		}
+		nodes = cache_stats.nodes;
+		pbx_rwlock_unlock(&cache_lock);
+	}
+	hits = ATOMIC_FETCH(&cache_stats.hits, &cache_stats.lock);
+	lookups = hits + ATOMIC_FETCH(&cache_stats.misses, &cache_stats.lock);
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\n--- SCCP dialplan match cache -----------------------------------------------------------------------------------------\n");
+	} else {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPDialplanCache\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	CLI_AMI_OUTPUT_PARAM("Cache TTL", CLI_AMI_LIST_WIDTH, "%d", GLOB(dialplan_cache_ttl));
+	CLI_AMI_OUTPUT_PARAM("Context/Callerid Tries", CLI_AMI_LIST_WIDTH, "%d", tries);
+	CLI_AMI_OUTPUT_PARAM("Nodes", CLI_AMI_LIST_WIDTH, "%d (max %d)", nodes, SCCP_DIALPLAN_CACHE_MAX_NODES);
+	CLI_AMI_OUTPUT_PARAM("Cached Results", CLI_AMI_LIST_WIDTH, "%d", valid);
+	CLI_AMI_OUTPUT_PARAM("Stale Results", CLI_AMI_LIST_WIDTH, "%d", stale);
+	CLI_AMI_OUTPUT_PARAM("Hits", CLI_AMI_LIST_WIDTH, "%d", hits);
+	CLI_AMI_OUTPUT_PARAM("Misses", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.misses, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Hit Ratio", CLI_AMI_LIST_WIDTH, "%d%%", lookups ? (hits * 100) / lookups : 0);
+	CLI_AMI_OUTPUT_PARAM("Bypassed", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.bypassed, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Stored", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.stored, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Dropped (pbx reload)", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.reloaded, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Flushed (cache full)", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.flushed, &cache_stats.lock));
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
+/*!
+ * \brief Flush Dialplan Match Cache
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_dialplan_cache_flush(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	const char *context = NULL;
+	int local_line_total = 0;
+	int removed = 0;
+
+	if (argc < 4 || argc > 5) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc > 4 && !sccp_strlen_zero(argv[4]) && !sccp_strcaseequals(argv[4], "all")) {
+		context = argv[4];
+	}
+	removed = sccp_dialplan_cache_invalidate(context);
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: Flushed %d dialplan cache entries\r\n", removed);
+		local_line_total += 2;
+		totals->lines = local_line_total;
+	} else {
+		CLI_AMI_OUTPUT(fd, s, "Flushed %d dialplan cache entries\n", removed);
+	}
+	return RESULT_SUCCESS;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
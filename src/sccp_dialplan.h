@@ -0,0 +1,21 @@
+/*!
+ * \file        sccp_dialplan.h
+ * \brief       SCCP Dialplan Match Cache Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+__BEGIN_C_EXTERN__
+SCCP_API void SCCP_CALL sccp_dialplan_module_start(void);
+SCCP_API void SCCP_CALL sccp_dialplan_module_stop(void);
+
+SCCP_API sccp_extension_status_t SCCP_CALL sccp_dialplan_extension_status(constChannelPtr channel);
+SCCP_API int SCCP_CALL sccp_dialplan_cache_invalidate(const char *context);
+SCCP_API void SCCP_CALL sccp_dialplan_cache_reloaded(void);
+
+SCCP_API int SCCP_CALL sccp_show_dialplan_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API int SCCP_CALL sccp_dialplan_cache_flush(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -47,13 +47,12 @@ SCCP_FILE_VERSION(__FILE__, "");
  */
 void sccp_featButton_changed(constDevicePtr device, sccp_feature_type_t featureType)
 {
-	sccp_msg_t *msg = NULL;
 	sccp_buttonconfig_t *config = NULL, *buttonconfig = NULL;
 	uint8_t instance = 0;
 	uint8_t buttonID = SKINNY_BUTTONTYPE_FEATURE;								// Default feature type.
 	boolean_t lineFound = FALSE;
 
-	if (!device) {
+	if (!device || !device->protocol) {
 		return;
 	}
 
@@ -137,7 +136,7 @@ void sccp_featButton_changed(constDevicePtr device, sccp_feature_type_t featureT
 					break;
 				case SCCP_FEATURE_MONITOR:
 					sccp_log((DEBUGCAT_FEATURE_BUTTON)) (VERBOSE_PREFIX_3 "%s: (sccp_featButton_changed) monitor featureButton new state:%s (%d)\n", DEV_ID_LOG(device), sccp_feature_monitor_state2str(device->monitorFeature.status), device->monitorFeature.status);
-					if (device->inuseprotocolversion > 15) {				// multiple States
+					if (sccp_protocol_hasFeature(device, SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES)) {	// multiple States
 						buttonID = SKINNY_BUTTONTYPE_MULTIBLINKFEATURE;
 						switch (device->monitorFeature.status) {
 							case SCCP_FEATURE_MONITOR_STATE_DISABLED:
@@ -251,7 +250,7 @@ void sccp_featButton_changed(constDevicePtr device, sccp_feature_type_t featureT
 				case SCCP_FEATURE_PARKINGLOT:
 #ifdef CS_SCCP_PARK
 					sccp_log((DEBUGCAT_FEATURE_BUTTON)) (VERBOSE_PREFIX_3 "%s: (sccp_featButton_changed) parkinglot state:%d\n", DEV_ID_LOG(device), config->button.feature.status);
-					if (device->inuseprotocolversion > 15) {
+					if (sccp_protocol_hasFeature(device, SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES)) {
 						buttonID = SKINNY_BUTTONTYPE_MULTIBLINKFEATURE;
 					}
 #endif
@@ -286,21 +285,8 @@ void sccp_featButton_changed(constDevicePtr device, sccp_feature_type_t featureT
 
 			}
 
-			/* send status using new message */
-			if (device->inuseprotocolversion >= 15) {
-				REQ(msg, FeatureStatDynamicMessage);
-				msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(instance);
-				msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(buttonID);
-				msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(config->button.feature.status);
-				sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, config->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-			} else {
-				REQ(msg, FeatureStatMessage);
-				msg->data.FeatureStatMessage.lel_featureIndex = htolel(instance);
-				msg->data.FeatureStatMessage.lel_featureID = htolel(buttonID);
-				msg->data.FeatureStatMessage.lel_featureStatus = htolel(config->button.feature.status);
-				sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, config->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-			}
-			sccp_dev_send(device, msg);
+			/* send status (FeatureStat / FeatureStatDynamic depending on protocol) */
+			device->protocol->sendFeatureStatus(device, instance, buttonID, config->button.feature.status, config->label);
 			sccp_log((DEBUGCAT_FEATURE_BUTTON + DEBUGCAT_FEATURE)) (VERBOSE_PREFIX_3 "%s: (sccp_featButton_changed) Got Feature Status Request. Instance = %d, Label: '%s', Status: %d\n", DEV_ID_LOG(device), instance, config->label, config->button.feature.status);
 		}
 	}
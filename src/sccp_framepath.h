@@ -0,0 +1,45 @@
+/*!
+ * \file        sccp_framepath.h
+ * \brief       SCCP Media Frame Path Header (precomputed rtp dispatch for the pbx frame read/write callbacks)
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \note        Only depends on config.h/define.h (no asterisk), so that it can be linked into standalone test harnesses (contrib/sccp_sim).
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+#define SCCP_FRAMEPATH_FDS 4											/* audio rtp, audio rtcp, video rtp, video rtcp */
+
+/*!
+ * \brief SCCP Media Frame Path
+ * \note The pbx read/write callbacks are called for every frame (50 per second per direction per call). Instead of working out which rtp
+ * instance a pbx fd belongs to on every frame, the instances are resolved once, when they are created or destroyed (sccp_rtp), and the
+ * callbacks only index into this table. Odd fd numbers are the rtcp control channels of the instance.
+ */
+typedef struct sccp_framepath {
+	PBX_RTP_TYPE *read[SCCP_FRAMEPATH_FDS];									/*!< RTP instance to read from, indexed by pbx fd number */
+	PBX_RTP_TYPE *write_audio;										/*!< RTP instance voice frames are written to */
+} sccp_framepath_t;
+
+/*!
+ * \brief (Re)Build the frame path from the current rtp instances
+ */
+static gcc_inline void sccp_framepath_set(sccp_framepath_t * fp, PBX_RTP_TYPE * audio, PBX_RTP_TYPE * video)
+{
+	fp->read[0] = audio;
+	fp->read[1] = audio;
+	fp->read[2] = video;
+	fp->read[3] = video;
+	fp->write_audio = audio;
+}
+
+/*!
+ * \brief RTP instance to read from for pbx fd number fdno
+ * \return rtp instance or NULL (unknown fd / no instance yet), the rtcp flag for the read is (fdno & 1)
+ */
+static gcc_inline PBX_RTP_TYPE *sccp_framepath_reader(const sccp_framepath_t * fp, int fdno)
+{
+	return do_expect((unsigned int) fdno < SCCP_FRAMEPATH_FDS) ? fp->read[fdno] : NULL;
+}
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
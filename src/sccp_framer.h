@@ -0,0 +1,134 @@
+/*!
+ * \file        sccp_framer.h
+ * \brief       SCCP Message Framer Header (receive ring buffer, header dissection)
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \note        Only depends on sccp_protocol.h (no asterisk), so that it can be linked into standalone test harnesses (contrib/sccp_sim).
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief SCCP Receive Ring Buffer
+ * \note Complete messages which lie in one piece in the ring are handed to the message handlers in place (see sccp_framer_getmsg),
+ * only messages straddling the wrap point (or shorter than their known size) are copied into the bounce message.
+ */
+#define SCCP_FRAMER_RINGBUFFER_SIZE (SCCP_MAX_PACKET * 2)
+typedef struct sccp_framer_ringbuffer {
+	size_t head;												/*!< Offset of the first unprocessed byte */
+	size_t used;												/*!< Number of unprocessed bytes */
+	const sccp_msg_t *last;											/*!< Last message handed to the handler (for debugging) */
+	uint64_t inplace;											/*!< Number of messages handled in place */
+	uint64_t copied;											/*!< Number of messages which needed to be copied */
+	sccp_msg_t bounce;											/*!< Bounce Message */
+	unsigned char data[SCCP_FRAMER_RINGBUFFER_SIZE] __attribute__ ((aligned(8)));				/*!< Ring Buffer Data */
+} sccp_framer_ringbuffer_t;
+
+/*!
+ * \brief Framer Results (negative return values of sccp_framer_next / sccp_framer_dissect_header)
+ */
+typedef enum {
+	SCCP_FRAMER_UNKNOWN_MESSAGE = -1,									/*!< messageId unknown, read the message and discard its content */
+	SCCP_FRAMER_INVALID_LENGTH = -2,									/*!< length field out of bounds, the stream can not be trusted anymore */
+} sccp_framer_result_t;
+
+SCCP_API int SCCP_CALL sccp_framer_dissect_header(const sccp_header_t * header);
+
+/*!
+ * \brief Copy len bytes from the head of the ring buffer (handles the wrap)
+ */
+static gcc_inline void sccp_framer_peek(const sccp_framer_ringbuffer_t * rb, void *dst, size_t len)
+{
+	size_t first = (rb->head + len <= SCCP_FRAMER_RINGBUFFER_SIZE) ? len : SCCP_FRAMER_RINGBUFFER_SIZE - rb->head;
+
+	memcpy(dst, rb->data + rb->head, first);
+	if (len > first) {
+		memcpy((unsigned char *) dst + first, rb->data, len - first);					// wrapped part
+	}
+}
+
+/*!
+ * \brief Contiguous space recv() may write to
+ * \return number of bytes writable at *ptr, the caller adds the number of bytes received to rb->used
+ */
+static gcc_inline size_t sccp_framer_writable(sccp_framer_ringbuffer_t * rb, unsigned char **ptr)
+{
+	size_t tail = 0;
+
+	if (rb->used == 0) {
+		rb->head = 0;											// empty, start at the beginning again to maximize contiguous space
+	}
+	tail = (rb->head + rb->used) % SCCP_FRAMER_RINGBUFFER_SIZE;
+	*ptr = rb->data + tail;
+	if (rb->used == SCCP_FRAMER_RINGBUFFER_SIZE) {
+		return 0;
+	}
+	return (tail >= rb->head) ? SCCP_FRAMER_RINGBUFFER_SIZE - tail : rb->head - tail;
+}
+
+static gcc_inline void sccp_framer_consume(sccp_framer_ringbuffer_t * rb, size_t len)
+{
+	rb->head = (rb->head + len) % SCCP_FRAMER_RINGBUFFER_SIZE;
+	rb->used -= len;
+	if (rb->used == 0) {
+		rb->head = 0;
+	}
+}
+
+/*!
+ * \brief Is there a complete packet at the head of the ring buffer
+ * \return length of the packet (including the header) / 0 when more data is needed / SCCP_FRAMER_INVALID_LENGTH
+ */
+static gcc_inline int sccp_framer_next(const sccp_framer_ringbuffer_t * rb)
+{
+	uint32_t hdr_len = 0;
+	uint32_t payload_len = 0;
+
+	if (rb->used < SCCP_PACKET_HEADER) {
+		return 0;
+	}
+	sccp_framer_peek(rb, &hdr_len, sizeof(hdr_len));
+	payload_len = letohl(hdr_len) + (SCCP_PACKET_HEADER - 4);
+	if (dont_expect(payload_len < SCCP_PACKET_HEADER || payload_len > SCCP_MAX_PACKET)) {
+		return SCCP_FRAMER_INVALID_LENGTH;
+	}
+	if (rb->used < payload_len) {
+		return 0;											// Too short - haven't received whole payload yet, go poll for more
+	}
+	return (int) payload_len;
+}
+
+/*!
+ * \brief Message view on the packet at the head of the ring buffer
+ * \param rb Ring Buffer
+ * \param lenAccordingToPacketHeader Length of the packet (as returned by sccp_framer_next)
+ * \param lenAccordingToOurProtocolSpec Known size of the message (as returned by sccp_framer_dissect_header, unknown messages are not handed out)
+ * \note The packet stays in the ring buffer until sccp_framer_consume. The returned message is writable, not a read-only view: msg->header.length
+ * is patched up to the size handed out, which for an in place message overwrites the length field in the ring. The packet can therefore not be
+ * framed again after this call, only consumed (sccp_framer_next / sccp_framer_peek have to be done before).
+ */
+static gcc_inline sccp_msg_t *sccp_framer_getmsg(sccp_framer_ringbuffer_t * rb, int lenAccordingToPacketHeader, int lenAccordingToOurProtocolSpec)
+{
+	sccp_msg_t *msg = NULL;
+	boolean_t contiguous = (rb->head + lenAccordingToPacketHeader <= SCCP_FRAMER_RINGBUFFER_SIZE) ? TRUE : FALSE;
+	boolean_t complete = TRUE;
+
+	if (((unsigned int)lenAccordingToPacketHeader) < ((unsigned int)lenAccordingToOurProtocolSpec)) {
+		lenAccordingToOurProtocolSpec = lenAccordingToPacketHeader;
+		complete = FALSE;											// needs zero padding up to the known size
+	}
+	if (do_expect(contiguous && complete && lenAccordingToOurProtocolSpec > 0 && ((uintptr_t) (rb->data + rb->head) & (__alignof__(sccp_msg_t) - 1)) == 0)) {
+		msg = (sccp_msg_t *) (rb->data + rb->head);							// in place, no copy
+		rb->inplace++;
+	} else {
+		msg = &rb->bounce;
+		memset(msg, 0, SCCP_MAX_PACKET);
+		sccp_framer_peek(rb, msg, lenAccordingToOurProtocolSpec);
+		rb->copied++;
+	}
+	msg->header.length = lenAccordingToOurProtocolSpec;								// patch up msg->header.length to new size
+	rb->last = msg;
+	return msg;
+}
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
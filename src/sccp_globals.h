@@ -74,6 +74,9 @@ struct sccp_global_vars {
 	uint8_t firstdigittimeout;										/*!< First Digit Timeout. Wait up to 16 seconds for first digit */
 	
 	uint8_t digittimeout;											/*!< Digit Timeout. How long to wait for following digits */
+	int dialplan_cache_ttl;										/*!< Dialplan Match Cache Time To Live (seconds) */
+	int rtp_pool_size;											/*!< Number of pre-warmed rtp instances kept in the rtp pool */
+	int calltrace_threshold;										/*!< Log the call setup timeline of calls with a setup phase slower than this (ms) */
 	char digittimeoutchar;											/*!< Digit End Character. What char will force the dial (Normally '#') */
 	boolean_t simulate_enbloc;										/*!< Simulated Enbloc Dialing for older device to speed up dialing */
 	uint8_t autoanswer_ring_time;										/*!< Auto Answer Ring Time */
@@ -139,6 +142,9 @@ struct sccp_global_vars {
 #ifdef CS_SCCP_REALTIME
 	char *realtimedevicetable;										/*!< Database Table Name for SCCP Devices */
 	char *realtimelinetable;											/*!< Database Table Name for SCCP Lines */
+	int realtime_cache_ttl;											/*!< Realtime Lookup Cache Time To Live (seconds) */
+	int realtime_negative_ttl;										/*!< Realtime Lookup Cache Time To Live for 'not found' entries (seconds) */
+	int realtime_prefetch;											/*!< Realtime Prefetch Interval (seconds) */
 #endif
 	char used_context[SCCP_MAX_EXTENSION];									/*!< placeholder to check if context are already used in regcontext (DUNDI) */
 
@@ -1132,7 +1132,7 @@ static void sccp_hint_notifySubscribers(sccp_hint_list_t * hint)
 			sccp_speed_t k;
 			char displayMessage[80] = "";
 			skinny_busylampfield_state_t status = SKINNY_BLF_STATUS_UNKNOWN;
-			if (d->inuseprotocolversion >= 15) {
+			if (sccp_protocol_hasFeature(d, SCCP_PROTOCOL_FEATURE_BLF_SPEEDDIAL)) {
 				sccp_dev_speed_find_byindex( d, subscriber->instance, TRUE, &k);
 
 				char cidName[StationMaxNameSize] = "";
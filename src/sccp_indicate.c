@@ -17,6 +17,7 @@
 #include "sccp_device.h"
 #include "sccp_indicate.h"
 #include "sccp_line.h"
+#include "sccp_session.h"
 #include "sccp_utils.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -64,6 +65,11 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 	/* all the check are ok. We can safely run all the dev functions with no more checks */
 	sccp_log((DEBUGCAT_INDICATE + DEBUGCAT_DEVICE + DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Indicate SCCP new state:%s, current channel state:%s on call:%s, lineInstance:%d (previous channelstate:%s)\n", d->id, sccp_channelstate2str(state), sccp_channelstate2str(c->state), c->designator, lineInstance, sccp_channelstate2str(c->previousChannelState));
 	sccp_channel_setChannelstate(c, state);
+	if (state == SCCP_CHANNELSTATE_RINGOUT || state == SCCP_CHANNELSTATE_RINGING) {
+		sccp_calltrace_mark(&c->calltrace, SCCP_CALLTRACE_RINGING);
+	} else if (state == SCCP_CHANNELSTATE_CONNECTED) {
+		sccp_calltrace_mark(&c->calltrace, SCCP_CALLTRACE_CONNECTED);
+	}
 	sccp_callinfo_t * const ci = sccp_channel_getCallInfo(c);
 
 	switch (state) {
@@ -449,6 +455,10 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
  * \param line SCCP Line
  * \param state State as int
  * 
+ * \note Everything which does not depend on the remote device (callinfo encoding, presentation, linkedid, which messages to send) is
+ * worked out once per state transition. Per remote device only the lineInstance and the visibility are applied, and the resulting
+ * messages are written to its session as one batch.
+ *
  * \warning
  *  - line->devices is not always locked
  */
@@ -467,14 +477,32 @@ static void __sccp_indicate_remote_device(const sccp_device_t * const device, co
 		sccp_log((DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "SCCP: (__sccp_indicate_remote_device) I'm a hotline, do not notify me!\n");
 		return;
 	}
+	switch (state) {
+		case SCCP_CHANNELSTATE_DOWN:
+		case SCCP_CHANNELSTATE_ONHOOK:
+		case SCCP_CHANNELSTATE_CONNECTEDCONFERENCE:
+		case SCCP_CHANNELSTATE_CONNECTED:
+			break;
+		case SCCP_CHANNELSTATE_HOLD:
+			if (c->channelStateReason == SCCP_CHANNELSTATEREASON_NORMAL) {
+				break;
+			}
+			sccp_log((DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Skipped Remote Hold Indication for reason: %s\n", DEV_ID_LOG(device), sccp_channelstatereason2str(c->channelStateReason));
+			return;
+		default:
+			return;											/* nothing to indicate to remote devices */
+	}
 	sccp_linedevices_t *linedevice = NULL;
 
-	/* copy temp variables, information to be send to remote device (in another thread) */
+	/* common to all remote devices, worked out once (information to be send to remote device (in another thread)) */
 	const uint32_t callid = c->callid;
 	const skinny_calltype_t calltype = c->calltype;
-	char dialedNumber[SCCP_MAX_EXTENSION];
-	sccp_copy_string(dialedNumber, c->dialedNumber, SCCP_MAX_EXTENSION);
-	sccp_callinfo_t * ci = iCallInfo.CopyConstructor(sccp_channel_getCallInfo(c));
+	const sccp_callinfo_t * const ci = sccp_channel_getCallInfo(c);					/* sent as is, the encoded message is shared between the remote devices */
+	sccp_callerid_presentation_t presenceParameter = CALLERID_PRESENTATION_ALLOWED;
+	iCallInfo.Getter(ci, SCCP_CALLINFO_PRESENTATION, &presenceParameter, SCCP_CALLINFO_KEY_SENTINEL);
+	const skinny_callinfo_visibility_t defaultVisibility = (c->privacy || !presenceParameter) ? SKINNY_CALLINFO_VISIBILITY_HIDDEN : SKINNY_CALLINFO_VISIBILITY_DEFAULT;
+	const char *linkedId = (state != SCCP_CHANNELSTATE_ONHOOK) ? iPbx.getChannelLinkedId(c) : NULL;
+	const boolean_t suppressPhonebook = (SKINNY_CALLTYPE_INBOUND == calltype && (c->answered_elsewhere || (state == SCCP_CHANNELSTATE_CONNECTED || state == SCCP_CHANNELSTATE_CONNECTEDCONFERENCE))) ? TRUE : FALSE;
 
 	sccp_log((DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Remote Indicate state %s (%d) with reason: %s (%d) on remote devices for channel %s\n", DEV_ID_LOG(device), sccp_channelstate2str(state), state, sccp_channelstatereason2str(c->channelStateReason), c->channelStateReason, c->designator);
 	SCCP_LIST_TRAVERSE(&line->devices, linedevice, list) {
@@ -492,39 +520,39 @@ static void __sccp_indicate_remote_device(const sccp_device_t * const device, co
 		AUTO_RELEASE(sccp_device_t, remoteDevice , sccp_device_retain(linedevice->device));
 
 		if (remoteDevice) {
-			sccp_callerid_presentation_t presenceParameter = CALLERID_PRESENTATION_ALLOWED;
-			iCallInfo.Getter(ci, SCCP_CALLINFO_PRESENTATION, &presenceParameter, SCCP_CALLINFO_KEY_SENTINEL);
-			uint8_t stateVisibility = (c->privacy || !presenceParameter) ? SKINNY_CALLINFO_VISIBILITY_HIDDEN : SKINNY_CALLINFO_VISIBILITY_DEFAULT;
+			/* per device patch: visibility */
+			skinny_callinfo_visibility_t stateVisibility = defaultVisibility;
 
 			/* Remarking the next piece out, solves the transfer issue when using sharedline as default on the transferer. Don't know why though (yet) */
 			if (state != SCCP_CHANNELSTATE_ONHOOK) {
 				AUTO_RELEASE(sccp_channel_t, activeChannel , sccp_device_getActiveChannel(remoteDevice));
 
-				if (activeChannel && (sccp_strequals(iPbx.getChannelLinkedId(activeChannel), iPbx.getChannelLinkedId(c)) || (activeChannel->conference_id && activeChannel->conference_id == c->conference_id))) {
+				if (activeChannel && (sccp_strequals(iPbx.getChannelLinkedId(activeChannel), linkedId) || (activeChannel->conference_id && activeChannel->conference_id == c->conference_id))) {
 					sccp_log(DEBUGCAT_INDICATE) (VERBOSE_PREFIX_3 "%s: (indicate_remote_device) Already Own Part of the Call: Skipped\n", DEV_ID_LOG(device));
-					//sccp_log_and(DEBUGCAT_INDICATE + DEBUGCAT_HIGH) (VERBOSE_PREFIX_3 "%s: LinkedId: %s / %s: LinkedId Remote: %s\n", DEV_ID_LOG(device), iPbx.getChannelLinkedId(c), DEV_ID_LOG(remoteDevice), iPbx.getChannelLinkedId(activeChannel));
+					//sccp_log_and(DEBUGCAT_INDICATE + DEBUGCAT_HIGH) (VERBOSE_PREFIX_3 "%s: LinkedId: %s / %s: LinkedId Remote: %s\n", DEV_ID_LOG(device), linkedId, DEV_ID_LOG(remoteDevice), iPbx.getChannelLinkedId(activeChannel));
 					continue;
 				}
 			}
 
-			if (linedevice) {
-				lineInstance = linedevice->lineInstance;							//sccp_device_find_index_for_line(remoteDevice, line->name);
-			}
+			/* per device patch: lineInstance */
+			lineInstance = linedevice->lineInstance;							//sccp_device_find_index_for_line(remoteDevice, line->name);
+
+			sccp_session_beginBatch(remoteDevice->session);
 			switch (state) {
 				case SCCP_CHANNELSTATE_DOWN:
 				case SCCP_CHANNELSTATE_ONHOOK:
-					sccp_log(DEBUGCAT_INDICATE) (VERBOSE_PREFIX_3 "%s -> %s: indicate remote onhook (lineInstance: %d, callid: %d %s)\n", DEV_ID_LOG(device), DEV_ID_LOG(remoteDevice), lineInstance, c->callid, c->answered_elsewhere ? ", answered elsewhere" :"");
-					if (SKINNY_CALLTYPE_INBOUND == c->calltype && c->answered_elsewhere && remoteDevice->indicate->suppress_phoneboook_entry) {
-						remoteDevice->indicate->suppress_phoneboook_entry(remoteDevice, lineInstance, c->callid);
+					sccp_log(DEBUGCAT_INDICATE) (VERBOSE_PREFIX_3 "%s -> %s: indicate remote onhook (lineInstance: %d, callid: %d %s)\n", DEV_ID_LOG(device), DEV_ID_LOG(remoteDevice), lineInstance, callid, c->answered_elsewhere ? ", answered elsewhere" :"");
+					if (suppressPhonebook && remoteDevice->indicate->suppress_phoneboook_entry) {
+						remoteDevice->indicate->suppress_phoneboook_entry(remoteDevice, lineInstance, callid);
 					}
 					remoteDevice->indicate->remoteOnhook(remoteDevice, lineInstance, callid);
 					break;
 
 				case SCCP_CHANNELSTATE_CONNECTEDCONFERENCE:
 				case SCCP_CHANNELSTATE_CONNECTED:
-					sccp_log(DEBUGCAT_INDICATE) (VERBOSE_PREFIX_3 "%s -> %s: indicate remote connected (lineInstance: %d, callid: %d %s)\n", DEV_ID_LOG(device), DEV_ID_LOG(remoteDevice), lineInstance, c->callid, c->answered_elsewhere ? ", answered elsewhere" : "");
-					if (SKINNY_CALLTYPE_INBOUND == c->calltype && remoteDevice->indicate->suppress_phoneboook_entry) {
-						remoteDevice->indicate->suppress_phoneboook_entry(remoteDevice, lineInstance, c->callid);
+					sccp_log(DEBUGCAT_INDICATE) (VERBOSE_PREFIX_3 "%s -> %s: indicate remote connected (lineInstance: %d, callid: %d %s)\n", DEV_ID_LOG(device), DEV_ID_LOG(remoteDevice), lineInstance, callid, c->answered_elsewhere ? ", answered elsewhere" : "");
+					if (suppressPhonebook && remoteDevice->indicate->suppress_phoneboook_entry) {
+						remoteDevice->indicate->suppress_phoneboook_entry(remoteDevice, lineInstance, callid);
 					}
 					
 					/* if line is not currently active on remote device, collapse the callstate */
@@ -533,26 +561,22 @@ static void __sccp_indicate_remote_device(const sccp_device_t * const device, co
 						stateVisibility = SKINNY_CALLINFO_VISIBILITY_COLLAPSED;
 					}
 					remoteDevice->indicate->remoteConnected(remoteDevice, lineInstance, callid, stateVisibility);
-					iCallInfo.Send(ci, callid, calltype, lineInstance, remoteDevice, TRUE);
+					iCallInfo.SendRemote(ci, callid, calltype, lineInstance, remoteDevice);
 					break;
 
 				case SCCP_CHANNELSTATE_HOLD:
-					if (c->channelStateReason == SCCP_CHANNELSTATEREASON_NORMAL) {
-						remoteDevice->indicate->remoteHold(remoteDevice, lineInstance, callid, SKINNY_CALLPRIORITY_NORMAL, stateVisibility);
-						iCallInfo.Send(ci, callid, calltype, lineInstance, remoteDevice, TRUE);
-					} else {
-						sccp_log((DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Skipped Remote Hold Indication for reason: %s\n", DEV_ID_LOG(device), sccp_channelstatereason2str(c->channelStateReason));
-					}
+					remoteDevice->indicate->remoteHold(remoteDevice, lineInstance, callid, SKINNY_CALLPRIORITY_NORMAL, stateVisibility);
+					iCallInfo.SendRemote(ci, callid, calltype, lineInstance, remoteDevice);
 					break;
 
 				default:
 					break;
 
 			}
+			sccp_session_endBatch();
 			sccp_log((DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Finish Indicating state %s (%d) with reason: %s (%d) on remote device %s for channel %s\n", DEV_ID_LOG(device), sccp_channelstate2str(state), state, sccp_channelstatereason2str(c->channelStateReason), c->channelStateReason, DEV_ID_LOG(remoteDevice), c->designator);
 		}
 	}
-	iCallInfo.Destructor(&ci);
 }
 
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -19,6 +19,7 @@
 #include "sccp_features.h"
 #include "sccp_mwi.h"
 #include "sccp_utils.h"
+#include "sccp_realtime.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -52,6 +53,7 @@ void sccp_line_pre_reload(void)
 			}
 		}
 		l->pendingUpdate = 0;
+		l->contextExists = FALSE;									/* recheck the context on the next call */
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
 }
@@ -869,7 +871,7 @@ sccp_line_t *sccp_line_find_realtime_byname(const char *name)
 		return NULL;
 	}
 
-	if ((variable = pbx_load_realtime(GLOB(realtimelinetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(GLOB(realtimelinetable), name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_LINE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Line '%s' found in realtime table '%s'\n", name, GLOB(realtimelinetable));
 
@@ -10,6 +10,7 @@
  * 
  */
 #pragma once
+#include "sccp_callquality.h"
 
 #define sccp_linedevice_retain(_x)		sccp_refcount_retain_type(sccp_linedevices_t, _x)
 #define sccp_linedevice_release(_x)		sccp_refcount_release_type(sccp_linedevices_t, _x)
@@ -39,6 +40,7 @@ struct sccp_line {
 		uint8_t numberOfHeldChannels;									/*!< Number of Hold Channels */
 		uint8_t numberOfDNDDevices;									/*!< Number of DND Devices */
 	} statistic;												/*!< Statistics for Line Structure */
+	sccp_callquality_t callquality;										/*!< Rolling call quality histograms */
 
 	uint8_t incominglimit;											/*!< max incoming calls limit */
 	uint8_t secondary_dialtone_tone;									/*!< secondary dialtone tone */
@@ -76,6 +78,7 @@ struct sccp_line {
 	char *meetmenum;											/*!< Meetme Extension to be Dialed (\todo TO BE REMOVED) */
 	char *meetmeopts;											/*!< Meetme Options to be Used */
 	char *context;												/*!< The context we use for Outgoing Calls. */
+	boolean_t contextExists;										/*!< context has been found in the dialplan since the last (re)load */
 	char *language;												/*!< language we use for calls */
 	char *accountcode;											/*!< accountcode used in cdr */
 	char *musicclass;											/*!< musicclass assigned when getting moh */
@@ -97,6 +100,7 @@ struct sccp_line {
 	/* this is for reload routines */
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this bit will tell the scheduler to update this line when unused */
+	uint64_t config_fingerprint;										/*!< fingerprint of the configuration last applied to this line (0 = unknown) */
 };														/*!< SCCP Line Structure */
 
 /*!
@@ -12,6 +12,7 @@
 #include "sccp_actions.h"
 #include "sccp_config.h"
 #include "sccp_device.h"
+#include "sccp_dialplan.h"
 #include "sccp_features.h"
 #include "sccp_line.h"
 #include "sccp_management.h"
@@ -955,6 +956,8 @@ static int sccp_asterisk_managerHookHelper(int category, const char *event, char
 		//} else {
 		//	sccp_log(DEBUGCAT_CORE)("SCCP: (managerHookHelper) %s Received\ncontent:[%s]\n", event, content);
 		}
+	} else if ((category & EVENT_FLAG_SYSTEM) && !strcasecmp("Reload", event)) {
+		sccp_dialplan_cache_reloaded();									/* the dialplan might have changed */
 	}
 	return 0;
 }
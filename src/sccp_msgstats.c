@@ -0,0 +1,427 @@
+/*!
+ * \file        sccp_msgstats.c
+ * \brief       SCCP Message Statistics
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Count skinny messages per message id (in/out, bytes) and keep a histogram of the time spent in the message handlers
+ *              When to use:    Called from the session layer (receive/send) and from sccp_handle_message
+ *              Relations:      Shown by 'sccp show stats messages' / SCCPShowStatsMessages
+ */
+
+/*!
+ * \section sccp_msgstats Message Statistics
+ *
+ * To stay out of the way of the session threads, every thread which receives or sends messages gets its own counter block (thread local
+ * storage). Updating a counter is a plain increment, no locks or atomic operations are involved. The blocks are only linked into a list, so
+ * that they can be summed up when the statistics are shown. When a thread exits, its block is folded into the 'retired' block.
+ *
+ * Handler durations are recorded in log2 buckets of microseconds (bucket 0: < 1us, bucket n: [2^(n-1), 2^n) us, last bucket: everything above).
+ *
+ * Resetting the statistics does not touch the per thread blocks (which would race against the owning thread), instead the current totals are
+ * stored as a baseline which is subtracted when showing.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_msgstats.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include "sccp_utils.h"
+#include <asterisk/threadstorage.h>
+
+#define SCCP_MSGSTATS_HISTOGRAM_BUCKETS 16
+#define SCCP_MSGSTATS_SPCP_SLOTS (SPCP_MESSAGE_HIGH_BOUNDARY - SPCP_MESSAGE_LOW_BOUNDARY + 1)
+#define SCCP_MSGSTATS_MID_SLOTS (SCCP_MESSAGE_HIGH_BOUNDARY + 1 + SCCP_MSGSTATS_SPCP_SLOTS)
+
+/*!
+ * \brief Message Statistics per Message Id
+ */
+typedef struct sccp_msgstats_counter {
+	uint64_t in;												/*!< Number of messages received */
+	uint64_t in_bytes;											/*!< Number of bytes received */
+	uint64_t out;												/*!< Number of messages sent */
+	uint64_t out_bytes;											/*!< Number of bytes sent */
+	uint64_t handled;											/*!< Number of messages timed in the handler */
+	uint64_t handled_us;											/*!< Total time spent in the handler */
+	uint64_t max_us;											/*!< Longest time spent in the handler (never reset) */
+	uint64_t histogram[SCCP_MSGSTATS_HISTOGRAM_BUCKETS];							/*!< Handler duration histogram */
+} sccp_msgstats_counter_t;
+
+/*!
+ * \brief Message Statistics Block (one per thread)
+ */
+typedef struct sccp_msgstats_block sccp_msgstats_block_t;
+struct sccp_msgstats_block {
+	sccp_msgstats_block_t *next;										/*!< Next block in list */
+	sccp_msgstats_counter_t counters[];									/*!< Counters per slot */
+};
+
+AST_MUTEX_DEFINE_STATIC(msgstats_lock);										/* protects the block list, retired and baseline, outlives module stop */
+static sccp_msgstats_block_t *msgstats_blocks = NULL;
+static sccp_msgstats_counter_t *msgstats_retired = NULL;
+static sccp_msgstats_counter_t *msgstats_baseline = NULL;
+static uint16_t msgstats_slot[SCCP_MSGSTATS_MID_SLOTS];							/* message id -> slot (0 = unknown message) */
+static sccp_mid_t *msgstats_mid = NULL;										/* slot -> message id */
+static uint16_t msgstats_num_slots = 0;
+static boolean_t msgstats_running = FALSE;
+static time_t msgstats_since = 0;
+
+static int msgstats_thread_init(void *data);
+static void msgstats_thread_cleanup(void *data);
+AST_THREADSTORAGE_CUSTOM(msgstats_threadbuf, msgstats_thread_init, msgstats_thread_cleanup);
+
+/* ========================================================================================================================= Private */
+static gcc_inline size_t msgstats_block_size(void)
+{
+	return sizeof(sccp_msgstats_block_t) + msgstats_num_slots * sizeof(sccp_msgstats_counter_t);
+}
+
+static gcc_inline uint16_t msgstats_mid2slot(sccp_mid_t mid)
+{
+	if (mid <= SCCP_MESSAGE_HIGH_BOUNDARY) {
+		return msgstats_slot[mid];
+	}
+	if (mid >= SPCP_MESSAGE_LOW_BOUNDARY && mid <= SPCP_MESSAGE_HIGH_BOUNDARY) {
+		return msgstats_slot[SCCP_MESSAGE_HIGH_BOUNDARY + 1 + (mid - SPCP_MESSAGE_LOW_BOUNDARY)];
+	}
+	return 0;
+}
+
+static gcc_inline uint msgstats_us2bucket(uint64_t usecs)
+{
+	uint bucket = 0;
+
+	while (usecs && bucket < SCCP_MSGSTATS_HISTOGRAM_BUCKETS - 1) {
+		usecs >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static void msgstats_counter_add(sccp_msgstats_counter_t * dst, const sccp_msgstats_counter_t * src)
+{
+	uint bucket = 0;
+
+	dst->in += src->in;
+	dst->in_bytes += src->in_bytes;
+	dst->out += src->out;
+	dst->out_bytes += src->out_bytes;
+	dst->handled += src->handled;
+	dst->handled_us += src->handled_us;
+	if (src->max_us > dst->max_us) {
+		dst->max_us = src->max_us;
+	}
+	for (bucket = 0; bucket < SCCP_MSGSTATS_HISTOGRAM_BUCKETS; bucket++) {
+		dst->histogram[bucket] += src->histogram[bucket];
+	}
+}
+
+static void msgstats_counter_sub(sccp_msgstats_counter_t * dst, const sccp_msgstats_counter_t * src)
+{
+	uint bucket = 0;
+
+	dst->in -= src->in;
+	dst->in_bytes -= src->in_bytes;
+	dst->out -= src->out;
+	dst->out_bytes -= src->out_bytes;
+	dst->handled -= src->handled;
+	dst->handled_us -= src->handled_us;
+	for (bucket = 0; bucket < SCCP_MSGSTATS_HISTOGRAM_BUCKETS; bucket++) {
+		dst->histogram[bucket] -= src->histogram[bucket];
+	}
+}
+
+/*!
+ * \brief Sum up retired and live blocks into totals
+ * \note needs to be called with msgstats_lock held
+ */
+static void msgstats_collect(sccp_msgstats_counter_t * totals)
+{
+	sccp_msgstats_block_t *block = NULL;
+	uint16_t slot = 0;
+
+	memcpy(totals, msgstats_retired, msgstats_num_slots * sizeof(sccp_msgstats_counter_t));
+	for (block = msgstats_blocks; block; block = block->next) {
+		for (slot = 0; slot < msgstats_num_slots; slot++) {
+			msgstats_counter_add(&totals[slot], &block->counters[slot]);
+		}
+	}
+}
+
+/*!
+ * \brief Return the upper bound (in us) of the bucket containing the requested percentile
+ * \note the last bucket is open ended, for this one the longest duration ever seen is returned
+ */
+static uint64_t msgstats_percentile(const sccp_msgstats_counter_t * counter, uint percent)
+{
+	uint64_t wanted = (counter->handled * percent + 99) / 100;
+	uint64_t seen = 0;
+	uint bucket = 0;
+
+	if (!counter->handled) {
+		return 0;
+	}
+	for (bucket = 0; bucket < SCCP_MSGSTATS_HISTOGRAM_BUCKETS - 1; bucket++) {
+		seen += counter->histogram[bucket];
+		if (seen >= wanted) {
+			break;
+		}
+	}
+	return (bucket < SCCP_MSGSTATS_HISTOGRAM_BUCKETS - 1) ? (1ULL << bucket) : counter->max_us;
+}
+
+static int msgstats_thread_init(void *data)
+{
+	sccp_msgstats_block_t *block = (sccp_msgstats_block_t *) data;
+
+	pbx_mutex_lock(&msgstats_lock);
+	block->next = msgstats_blocks;
+	msgstats_blocks = block;
+	pbx_mutex_unlock(&msgstats_lock);
+	return 0;
+}
+
+static void msgstats_thread_cleanup(void *data)
+{
+	sccp_msgstats_block_t *block = (sccp_msgstats_block_t *) data;
+	sccp_msgstats_block_t **prev = NULL;
+	uint16_t slot = 0;
+
+	pbx_mutex_lock(&msgstats_lock);
+	for (prev = &msgstats_blocks; *prev; prev = &(*prev)->next) {
+		if (*prev == block) {
+			*prev = block->next;
+			if (msgstats_running) {
+				for (slot = 0; slot < msgstats_num_slots; slot++) {
+					msgstats_counter_add(&msgstats_retired[slot], &block->counters[slot]);
+				}
+			}
+			break;
+		}
+	}
+	pbx_mutex_unlock(&msgstats_lock);
+	sccp_free(block);
+}
+
+static gcc_inline sccp_msgstats_counter_t *msgstats_get_counter(sccp_mid_t mid)
+{
+	sccp_msgstats_block_t *block = NULL;
+
+	if (!msgstats_running || !(block = ast_threadstorage_get(&msgstats_threadbuf, msgstats_block_size()))) {
+		return NULL;
+	}
+	return &block->counters[msgstats_mid2slot(mid)];
+}
+
+/* ========================================================================================================================= Module Start/Stop */
+/*!
+ * \brief starting message statistics
+ */
+void sccp_msgstats_module_start(void)
+{
+	sccp_mid_t mid = 0;
+	uint16_t slots = 1;											/* slot 0 is used for unknown messages */
+
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting message statistics\n");
+	memset(msgstats_slot, 0, sizeof(msgstats_slot));
+	for (mid = 0; mid <= SCCP_MESSAGE_HIGH_BOUNDARY; mid++) {
+		if (sccp_messagetypes[mid].messageId == mid && sccp_messagetypes[mid].text) {
+			msgstats_slot[mid] = slots++;
+		}
+	}
+	for (mid = SPCP_MESSAGE_LOW_BOUNDARY; mid <= SPCP_MESSAGE_HIGH_BOUNDARY; mid++) {
+		if (spcp_messagetypes[mid - SPCP_MESSAGE_OFFSET].messageId == mid && spcp_messagetypes[mid - SPCP_MESSAGE_OFFSET].text) {
+			msgstats_slot[SCCP_MESSAGE_HIGH_BOUNDARY + 1 + (mid - SPCP_MESSAGE_LOW_BOUNDARY)] = slots++;
+		}
+	}
+
+	pbx_mutex_lock(&msgstats_lock);
+	msgstats_num_slots = slots;
+	msgstats_mid = sccp_calloc(slots, sizeof(sccp_mid_t));
+	msgstats_retired = sccp_calloc(slots, sizeof(sccp_msgstats_counter_t));
+	msgstats_baseline = sccp_calloc(slots, sizeof(sccp_msgstats_counter_t));
+	if (msgstats_mid && msgstats_retired && msgstats_baseline) {
+		for (mid = 0; mid < SCCP_MSGSTATS_MID_SLOTS; mid++) {
+			if (msgstats_slot[mid]) {
+				msgstats_mid[msgstats_slot[mid]] = (mid <= SCCP_MESSAGE_HIGH_BOUNDARY) ? mid : mid - (SCCP_MESSAGE_HIGH_BOUNDARY + 1) + SPCP_MESSAGE_LOW_BOUNDARY;
+			}
+		}
+		msgstats_since = time(0);
+		msgstats_running = TRUE;
+	} else {
+		pbx_log(LOG_ERROR, "SCCP: (msgstats_module_start) Memory allocation error, message statistics disabled\n");
+	}
+	pbx_mutex_unlock(&msgstats_lock);
+}
+
+/*!
+ * \brief stopping message statistics
+ * \note live thread blocks are left alone, they will be released by their own thread (msgstats_thread_cleanup)
+ */
+void sccp_msgstats_module_stop(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Stopping message statistics\n");
+	pbx_mutex_lock(&msgstats_lock);
+	msgstats_running = FALSE;
+	msgstats_blocks = NULL;
+	if (msgstats_mid) {
+		sccp_free(msgstats_mid);
+	}
+	if (msgstats_retired) {
+		sccp_free(msgstats_retired);
+	}
+	if (msgstats_baseline) {
+		sccp_free(msgstats_baseline);
+	}
+	pbx_mutex_unlock(&msgstats_lock);
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Count an incoming message
+ * \param mid Message Id
+ * \param bytes Number of bytes on the wire (including header)
+ */
+void sccp_msgstats_in(sccp_mid_t mid, size_t bytes)
+{
+	sccp_msgstats_counter_t *counter = msgstats_get_counter(mid);
+
+	if (counter) {
+		counter->in++;
+		counter->in_bytes += bytes;
+	}
+}
+
+/*!
+ * \brief Count an outgoing message
+ * \param mid Message Id
+ * \param bytes Number of bytes on the wire (including header)
+ */
+void sccp_msgstats_out(sccp_mid_t mid, size_t bytes)
+{
+	sccp_msgstats_counter_t *counter = msgstats_get_counter(mid);
+
+	if (counter) {
+		counter->out++;
+		counter->out_bytes += bytes;
+	}
+}
+
+/*!
+ * \brief Record the time spent handling an incoming message
+ * \param mid Message Id
+ * \param usecs Handler duration in microseconds
+ */
+void sccp_msgstats_handled(sccp_mid_t mid, int64_t usecs)
+{
+	sccp_msgstats_counter_t *counter = msgstats_get_counter(mid);
+	uint64_t duration = usecs > 0 ? (uint64_t) usecs : 0;
+
+	if (counter) {
+		counter->handled++;
+		counter->handled_us += duration;
+		if (duration > counter->max_us) {
+			counter->max_us = duration;
+		}
+		counter->histogram[msgstats_us2bucket(duration)]++;
+	}
+}
+
+/*!
+ * \brief Reset the message statistics (by moving the baseline)
+ */
+void sccp_msgstats_reset(void)
+{
+	pbx_mutex_lock(&msgstats_lock);
+	if (msgstats_running) {
+		msgstats_collect(msgstats_baseline);
+		msgstats_since = time(0);
+	}
+	pbx_mutex_unlock(&msgstats_lock);
+}
+
+/* ========================================================================================================================= CLI */
+/*!
+ * \brief Show Message Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_msgstats(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	sccp_msgstats_counter_t *stats = NULL;
+	sccp_msgstats_counter_t *counter = NULL;
+	uint16_t slot = 0;
+	boolean_t reset = FALSE;
+	time_t since = 0;
+
+	if (argc < 4 || argc > 5) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc == 5 && !sccp_strlen_zero(argv[4])) {
+		if (!sccp_strcaseequals(argv[4], "reset") && !sccp_true(argv[4])) {
+			return RESULT_SHOWUSAGE;
+		}
+		reset = TRUE;
+	}
+
+	pbx_mutex_lock(&msgstats_lock);
+	if (msgstats_running && (stats = sccp_calloc(msgstats_num_slots, sizeof(sccp_msgstats_counter_t)))) {
+		msgstats_collect(stats);
+		for (slot = 0; slot < msgstats_num_slots; slot++) {
+			msgstats_counter_sub(&stats[slot], &msgstats_baseline[slot]);
+		}
+		since = msgstats_since;
+		if (reset) {
+			msgstats_collect(msgstats_baseline);
+			msgstats_since = time(0);
+		}
+	}
+	pbx_mutex_unlock(&msgstats_lock);
+
+	if (!stats) {
+		CLI_AMI_RETURN_ERROR(fd, s, m, "%s", "Message statistics not available\n");
+	}
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\nMessage statistics since %d seconds%s. Latencies in microseconds (p50/p99/max: upper bound of log2 bucket)\n", (int) (time(0) - since), reset ? " (now reset)" : "");
+	}
+#define CLI_AMI_TABLE_NAME MessageStatistics
+#define CLI_AMI_TABLE_PER_ENTRY_NAME MessageStatistic
+#define CLI_AMI_TABLE_ITERATOR for(slot = 0; slot < msgstats_num_slots; slot++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		counter = &stats[slot];														\
+		if (counter->in || counter->out) {												\
+
+#define CLI_AMI_TABLE_AFTER_ITERATION 														\
+		}																\
+
+#define CLI_AMI_TABLE_FIELDS 															\
+		CLI_AMI_TABLE_FIELD(Id,			"-6",		x,	6,	slot ? msgstats_mid[slot] : 0)				\
+		CLI_AMI_TABLE_FIELD(Message,		"-36.36",	s,	36,	slot ? msgtype2str(msgstats_mid[slot]) : "Unknown")	\
+		CLI_AMI_TABLE_FIELD(In,			"-10",		ju,	10,	(uintmax_t) counter->in)				\
+		CLI_AMI_TABLE_FIELD(InBytes,		"-12",		ju,	12,	(uintmax_t) counter->in_bytes)				\
+		CLI_AMI_TABLE_FIELD(Out,		"-10",		ju,	10,	(uintmax_t) counter->out)				\
+		CLI_AMI_TABLE_FIELD(OutBytes,		"-12",		ju,	12,	(uintmax_t) counter->out_bytes)				\
+		CLI_AMI_TABLE_FIELD(AvgUs,		"-8",		ju,	8,	(uintmax_t) (counter->handled ? counter->handled_us / counter->handled : 0))	\
+		CLI_AMI_TABLE_FIELD(P50Us,		"-8",		ju,	8,	(uintmax_t) msgstats_percentile(counter, 50))		\
+		CLI_AMI_TABLE_FIELD(P99Us,		"-8",		ju,	8,	(uintmax_t) msgstats_percentile(counter, 99))		\
+		CLI_AMI_TABLE_FIELD(MaxUs,		"-8",		ju,	8,	(uintmax_t) msgstats_percentile(counter, 100))
+#include "sccp_cli_table.h"
+
+	sccp_free(stats);
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,21 @@
+/*!
+ * \file        sccp_msgstats.h
+ * \brief       SCCP Message Statistics Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+__BEGIN_C_EXTERN__
+SCCP_API void SCCP_CALL sccp_msgstats_module_start(void);
+SCCP_API void SCCP_CALL sccp_msgstats_module_stop(void);
+
+SCCP_API void SCCP_CALL sccp_msgstats_in(sccp_mid_t mid, size_t bytes);
+SCCP_API void SCCP_CALL sccp_msgstats_out(sccp_mid_t mid, size_t bytes);
+SCCP_API void SCCP_CALL sccp_msgstats_handled(sccp_mid_t mid, int64_t usecs);
+SCCP_API void SCCP_CALL sccp_msgstats_reset(void);
+
+SCCP_API int SCCP_CALL sccp_show_msgstats(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
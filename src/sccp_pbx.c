@@ -25,6 +25,7 @@
 #include "sccp_netsock.h"
 #include "sccp_session.h"
 #include "sccp_atomic.h"
+#include "sccp_dialplan.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -125,22 +126,21 @@ struct sccp_answer_conveyor_struct {
 };
 
 /*!
- * \brief Call Auto Answer Thead
+ * \brief Call Auto Answer
  * \param data Data
  *
- * The Auto Answer thread is started by ref sccp_pbx_call if necessary
+ * Scheduled by ref sccp_pbx_call to fire after autoanswer_ring_time, instead of keeping a thread asleep while the phone rings
+ *
+ * \called_from_asterisk
  */
-static void *sccp_pbx_call_autoanswer_thread(void *data)
+static int sccp_pbx_sched_autoanswer(const void *data)
 {
-	struct sccp_answer_conveyor_struct *conveyor = data;
+	struct sccp_answer_conveyor_struct *conveyor = (struct sccp_answer_conveyor_struct *) data;
 
 	int instance = 0;
 
-	sleep(GLOB(autoanswer_ring_time));
-	pthread_testcancel();
-
 	if (!conveyor) {
-		return NULL;
+		return 0;
 	}
 	if (!conveyor->linedevice) {
 		goto FINAL;
@@ -174,7 +174,7 @@ FINAL:
 		sccp_linedevice_release(&conveyor->linedevice);			// retained in calling thread, explicit release required here
 	}
 	sccp_free(conveyor);
-	return NULL;
+	return 0;											// return 0 to release schedule !
 }
 
 /*!
@@ -363,11 +363,15 @@ int sccp_pbx_call(sccp_channel_t * c, char *dest, int timeout)
 			if (c->autoanswer_type) {
 				struct sccp_answer_conveyor_struct *conveyor = sccp_calloc(1, sizeof(struct sccp_answer_conveyor_struct));
 				if (conveyor) {
-					sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Running the autoanswer thread on %s\n", DEV_ID_LOG(linedevice->device), iPbx.getChannelName(c));
+					sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Scheduling autoanswer on %s in %d seconds\n", DEV_ID_LOG(linedevice->device), iPbx.getChannelName(c), GLOB(autoanswer_ring_time));
 					conveyor->callid = c->callid;
 					conveyor->linedevice = sccp_linedevice_retain(linedevice);
 
-					sccp_threadpool_add_work(GLOB(general_threadpool), (void *) sccp_pbx_call_autoanswer_thread, (void *) conveyor);
+					if (iPbx.sched_add(GLOB(autoanswer_ring_time) * 1000, sccp_pbx_sched_autoanswer, conveyor) < 0) {
+						pbx_log(LOG_ERROR, "%s: Could not schedule autoanswer on %s\n", DEV_ID_LOG(linedevice->device), iPbx.getChannelName(c));
+						sccp_linedevice_release(&conveyor->linedevice);
+						sccp_free(conveyor);
+					}
 				} else {
 					pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, c->designator);
 				}
@@ -922,7 +926,7 @@ sccp_extension_status_t sccp_pbx_helper(sccp_channel_t * c)
 	    ) {
 
 		//! \todo check overlap feature status -MC
-		extensionStatus = iPbx.extension_status(c);
+		extensionStatus = sccp_dialplan_extension_status(c);
 		AUTO_RELEASE(sccp_device_t, d , sccp_channel_getDevice(c));
 
 		if (d) {
@@ -955,6 +959,7 @@ void *sccp_pbx_softswitch(sccp_channel_t * channel)
 			pbx_log(LOG_ERROR, "SCCP: (sccp_pbx_softswitch) No <channel> available. Returning from dial thread.\n");
 			goto EXIT_FUNC;
 		}
+		sccp_calltrace_mark(&c->calltrace, SCCP_CALLTRACE_DIALCOMPLETE);
 		sccp_channel_stop_schedule_digittimout(c);
 		
 		/* Reset Enbloc Dial Emulation */
@@ -1217,7 +1222,7 @@ void *sccp_pbx_softswitch(sccp_channel_t * channel)
 		/*! \todo DdG: Extra wait time is incurred when checking pbx_exists_extension, when a wrong number is dialed. storing extension_exists status for sccp_log use */
 		int extension_exists = SCCP_EXTENSION_NOTEXISTS;
 
-		if (!sccp_strlen_zero(shortenedNumber) && ((extension_exists = iPbx.extension_status(c) != SCCP_EXTENSION_NOTEXISTS))
+		if (!sccp_strlen_zero(shortenedNumber) && ((extension_exists = sccp_dialplan_extension_status(c) != SCCP_EXTENSION_NOTEXISTS))
 		    ) {
 			if (pbx_channel && !pbx_check_hangup(pbx_channel)) {
 				/* found an extension, let's dial it */
@@ -1226,6 +1231,7 @@ void *sccp_pbx_softswitch(sccp_channel_t * channel)
 				/* Answer dialplan command works only when in RINGING OR RING ast_state */
 				iPbx.set_callstate(c, AST_STATE_RING);
 
+				sccp_calltrace_mark(&c->calltrace, SCCP_CALLTRACE_PBXSTART);
 				enum ast_pbx_result pbxStartResult = pbx_pbx_start(pbx_channel);
 
 				/* \todo replace AST_PBX enum using pbx_impl wrapper enum */
@@ -18,18 +18,118 @@
 #include "sccp_session.h"
 #include "sccp_utils.h"
 #include <asterisk/unaligned.h>
+#include <asterisk/threadstorage.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
 
+/* =================================================================================================================== Message Encoder */
+AST_THREADSTORAGE(sccp_msg_encoder_buf);
+#define SCCP_MSG_ENCODER_LIMIT (sizeof(sccp_data_t) & ~((size_t) 3))
+
+/*!
+ * \brief Start building a message with variable length fields
+ * \param enc Encoder
+ * \param mid Message Id
+ * \param fixedLen Length of the fixed part of the message data (offset of the variable part)
+ * \return Message to fill in the fixed fields, NULL on allocation failure
+ */
+sccp_msg_t *__sccp_msg_encoder_begin(sccp_msg_encoder_t * enc, sccp_mid_t mid, size_t fixedLen)
+{
+	sccp_msg_t *msg = ast_threadstorage_get(&sccp_msg_encoder_buf, SCCP_MAX_PACKET);
+
+	enc->msg = msg;
+	enc->offset = fixedLen;
+	enc->overflow = FALSE;
+	if (msg) {
+		memset(msg, 0, SCCP_PACKET_HEADER + fixedLen);						/* the variable part gets overwritten anyway */
+		msg->header.lel_messageId = htolel(mid);
+	} else {
+		pbx_log(LOG_WARNING, "SCCP: Packet memory allocation error\n");
+	}
+	return msg;
+}
+
+/*!
+ * \brief Append a string including its terminator, in one pass (no separate strlen)
+ */
+void sccp_msg_encoder_putString(sccp_msg_encoder_t * enc, const char *str)
+{
+	char *dst = (char *) &enc->msg->data + enc->offset;
+	size_t room = SCCP_MSG_ENCODER_LIMIT - enc->offset;
+	char *end = NULL;
+
+	if (!room) {
+		enc->overflow = TRUE;
+		return;
+	}
+	if ((end = memccpy(dst, str ? str : "", '\0', room))) {
+		enc->offset += end - dst;
+	} else {
+		dst[room - 1] = '\0';										/* truncate */
+		enc->offset = SCCP_MSG_ENCODER_LIMIT;
+		enc->overflow = TRUE;
+	}
+}
+
+/*!
+ * \brief Append len zero bytes
+ */
+void sccp_msg_encoder_putZero(sccp_msg_encoder_t * enc, size_t len)
+{
+	if (len > SCCP_MSG_ENCODER_LIMIT - enc->offset) {
+		len = SCCP_MSG_ENCODER_LIMIT - enc->offset;
+		enc->overflow = TRUE;
+	}
+	memset((char *) &enc->msg->data + enc->offset, 0, len);
+	enc->offset += len;
+}
+
+/*!
+ * \brief Pad the message to a multiple of 4 bytes and patch the header length
+ * \return Finished Message (still owned by the encoder)
+ */
+sccp_msg_t *sccp_msg_encoder_finish(sccp_msg_encoder_t * enc)
+{
+	while (enc->offset & 3) {
+		((char *) &enc->msg->data)[enc->offset++] = '\0';
+	}
+	enc->msg->header.length = htolel(enc->offset + 4);
+	if (enc->overflow) {
+		pbx_log(LOG_WARNING, "SCCP: (msg_encoder) %s got truncated to %d bytes\n", msgtype2str(letohl(enc->msg->header.lel_messageId)), (int) enc->offset);
+	}
+	return enc->msg;
+}
+
+/*!
+ * \brief Finish the message and return an allocated copy of exactly the right size
+ * \return Message which needs to be freed by the caller (or sent using sccp_dev_send), NULL on allocation failure
+ */
+sccp_msg_t *sccp_msg_encoder_dup(sccp_msg_encoder_t * enc)
+{
+	sccp_msg_t *msg = sccp_msg_encoder_finish(enc);
+	sccp_msg_t *copy = sccp_malloc(SCCP_PACKET_HEADER + enc->offset);
+
+	if (copy) {
+		memcpy(copy, msg, SCCP_PACKET_HEADER + enc->offset);
+	}
+	return copy;
+}
+
 /* CallInfo Message */
+AST_THREADSTORAGE(sccp_callinfo_send_buf);
 
 /* =================================================================================================================== Send Messages */
-static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+/*!
+ * \brief Encode the callinfo part of the CallInfoMessage (V3), the per call fields are filled in by sccp_protocol_sendCallInfoV3
+ */
+static sccp_msg_t *sccp_protocol_encodeCallInfoV3(const sccp_callinfo_t * const ci)
 {
- 	pbx_assert(device != NULL);
-	sccp_msg_t *msg;
+	sccp_msg_t *msg = NULL;
 
 	REQ(msg, CallInfoMessage);
+	if (!msg) {
+		return NULL;
+	}
 
 	int originalCdpnRedirectReason = 0;
 	int lastRedirectingReason = 0;
@@ -54,33 +154,47 @@ static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_t * const ci, cons
 		SCCP_CALLINFO_KEY_SENTINEL);
 
 	msg->data.CallInfoMessage.partyPIRestrictionBits = presentation ? 0xf : 0x0;
+	msg->data.CallInfoMessage.lel_originalCdpnRedirectReason = htolel(originalCdpnRedirectReason);
+	msg->data.CallInfoMessage.lel_lastRedirectingReason = htolel(lastRedirectingReason);
+	return msg;
+}
+
+static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+{
+ 	pbx_assert(device != NULL);
+	sccp_msg_t *msg = ast_threadstorage_get(&sccp_callinfo_send_buf, SCCP_MAX_PACKET);		/* per call fields get patched into a copy of the cached message */
+
+	if (!msg || !(msg = iCallInfo.GetEncoded(ci, SCCP_CALLINFO_ENCODING_V3, sccp_protocol_encodeCallInfoV3, msg))) {
+		return;
+	}
 	msg->data.CallInfoMessage.lel_lineInstance = htolel(lineInstance);
 	msg->data.CallInfoMessage.lel_callReference = htolel(callid);
 	msg->data.CallInfoMessage.lel_callType = htolel(calltype);
 	msg->data.CallInfoMessage.lel_callInstance = htolel(callInstance);
 	msg->data.CallInfoMessage.lel_callSecurityStatus = htolel(callsecurityState);
-	msg->data.CallInfoMessage.lel_originalCdpnRedirectReason = htolel(originalCdpnRedirectReason);
-	msg->data.CallInfoMessage.lel_lastRedirectingReason = htolel(lastRedirectingReason);
 
 	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(V3) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", skinny_calltype2str(calltype), callid, callInstance, lineInstance);
 	//if ((GLOB(debug) & (DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) != 0) {
 	//	iCallInfo.Print2log(ci, "SCCP: (sendCallInfoV3)");
 	//}
-	sccp_dev_send(device, msg);
+	sccp_dev_sendStatic(device, msg);
 }
 
-static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+/*!
+ * \brief Encode the callinfo part of the CallInfoDynamicMessage (V7), the per call fields are filled in by sccp_protocol_sendCallInfoDynamic
+ */
+static sccp_msg_t *sccp_protocol_encodeCallInfoV7(const sccp_callinfo_t * const ci)
 {
- 	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
+	sccp_msg_encoder_t enc;
 
 	unsigned int dataSize = 12;
 	char data[dataSize][StationMaxNameSize];
-	int data_len[dataSize];
 	unsigned int i = 0;
-	int dummy_len = 0;
 
-	memset(data, 0, dataSize * StationMaxNameSize);
+	for (i = 0; i < dataSize; i++) {
+		data[i][0] = '\0';										/* only the terminator matters to the encoder */
+	}
 	
 	int originalCdpnRedirectReason = 0;
 	int lastRedirectingReason = 0;
@@ -104,59 +218,35 @@ static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, cons
 		SCCP_CALLINFO_KEY_SENTINEL);
 
 
-	for (i = 0; i < dataSize; i++) {
-		data_len[i] = strlen(data[i]);
-		dummy_len += data_len[i];
+	if (!(msg = sccp_msg_encoder_begin(&enc, CallInfoDynamicMessage))) {
+		return NULL;
 	}
-
-	int hdr_len = sizeof(msg->data.CallInfoDynamicMessage) + (dataSize - 3);
-	msg = sccp_build_packet(CallInfoDynamicMessage, hdr_len + dummy_len);
-
-	msg->data.CallInfoDynamicMessage.lel_lineInstance = htolel(lineInstance);
-	msg->data.CallInfoDynamicMessage.lel_callReference = htolel(callid);
-	msg->data.CallInfoDynamicMessage.lel_callType = htolel(calltype);
 	msg->data.CallInfoDynamicMessage.partyPIRestrictionBits = presentation ? 0x0 : 0xf;
-	//! note callSecurityStatus:
-	// when indicating ringout we should set SKINNY_CALLSECURITYSTATE_UNKNOWN
-	// when indicating connected we should set SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
-	msg->data.CallInfoDynamicMessage.lel_callSecurityStatus = htolel(callsecurityState);
-	msg->data.CallInfoDynamicMessage.lel_callInstance = htolel(callInstance);
 	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason = htolel(originalCdpnRedirectReason);
 	msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason = htolel(lastRedirectingReason);
 
-	if (dummy_len) {
-		int bufferSize = dummy_len + dataSize;
-		char buffer[bufferSize];
-		int pos = 0;
-
-		memset(&buffer[0], 0, bufferSize);
-		for (i = 0; i < dataSize; i++) {
-			if (data_len[i]) {
-				memcpy(&buffer[pos], data[i], data_len[i]);
-				pos += data_len[i] + 1;
-			} else {
-				pos += 1;
-			}
-		}
-		memcpy(&msg->data.CallInfoDynamicMessage.dummy, &buffer[0], bufferSize);
+	for (i = 0; i < dataSize; i++) {
+		sccp_msg_encoder_putString(&enc, data[i]);
 	}
-
-	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(V7) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", skinny_calltype2str(calltype), callid, callInstance, lineInstance);
-	//if ((GLOB(debug) & (DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) != 0) {
-	//	iCallInfo.Print2log(ci, "SCCP: (sendCallInfoV7)");
-	//	sccp_dump_msg(msg);
-	//}
-	sccp_dev_send(device, msg);
+	sccp_msg_encoder_putZero(&enc, 1);									/* V7 has always been sent with one extra terminator */
+	return sccp_msg_encoder_dup(&enc);
 }
 
-static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+/*!
+ * \brief Encode the callinfo part of the CallInfoDynamicMessage (V16), the per call fields are filled in by sccp_protocol_sendCallInfoDynamic
+ */
+static sccp_msg_t *sccp_protocol_encodeCallInfoV16(const sccp_callinfo_t * const ci)
 {
- 	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
+	sccp_msg_encoder_t enc;
 
 	unsigned int dataSize = 15;
 	char data[dataSize][StationMaxNameSize];
-	memset(data, 0, dataSize * StationMaxNameSize);
+	unsigned int field = 0;
+
+	for (field = 0; field < dataSize; field++) {
+		data[field][0] = '\0';
+	}
 
 	int originalCdpnRedirectReason = 0;
 	int lastRedirectingReason = 0;
@@ -182,37 +272,54 @@ static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_t * const ci, con
 		SCCP_CALLINFO_PRESENTATION, &presentation,
 		SCCP_CALLINFO_KEY_SENTINEL);
 
-	unsigned int field = 0;
-	int data_len = 0;
-	int dummy_len = 0;
-	uint8_t *dummy = sccp_calloc(sizeof(uint8_t), dataSize * StationMaxNameSize);
-	if (!dummy) {
-		return;
+	if (!(msg = sccp_msg_encoder_begin(&enc, CallInfoDynamicMessage))) {
+		return NULL;
 	}
+	msg->data.CallInfoDynamicMessage.partyPIRestrictionBits		= presentation ? 0x0 : 0xf;
+	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason	= htolel(originalCdpnRedirectReason);
+	msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason	= htolel(lastRedirectingReason);
 	for (field = 0; field < dataSize; field++) {
-		data_len = strlen(data[field]) + 1; 		//add NULL terminator
-		memcpy(dummy + dummy_len, data[field], data_len);
-		dummy_len += data_len;
+		sccp_msg_encoder_putString(&enc, data[field]);
+	}
+	return sccp_msg_encoder_dup(&enc);
+}
+
+/*!
+ * \brief Send the cached CallInfoDynamicMessage, only the per call fields are filled in here
+ */
+static void sccp_protocol_sendCallInfoDynamic(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, sccp_callinfo_encoder_t encoder, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+{
+ 	pbx_assert(device != NULL);
+	sccp_msg_t *msg = ast_threadstorage_get(&sccp_callinfo_send_buf, SCCP_MAX_PACKET);
+
+	if (!msg || !(msg = iCallInfo.GetEncoded(ci, encoding, encoder, msg))) {
+		return;
 	}
-	int hdr_len = sizeof(msg->data.CallInfoDynamicMessage) - 4;
-	msg = sccp_build_packet(CallInfoDynamicMessage, hdr_len + dummy_len);
 	msg->data.CallInfoDynamicMessage.lel_lineInstance		= htolel(lineInstance);
 	msg->data.CallInfoDynamicMessage.lel_callReference		= htolel(callid);
 	msg->data.CallInfoDynamicMessage.lel_callType			= htolel(calltype);
-	msg->data.CallInfoDynamicMessage.partyPIRestrictionBits		= presentation ? 0x0 : 0xf;
+	//! note callSecurityStatus:
+	// when indicating ringout we should set SKINNY_CALLSECURITYSTATE_UNKNOWN
+	// when indicating connected we should set SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
 	msg->data.CallInfoDynamicMessage.lel_callSecurityStatus		= htolel(callsecurityState);
 	msg->data.CallInfoDynamicMessage.lel_callInstance		= htolel(callInstance);
-	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason	= htolel(originalCdpnRedirectReason);
-	msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason	= htolel(lastRedirectingReason);
-	memcpy(&msg->data.CallInfoDynamicMessage.dummy, dummy, dummy_len);
-	sccp_free(dummy);
-	
-	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(V20) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", skinny_calltype2str(calltype), callid, callInstance, lineInstance);
+
+	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(%d) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", encoding, skinny_calltype2str(calltype), callid, callInstance, lineInstance);
 	//if ((GLOB(debug) & (DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) != 0) {
-	//	iCallInfo.Print2log(ci, "SCCP: (sendCallInfoV16)");
+	//	iCallInfo.Print2log(ci, "SCCP: (sendCallInfoDynamic)");
 	//	sccp_dump_msg(msg);
 	//}
-	sccp_dev_send(device, msg);
+	sccp_dev_sendStatic(device, msg);
+}
+
+static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+{
+	sccp_protocol_sendCallInfoDynamic(ci, SCCP_CALLINFO_ENCODING_V7, sccp_protocol_encodeCallInfoV7, callid, calltype, lineInstance, callInstance, callsecurityState, device);
+}
+
+static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+{
+	sccp_protocol_sendCallInfoDynamic(ci, SCCP_CALLINFO_ENCODING_V16, sccp_protocol_encodeCallInfoV16, callid, calltype, lineInstance, callInstance, callsecurityState, device);
 }
 
 /* done - CallInfoMessage */
@@ -283,16 +390,17 @@ static void sccp_protocol_sendStaticDisplayprompt(constDevicePtr device, uint8_t
 static void sccp_protocol_sendDynamicDisplayprompt(constDevicePtr device, uint8_t lineInstance, uint32_t callid, uint8_t timeout, const char *message)
 {
 	sccp_msg_t *msg = NULL;
+	sccp_msg_encoder_t enc;
 
-	int msg_len = strlen(message);
-	int hdr_len = sizeof(msg->data.DisplayDynamicPromptStatusMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicPromptStatusMessage, hdr_len + msg_len);
+	if (!(msg = sccp_msg_encoder_begin(&enc, DisplayDynamicPromptStatusMessage))) {
+		return;
+	}
 	msg->data.DisplayDynamicPromptStatusMessage.lel_messageTimeout = htolel(timeout);
 	msg->data.DisplayDynamicPromptStatusMessage.lel_callReference = htolel(callid);
 	msg->data.DisplayDynamicPromptStatusMessage.lel_lineInstance = htolel(lineInstance);
-	memcpy(&msg->data.DisplayDynamicPromptStatusMessage.dummy, message, msg_len);
+	sccp_msg_encoder_putString(&enc, message);
 
-	sccp_dev_send(device, msg);
+	sccp_dev_sendStatic(device, sccp_msg_encoder_finish(&enc));
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display prompt on line %d, callid %d, timeout %d\n", device->id, lineInstance, callid, timeout);
 }
 
@@ -321,15 +429,15 @@ static void sccp_protocol_sendStaticDisplayNotify(constDevicePtr device, uint8_t
 static void sccp_protocol_sendDynamicDisplayNotify(constDevicePtr device, uint8_t timeout, const char *message)
 {
 	sccp_msg_t *msg = NULL;
+	sccp_msg_encoder_t enc;
 
-	int msg_len = strlen(message);
-
-	int hdr_len = sizeof(msg->data.DisplayDynamicNotifyMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicNotifyMessage, hdr_len + msg_len);
+	if (!(msg = sccp_msg_encoder_begin(&enc, DisplayDynamicNotifyMessage))) {
+		return;
+	}
 	msg->data.DisplayDynamicNotifyMessage.lel_displayTimeout = htolel(timeout);
-	memcpy(&msg->data.DisplayDynamicNotifyMessage.dummy, message, msg_len);
+	sccp_msg_encoder_putString(&enc, message);
 
-	sccp_dev_send(device, msg);
+	sccp_dev_sendStatic(device, sccp_msg_encoder_finish(&enc));
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display notify timeout %d\n", device->id, timeout);
 }
 
@@ -359,15 +467,16 @@ static void sccp_protocol_sendStaticDisplayPriNotify(constDevicePtr device, uint
 static void sccp_protocol_sendDynamicDisplayPriNotify(constDevicePtr device, uint8_t priority, uint8_t timeout, const char *message)
 {
 	sccp_msg_t *msg = NULL;
+	sccp_msg_encoder_t enc;
 
-	int msg_len = strlen(message);
-	int hdr_len = sizeof(msg->data.DisplayDynamicPriNotifyMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicPriNotifyMessage, hdr_len + msg_len);
+	if (!(msg = sccp_msg_encoder_begin(&enc, DisplayDynamicPriNotifyMessage))) {
+		return;
+	}
 	msg->data.DisplayDynamicPriNotifyMessage.lel_displayTimeout = htolel(timeout);
 	msg->data.DisplayDynamicPriNotifyMessage.lel_priority = htolel(priority);
-	memcpy(&msg->data.DisplayDynamicPriNotifyMessage.dummy, message, msg_len);
+	sccp_msg_encoder_putString(&enc, message);
 
-	sccp_dev_send(device, msg);
+	sccp_dev_sendStatic(device, sccp_msg_encoder_finish(&enc));
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display notify timeout %d\n", device->id, timeout);
 }
 
@@ -1052,21 +1161,54 @@ static void sccp_protocol_sendPortRequest(constDevicePtr device, constChannelPtr
 
 /* sendPortClose */
 /*!
- * \brief Send PortClose
+ * \brief Send PortClose (V3: not supported before protocol version 11)
  */
-static void sccp_protocol_sendPortClose(constDevicePtr device, constChannelPtr channel, skinny_mediaType_t mediaType)
-{
-	if (device->protocol && device->protocol->version >= 11) {
-		sccp_msg_t *msg = sccp_build_packet(PortCloseMessage, sizeof(msg->data.PortCloseMessage));
-		msg->data.PortCloseMessage.lel_conferenceId = htolel(channel->callid);
-		msg->data.PortCloseMessage.lel_passThruPartyId = htolel(channel->passthrupartyid);
-		msg->data.PortCloseMessage.lel_callReference = htolel(channel->callid);
-		msg->data.PortCloseMessage.lel_mediaType = htolel(mediaType);
-		sccp_dev_send(device, msg);
-	}
+static void sccp_protocol_sendPortCloseV3(constDevicePtr device, constChannelPtr channel, skinny_mediaType_t mediaType)
+{
+}
+
+/*!
+ * \brief Send PortClose (V11)
+ */
+static void sccp_protocol_sendPortCloseV11(constDevicePtr device, constChannelPtr channel, skinny_mediaType_t mediaType)
+{
+	sccp_msg_t *msg = sccp_build_packet(PortCloseMessage, sizeof(msg->data.PortCloseMessage));
+	msg->data.PortCloseMessage.lel_conferenceId = htolel(channel->callid);
+	msg->data.PortCloseMessage.lel_passThruPartyId = htolel(channel->passthrupartyid);
+	msg->data.PortCloseMessage.lel_callReference = htolel(channel->callid);
+	msg->data.PortCloseMessage.lel_mediaType = htolel(mediaType);
+	sccp_dev_send(device, msg);
 }
 /* done - sendPortClose */
 
+/* sendFeatureStatus */
+/*!
+ * \brief Send FeatureStat (V3)
+ */
+static void sccp_protocol_sendFeatureStatusV3(constDevicePtr device, uint32_t instance, uint32_t buttonType, uint32_t status, const char *label)
+{
+	sccp_msg_t *msg = sccp_build_packet(FeatureStatMessage, sizeof(msg->data.FeatureStatMessage));
+	msg->data.FeatureStatMessage.lel_featureIndex = htolel(instance);
+	msg->data.FeatureStatMessage.lel_featureID = htolel(buttonType);
+	msg->data.FeatureStatMessage.lel_featureStatus = htolel(status);
+	sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
+	sccp_dev_send(device, msg);
+}
+
+/*!
+ * \brief Send FeatureStatDynamic (V15)
+ */
+static void sccp_protocol_sendFeatureStatusV15(constDevicePtr device, uint32_t instance, uint32_t buttonType, uint32_t status, const char *label)
+{
+	sccp_msg_t *msg = sccp_build_packet(FeatureStatDynamicMessage, sizeof(msg->data.FeatureStatDynamicMessage));
+	msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(instance);
+	msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(buttonType);
+	msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(status);
+	sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
+	sccp_dev_send(device, msg);
+}
+/* done - sendFeatureStatus */
+
 /*! \todo need a protocol implementation for ConnectionStatisticsReq using Version 19 and higher */
 
 /*! \todo need a protocol implementation for ForwardStatMessage using Version 19 and higher */
@@ -1316,57 +1458,57 @@ static const sccp_deviceProtocol_t *sccpProtocolDefinition[] = {
 	NULL,
 	NULL,
 	NULL,
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 3, TimeDateReqMessage, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV3, sccp_protocol_sendStaticDisplayprompt, sccp_protocol_sendStaticDisplayNotify, sccp_protocol_sendStaticDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 3, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V3, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV3, sccp_protocol_sendStaticDisplayprompt, sccp_protocol_sendStaticDisplayNotify, sccp_protocol_sendStaticDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},	/* default impl */
 	NULL,
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 5, TimeDateReqMessage, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendStaticDisplayprompt, sccp_protocol_sendStaticDisplayNotify, sccp_protocol_sendStaticDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 5, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V3, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendStaticDisplayprompt, sccp_protocol_sendStaticDisplayNotify, sccp_protocol_sendStaticDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
 	NULL,
 	NULL,
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 8, TimeDateReqMessage, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 8, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V7, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 9, TimeDateReqMessage, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 9, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V7, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 10, TimeDateReqMessage, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 10, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V7, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 11, TimeDateReqMessage, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 11, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V7, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV3,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
 	NULL,
 	NULL,
 	NULL,
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 15, TimeDateReqMessage, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 15, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V15, sccp_protocol_sendCallInfoV7, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV17,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 16, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 16, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3, sccp_protocol_sendOpenMultiMediaChannelV17,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 17, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17, sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 17, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17, sccp_protocol_sendOpenMultiMediaChannelV17,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17, sccp_protocol_parseStartMediaTransmissionAckV17, sccp_protocol_parseStartMultiMediaTransmissionAckV17, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 18, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17, sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 18, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17, sccp_protocol_sendOpenMultiMediaChannelV17,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17, sccp_protocol_parseStartMediaTransmissionAckV17, sccp_protocol_parseStartMultiMediaTransmissionAckV17, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV3},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 19, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 19, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
 				  sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17, sccp_protocol_parseStartMediaTransmissionAckV17, sccp_protocol_parseStartMultiMediaTransmissionAckV17, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV19},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 20, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 20, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
 				  sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17, sccp_protocol_parseStartMediaTransmissionAckV17, sccp_protocol_parseStartMultiMediaTransmissionAckV17, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV19},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 21, TimeDateReqMessage, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 21, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16, sccp_protocol_sendDialedNumberV18, sccp_protocol_sendRegisterAckV11, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatusV18, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV17,
 				  sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17, sccp_protocol_sendStartMediaTransmissionV17, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17, sccp_protocol_parseStartMediaTransmissionAckV17, sccp_protocol_parseStartMultiMediaTransmissionAckV17, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV19},
-	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 22, TimeDateReqMessage, sccp_protocol_sendCallInfoV16,sccp_protocol_sendDialedNumberV18,sccp_protocol_sendRegisterAckV11,sccp_protocol_sendDynamicDisplayprompt,sccp_protocol_sendDynamicDisplayNotify,sccp_protocol_sendDynamicDisplayPriNotify,sccp_protocol_sendCallForwardStatusV18,sccp_protocol_sendUserToDeviceDataVersion1Message,sccp_protocol_sendFastPictureUpdate,sccp_protocol_sendOpenReceiveChannelv22,
+	&(sccp_deviceProtocol_t) {SCCP_PROTOCOL, 22, TimeDateReqMessage, SCCP_PROTOCOL_FEATURES_V16, sccp_protocol_sendCallInfoV16,sccp_protocol_sendDialedNumberV18,sccp_protocol_sendRegisterAckV11,sccp_protocol_sendDynamicDisplayprompt,sccp_protocol_sendDynamicDisplayNotify,sccp_protocol_sendDynamicDisplayPriNotify,sccp_protocol_sendCallForwardStatusV18,sccp_protocol_sendUserToDeviceDataVersion1Message,sccp_protocol_sendFastPictureUpdate,sccp_protocol_sendOpenReceiveChannelv22,
 				  sccp_protocol_sendOpenMultiMediaChannelV17,
-				  sccp_protocol_sendStartMultiMediaTransmissionV17,sccp_protocol_sendStartMediaTransmissionv22,sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV17,sccp_protocol_sendStartMediaTransmissionv22,sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV11, sccp_protocol_sendFeatureStatusV15,
 				  sccp_protocol_parseOpenReceiveChannelAckV17,sccp_protocol_parseOpenMultiMediaReceiveChannelAckV17,sccp_protocol_parseStartMediaTransmissionAckV17,sccp_protocol_parseStartMultiMediaTransmissionAckV17,sccp_protocol_parseEnblocCallV22, sccp_protocol_parsePortResponseV19},
 };
 
@@ -1374,9 +1516,9 @@ static const sccp_deviceProtocol_t *sccpProtocolDefinition[] = {
  * \brief SPCP Protocol Version to Message Mapping
  */
 static const sccp_deviceProtocol_t *spcpProtocolDefinition[] = {
-	&(sccp_deviceProtocol_t) {SPCP_PROTOCOL, 0, RegisterAvailableLinesMessage, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3,
+	&(sccp_deviceProtocol_t) {SPCP_PROTOCOL, 0, RegisterAvailableLinesMessage, SCCP_PROTOCOL_FEATURES_V3, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3,
 				  sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV3, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV3, sccp_protocol_parsePortResponseV3},
 	NULL,
 	NULL,
@@ -1385,9 +1527,9 @@ static const sccp_deviceProtocol_t *spcpProtocolDefinition[] = {
 	NULL,
 	NULL,
 	NULL,
-	&(sccp_deviceProtocol_t) {SPCP_PROTOCOL, 8, RegisterAvailableLinesMessage, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3,
+	&(sccp_deviceProtocol_t) {SPCP_PROTOCOL, 8, RegisterAvailableLinesMessage, SCCP_PROTOCOL_FEATURES_V7, sccp_protocol_sendCallInfoV3, sccp_protocol_sendDialedNumberV3, sccp_protocol_sendRegisterAckV4, sccp_protocol_sendDynamicDisplayprompt, sccp_protocol_sendDynamicDisplayNotify, sccp_protocol_sendDynamicDisplayPriNotify, sccp_protocol_sendCallForwardStatus, sccp_protocol_sendUserToDeviceDataVersion1Message, sccp_protocol_sendFastPictureUpdate, sccp_protocol_sendOpenReceiveChannelV3,
 				  sccp_protocol_sendOpenMultiMediaChannelV3,
-				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortClose,
+				  sccp_protocol_sendStartMultiMediaTransmissionV3, sccp_protocol_sendStartMediaTransmissionV3, sccp_protocol_sendConnectionStatisticsReqV19, sccp_protocol_sendPortRequest,sccp_protocol_sendPortCloseV3, sccp_protocol_sendFeatureStatusV3,
 				  sccp_protocol_parseOpenReceiveChannelAckV3, sccp_protocol_parseOpenMultiMediaReceiveChannelAckV3, sccp_protocol_parseStartMediaTransmissionAckV3, sccp_protocol_parseStartMultiMediaTransmissionAckV3, sccp_protocol_parseEnblocCallV17, sccp_protocol_parsePortResponseV19},
 };
 
@@ -1498,200 +1640,73 @@ const char *skinny_keymode2longstr(skinny_keymode_t keymode)
 	}
 }
 
-const struct messagetype sccp_messagetypes[] = {
-	/* *INDENT-OFF* */
-	[KeepAliveMessage] = {KeepAliveMessage,						"Keep Alive Message",				offsize(sccp_data_t, StationKeepAliveMessage)},
-	[RegisterMessage] = {RegisterMessage,						"Register Message",				offsize(sccp_data_t, RegisterMessage)},
-	[IpPortMessage] = {IpPortMessage,						"Ip-Port Message",				offsize(sccp_data_t, IpPortMessage)},
-	[KeypadButtonMessage] = {KeypadButtonMessage,					"Keypad Button Message",			offsize(sccp_data_t, KeypadButtonMessage)},
-	[EnblocCallMessage] = {EnblocCallMessage,					"Enbloc Call Message",				offsize(sccp_data_t, EnblocCallMessage)},
-	[StimulusMessage] = {StimulusMessage,						"Stimulus Message",				offsize(sccp_data_t, StimulusMessage)},
-	[OffHookMessage] = {OffHookMessage,						"Off-Hook Message",				offsize(sccp_data_t, OffHookMessage)},
-	[OnHookMessage] = {OnHookMessage,						"On-Hook Message",				offsize(sccp_data_t, OnHookMessage)},
-	[HookFlashMessage] = {HookFlashMessage,						"Hook-Flash Message",				offsize(sccp_data_t, HookFlashMessage)},
-	[ForwardStatReqMessage] = {ForwardStatReqMessage,				"Forward State Request",			offsize(sccp_data_t, ForwardStatReqMessage)},
-	[SpeedDialStatReqMessage] = {SpeedDialStatReqMessage,				"Speed-Dial State Request",			offsize(sccp_data_t, SpeedDialStatReqMessage)},
-	[LineStatReqMessage] = {LineStatReqMessage,					"Line State Request",				offsize(sccp_data_t, LineStatReqMessage)},
-	[ConfigStatReqMessage] = {ConfigStatReqMessage,					"Config State Request",				offsize(sccp_data_t, ConfigStatReqMessage)},
-	[TimeDateReqMessage] = {TimeDateReqMessage,					"Time Date Request",				offsize(sccp_data_t, TimeDateReqMessage)},
-	[ButtonTemplateReqMessage] = {ButtonTemplateReqMessage,				"Button Template Request",			offsize(sccp_data_t, ButtonTemplateReqMessage)},
-	[VersionReqMessage] = {VersionReqMessage,					"Version Request",				offsize(sccp_data_t, VersionReqMessage)},
-	[CapabilitiesResMessage] = {CapabilitiesResMessage,				"Capabilities Response Message",		offsize(sccp_data_t, CapabilitiesResMessage)},
-	[MediaPortListMessage] = {MediaPortListMessage,					"Media Port List Message",			offsize(sccp_data_t, MediaPortListMessage)},
-	[ServerReqMessage] = {ServerReqMessage,						"Server Request",				offsize(sccp_data_t, ServerReqMessage)},
-	[AlarmMessage] = {AlarmMessage,							"Alarm Message",				offsize(sccp_data_t, AlarmMessage)},
-	[MulticastMediaReceptionAck] = {MulticastMediaReceptionAck,			"Multicast Media Reception Acknowledge",	offsize(sccp_data_t, MulticastMediaReceptionAck)},
-	[OpenReceiveChannelAck] = {OpenReceiveChannelAck,				"Open Receive Channel Acknowledge",		offsize(sccp_data_t, OpenReceiveChannelAck)},
-	[ConnectionStatisticsRes] = {ConnectionStatisticsRes,				"Connection Statistics Response",		offsize(sccp_data_t, ConnectionStatisticsRes)},
-	[OffHookWithCgpnMessage] = {OffHookWithCgpnMessage,				"Off-Hook With Cgpn Message",			offsize(sccp_data_t, OffHookWithCgpnMessage)},
-	[SoftKeySetReqMessage] = {SoftKeySetReqMessage,					"SoftKey Set Request",				offsize(sccp_data_t, SoftKeySetReqMessage)},
-	[SoftKeyEventMessage] = {SoftKeyEventMessage,					"SoftKey Event Message",			offsize(sccp_data_t, SoftKeyEventMessage)},
-	[UnregisterMessage] = {UnregisterMessage,					"Unregister Message",				offsize(sccp_data_t, UnregisterMessage)},
-	[SoftKeyTemplateReqMessage] = {SoftKeyTemplateReqMessage,			"SoftKey Template Request",			offsize(sccp_data_t, SoftKeyTemplateReqMessage)},
-	[RegisterTokenRequest] = {RegisterTokenRequest,					"Register Token Request",			offsize(sccp_data_t, RegisterTokenRequest)},
-	[MediaTransmissionFailure] = {MediaTransmissionFailure,				"Media Transmission Failure",			offsize(sccp_data_t, MediaTransmissionFailure)}, 
-	[HeadsetStatusMessage] = {HeadsetStatusMessage,					"Headset Status Message",			offsize(sccp_data_t, HeadsetStatusMessage)},
-	[MediaResourceNotification] = {MediaResourceNotification,			"Media Resource Notification",			offsize(sccp_data_t, MediaResourceNotification)},
-	[RegisterAvailableLinesMessage] = {RegisterAvailableLinesMessage,		"Register Available Lines Message",		offsize(sccp_data_t, RegisterAvailableLinesMessage)},
-	[DeviceToUserDataMessage] = {DeviceToUserDataMessage,				"Device To User Data Message",			offsize(sccp_data_t, DeviceToUserDataMessage)},
-	[DeviceToUserDataResponseMessage] = {DeviceToUserDataResponseMessage,		"Device To User Data Response",			offsize(sccp_data_t, DeviceToUserDataResponseMessage)},
-	[UpdateCapabilitiesMessage] = {UpdateCapabilitiesMessage,			"Update Capabilities Message",			offsize(sccp_data_t, UpdateCapabilitiesMessage)},
-	[OpenMultiMediaReceiveChannelAckMessage] = {OpenMultiMediaReceiveChannelAckMessage,	"Open MultiMedia Receive Channel Acknowledge",	offsize(sccp_data_t, OpenMultiMediaReceiveChannelAckMessage)},
-	[ClearConferenceMessage] = {ClearConferenceMessage,				"Clear Conference Message",			offsize(sccp_data_t, ClearConferenceMessage)},
-	[ServiceURLStatReqMessage] = {ServiceURLStatReqMessage,				"Service URL State Request",			offsize(sccp_data_t, ServiceURLStatReqMessage)},
-	[FeatureStatReqMessage] = {FeatureStatReqMessage,				"Feature State Request",			offsize(sccp_data_t, FeatureStatReqMessage)},
-	[CreateConferenceResMessage] = {CreateConferenceResMessage,			"Create Conference Response",			offsize(sccp_data_t, CreateConferenceResMessage)},
-	[DeleteConferenceResMessage] = {DeleteConferenceResMessage,			"Delete Conference Response",			offsize(sccp_data_t, DeleteConferenceResMessage)},
-	[ModifyConferenceResMessage] = {ModifyConferenceResMessage,			"Modify Conference Response",			offsize(sccp_data_t, ModifyConferenceResMessage)},
-	[AddParticipantResMessage] = {AddParticipantResMessage,				"Add Participant Response",			offsize(sccp_data_t, AddParticipantResMessage)},
-	[AuditConferenceResMessage] = {AuditConferenceResMessage,			"Audit Conference Response",			offsize(sccp_data_t, AuditConferenceResMessage)},
-	[AuditParticipantResMessage] = {AuditParticipantResMessage,			"Audit Participant Response",			offsize(sccp_data_t, AuditParticipantResMessage)},
-	[DeviceToUserDataVersion1Message] = {DeviceToUserDataVersion1Message,		"Device To User Data Version1 Message",		offsize(sccp_data_t, DeviceToUserDataVersion1Message)},
-	[DeviceToUserDataResponseVersion1Message] = {DeviceToUserDataResponseVersion1Message,	"Device To User Data Version1 Response",offsize(sccp_data_t, DeviceToUserDataResponseVersion1Message)},
-	[SubscriptionStatReqMessage] = {SubscriptionStatReqMessage,			"Subscription Status Request (DialedPhoneBook)", offsize(sccp_data_t, SubscriptionStatReqMessage)},
-	[AccessoryStatusMessage] = {AccessoryStatusMessage,				"Accessory Status Message",			offsize(sccp_data_t, AccessoryStatusMessage)},
-	[RegisterAckMessage] = {RegisterAckMessage,					"Register Acknowledge",				offsize(sccp_data_t, RegisterAckMessage)},
-	[StartToneMessage] = {StartToneMessage,						"Start Tone Message",				offsize(sccp_data_t, StartToneMessage)},
-	[StopToneMessage] = {StopToneMessage,						"Stop Tone Message",				offsize(sccp_data_t, StopToneMessage)},
-	[SetRingerMessage] = {SetRingerMessage,						"Set Ringer Message",				offsize(sccp_data_t, SetRingerMessage)},
-	[SetLampMessage] = {SetLampMessage,						"Set Lamp Message",				offsize(sccp_data_t, SetLampMessage)},
-	[SetHookFlashDetectMessage] = {SetHookFlashDetectMessage,			"Set HookFlash Detect Message",			offsize(sccp_data_t, SetHookFlashDetectMessage)},
-	[SetSpeakerModeMessage] = {SetSpeakerModeMessage,				"Set Speaker Mode Message",			offsize(sccp_data_t, SetSpeakerModeMessage)},
-	[SetMicroModeMessage] = {SetMicroModeMessage,					"Set Micro Mode Message",			offsize(sccp_data_t, SetMicroModeMessage)},
-	[StartMediaTransmission] = {StartMediaTransmission,				"Start Media Transmission",			offsize(sccp_data_t, StartMediaTransmission)},
-	[StopMediaTransmission] = {StopMediaTransmission,				"Stop Media Transmission",			offsize(sccp_data_t, StopMediaTransmission)},
-	[StartMediaReception] = {StartMediaReception,					"Start Media Reception",			offsize(sccp_data_t, StartMediaReception)},
-	[StopMediaReception] = {StopMediaReception,					"Stop Media Reception",				offsize(sccp_data_t, StopMediaReception)},
-	[CallInfoMessage] = {CallInfoMessage,						"Call Information Message",			offsize(sccp_data_t, CallInfoMessage)},
-	[ForwardStatMessage] = {ForwardStatMessage,					"Forward State Message",			offsize(sccp_data_t, ForwardStatMessage)},
-	[SpeedDialStatMessage] = {SpeedDialStatMessage,					"SpeedDial State Message",			offsize(sccp_data_t, SpeedDialStatMessage)},
-	[LineStatMessage] = {LineStatMessage,						"Line State Message",				offsize(sccp_data_t, LineStatMessage)},
-	[ConfigStatMessage] = {ConfigStatMessage,					"Config State Message",				offsize(sccp_data_t, ConfigStatMessage)},
-	[ConfigStatDynamicMessage] = {ConfigStatDynamicMessage,				"Config State Dynamic Message",			offsize(sccp_data_t, ConfigStatDynamicMessage)},
-	[DefineTimeDate] = {DefineTimeDate,						"Define Time Date",				offsize(sccp_data_t, DefineTimeDate)},
-	[StartSessionTransmission] = {StartSessionTransmission,				"Start Session Transmission",			offsize(sccp_data_t, StartSessionTransmission)},
-	[StopSessionTransmission] = {StopSessionTransmission,				"Stop Session Transmission",			offsize(sccp_data_t, StopSessionTransmission)},
-	[ButtonTemplateMessage] = {ButtonTemplateMessage,				"Button Template Message",			offsize(sccp_data_t, ButtonTemplateMessage)},
-	//[ButtonTemplateMessageSingle] = {ButtonTemplateMessageSingle,			"Button Template Message Single",		offsize(sccp_data_t, ButtonTemplateMessageSingle)},
-	[VersionMessage] = {VersionMessage,						"Version Message",				offsize(sccp_data_t, VersionMessage)},
-	[DisplayTextMessage] = {DisplayTextMessage,					"Display Text Message",				offsize(sccp_data_t, DisplayTextMessage)},
-	[ClearDisplay] = {ClearDisplay,							"Clear Display",				offsize(sccp_data_t, ClearDisplay)},
-	[CapabilitiesReqMessage] = {CapabilitiesReqMessage,				"Capabilities Request",				offsize(sccp_data_t, CapabilitiesReqMessage)},
-	[EnunciatorCommandMessage] = {EnunciatorCommandMessage,				"Enunciator Command Message",			offsize(sccp_data_t, EnunciatorCommandMessage)},
-	[RegisterRejectMessage] = {RegisterRejectMessage,				"Register Reject Message",			offsize(sccp_data_t, RegisterRejectMessage)},
-	[ServerResMessage] = {ServerResMessage,						"Server Response",				offsize(sccp_data_t, ServerResMessage)},
-	[Reset] = {Reset,								"Reset",					offsize(sccp_data_t, Reset)},
-	[KeepAliveAckMessage] = {KeepAliveAckMessage,					"Keep Alive Acknowledge",			offsize(sccp_data_t, KeepAliveAckMessage)},
-	[StartMulticastMediaReception] = {StartMulticastMediaReception,			"Start MulticastMedia Reception",		offsize(sccp_data_t, StartMulticastMediaReception)},
-	[StartMulticastMediaTransmission] = {StartMulticastMediaTransmission,		"Start MulticastMedia Transmission",		offsize(sccp_data_t, StartMulticastMediaTransmission)},
-	[StopMulticastMediaReception] = {StopMulticastMediaReception,			"Stop MulticastMedia Reception",		offsize(sccp_data_t, StopMulticastMediaReception)},
-	[StopMulticastMediaTransmission] = {StopMulticastMediaTransmission,		"Stop MulticastMedia Transmission",		offsize(sccp_data_t, StopMulticastMediaTransmission)},
-	[OpenReceiveChannel] = {OpenReceiveChannel,					"Open Receive Channel",				offsize(sccp_data_t, OpenReceiveChannel)},
-	[CloseReceiveChannel] = {CloseReceiveChannel,					"Close Receive Channel",			offsize(sccp_data_t, CloseReceiveChannel)},
-	[ConnectionStatisticsReq] = {ConnectionStatisticsReq,				"Connection Statistics Request",		offsize(sccp_data_t, ConnectionStatisticsReq)},
-	[SoftKeyTemplateResMessage] = {SoftKeyTemplateResMessage,			"SoftKey Template Response",			offsize(sccp_data_t, SoftKeyTemplateResMessage)},
-	[SoftKeySetResMessage] = {SoftKeySetResMessage,					"SoftKey Set Response",				offsize(sccp_data_t, SoftKeySetResMessage)},
-	[SelectSoftKeysMessage] = {SelectSoftKeysMessage,				"Select SoftKeys Message",			offsize(sccp_data_t, SelectSoftKeysMessage)},
-	[CallStateMessage] = {CallStateMessage,						"Call State Message",				offsize(sccp_data_t, CallStateMessage)},
-	[DisplayPromptStatusMessage] = {DisplayPromptStatusMessage,			"Display Prompt Status Message",		offsize(sccp_data_t, DisplayPromptStatusMessage)},
-	[ClearPromptStatusMessage] = {ClearPromptStatusMessage,				"Clear Prompt Status Message",			offsize(sccp_data_t, ClearPromptStatusMessage)},
-	[DisplayNotifyMessage] = {DisplayNotifyMessage,					"Display Notify Message",			offsize(sccp_data_t, DisplayNotifyMessage)},
-	[ClearNotifyMessage] = {ClearNotifyMessage,					"Clear Notify Message",				offsize(sccp_data_t, ClearNotifyMessage)},
-	[ActivateCallPlaneMessage] = {ActivateCallPlaneMessage,				"Activate Call Plane Message",			offsize(sccp_data_t, ActivateCallPlaneMessage)},
-	[DeactivateCallPlaneMessage] = {DeactivateCallPlaneMessage,			"Deactivate Call Plane Message",		offsize(sccp_data_t, DeactivateCallPlaneMessage)},
-	[UnregisterAckMessage] = {UnregisterAckMessage,					"Unregister Acknowledge",			offsize(sccp_data_t, UnregisterAckMessage)},
-	[BackSpaceResMessage] = {BackSpaceResMessage,					"Back Space Response",				offsize(sccp_data_t, BackSpaceResMessage)},
-	[RegisterTokenAck] = {RegisterTokenAck,						"Register Token Acknowledge",			offsize(sccp_data_t, RegisterTokenAck)},
-	[RegisterTokenReject] = {RegisterTokenReject,					"Register Token Reject",			offsize(sccp_data_t, RegisterTokenReject)},
-	[StartMediaFailureDetection] = {StartMediaFailureDetection,			"Start Media Failure Detection",		offsize(sccp_data_t, StartMediaFailureDetection)},
-	[DialedNumberMessage] = {DialedNumberMessage,					"Dialed Number Message",			offsize(sccp_data_t, DialedNumberMessage)},
-	[UserToDeviceDataMessage] = {UserToDeviceDataMessage,				"User To Device Data Message",			offsize(sccp_data_t, UserToDeviceDataMessage)},
-	[FeatureStatMessage] = {FeatureStatMessage,					"Feature State Message",			offsize(sccp_data_t, FeatureStatMessage)},
-	[DisplayPriNotifyMessage] = {DisplayPriNotifyMessage,				"Display Pri Notify Message",			offsize(sccp_data_t, DisplayPriNotifyMessage)},
-	[ClearPriNotifyMessage] = {ClearPriNotifyMessage,				"Clear Pri Notify Message",			offsize(sccp_data_t, ClearPriNotifyMessage)},
-	[StartAnnouncementMessage] = {StartAnnouncementMessage,				"Start Announcement Message",			offsize(sccp_data_t, StartAnnouncementMessage)},
-	[StopAnnouncementMessage] = {StopAnnouncementMessage,				"Stop Announcement Message",			offsize(sccp_data_t, StopAnnouncementMessage)},
-	[AnnouncementFinishMessage] = {AnnouncementFinishMessage,			"Announcement Finish Message",			offsize(sccp_data_t, AnnouncementFinishMessage)},
-	[NotifyDtmfToneMessage] = {NotifyDtmfToneMessage,				"Notify DTMF Tone Message",			offsize(sccp_data_t, NotifyDtmfToneMessage)},
-	[SendDtmfToneMessage] = {SendDtmfToneMessage,					"Send DTMF Tone Message",			offsize(sccp_data_t, SendDtmfToneMessage)},
-	[SubscribeDtmfPayloadReqMessage] = {SubscribeDtmfPayloadReqMessage,		"Subscribe DTMF Payload Request",		offsize(sccp_data_t, SubscribeDtmfPayloadReqMessage)},
-	[SubscribeDtmfPayloadResMessage] = {SubscribeDtmfPayloadResMessage,		"Subscribe DTMF Payload Response",		offsize(sccp_data_t, SubscribeDtmfPayloadResMessage)},
-	[SubscribeDtmfPayloadErrMessage] = {SubscribeDtmfPayloadErrMessage,		"Subscribe DTMF Payload Error Message",		offsize(sccp_data_t, SubscribeDtmfPayloadErrMessage)},
-	[UnSubscribeDtmfPayloadReqMessage] = {UnSubscribeDtmfPayloadReqMessage,		"UnSubscribe DTMF Payload Request",		offsize(sccp_data_t, UnSubscribeDtmfPayloadReqMessage)},
-	[UnSubscribeDtmfPayloadResMessage] = {UnSubscribeDtmfPayloadResMessage,		"UnSubscribe DTMF Payload Response",		offsize(sccp_data_t, UnSubscribeDtmfPayloadResMessage)},
-	[UnSubscribeDtmfPayloadErrMessage] = {UnSubscribeDtmfPayloadErrMessage,		"UnSubscribe DTMF Payload Error Message",	offsize(sccp_data_t, UnSubscribeDtmfPayloadErrMessage)},
-	[ServiceURLStatMessage] = {ServiceURLStatMessage,				"ServiceURL State Message",			offsize(sccp_data_t, ServiceURLStatMessage)},
-	[CallSelectStatMessage] = {CallSelectStatMessage,				"Call Select State Message",			offsize(sccp_data_t, CallSelectStatMessage)},
-	[OpenMultiMediaChannelMessage] = {OpenMultiMediaChannelMessage,			"Open MultiMedia Channel Message",		offsize(sccp_data_t, OpenMultiMediaChannelMessage)},
-	[StartMultiMediaTransmission] = {StartMultiMediaTransmission,			"Start MultiMedia Transmission",		offsize(sccp_data_t, StartMultiMediaTransmission)},
-	[StopMultiMediaTransmission] = {StopMultiMediaTransmission,			"Stop MultiMedia Transmission",			offsize(sccp_data_t, StopMultiMediaTransmission)},
-	[MiscellaneousCommandMessage] = {MiscellaneousCommandMessage,			"Miscellaneous Command Message",		offsize(sccp_data_t, MiscellaneousCommandMessage)},
-	[FlowControlCommandMessage] = {FlowControlCommandMessage,			"Flow Control Command Message",			offsize(sccp_data_t, FlowControlCommandMessage)},
-	[CloseMultiMediaReceiveChannel] = {CloseMultiMediaReceiveChannel,		"Close MultiMedia Receive Channel",		offsize(sccp_data_t, CloseMultiMediaReceiveChannel)},
-	[CreateConferenceReqMessage] = {CreateConferenceReqMessage,			"Create Conference Request",			offsize(sccp_data_t, CreateConferenceReqMessage)},
-	[DeleteConferenceReqMessage] = {DeleteConferenceReqMessage,			"Delete Conference Request",			offsize(sccp_data_t, DeleteConferenceReqMessage)},
-	[ModifyConferenceReqMessage] = {ModifyConferenceReqMessage,			"Modify Conference Request",			offsize(sccp_data_t, ModifyConferenceReqMessage)},
-	[AddParticipantReqMessage] = {AddParticipantReqMessage,				"Add Participant Request",			offsize(sccp_data_t, AddParticipantReqMessage)},
-	[DropParticipantReqMessage] = {DropParticipantReqMessage,			"Drop Participant Request",			offsize(sccp_data_t, DropParticipantReqMessage)},
-	[AuditConferenceReqMessage] = {AuditConferenceReqMessage,			"Audit Conference Request",			offsize(sccp_data_t, AuditConferenceReqMessage)},
-	[AuditParticipantReqMessage] = {AuditParticipantReqMessage,			"Audit Participant Request",			offsize(sccp_data_t, AuditParticipantReqMessage)},
-	[UserToDeviceDataVersion1Message] = {UserToDeviceDataVersion1Message,		"User To Device Data Version1 Message",		offsize(sccp_data_t, UserToDeviceDataVersion1Message)},
-	[DisplayDynamicNotifyMessage] = {DisplayDynamicNotifyMessage,			"Display Dynamic Notify Message",		offsize(sccp_data_t, DisplayDynamicNotifyMessage)},
-	[DisplayDynamicPriNotifyMessage] = {DisplayDynamicPriNotifyMessage,		"Display Dynamic Priority Notify Message",	offsize(sccp_data_t, DisplayDynamicPriNotifyMessage)},
-	[DisplayDynamicPromptStatusMessage] = {DisplayDynamicPromptStatusMessage,"Display Dynamic Prompt Status Message",	offsize(sccp_data_t, DisplayDynamicPromptStatusMessage)},
-	[FeatureStatDynamicMessage] = {FeatureStatDynamicMessage,			"SpeedDial State Dynamic Message",		offsize(sccp_data_t, FeatureStatDynamicMessage)},
-	[LineStatDynamicMessage] = {LineStatDynamicMessage,				"Line State Dynamic Message",			offsize(sccp_data_t, LineStatDynamicMessage)},
-	[ServiceURLStatDynamicMessage] = {ServiceURLStatDynamicMessage,			"Service URL Stat Dynamic Messages",		offsize(sccp_data_t, ServiceURLStatDynamicMessage)},
-	[SpeedDialStatDynamicMessage] = {SpeedDialStatDynamicMessage,			"SpeedDial Stat Dynamic Message",		offsize(sccp_data_t, SpeedDialStatDynamicMessage)},
-	[CallInfoDynamicMessage] = {CallInfoDynamicMessage,				"Call Information Dynamic Message",		offsize(sccp_data_t, CallInfoDynamicMessage)},
-	[SubscriptionStatMessage] = {SubscriptionStatMessage,				"Subscription Status Response (Dialed Number)", offsize(sccp_data_t, SubscriptionStatMessage)},
-	[NotificationMessage] = {NotificationMessage,					"Notify Call List (CallListStatusUpdate)",	offsize(sccp_data_t, NotificationMessage)},
-	[StartMediaTransmissionAck] = {StartMediaTransmissionAck,			"Start Media Transmission Acknowledge",		offsize(sccp_data_t, StartMediaTransmissionAck)},
-	[StartMultiMediaTransmissionAck] = {StartMultiMediaTransmissionAck,		"Start Media Transmission Acknowledge",		offsize(sccp_data_t, StartMultiMediaTransmissionAck)},
-	[CallHistoryDispositionMessage] = {CallHistoryDispositionMessage,		"Call History Disposition",			offsize(sccp_data_t, CallHistoryDispositionMessage)},
-	[LocationInfoMessage] = {LocationInfoMessage,					"Location/Wifi Information",			offsize(sccp_data_t, LocationInfoMessage)},
-	[ExtensionDeviceCaps] = {ExtensionDeviceCaps,					"Extension Device Capabilities Message",	offsize(sccp_data_t, ExtensionDeviceCaps)},
-	[XMLAlarmMessage] = {XMLAlarmMessage,						"XML-AlarmMessage",				offsize(sccp_data_t, XMLAlarmMessage)},
-	[MediaPathCapabilityMessage] = {MediaPathCapabilityMessage,			"MediaPath Capability Message",			offsize(sccp_data_t, MediaPathCapabilityMessage)},
-	[FlowControlNotifyMessage] = {FlowControlNotifyMessage,				"FlowControl Notify Message",			offsize(sccp_data_t, FlowControlNotifyMessage)},
-	[CallCountReqMessage] = {CallCountReqMessage,					"CallCount Request Message",			offsize(sccp_data_t, CallCountReqMessage)},
-/*new*/
-	[UpdateCapabilitiesV2Message] = {UpdateCapabilitiesV2Message,			"Update Capabilities V2",			offsize(sccp_data_t, UpdateCapabilitiesV2Message)},
-	[UpdateCapabilitiesV3Message] = {UpdateCapabilitiesV3Message,			"Update Capabilities V3",			offsize(sccp_data_t, UpdateCapabilitiesV3Message)},
-	[PortResponseMessage] = {PortResponseMessage,					"Port Response Message",			offsize(sccp_data_t, PortResponseMessage)},
-	[QoSResvNotifyMessage] = {QoSResvNotifyMessage,					"QoS Resv Notify Message",			offsize(sccp_data_t, QoSResvNotifyMessage)},
-	[QoSErrorNotifyMessage] = {QoSErrorNotifyMessage,				"QoS Error Notify Message",			offsize(sccp_data_t, QoSErrorNotifyMessage)},
-	[PortRequestMessage] = {PortRequestMessage,					"Port Request Message",				offsize(sccp_data_t, PortRequestMessage)},
-	[PortCloseMessage] = {PortCloseMessage,						"Port Close Message",				offsize(sccp_data_t, PortCloseMessage)},
-	[QoSListenMessage] = {QoSListenMessage,						"QoS Listen Message",				offsize(sccp_data_t, QoSListenMessage)},
-	[QoSPathMessage] = {QoSPathMessage,						"QoS Path Message",				offsize(sccp_data_t, QoSPathMessage)},
-	[QoSTeardownMessage] = {QoSTeardownMessage,					"QoS Teardown Message",				offsize(sccp_data_t, QoSTeardownMessage)},
-	[UpdateDSCPMessage] = {UpdateDSCPMessage,					"Update DSCP Message",				offsize(sccp_data_t, UpdateDSCPMessage)},
-	[QoSModifyMessage] = {QoSModifyMessage,						"QoS Modify Message",				offsize(sccp_data_t, QoSModifyMessage)},
-	[MwiResponseMessage] = {MwiResponseMessage,					"Mwi Response Message",				offsize(sccp_data_t, MwiResponseMessage)},
-	[CallCountRespMessage] = {CallCountRespMessage,					"CallCount Response Message",			offsize(sccp_data_t, CallCountRespMessage)},
-	[RecordingStatusMessage] = {RecordingStatusMessage,				"Recording Status Message",			offsize(sccp_data_t, RecordingStatusMessage)},
-	/* *INDENT-ON* */
-};
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_protocol_msg_encoder)
+{
+	sccp_msg_encoder_t enc;
+	sccp_msg_t *msg = NULL;
+	const char *dummy = NULL;
+	char longstr[2 * SCCP_MAX_PACKET];
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "msg_encoder";
+			info->category = "/channels/chan_sccp/protocol/";
+			info->summary = "chan-sccp-b dynamic message encoder test";
+			info->description = "Verifies the field layout, padding, header length and truncation of the single pass message encoder";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
 
-const struct messagetype spcp_messagetypes[] = {
-	/* *INDENT-OFF* */
-	[SPCPRegisterTokenRequest - SPCP_MESSAGE_OFFSET	] = {SPCPRegisterTokenRequest,	"SPCP Register Token Request",			offsize(sccp_data_t, SPCPRegisterTokenRequest)},
-	[SPCPRegisterTokenAck - SPCP_MESSAGE_OFFSET	] = {SPCPRegisterTokenAck,	"SPCP RegisterMessageACK",			offsize(sccp_data_t, SPCPRegisterTokenAck)},
-	[SPCPRegisterTokenReject - SPCP_MESSAGE_OFFSET	] = {SPCPRegisterTokenReject,	"SPCP RegisterMessageReject",			offsize(sccp_data_t, SPCPRegisterTokenReject)},
-	//[UnknownVGMessage - SPCP_MESSAGE_OFFSET		] = {UnknownVGMessage,		"Unknown Message (VG224)",			offsize(sccp_data_t, UnknownVGMessage)},
-	/* *INDENT-ON* */
-};
+	pbx_test_status_update(test, "Encode DisplayDynamicNotifyMessage...\n");
+	msg = sccp_msg_encoder_begin(&enc, DisplayDynamicNotifyMessage);
+	pbx_test_validate(test, msg != NULL);
+	msg->data.DisplayDynamicNotifyMessage.lel_displayTimeout = htolel(5);
+	sccp_msg_encoder_putString(&enc, "Hello");
+	msg = sccp_msg_encoder_finish(&enc);
+	pbx_test_validate(test, letohl(msg->header.lel_messageId) == DisplayDynamicNotifyMessage);
+	pbx_test_validate(test, letohl(msg->header.length) == 4 + 4 + 8);					/* timeout + "Hello\0" padded to 8 */
+	pbx_test_validate(test, !strcmp((const char *) &msg->data.DisplayDynamicNotifyMessage.dummy, "Hello"));
+	pbx_test_validate(test, enc.overflow == FALSE);
+
+	pbx_test_status_update(test, "Encode LineStatDynamicMessage with empty field...\n");
+	msg = sccp_utils_buildLineStatDynamicMessage(2, 0x0f, "98011", "", "Line 2");
+	pbx_test_validate(test, msg != NULL);
+	dummy = msg->data.LineStatDynamicMessage.dummy;
+	pbx_test_validate(test, !strcmp(dummy, "98011"));
+	pbx_test_validate(test, dummy[6] == '\0');
+	pbx_test_validate(test, !strcmp(dummy + 7, "Line 2"));
+	pbx_test_validate(test, (letohl(msg->header.length) & 3) == 0);
+	pbx_test_validate(test, letohl(msg->header.length) == 4 + 8 + 16);					/* 6 + 1 + 7 = 14, padded to 16 */
+	sccp_free(msg);
+
+	pbx_test_status_update(test, "Encode truncated CallInfoDynamicMessage...\n");
+	memset(longstr, 'x', sizeof(longstr) - 1);
+	longstr[sizeof(longstr) - 1] = '\0';
+	msg = sccp_msg_encoder_begin(&enc, CallInfoDynamicMessage);
+	pbx_test_validate(test, msg != NULL);
+	sccp_msg_encoder_putString(&enc, "1234");
+	sccp_msg_encoder_putString(&enc, longstr);
+	sccp_msg_encoder_putString(&enc, "5678");
+	msg = sccp_msg_encoder_finish(&enc);
+	pbx_test_validate(test, enc.overflow == TRUE);
+	pbx_test_validate(test, letohl(msg->header.length) + 8 <= SCCP_MAX_PACKET);
+	pbx_test_validate(test, ((const char *) &msg->data)[enc.offset - 1] == '\0');
+
+	return AST_TEST_PASS;
+}
 
-gcc_inline const char *msgtype2str(sccp_mid_t msgId)
-{														/* sccp_protocol.h */
-	if (msgId >= SPCP_MESSAGE_OFFSET && (msgId - SPCP_MESSAGE_OFFSET) < ARRAY_LEN(spcp_messagetypes)) {
-		return spcp_messagetypes[msgId - SPCP_MESSAGE_OFFSET].text;
-	}
-	if (msgId < ARRAY_LEN(sccp_messagetypes)) {
-		return sccp_messagetypes[msgId].text;
-	} 
-	return "SCCP: Requested MessageId does not exist";
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_protocol_msg_encoder);
 }
 
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_protocol_msg_encoder);
+}
+#endif
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
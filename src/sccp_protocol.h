@@ -3257,16 +3257,36 @@ typedef struct {
 	uint8_t count;												/*!< Soft Key Count */
 } softkey_modes;												/*!< SKINNY Soft Key Modes Structure */
 
+/*!
+ * \brief SCCP Device Protocol Features (sccp_deviceProtocol_t->features)
+ *
+ * Resolved per protocol version in the protocol definition tables, test with sccp_protocol_hasFeature() instead of comparing inuseprotocolversion
+ */
+typedef enum {
+	SCCP_PROTOCOL_FEATURE_SERVICEURL_DYNAMIC	= 1 << 0,						/*!< ServiceURLStatDynamicMessage (>= 7) */
+	SCCP_PROTOCOL_FEATURE_FEATURESTAT_DYNAMIC	= 1 << 1,						/*!< FeatureStatDynamicMessage (>= 15) */
+	SCCP_PROTOCOL_FEATURE_BLF_SPEEDDIAL		= 1 << 2,						/*!< BLF Speeddial buttons / state via FeatureStatDynamic (>= 15) */
+	SCCP_PROTOCOL_FEATURE_MULTIBLINK		= 1 << 3,						/*!< MultiBlinkFeature buttons (>= 15) */
+	SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES		= 1 << 4,						/*!< MultiBlinkFeature for monitor / parkinglot states (> 15) */
+} sccp_protocol_feature_t;
+
+#define SCCP_PROTOCOL_FEATURES_V3	0
+#define SCCP_PROTOCOL_FEATURES_V7	(SCCP_PROTOCOL_FEATURES_V3 | SCCP_PROTOCOL_FEATURE_SERVICEURL_DYNAMIC)
+#define SCCP_PROTOCOL_FEATURES_V15	(SCCP_PROTOCOL_FEATURES_V7 | SCCP_PROTOCOL_FEATURE_FEATURESTAT_DYNAMIC | SCCP_PROTOCOL_FEATURE_BLF_SPEEDDIAL | SCCP_PROTOCOL_FEATURE_MULTIBLINK)
+#define SCCP_PROTOCOL_FEATURES_V16	(SCCP_PROTOCOL_FEATURES_V15 | SCCP_PROTOCOL_FEATURE_MULTIBLINK_STATES)
+
 /*!
  * \brief SCCP Device Protocol Callback Structure
  *
  * Connect Specific CallBack-Functions to Particular SCCP Protocol Versions
+ * \note Bound once to device->protocol during registration (sccp_protocol_getDeviceProtocol), everything version dependent should be resolved through it
  */
 typedef struct {
 	//const char *name;											/*! protocol name ( SCCP | SPCP ) */
 	const uint16_t type;											/*! (SCCP_PROTOCOL | SPCP_PROTOCOL) */
 	const uint8_t version;											/*! the protocol version number */
 	const uint16_t registrationFinishedMessageId;								/*! use this message id to determine that the device is fully registered */
+	const uint32_t features;										/*! sccp_protocol_feature_t bitmask */
 
 	/* protocol callbacks */
 	/* send messages */
@@ -3286,6 +3306,7 @@ typedef struct {
 	void (*const sendConnectionStatisticsReq) (constDevicePtr device, constChannelPtr channel, uint8_t clear);
 	void (*const sendPortRequest) (constDevicePtr device, constChannelPtr channel, skinny_mediaTransportType_t mediaTransportType, skinny_mediaType_t mediaType);
 	void (*const sendPortClose) (constDevicePtr device, constChannelPtr channel, skinny_mediaType_t mediaType);
+	void (*const sendFeatureStatus) (constDevicePtr device, uint32_t instance, uint32_t buttonType, uint32_t status, const char *label);
 
 	/* parse received messages */
 	void (*const parseOpenReceiveChannelAck) (constMessagePtr msg, skinny_mediastatus_t * mediastatus, struct sockaddr_storage * ss, uint32_t * passthrupartyid, uint32_t * callReference);
@@ -3299,6 +3320,30 @@ typedef struct {
 SCCP_API boolean_t SCCP_CALL sccp_protocol_isProtocolSupported(uint8_t type, uint8_t version);
 SCCP_API uint8_t SCCP_CALL sccp_protocol_getMaxSupportedVersionNumber(int type);
 SCCP_API const sccp_deviceProtocol_t * SCCP_CALL sccp_protocol_getDeviceProtocol(constDevicePtr device, int type);
+
+/*!
+ * \brief Does the protocol bound to the device support feature
+ * \note device->protocol is only set once the device registered, before that nothing is supported
+ */
+#define sccp_protocol_hasFeature(_device, _feature) ((_device)->protocol && ((_device)->protocol->features & (_feature)))
 SCCP_API const char * SCCP_CALL skinny_keymode2longstr(skinny_keymode_t keymode);
+
+/*!
+ * \brief Single pass encoder for messages with variable length (dynamic) fields
+ * \note The message is built in a per thread scratch buffer, which is reused by the next message built on the same thread. Send it using
+ * sccp_dev_sendStatic (which does not free it) or use sccp_msg_encoder_dup to get an allocated copy.
+ */
+typedef struct sccp_msg_encoder {
+	sccp_msg_t *msg;											/*!< Message being built */
+	size_t offset;												/*!< Number of bytes of msg->data in use */
+	boolean_t overflow;											/*!< Variable part got truncated */
+} sccp_msg_encoder_t;
+
+#define sccp_msg_encoder_begin(_enc, _type) __sccp_msg_encoder_begin(_enc, _type, offsetof(sccp_data_t, _type.dummy))
+SCCP_API sccp_msg_t * SCCP_CALL __sccp_msg_encoder_begin(sccp_msg_encoder_t * enc, sccp_mid_t mid, size_t fixedLen);
+SCCP_API void SCCP_CALL sccp_msg_encoder_putString(sccp_msg_encoder_t * enc, const char *str);
+SCCP_API void SCCP_CALL sccp_msg_encoder_putZero(sccp_msg_encoder_t * enc, size_t len);
+SCCP_API sccp_msg_t * SCCP_CALL sccp_msg_encoder_finish(sccp_msg_encoder_t * enc);
+SCCP_API sccp_msg_t * SCCP_CALL sccp_msg_encoder_dup(sccp_msg_encoder_t * enc);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
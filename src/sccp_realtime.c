@@ -0,0 +1,583 @@
+/*!
+ * \file        sccp_realtime.c
+ * \brief       SCCP Realtime Lookup Cache
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Purpose:        Keep the result of realtime device/line lookups in memory for a configurable time
+ *              When to use:    Instead of calling pbx_load_realtime directly, when looking up a device or line by name
+ *              Relations:      Used by sccp_device_find_realtime and sccp_line_find_realtime_byname
+ */
+
+/*!
+ * \section sccp_realtime Realtime Lookup Cache
+ *
+ * Every registration attempt by a device which is not yet known in memory results in a realtime lookup. Unknown or misconfigured devices
+ * will retry over and over again, causing a database query per connection attempt. To protect the database, the results of these lookups are
+ * kept in a small hash table:
+ *  - positive entries hold a copy of the variables returned by the database and live for 'realtime_cache_ttl' seconds (default 0, off)
+ *  - negative entries remember that the name was not found and live for 'realtime_negative_ttl' seconds (default 0, off)
+ *
+ * The cache is flushed on 'sccp reload' and can be invalidated (completely, per table or per name) via CLI/AMI.
+ *
+ * When 'realtime_prefetch' is set, all rows of the device and line table are loaded into the cache in the background using a single
+ * multi-row query per table, at startup/reload and every 'realtime_prefetch' seconds after that. Registrations are then served from memory.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_realtime.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#ifdef CS_SCCP_REALTIME
+#include "sccp_utils.h"
+
+#define SCCP_REALTIME_CACHE_BUCKETS 256
+#define SCCP_REALTIME_CACHE_MAX_ENTRIES 16384
+
+/*!
+ * \brief Realtime Cache Entry
+ */
+typedef struct sccp_realtime_cache_entry sccp_realtime_cache_entry_t;
+struct sccp_realtime_cache_entry {
+	sccp_realtime_cache_entry_t *next;									/*!< Next entry in bucket */
+	unsigned int hash;											/*!< Hash of table + name */
+	time_t expires;												/*!< Time at which this entry becomes stale */
+	PBX_VARIABLE_TYPE *variables;										/*!< Copy of the realtime result, NULL for a negative entry */
+	char *table;												/*!< Realtime Table Name */
+	char *name;												/*!< Device/Line Name */
+};
+
+/*!
+ * \brief Realtime Cache Statistics
+ */
+static struct {
+	sccp_mutex_t lock;											/*!< Only used when the platform has no atomic operations */
+	volatile CAS32_TYPE hits;
+	volatile CAS32_TYPE negative_hits;
+	volatile CAS32_TYPE misses;
+	volatile CAS32_TYPE expired;
+	volatile CAS32_TYPE rejected;
+	volatile CAS32_TYPE invalidated;
+	volatile CAS32_TYPE prefetched;
+	int entries;												/*!< Protected by cache_lock */
+	int64_t last_prefetch_ms;										/*!< Duration of the last prefetch run */
+	time_t last_prefetch;											/*!< Time of the last prefetch run */
+} cache_stats;
+
+static ast_rwlock_t cache_lock;
+static sccp_realtime_cache_entry_t *cache_buckets[SCCP_REALTIME_CACHE_BUCKETS];
+static boolean_t cache_running = FALSE;
+static sccp_mutex_t prefetch_lock;										/*!< Held while a prefetch is running */
+static int prefetch_sched = -1;										/*!< Protected by cache_lock */
+static uintptr_t prefetch_generation = 0;								/*!< Protected by cache_lock, bumped on (re)start/stop to retire a running schedule */
+
+/* ========================================================================================================================= Helpers */
+static unsigned int sccp_realtime_cache_hash(const char *table, const char *name)
+{
+	unsigned int hash = 5381;
+
+	for (; *table; table++) {
+		hash = ((hash << 5) + hash) ^ (unsigned char) *table;
+	}
+	hash = ((hash << 5) + hash) ^ '/';
+	for (; *name; name++) {
+		hash = ((hash << 5) + hash) ^ (unsigned char) tolower(*name);					/* names are matched case-insensitive */
+	}
+	return hash;
+}
+
+/*!
+ * \brief Copy a realtime variable list, leaving out blank values
+ * \note pbx_load_realtime strips blank columns, pbx_load_realtime_multientry (prefetch) does not. Blank values would override the
+ * [general] / default values in sccp_config_set_defaults, so they are dropped here, to make a cached row look like one loaded on demand.
+ */
+static PBX_VARIABLE_TYPE *sccp_realtime_variables_dup(PBX_VARIABLE_TYPE * variables)
+{
+	PBX_VARIABLE_TYPE *root = NULL, *tail = NULL, *tmp = NULL, *v = NULL;
+
+	for (v = variables; v; v = v->next) {
+		if (sccp_strlen_zero(v->value)) {
+			continue;
+		}
+		if (!(tmp = pbx_variable_new(v->name, v->value, ""))) {
+			pbx_log(LOG_ERROR, "SCCP: (realtime_cache) Unable to allocate variable\n");
+			if (root) {
+				pbx_variables_destroy(root);
+			}
+			return NULL;
+		}
+		if (tail) {
+			tail->next = tmp;
+		} else {
+			root = tmp;
+		}
+		tail = tmp;
+	}
+	return root;
+}
+
+static void sccp_realtime_cache_entry_destroy(sccp_realtime_cache_entry_t * entry)
+{
+	if (entry->variables) {
+		pbx_variables_destroy(entry->variables);
+	}
+	sccp_free(entry->table);
+	sccp_free(entry->name);
+	sccp_free(entry);
+}
+
+/*!
+ * \brief Find an entry in its bucket
+ * \note cache_lock needs to be held
+ */
+static sccp_realtime_cache_entry_t *sccp_realtime_cache_find(const char *table, const char *name, unsigned int hash)
+{
+	sccp_realtime_cache_entry_t *entry = NULL;
+
+	for (entry = cache_buckets[hash % SCCP_REALTIME_CACHE_BUCKETS]; entry; entry = entry->next) {
+		if (entry->hash == hash && sccp_strequals(entry->table, table) && sccp_strcaseequals(entry->name, name)) {
+			break;
+		}
+	}
+	return entry;
+}
+
+/*!
+ * \brief Remove all stale entries
+ * \note cache_lock needs to be write locked
+ */
+static void sccp_realtime_cache_purge(time_t now)
+{
+	sccp_realtime_cache_entry_t **entryp = NULL, *entry = NULL;
+	uint bucket = 0;
+
+	for (bucket = 0; bucket < SCCP_REALTIME_CACHE_BUCKETS; bucket++) {
+		entryp = &cache_buckets[bucket];
+		while ((entry = *entryp)) {
+			if (entry->expires <= now) {
+				*entryp = entry->next;
+				sccp_realtime_cache_entry_destroy(entry);
+				cache_stats.entries--;
+				ATOMIC_INCR(&cache_stats.expired, 1, &cache_stats.lock);
+			} else {
+				entryp = &entry->next;
+			}
+		}
+	}
+}
+
+/*!
+ * \brief Store a realtime result (or the fact that there was none) in the cache
+ */
+static void sccp_realtime_cache_store(const char *table, const char *name, unsigned int hash, PBX_VARIABLE_TYPE * variables, time_t now, int ttl)
+{
+	sccp_realtime_cache_entry_t *entry = NULL;
+	PBX_VARIABLE_TYPE *copy = NULL;
+
+	if (ttl <= 0) {
+		return;
+	}
+	if (variables && !(copy = sccp_realtime_variables_dup(variables))) {
+		return;
+	}
+
+	pbx_rwlock_wrlock(&cache_lock);
+	if ((entry = sccp_realtime_cache_find(table, name, hash))) {
+		if (entry->variables) {
+			pbx_variables_destroy(entry->variables);
+		}
+		entry->variables = copy;
+		entry->expires = now + ttl;
+		pbx_rwlock_unlock(&cache_lock);
+		return;
+	}
+	if (cache_stats.entries >= SCCP_REALTIME_CACHE_MAX_ENTRIES) {
+		sccp_realtime_cache_purge(now);
+	}
+	if (cache_stats.entries >= SCCP_REALTIME_CACHE_MAX_ENTRIES || !(entry = sccp_calloc(1, sizeof(sccp_realtime_cache_entry_t)))) {
+		ATOMIC_INCR(&cache_stats.rejected, 1, &cache_stats.lock);
+		pbx_rwlock_unlock(&cache_lock);
+		if (copy) {
+			pbx_variables_destroy(copy);
+		}
+		return;
+	}
+	entry->hash = hash;
+	entry->expires = now + ttl;
+	entry->variables = copy;
+	entry->table = pbx_strdup(table);
+	entry->name = pbx_strdup(name);
+	entry->next = cache_buckets[hash % SCCP_REALTIME_CACHE_BUCKETS];
+	cache_buckets[hash % SCCP_REALTIME_CACHE_BUCKETS] = entry;
+	cache_stats.entries++;
+	pbx_rwlock_unlock(&cache_lock);
+}
+
+/* ========================================================================================================================= Prefetch */
+/*!
+ * \brief Load all rows of a realtime table into the cache using one multi-row query
+ * \return Number of rows stored
+ */
+static int sccp_realtime_prefetch_table(const char *table, time_t now, int ttl)
+{
+	struct ast_config *cfg = NULL;
+	PBX_VARIABLE_TYPE *v = NULL;
+	char *cat = NULL;
+	const char *name = NULL;
+	int count = 0;
+
+	if (sccp_strlen_zero(table)) {
+		return 0;
+	}
+	if (!(cfg = pbx_load_realtime_multientry(table, "name LIKE", "%", NULL))) {
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (realtime_prefetch) no rows returned from table '%s'\n", table);
+		return 0;
+	}
+	while (cache_running && (cat = pbx_category_browse(cfg, cat))) {
+		v = pbx_variable_browse(cfg, cat);
+		name = pbx_variable_retrieve(cfg, cat, "name");
+		if (v && !sccp_strlen_zero(name)) {
+			sccp_realtime_cache_store(table, name, sccp_realtime_cache_hash(table, name), v, now, ttl);
+			count++;
+		}
+	}
+	pbx_config_destroy(cfg);
+	return count;
+}
+
+/*!
+ * \brief Prefetch all devices and lines (threadpool job)
+ */
+static void *sccp_realtime_prefetch(void *data)
+{
+	struct timeval start = pbx_tvnow();
+	time_t now = time(NULL);
+	int ttl = GLOB(realtime_prefetch) + (GLOB(realtime_cache_ttl) > 0 ? GLOB(realtime_cache_ttl) : 0);	/* stay valid until the next run has finished */
+	int devices = 0, lines = 0;
+
+	if (!cache_running) {
+		return NULL;
+	}
+	if (sccp_mutex_trylock(&prefetch_lock)) {
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (realtime_prefetch) previous prefetch still running, skipped\n");
+		return NULL;
+	}
+	devices = sccp_realtime_prefetch_table(GLOB(realtimedevicetable), now, ttl);
+	lines = sccp_realtime_prefetch_table(GLOB(realtimelinetable), now, ttl);
+	ATOMIC_INCR(&cache_stats.prefetched, devices + lines, &cache_stats.lock);
+	cache_stats.last_prefetch = now;
+	cache_stats.last_prefetch_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+	sccp_mutex_unlock(&prefetch_lock);
+
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_2 "SCCP: (realtime_prefetch) cached %d devices and %d lines in %dms\n", devices, lines, (int) cache_stats.last_prefetch_ms);
+	return NULL;
+}
+
+/*!
+ * \brief Scheduled prefetch, data holds the generation it was scheduled for
+ */
+static int sccp_realtime_prefetch_run(const void *data)
+{
+	pbx_rwlock_wrlock(&cache_lock);
+	if ((uintptr_t) data != prefetch_generation) {							/* restarted or stopped in the meantime */
+		pbx_rwlock_unlock(&cache_lock);
+		return 0;
+	}
+	prefetch_sched = -1;
+	if (cache_running && GLOB(realtime_prefetch) > 0) {
+		if (!GLOB(general_threadpool) || !sccp_threadpool_add_work(GLOB(general_threadpool), sccp_realtime_prefetch, NULL)) {
+			pbx_log(LOG_WARNING, "SCCP: (realtime_prefetch) unable to queue prefetch\n");
+		}
+		/* reschedule my self */
+		if ((prefetch_sched = iPbx.sched_add(GLOB(realtime_prefetch) * 1000, sccp_realtime_prefetch_run, data)) < 0) {
+			pbx_log(LOG_ERROR, "SCCP: (realtime_prefetch) unable to schedule next prefetch\n");
+		}
+	}
+	pbx_rwlock_unlock(&cache_lock);
+	return 0;
+}
+
+/*!
+ * \brief Retire the current prefetch schedule
+ * \return generation for the next schedule
+ * \note sched_del is called without cache_lock, as it may wait for a running sccp_realtime_prefetch_run, which needs it
+ */
+static uintptr_t sccp_realtime_prefetch_cancel(void)
+{
+	int sched = -1;
+	uintptr_t generation = 0;
+
+	pbx_rwlock_wrlock(&cache_lock);
+	sched = prefetch_sched;
+	prefetch_sched = -1;
+	generation = ++prefetch_generation;
+	pbx_rwlock_unlock(&cache_lock);
+	if (sched > -1) {
+		iPbx.sched_del(sched);
+	}
+	return generation;
+}
+
+/*!
+ * \brief (Re)Start the background prefetch of all realtime devices and lines
+ * \note called after (re)loading the configuration, runs immediately and then every 'realtime_prefetch' seconds
+ */
+void sccp_realtime_prefetch_start(void)
+{
+	uintptr_t generation = 0;
+
+	if (!cache_running) {
+		return;
+	}
+	generation = sccp_realtime_prefetch_cancel();
+	if (GLOB(realtime_prefetch) > 0) {
+		sccp_realtime_prefetch_run((const void *) generation);
+	}
+}
+
+/* ========================================================================================================================= Module Start/Stop */
+/*!
+ * \brief starting realtime cache
+ */
+void sccp_realtime_module_start(void)
+{
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_2 "SCCP: Starting realtime lookup cache\n");
+	pbx_rwlock_init_notracking(&cache_lock);
+	memset(&cache_stats, 0, sizeof(cache_stats));
+	sccp_mutex_init(&cache_stats.lock);
+	sccp_mutex_init(&prefetch_lock);
+	memset(cache_buckets, 0, sizeof(cache_buckets));
+	cache_running = TRUE;
+}
+
+/*!
+ * \brief stopping realtime cache
+ */
+void sccp_realtime_module_stop(void)
+{
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_2 "SCCP: Stopping realtime lookup cache\n");
+	sccp_realtime_prefetch_cancel();
+	sccp_mutex_lock(&prefetch_lock);									/* wait for a running prefetch to finish */
+	sccp_realtime_cache_invalidate(NULL, NULL);
+	pbx_rwlock_wrlock(&cache_lock);
+	cache_running = FALSE;
+	pbx_rwlock_unlock(&cache_lock);
+	sccp_mutex_unlock(&prefetch_lock);
+	pbx_rwlock_destroy(&cache_lock);
+	sccp_mutex_destroy(&cache_stats.lock);
+	sccp_mutex_destroy(&prefetch_lock);
+}
+
+/* ========================================================================================================================= Public */
+/*!
+ * \brief Load a device/line from realtime, using the realtime lookup cache
+ * \param table Realtime Table Name
+ * \param name Device/Line Name
+ * \return Variable list which needs to be destroyed by the caller using pbx_variables_destroy, or NULL when not found
+ */
+PBX_VARIABLE_TYPE *sccp_realtime_load(const char *table, const char *name)
+{
+	sccp_realtime_cache_entry_t *entry = NULL;
+	PBX_VARIABLE_TYPE *variables = NULL;
+	boolean_t found = FALSE;
+	unsigned int hash = 0;
+	time_t now = 0;
+
+	if (sccp_strlen_zero(table) || sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	if (!cache_running || (GLOB(realtime_cache_ttl) <= 0 && GLOB(realtime_negative_ttl) <= 0 && GLOB(realtime_prefetch) <= 0)) {
+		return pbx_load_realtime(table, "name", name, NULL);
+	}
+
+	now = time(NULL);
+	hash = sccp_realtime_cache_hash(table, name);
+
+	pbx_rwlock_rdlock(&cache_lock);
+	if ((entry = sccp_realtime_cache_find(table, name, hash)) && entry->expires > now) {
+		if (entry->variables) {
+			variables = sccp_realtime_variables_dup(entry->variables);
+			found = variables ? TRUE : FALSE;
+		} else {
+			found = TRUE;
+		}
+	}
+	pbx_rwlock_unlock(&cache_lock);
+
+	if (found) {
+		if (variables) {
+			ATOMIC_INCR(&cache_stats.hits, 1, &cache_stats.lock);
+		} else {
+			ATOMIC_INCR(&cache_stats.negative_hits, 1, &cache_stats.lock);
+			sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (realtime_cache) '%s' is cached as not found in table '%s'\n", name, table);
+		}
+		return variables;
+	}
+
+	ATOMIC_INCR(&cache_stats.misses, 1, &cache_stats.lock);
+	variables = pbx_load_realtime(table, "name", name, NULL);
+	sccp_realtime_cache_store(table, name, hash, variables, now, variables ? GLOB(realtime_cache_ttl) : GLOB(realtime_negative_ttl));
+	return variables;
+}
+
+/*!
+ * \brief Invalidate realtime cache entries
+ * \param table Realtime Table Name (NULL for all tables)
+ * \param name Device/Line Name (NULL for all names)
+ * \return Number of entries removed
+ */
+int sccp_realtime_cache_invalidate(const char *table, const char *name)
+{
+	sccp_realtime_cache_entry_t **entryp = NULL, *entry = NULL;
+	uint bucket = 0;
+	int removed = 0;
+
+	if (!cache_running) {
+		return 0;
+	}
+	pbx_rwlock_wrlock(&cache_lock);
+	for (bucket = 0; bucket < SCCP_REALTIME_CACHE_BUCKETS; bucket++) {
+		entryp = &cache_buckets[bucket];
+		while ((entry = *entryp)) {
+			if ((!table || sccp_strequals(entry->table, table)) && (!name || sccp_strcaseequals(entry->name, name))) {
+				*entryp = entry->next;
+				sccp_realtime_cache_entry_destroy(entry);
+				cache_stats.entries--;
+				removed++;
+			} else {
+				entryp = &entry->next;
+			}
+		}
+	}
+	ATOMIC_INCR(&cache_stats.invalidated, removed, &cache_stats.lock);
+	pbx_rwlock_unlock(&cache_lock);
+
+	sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (realtime_cache) invalidated %d entries (table: %s, name: %s)\n", removed, table ? table : "all", name ? name : "all");
+	return removed;
+}
+
+/* ========================================================================================================================= CLI/AMI */
+/*!
+ * \brief Show Realtime Cache Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_realtime_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	sccp_realtime_cache_entry_t *entry = NULL;
+	int local_line_total = 0;
+	int positive = 0, negative = 0, stale = 0;
+	int hits = 0, lookups = 0;
+	uint bucket = 0;
+	time_t now = time(NULL);
+	const char *actionid = "";
+
+	if (cache_running) {
+		pbx_rwlock_rdlock(&cache_lock);
+		for (bucket = 0; bucket < SCCP_REALTIME_CACHE_BUCKETS; bucket++) {
+			for (entry = cache_buckets[bucket]; entry; entry = entry->next) {
+				if (entry->expires <= now) {
+					stale++;
+				} else if (entry->variables) {
+					positive++;
+				} else {
+					negative++;
+				}
+			}
+		}
+		pbx_rwlock_unlock(&cache_lock);
+	}
+	hits = ATOMIC_FETCH(&cache_stats.hits, &cache_stats.lock) + ATOMIC_FETCH(&cache_stats.negative_hits, &cache_stats.lock);
+	lookups = hits + ATOMIC_FETCH(&cache_stats.misses, &cache_stats.lock);
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\n--- SCCP realtime lookup cache ----------------------------------------------------------------------------------------\n");
+	} else {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPRealtimeCache\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	CLI_AMI_OUTPUT_PARAM("Cache TTL", CLI_AMI_LIST_WIDTH, "%d", GLOB(realtime_cache_ttl));
+	CLI_AMI_OUTPUT_PARAM("Negative TTL", CLI_AMI_LIST_WIDTH, "%d", GLOB(realtime_negative_ttl));
+	CLI_AMI_OUTPUT_PARAM("Entries", CLI_AMI_LIST_WIDTH, "%d", positive);
+	CLI_AMI_OUTPUT_PARAM("Negative Entries", CLI_AMI_LIST_WIDTH, "%d", negative);
+	CLI_AMI_OUTPUT_PARAM("Stale Entries", CLI_AMI_LIST_WIDTH, "%d", stale);
+	CLI_AMI_OUTPUT_PARAM("Hits", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.hits, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Negative Hits", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.negative_hits, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Misses", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.misses, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Hit Ratio", CLI_AMI_LIST_WIDTH, "%d%%", lookups ? (hits * 100) / lookups : 0);
+	CLI_AMI_OUTPUT_PARAM("Expired", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.expired, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Invalidated", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.invalidated, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Rejected (cache full)", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.rejected, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Prefetch Interval", CLI_AMI_LIST_WIDTH, "%d", GLOB(realtime_prefetch));
+	CLI_AMI_OUTPUT_PARAM("Prefetched Rows", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&cache_stats.prefetched, &cache_stats.lock));
+	CLI_AMI_OUTPUT_PARAM("Last Prefetch (seconds ago)", CLI_AMI_LIST_WIDTH, "%d", cache_stats.last_prefetch ? (int) (now - cache_stats.last_prefetch) : -1);
+	CLI_AMI_OUTPUT_PARAM("Last Prefetch Duration (ms)", CLI_AMI_LIST_WIDTH, "%d", (int) cache_stats.last_prefetch_ms);
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
+/*!
+ * \brief Invalidate Realtime Cache Entries
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \note table can be specified as 'device' or 'line' which map to the configured devicetable/linetable, or as 'all'
+ * \called_from_asterisk
+ */
+int sccp_realtime_cache_flush(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	const char *table = NULL;
+	const char *name = NULL;
+	int local_line_total = 0;
+	int removed = 0;
+
+	if (argc < 4 || argc > 6) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc > 4 && !sccp_strlen_zero(argv[4]) && !sccp_strcaseequals(argv[4], "all")) {
+		if (sccp_strcaseequals(argv[4], "device")) {
+			table = GLOB(realtimedevicetable);
+		} else if (sccp_strcaseequals(argv[4], "line")) {
+			table = GLOB(realtimelinetable);
+		} else {
+			table = argv[4];
+		}
+	}
+	if (argc > 5 && !sccp_strlen_zero(argv[5])) {
+		name = argv[5];
+	}
+	removed = sccp_realtime_cache_invalidate(table, name);
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: Invalidated %d realtime cache entries\r\n", removed);
+		local_line_total += 2;
+		totals->lines = local_line_total;
+	} else {
+		CLI_AMI_OUTPUT(fd, s, "Invalidated %d realtime cache entries\n", removed);
+	}
+	return RESULT_SUCCESS;
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,23 @@
+/*!
+ * \file        sccp_realtime.h
+ * \brief       SCCP Realtime Lookup Cache Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+__BEGIN_C_EXTERN__
+#ifdef CS_SCCP_REALTIME
+SCCP_API void SCCP_CALL sccp_realtime_module_start(void);
+SCCP_API void SCCP_CALL sccp_realtime_module_stop(void);
+
+SCCP_API PBX_VARIABLE_TYPE * SCCP_CALL sccp_realtime_load(const char *table, const char *name);
+SCCP_API int SCCP_CALL sccp_realtime_cache_invalidate(const char *table, const char *name);
+SCCP_API void SCCP_CALL sccp_realtime_prefetch_start(void);
+
+SCCP_API int SCCP_CALL sccp_show_realtime_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API int SCCP_CALL sccp_realtime_cache_flush(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+#endif
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -110,6 +110,23 @@ static struct refcount_objentry{
 	SCCP_RWLIST_HEAD (, RefCountedObject) refCountedObjects  __attribute__((aligned(8)));			//!< one rwlock per hash table entry, used to modify list
 } *objects[SCCP_HASH_PRIME];											//!< objects hash table
 
+/*!
+ * \brief Pool of released objects per type
+ * \note Objects of a pooled type are zeroed and kept here when their last reference is released, sccp_refcount_object_alloc hands them out
+ * again instead of allocating new memory. Only objects of exactly the pool's size are accepted.
+ * \note The pool is a FIFO queue: the object released longest ago is reused first, so that a stale pointer which is retained again after
+ * the release most likely still finds a dead (zeroed) object, instead of a live, unrelated one.
+ */
+static struct sccp_refcount_pool {
+	ast_mutex_t lock;
+	RefCountedObject *first;										//!< Single linked through list.next, next to be handed out
+	RefCountedObject *last;											//!< Most recently returned object
+	size_t len;												//!< Object size (without header), 0 when the type is not pooled
+	int max;												//!< Maximum number of idle objects kept
+	int size;												//!< Number of idle objects in the pool
+	uint32_t reused;											//!< Number of allocations served from the pool
+} pools[ARRAY_LEN(obj_info)];
+
 #if CS_REFCOUNT_DEBUG
 static FILE *sccp_ref_debug_log;
 static volatile uint32_t ref_debug_size;
@@ -119,6 +136,9 @@ void sccp_refcount_init(void)
 {
 	sccp_log((DEBUGCAT_REFCOUNT + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_1 "SCCP: (Refcount) init\n");
 	pbx_rwlock_init_notracking(&objectslock);								// No tracking to safe cpu cycles
+	for (uint type = 0; type < ARRAY_LEN(pools); type++) {
+		ast_mutex_init(&pools[type].lock);
+	}
 #if CS_REFCOUNT_DEBUG
 	sccp_ref_debug_log = NULL;
 	ref_debug_size = 0;
@@ -169,6 +189,18 @@ void sccp_refcount_destroy(void)
 	}
 	ast_rwlock_unlock(&objectslock);
 	pbx_rwlock_destroy(&objectslock);
+	for (type = 0; type < ARRAY_LEN(pools); type++) {
+		ast_mutex_lock(&pools[type].lock);
+		while ((obj = pools[type].first)) {
+			pools[type].first = obj->list.next;
+			sccp_free(obj);
+		}
+		pools[type].last = NULL;
+		pools[type].size = 0;
+		pools[type].len = 0;
+		ast_mutex_unlock(&pools[type].lock);
+		ast_mutex_destroy(&pools[type].lock);
+	}
 	if (numObjects) {
 		pbx_log(LOG_WARNING, "SCCP: (Refcount) Note: We found %d objects which had to be forcefulfy removed during refcount shutdown, see above.\n", numObjects);
 	}
@@ -193,6 +225,94 @@ int sccp_refcount_schedule_cleanup(const void *data)
 	return 0;
 }
 
+/*!
+ * \brief Keep up to max released objects of type (of size bytes) for reuse, and preallocate them
+ * \note max 0 disables pooling for this type and frees the idle objects
+ */
+void sccp_refcount_pool_setSize(enum sccp_refcounted_types type, size_t size, int max)
+{
+	struct sccp_refcount_pool *pool = &pools[type];
+	RefCountedObject *obj = NULL;
+
+	ast_mutex_lock(&pool->lock);
+	if (pool->len != size || max <= 0) {									/* drop objects of the wrong size */
+		while ((obj = pool->first)) {
+			pool->first = obj->list.next;
+			sccp_free(obj);
+		}
+		pool->last = NULL;
+		pool->size = 0;
+	}
+	pool->len = max > 0 ? size : 0;
+	pool->max = max > 0 ? max : 0;
+	while (pool->size < pool->max && (obj = sccp_calloc(size + (sizeof *obj), 1))) {
+		obj->list.next = pool->first;
+		pool->first = obj;
+		if (!pool->last) {
+			pool->last = obj;
+		}
+		pool->size++;
+	}
+	ast_mutex_unlock(&pool->lock);
+	sccp_log((DEBUGCAT_REFCOUNT)) (VERBOSE_PREFIX_2 "SCCP: (refcount_pool) %s pool holds %d objects of %d bytes\n", (&obj_info[type])->datatype, pool->size, (int) size);
+}
+
+/*!
+ * \brief Take a zeroed object of size out of the pool for type
+ */
+static gcc_inline RefCountedObject *sccp_refcount_pool_get(enum sccp_refcounted_types type, size_t size)
+{
+	struct sccp_refcount_pool *pool = &pools[type];
+	RefCountedObject *obj = NULL;
+
+	if (!pool->len) {
+		return NULL;
+	}
+	ast_mutex_lock(&pool->lock);
+	if (pool->len == size && (obj = pool->first)) {
+		if (!(pool->first = obj->list.next)) {
+			pool->last = NULL;
+		}
+		obj->list.next = NULL;
+		pool->size--;
+		pool->reused++;
+	}
+	ast_mutex_unlock(&pool->lock);
+	return obj;
+}
+
+/*!
+ * \brief Return a destroyed object to the pool for its type
+ * \return TRUE when the pool took the object, FALSE when it needs to be freed
+ */
+static gcc_inline boolean_t sccp_refcount_pool_put(RefCountedObject * obj)
+{
+	struct sccp_refcount_pool *pool = &pools[obj->type];
+	size_t len = obj->len;
+	boolean_t res = FALSE;
+
+	if (!pool->len || runState != SCCP_REF_RUNNING) {
+		return FALSE;
+	}
+	ast_mutex_lock(&pool->lock);
+	if (pool->len == len && pool->size < pool->max) {
+#ifndef SCCP_ATOMIC
+		ast_mutex_destroy(&obj->lock);
+#endif
+		memset(obj, 0, sizeof(RefCountedObject) + len);						/* hand it out pre-zeroed */
+		if (pool->last) {
+			pool->last->list.next = obj;							/* queue at the end, reused last */
+		} else {
+			pool->first = obj;
+		}
+		pool->last = obj;
+		pool->size++;
+		res = TRUE;
+	}
+	ast_mutex_unlock(&pool->lock);
+	return res;
+}
+
 void *const sccp_refcount_object_alloc(size_t size, enum sccp_refcounted_types type, const char *identifier, void *destructor)
 {
 	RefCountedObject *obj;
@@ -204,7 +324,7 @@ void *const sccp_refcount_object_alloc(size_t size, enum sccp_refcounted_types t
 		return NULL;
 	}
 
-	if (!(obj = sccp_calloc(size + (sizeof *obj), 1) )) {
+	if (!(obj = sccp_refcount_pool_get(type, size)) && !(obj = sccp_calloc(size + (sizeof *obj), 1) )) {
 		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP: obj");
 		return NULL;
 	}
@@ -410,8 +530,10 @@ static gcc_inline void sccp_refcount_remove_obj(const void *ptr)
 			if ((&obj_info[obj->type])->destructor) {
 				(&obj_info[obj->type])->destructor(ptr);
 			}
-			memset(obj, 0, sizeof(RefCountedObject));
-			sccp_free(obj);
+			if (!sccp_refcount_pool_put(obj)) {
+				memset(obj, 0, sizeof(RefCountedObject));
+				sccp_free(obj);
+			}
 			obj = NULL;
 		}
 	}
@@ -588,6 +710,20 @@ int sccp_show_refcount(int fd, sccp_cli_totals_t *totals, struct mansession *s,
 	CLI_AMI_TABLE_FIELD(MaxDepth,		"-8.8",		d,	8,	maxdepth)
 #include "sccp_cli_table.h"
 	local_line_total++;
+
+	// Object Pools
+	uint pooltype = 0;
+#define CLI_AMI_TABLE_NAME Pools
+#define CLI_AMI_TABLE_PER_ENTRY_NAME Pool
+#define CLI_AMI_TABLE_ITERATOR for(pooltype = 0; pooltype < ARRAY_LEN(pools); pooltype++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION if (!pools[pooltype].len) { continue; }
+#define CLI_AMI_TABLE_FIELDS 												\
+	CLI_AMI_TABLE_FIELD(Type,		"-17.17",	s,	17,	(obj_info[pooltype]).datatype)		\
+	CLI_AMI_TABLE_FIELD(Idle,		"-8.8",		d,	8,	pools[pooltype].size)			\
+	CLI_AMI_TABLE_FIELD(Max,		"-8.8",		d,	8,	pools[pooltype].max)			\
+	CLI_AMI_TABLE_FIELD(Reused,		"-8.8",		d,	8,	(int) pools[pooltype].reused)
+#include "sccp_cli_table.h"
+	local_line_total++;
 	if (fillfactor > 1.00) {
 		if (!s) {
 			pbx_cli(fd, "\033[1m\033[41m\033[37mPlease keep fillfactor below 1.00. Check ./configure --with-hash-size.\033[0m\n");
@@ -599,7 +735,7 @@ int sccp_show_refcount(int fd, sccp_cli_totals_t *totals, struct mansession *s,
 
 	if (s) {
 		totals->lines = local_line_total;
-		totals->tables = 2;
+		totals->tables = 3;
 	}
 	return RESULT_SUCCESS;
 }
@@ -834,8 +970,8 @@ struct refcount_test **object;
 
 static void refcount_test_destroy(struct refcount_test *obj)
 {
-	sccp_free(object[obj->id]->str);
-	object[obj->id]->str = NULL;
+	sccp_free(obj->str);
+	obj->str = NULL;
 };
 
 static void *refcount_test_thread(void *data)
@@ -957,6 +1093,25 @@ AST_TEST_DEFINE(sccp_refcount_tests)
 	}
 	ast_rwlock_unlock(&objectslock);
 	sccp_free(object);
+
+	pbx_test_status_update(test, "Pooled objects are reused and handed out zeroed...\n");
+	struct refcount_test *pooled = NULL, *reused = NULL;
+	sccp_refcount_pool_setSize(SCCP_REF_TEST, sizeof(struct refcount_test), 1);
+	pbx_test_validate(test, pools[SCCP_REF_TEST].size == 1);
+	pooled = (struct refcount_test *) sccp_refcount_object_alloc(sizeof(struct refcount_test), SCCP_REF_TEST, "pooled", refcount_test_destroy);
+	pbx_test_validate(test, pooled != NULL && pools[SCCP_REF_TEST].size == 0);
+	pooled->id = 4711;
+	pooled->str = NULL;
+	reused = pooled;
+	sccp_refcount_release((const void ** const)&pooled, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	pbx_test_validate(test, pools[SCCP_REF_TEST].size == 1);
+	pooled = (struct refcount_test *) sccp_refcount_object_alloc(sizeof(struct refcount_test), SCCP_REF_TEST, "reused", refcount_test_destroy);
+	pbx_test_validate(test, pooled == reused && pooled->id == 0);
+	pbx_test_validate(test, sccp_refcount_retain(pooled, __FILE__, __LINE__, __PRETTY_FUNCTION__) == pooled);
+	sccp_refcount_release((const void ** const)&reused, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	sccp_refcount_release((const void ** const)&pooled, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	sccp_refcount_pool_setSize(SCCP_REF_TEST, sizeof(struct refcount_test), 0);
+	pbx_test_validate(test, pools[SCCP_REF_TEST].size == 0);
 	return AST_TEST_PASS;
 }
 
@@ -95,6 +95,271 @@
 
 SCCP_FILE_VERSION(__FILE__, "");
 
+/*!
+ * \section sccp_rtp_pool Pre-Warmed RTP Instance Pool
+ *
+ * Creating an rtp instance (allocating it, binding a port pair and setting up the socket options) happens while the call is being set
+ * up, which adds to the post dial delay, especially when earlyrtp is used. When 'rtp_pool_size' is set, a number of audio rtp instances is
+ * created in advance against the current bind address and handed out in LIFO order by sccp_rtp_createServer. The pool is replenished
+ * in the background (threadpool) whenever it drops below the configured size, and flushed when the bind address changes.
+ *
+ * Instances are never put back into the pool after use, a channel always gets a fresh instance (new ssrc / sequence numbers).
+ * Only available when the pbx implementation provides iPbx.rtp_instance_new.
+ */
+#define SCCP_RTP_POOL_MAX 128
+#define SCCP_RTP_POOL_REFILL_DELAY 10										/* ms */
+
+static struct {
+	sccp_mutex_t lock;											/*!< Protects the instances, bindaddr and sched */
+	sccp_mutex_t refill_lock;										/*!< Held while a refill is running */
+	PBX_RTP_TYPE *instances[SCCP_RTP_POOL_MAX];								/*!< Ready to use instances (LIFO) */
+	int size;												/*!< Number of instances in the pool */
+	struct sockaddr_storage bindaddr;									/*!< Bind address the pooled instances were created for */
+	int sched;												/*!< Scheduled refill */
+	boolean_t running;
+	volatile CAS32_TYPE hits;
+	volatile CAS32_TYPE misses;
+	volatile CAS32_TYPE created;
+	volatile CAS32_TYPE flushed;
+} rtp_pool = {.sched = -1, };
+
+static gcc_inline int sccp_rtp_pool_target(void)
+{
+	if (!iPbx.rtp_instance_new || GLOB(rtp_pool_size) <= 0) {
+		return 0;
+	}
+	return GLOB(rtp_pool_size) > SCCP_RTP_POOL_MAX ? SCCP_RTP_POOL_MAX : GLOB(rtp_pool_size);
+}
+
+/*!
+ * \brief Remove all pooled instances from the pool
+ * \note rtp_pool.lock needs to be held, the removed instances are returned in flush, to be destroyed outside of the lock
+ * \return number of instances removed
+ */
+static int sccp_rtp_pool_take_all(PBX_RTP_TYPE *flush[SCCP_RTP_POOL_MAX])
+{
+	int count = rtp_pool.size;
+
+	memcpy(flush, rtp_pool.instances, count * sizeof(PBX_RTP_TYPE *));
+	memset(rtp_pool.instances, 0, sizeof(rtp_pool.instances));
+	rtp_pool.size = 0;
+	return count;
+}
+
+static void sccp_rtp_pool_destroy_instances(PBX_RTP_TYPE *flush[SCCP_RTP_POOL_MAX], int count)
+{
+	int idx = 0;
+
+	for (idx = 0; idx < count; idx++) {
+		iPbx.rtp_destroy(flush[idx]);
+	}
+	if (count) {
+		ATOMIC_INCR(&rtp_pool.flushed, count, &rtp_pool.lock);
+	}
+}
+
+/*!
+ * \brief Fill the pool up to rtp_pool_size (threadpool job)
+ */
+static void *sccp_rtp_pool_refill(void *data)
+{
+	PBX_RTP_TYPE *flush[SCCP_RTP_POOL_MAX] = { NULL };
+	PBX_RTP_TYPE *instance = NULL;
+	struct sockaddr_storage bindaddr;
+	int target = sccp_rtp_pool_target();
+	int count = 0;
+	int added = 0;
+
+	if (!rtp_pool.running || sccp_mutex_trylock(&rtp_pool.refill_lock)) {
+		return NULL;
+	}
+	memcpy(&bindaddr, &GLOB(bindaddr), sizeof(struct sockaddr_storage));
+
+	sccp_mutex_lock(&rtp_pool.lock);
+	if (sccp_netsock_cmp_addr(&rtp_pool.bindaddr, &bindaddr) || rtp_pool.size > target) {			// bindaddr changed / pool shrunk
+		count = sccp_rtp_pool_take_all(flush);
+		memcpy(&rtp_pool.bindaddr, &bindaddr, sizeof(struct sockaddr_storage));
+	}
+	sccp_mutex_unlock(&rtp_pool.lock);
+	sccp_rtp_pool_destroy_instances(flush, count);
+
+	while (rtp_pool.running && rtp_pool.size < target) {
+		if (!(instance = iPbx.rtp_instance_new(&bindaddr))) {
+			pbx_log(LOG_WARNING, "SCCP: (rtp_pool) unable to create rtp instance, pool size stays at %d\n", rtp_pool.size);
+			break;
+		}
+		ATOMIC_INCR(&rtp_pool.created, 1, &rtp_pool.lock);
+		sccp_mutex_lock(&rtp_pool.lock);
+		if (rtp_pool.size < target) {
+			rtp_pool.instances[rtp_pool.size++] = instance;
+			instance = NULL;
+			added++;
+		}
+		sccp_mutex_unlock(&rtp_pool.lock);
+		if (instance) {
+			iPbx.rtp_destroy(instance);
+			break;
+		}
+	}
+	sccp_mutex_unlock(&rtp_pool.refill_lock);
+
+	if (added) {
+		sccp_log((DEBUGCAT_RTP)) (VERBOSE_PREFIX_3 "SCCP: (rtp_pool) added %d rtp instances, pool size: %d/%d\n", added, rtp_pool.size, target);
+	}
+	return NULL;
+}
+
+static int sccp_rtp_pool_refill_run(const void *data)
+{
+	sccp_mutex_lock(&rtp_pool.lock);
+	rtp_pool.sched = -1;
+	sccp_mutex_unlock(&rtp_pool.lock);
+
+	if (!rtp_pool.running) {
+		return 0;
+	}
+	if (!GLOB(general_threadpool) || !sccp_threadpool_add_work(GLOB(general_threadpool), sccp_rtp_pool_refill, NULL)) {
+		pbx_log(LOG_WARNING, "SCCP: (rtp_pool) unable to queue refill\n");
+	}
+	return 0;
+}
+
+/*!
+ * \brief Schedule a background refill of the pool (if not already scheduled)
+ * \note rtp_pool.lock needs to be held
+ */
+static void sccp_rtp_pool_schedule_refill(void)
+{
+	if (rtp_pool.running && rtp_pool.sched < 0) {
+		if ((rtp_pool.sched = iPbx.sched_add(SCCP_RTP_POOL_REFILL_DELAY, sccp_rtp_pool_refill_run, NULL)) < 0) {
+			pbx_log(LOG_ERROR, "SCCP: (rtp_pool) unable to schedule refill\n");
+		}
+	}
+}
+
+/*!
+ * \brief Take a pre-warmed audio rtp instance from the pool
+ * \return rtp instance (bound to the current bindaddr) or NULL when the pool is empty/disabled
+ */
+static PBX_RTP_TYPE *sccp_rtp_pool_get(void)
+{
+	PBX_RTP_TYPE *instance = NULL;
+
+	if (!rtp_pool.running || !sccp_rtp_pool_target()) {
+		return NULL;
+	}
+	sccp_mutex_lock(&rtp_pool.lock);
+	if (rtp_pool.size > 0 && !sccp_netsock_cmp_addr(&rtp_pool.bindaddr, &GLOB(bindaddr))) {
+		instance = rtp_pool.instances[--rtp_pool.size];
+		rtp_pool.instances[rtp_pool.size] = NULL;
+	}
+	sccp_rtp_pool_schedule_refill();
+	sccp_mutex_unlock(&rtp_pool.lock);
+
+	if (instance) {
+		ATOMIC_INCR(&rtp_pool.hits, 1, &rtp_pool.lock);
+	} else {
+		ATOMIC_INCR(&rtp_pool.misses, 1, &rtp_pool.lock);
+	}
+	return instance;
+}
+
+/*!
+ * \brief Return an unused instance taken by sccp_rtp_pool_get, destroying it when it does not fit into the pool anymore
+ */
+static void sccp_rtp_pool_put(PBX_RTP_TYPE *instance)
+{
+	boolean_t pooled = FALSE;
+
+	sccp_mutex_lock(&rtp_pool.lock);
+	if (rtp_pool.running && rtp_pool.size < sccp_rtp_pool_target() && !sccp_netsock_cmp_addr(&rtp_pool.bindaddr, &GLOB(bindaddr))) {
+		rtp_pool.instances[rtp_pool.size++] = instance;
+		pooled = TRUE;
+	}
+	sccp_mutex_unlock(&rtp_pool.lock);
+
+	if (!pooled) {
+		iPbx.rtp_destroy(instance);
+	}
+}
+
+/*!
+ * \brief (Re)Fill the rtp instance pool
+ * \note called after (re)loading the configuration, picks up changes to rtp_pool_size and bindaddr
+ */
+void sccp_rtp_pool_reload(void)
+{
+	if (!rtp_pool.running) {
+		return;
+	}
+	if (GLOB(rtp_pool_size) > 0 && !iPbx.rtp_instance_new) {
+		pbx_log(LOG_NOTICE, "SCCP: (rtp_pool) rtp_pool_size is not supported by this pbx version, ignored\n");
+	}
+	sccp_mutex_lock(&rtp_pool.lock);
+	sccp_rtp_pool_schedule_refill();
+	sccp_mutex_unlock(&rtp_pool.lock);
+}
+
+/*!
+ * \brief starting rtp instance pool
+ */
+void sccp_rtp_module_start(void)
+{
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting rtp instance pool\n");
+	sccp_mutex_init(&rtp_pool.lock);
+	sccp_mutex_init(&rtp_pool.refill_lock);
+	memset(rtp_pool.instances, 0, sizeof(rtp_pool.instances));
+	memset(&rtp_pool.bindaddr, 0, sizeof(rtp_pool.bindaddr));
+	rtp_pool.size = 0;
+	rtp_pool.sched = -1;
+	rtp_pool.hits = rtp_pool.misses = rtp_pool.created = rtp_pool.flushed = 0;
+	rtp_pool.running = TRUE;
+}
+
+/*!
+ * \brief stopping rtp instance pool (destroys all pooled instances)
+ */
+void sccp_rtp_module_stop(void)
+{
+	PBX_RTP_TYPE *flush[SCCP_RTP_POOL_MAX] = { NULL };
+	int count = 0;
+	int sched = -1;
+
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Stopping rtp instance pool\n");
+	sccp_mutex_lock(&rtp_pool.lock);
+	rtp_pool.running = FALSE;
+	sched = rtp_pool.sched;
+	rtp_pool.sched = -1;
+	sccp_mutex_unlock(&rtp_pool.lock);
+	if (sched > -1) {
+		iPbx.sched_del(sched);									/* outside of the lock, the callback takes it */
+	}
+
+	sccp_mutex_lock(&rtp_pool.refill_lock);								/* wait for a running refill to finish */
+	sccp_mutex_lock(&rtp_pool.lock);
+	count = sccp_rtp_pool_take_all(flush);
+	sccp_mutex_unlock(&rtp_pool.lock);
+	sccp_mutex_unlock(&rtp_pool.refill_lock);
+	sccp_rtp_pool_destroy_instances(flush, count);
+
+	sccp_mutex_destroy(&rtp_pool.refill_lock);
+	sccp_mutex_destroy(&rtp_pool.lock);
+}
+
+/*!
+ * \brief Resolve the rtp instances used by the pbx frame read/write callbacks
+ * \note called whenever an rtp instance is created or destroyed
+ */
+static void sccp_rtp_updateFramePath(constChannelPtr c)
+{
+	PBX_RTP_TYPE *video = NULL;
+
+#ifdef CS_SCCP_VIDEO
+	video = c->rtp.video.instance;
+#endif
+	sccp_framepath_set((sccp_framepath_t *) &c->rtp.framepath, c->rtp.audio.instance, video);
+}
+
 /*!
  * \brief create a new rtp server
  * \todo refactor iPbx.rtp_???_server to include sccp_rtp_type_t
@@ -129,7 +394,21 @@ boolean_t sccp_rtp_createServer(constDevicePtr d, channelPtr c, sccp_rtp_type_t
 	rtp->type = type;
 
 	if (iPbx.rtp_create_instance) {
-		rtpResult = iPbx.rtp_create_instance(d, c, rtp);
+		PBX_RTP_TYPE *pooled = NULL;
+
+		if (type == SCCP_RTP_AUDIO) {
+			rtp->instance = pooled = sccp_rtp_pool_get();					/* pre-warmed instance, rtp_create_instance only needs to configure it */
+		}
+		if (!(rtpResult = iPbx.rtp_create_instance(d, c, rtp))) {
+			if (pooled && rtp->instance == pooled) {					/* not configured, can be handed out again */
+				sccp_rtp_pool_put(pooled);
+			} else if (rtp->instance) {
+				iPbx.rtp_destroy(rtp->instance);
+			}
+			rtp->instance = NULL;
+			return FALSE;
+		}
+		sccp_rtp_updateFramePath(c);
 	} else {
 		pbx_log(LOG_ERROR, "we should start our own rtp server, but we don't have one\n");
 		return FALSE;
@@ -213,17 +492,26 @@ void sccp_rtp_destroy(constChannelPtr c)
 {
 	sccp_rtp_t *audio = (sccp_rtp_t *) &(c->rtp.audio);
 	sccp_rtp_t *video = (sccp_rtp_t *) &(c->rtp.video);
+	PBX_RTP_TYPE *audio_instance = audio->instance;
+	PBX_RTP_TYPE *video_instance = video->instance;
+
+	/* unhook the instances from the frame path before destroying them, the pbx frame callbacks use it without taking any sccp lock */
+	audio->instance = NULL;
+	video->instance = NULL;
+	sccp_rtp_updateFramePath(c);
+	if (c->owner) {
+		pbx_channel_lock(c->owner);									/* frame callbacks run with the pbx channel locked, wait for one */
+		pbx_channel_unlock(c->owner);									/* which might still be using the old frame path */
+	}
 
-	if (audio->instance) {
+	if (audio_instance) {
 		sccp_log(DEBUGCAT_RTP) (VERBOSE_PREFIX_3 "%s: destroying PBX rtp server on channel %s\n", c->currentDeviceId, c->designator);
-		iPbx.rtp_destroy(audio->instance);
-		audio->instance = NULL;
+		iPbx.rtp_destroy(audio_instance);
 	}
 
-	if (video->instance) {
+	if (video_instance) {
 		sccp_log(DEBUGCAT_RTP) (VERBOSE_PREFIX_3 "%s: destroying PBX vrtp server on channel %s\n", c->currentDeviceId, c->designator);
-		iPbx.rtp_destroy(video->instance);
-		video->instance = NULL;
+		iPbx.rtp_destroy(video_instance);
 	}
 }
 
@@ -473,4 +761,62 @@ int sccp_rtp_get_sampleRate(skinny_codec_t codec)
 	return 3840;
 }
 
+/* ========================================================================================================================= CLI/AMI */
+/*!
+ * \brief Show RTP Instance Pool Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_rtp_pool(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int size = 0, hits = 0, lookups = 0;
+	char bindaddr[NI_MAXHOST + NI_MAXSERV] = "";
+	const char *actionid = "";
+
+	if (rtp_pool.running) {
+		sccp_mutex_lock(&rtp_pool.lock);
+		size = rtp_pool.size;
+		if (rtp_pool.bindaddr.ss_family) {
+			sccp_copy_string(bindaddr, sccp_netsock_stringify_addr(&rtp_pool.bindaddr), sizeof(bindaddr));
+		}
+		sccp_mutex_unlock(&rtp_pool.lock);
+	}
+	hits = ATOMIC_FETCH(&rtp_pool.hits, &rtp_pool.lock);
+	lookups = hits + ATOMIC_FETCH(&rtp_pool.misses, &rtp_pool.lock);
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\n--- SCCP rtp instance pool --------------------------------------------------------------------------------------------\n");
+	} else {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPRtpPool\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	CLI_AMI_OUTPUT_PARAM("Supported", CLI_AMI_LIST_WIDTH, "%s", iPbx.rtp_instance_new ? "yes" : "no");
+	CLI_AMI_OUTPUT_PARAM("Configured Size", CLI_AMI_LIST_WIDTH, "%d (max %d)", GLOB(rtp_pool_size), SCCP_RTP_POOL_MAX);
+	CLI_AMI_OUTPUT_PARAM("Bind Address", CLI_AMI_LIST_WIDTH, "%s", bindaddr);
+	CLI_AMI_OUTPUT_PARAM("Pooled Instances", CLI_AMI_LIST_WIDTH, "%d", size);
+	CLI_AMI_OUTPUT_PARAM("Hits", CLI_AMI_LIST_WIDTH, "%d", hits);
+	CLI_AMI_OUTPUT_PARAM("Misses", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&rtp_pool.misses, &rtp_pool.lock));
+	CLI_AMI_OUTPUT_PARAM("Hit Ratio", CLI_AMI_LIST_WIDTH, "%d%%", lookups ? (hits * 100) / lookups : 0);
+	CLI_AMI_OUTPUT_PARAM("Created", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&rtp_pool.created, &rtp_pool.lock));
+	CLI_AMI_OUTPUT_PARAM("Flushed", CLI_AMI_LIST_WIDTH, "%d", ATOMIC_FETCH(&rtp_pool.flushed, &rtp_pool.lock));
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -8,10 +8,14 @@
 #pragma once
 
 #include "sccp_codec.h"
+#include "sccp_cli.h"
+#include "sccp_framepath.h"
 
 /* can be removed in favor of forward declaration if we change phone and phone_remote to pointers instead */
 #include <netinet/in.h>
 //struct sockaddr_storage;
+struct mansession;
+struct message;
 
 __BEGIN_C_EXTERN__
 /*!
@@ -30,6 +34,11 @@ struct sccp_rtp {
 	boolean_t directMedia;											/*!< Show if we are running in directmedia mode (set in pbx_impl during rtp bridging) */
 };														/*!< SCCP RTP Structure */
 
+SCCP_API void SCCP_CALL sccp_rtp_module_start(void);
+SCCP_API void SCCP_CALL sccp_rtp_module_stop(void);
+SCCP_API void SCCP_CALL sccp_rtp_pool_reload(void);
+SCCP_API int SCCP_CALL sccp_show_rtp_pool(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+
 SCCP_API boolean_t SCCP_CALL sccp_rtp_createServer(constDevicePtr d, channelPtr c, sccp_rtp_type_t type);
 SCCP_API int SCCP_CALL sccp_rtp_requestRTPPorts(constDevicePtr device, channelPtr channel);
 SCCP_API void SCCP_CALL sccp_rtp_stop(constChannelPtr channel);
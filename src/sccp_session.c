@@ -17,6 +17,9 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_actions.h"
 #include "sccp_cli.h"
 #include "sccp_device.h"
+#include "sccp_msgstats.h"
+#include "sccp_capture.h"
+#include "sccp_framer.h"
 #include "sccp_netsock.h"
 #include "sccp_utils.h"
 #include <netinet/in.h>
@@ -37,8 +40,9 @@ SCCP_FILE_VERSION(__FILE__, "");
 #  include <asterisk/acl.h>
 #endif
 #include <asterisk/cli.h>
+#include <asterisk/threadstorage.h>
 
-#define WRITE_BACKOFF 500											/* backoff time in millisecs, doubled every write retry (150+300+600+1200+2400+4800 = 9450 millisecs = 9.5 sec) */
+#define WRITE_RETRIES 5												/* number of times an interrupted send() is retried, right away as write_lock is held */
 #define SESSION_DEVICE_CLEANUP_TIME 10										/* wait time before destroying a device on thread exit */
 #define KEEPALIVE_ADDITIONAL_PERCENT_SESSION 1.05								/* extra time allowed for device keepalive overrun (percentage of GLOB(keepalive)) */
 #define KEEPALIVE_ADDITIONAL_PERCENT_DEVICE 1.20								/* extra time allowed for device keepalive overrun (percentage of GLOB(keepalive)) */
@@ -53,8 +57,11 @@ SCCP_FILE_VERSION(__FILE__, "");
 void sccp_netsock_device_thread_exit(void *session);
 void *sccp_netsock_device_thread(void *session);
 void __sccp_session_stopthread(sessionPtr session, uint8_t newRegistrationState);
+static int __sccp_session_put(sccp_session_t * const s, const uint8_t * bufAddr, ssize_t bufLen);
 gcc_inline void recalc_wait_time(sccp_session_t *s);
 
+typedef int (*sccp_session_msghandler_t) (constMessagePtr msg, constSessionPtr s);
+
 /*!
  * \brief SCCP Session Structure
  * \note This contains the current session the phone is in
@@ -68,6 +75,7 @@ struct sccp_session {
 	struct pollfd fds[1];											/*!< File Descriptor */
 	struct sockaddr_storage sin;										/*!< Incoming Socket Address */
 	uint32_t protocolType;
+	uint32_t protocolVersion;										/*!< Last header protocol version found to be supported (skips the protocol table lookup) */
 	volatile boolean_t session_stop;									/*!< Signal Session Stop */
 	sccp_mutex_t write_lock;										/*!< Prevent multiple threads writing to the socket at the same time */
 	sccp_mutex_t lock;											/*!< Asterisk: Lock Me Up and Tie me Down */
@@ -75,6 +83,16 @@ struct sccp_session {
 	struct sockaddr_storage ourip;										/*!< Our IP is for rtp use */
 	struct sockaddr_storage ourIPv4;
 	char designator[40];
+	uint32_t serial;											/*!< Session Serial Number (used to tell sessions apart in a capture) */
+	uint32_t capture_generation;										/*!< Capture generation capture_match was evaluated for */
+	boolean_t capture_match;										/*!< Session matches the capture filter */
+	sccp_framer_ringbuffer_t recv;										/*!< Receive Ring Buffer */
+	uint32_t messagesSent;											/*!< Number of messages sent (protected by write_lock) */
+	uint32_t socketWrites;											/*!< Number of send() calls needed for them (protected by write_lock) */
+	uint8_t *batch;												/*!< Send Batch, messages queued while a batch is open (protected by write_lock) */
+	size_t batchLen;											/*!< Bytes queued in batch (protected by write_lock) */
+	uint32_t batchMessages;											/*!< Messages queued in batch (protected by write_lock) */
+	uint16_t batchesOpen;											/*!< Threads having a batch open on this session (protected by write_lock) */
 };														/*!< SCCP Session Structure */
 
 boolean_t sccp_session_getOurIP(constSessionPtr session, struct sockaddr_storage * const sockAddrStorage, int family)
@@ -183,101 +201,126 @@ static void socket_get_error(constSessionPtr s, const char* file, int line, cons
 	}
 }
 
-static int session_dissect_header(sccp_session_t * s, sccp_header_t * header)
+/*!
+ * \brief Should this session be captured
+ * \note re-evaluates the capture filter only when the capture generation changed (capture started/stopped, device attached/detached)
+ */
+static gcc_inline boolean_t session_capture_wanted(sccp_session_t * s)
 {
-	int result = -1;
-	unsigned int packetSize = header->length = letohl(header->length);
+	if (do_expect(!sccp_capture_active)) {
+		return FALSE;
+	}
+	if (s->capture_generation != sccp_capture_generation) {
+		s->capture_match = sccp_capture_matches(s->device ? s->device->id : NULL, &s->sin);
+		s->capture_generation = sccp_capture_generation;
+	}
+	return s->capture_match;
+}
+
+static int session_dissect_header(sccp_session_t * s, const sccp_header_t * header)
+{
+	unsigned int packetSize = letohl(header->length);
 	int protocolVersion = letohl(header->lel_protocolVer);
 	sccp_mid_t messageId = letohl(header->lel_messageId);
+	int result = sccp_framer_dissect_header(header);
 
-	do {
-		// dissecting header to see if we have a valid sccp message, that we can handle
-		if (packetSize < 4 || packetSize > SCCP_MAX_PACKET - 8) {
-			pbx_log(LOG_ERROR, "%s: (session_dissect_header) Size of the data payload in the packet (messageId: %u, protocolVersion: %u / 0x0%x) is out of bounds: %d < %u > %d, close connection !\n", DEV_ID_LOG(s->device), messageId, protocolVersion, protocolVersion, 4, packetSize, (int) (SCCP_MAX_PACKET - 8));
-			return -2;
-		}
-
-		if (protocolVersion > 0 && !(sccp_protocol_isProtocolSupported(s->protocolType, protocolVersion))) {
+	// dissecting header to see if we have a valid sccp message, that we can handle
+	if (result == SCCP_FRAMER_INVALID_LENGTH) {
+		pbx_log(LOG_ERROR, "%s: (session_dissect_header) Size of the data payload in the packet (messageId: %u, protocolVersion: %u / 0x0%x) is out of bounds: %d < %u > %d, close connection !\n", DEV_ID_LOG(s->device), messageId, protocolVersion, protocolVersion, 4, packetSize, (int) (SCCP_MAX_PACKET - 8));
+		return -2;
+	}
+	if (protocolVersion > 0 && (uint32_t) protocolVersion != s->protocolVersion) {
+		if (!sccp_protocol_isProtocolSupported(s->protocolType, protocolVersion)) {
 			pbx_log(LOG_ERROR, "%s: (session_dissect_header) protocolversion %u is unknown, cancelling read.\n", DEV_ID_LOG(s->device), protocolVersion);
-			break;
+			return -1;
 		}
-
-		const struct messagetype *msgtype;
-		if (messageId <= SCCP_MESSAGE_HIGH_BOUNDARY) {
-			msgtype = &sccp_messagetypes[messageId];
-			if (msgtype->messageId == messageId) {
-				return msgtype->size + SCCP_PACKET_HEADER;
-			}
-			pbx_log(LOG_ERROR, "%s: (session_dissect_header) messageId %d (0x%x) unknown. discarding message.\n", DEV_ID_LOG(s->device), messageId, messageId);
-			break;
-		} else if (messageId >= SPCP_MESSAGE_LOW_BOUNDARY && messageId <= SPCP_MESSAGE_HIGH_BOUNDARY) {
-			msgtype = &spcp_messagetypes[messageId - SPCP_MESSAGE_OFFSET];
-			if (msgtype->messageId == messageId) {
-				return msgtype->size + SCCP_PACKET_HEADER;
-			}
+		s->protocolVersion = protocolVersion;								// devices keep using the same version in their headers
+	}
+	if (result == SCCP_FRAMER_UNKNOWN_MESSAGE) {
+		if (messageId <= SCCP_MESSAGE_HIGH_BOUNDARY || (messageId >= SPCP_MESSAGE_LOW_BOUNDARY && messageId <= SPCP_MESSAGE_HIGH_BOUNDARY)) {
 			pbx_log(LOG_ERROR, "%s: (session_dissect_header) messageId %d (0x%x) unknown. discarding message.\n", DEV_ID_LOG(s->device), messageId, messageId);
-			break;
 		} else {
 			pbx_log(LOG_ERROR, "%s: (session_dissect_header) messageId out of bounds: %d < %u > %d. Or messageId unknown. discarding message.\n", DEV_ID_LOG(s->device), SCCP_MESSAGE_LOW_BOUNDARY, messageId, SPCP_MESSAGE_HIGH_BOUNDARY);
-			break;
 		}
-	} while (0);
-
+		return -1;
+	}
 	return result;
 }
 
-static gcc_inline int session_buffer2msg(sccp_session_t * s, unsigned char *buffer, int lenAccordingToPacketHeader, sccp_msg_t *msg) 
+/*!
+ * \brief Pre-encoded KeepAliveAck (length:4, protocolVer:0, messageId:KeepAliveAckMessage, all little endian)
+ */
+static const unsigned char session_keepAliveAck[SCCP_PACKET_HEADER] = { 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00 };
+
+/*!
+ * \brief Answer a KeepAlive directly from the session thread
+ * \note Does not touch the device, the refcount system or the allocator. Writes through __sccp_session_put like sccp_session_send2.
+ */
+static int session_keepalive_fastpath(sccp_session_t * s)
+{
+	s->lastKeepAlive = time(0);
+	__sccp_session_put(s, session_keepAliveAck, sizeof(session_keepAliveAck));				/* stops the session on failure */
+	return 0;
+}
+
+static gcc_inline int session_buffer2msg(sccp_session_t * s, sccp_framer_ringbuffer_t * rb, int lenAccordingToPacketHeader, sccp_session_msghandler_t handler, boolean_t fastpath)
 {
 	sccp_header_t msg_header = {0};
-	memcpy(&msg_header, buffer, SCCP_PACKET_HEADER);
+	unsigned char *view = rb->data + rb->head;
+	boolean_t contiguous = (rb->head + lenAccordingToPacketHeader <= SCCP_FRAMER_RINGBUFFER_SIZE) ? TRUE : FALSE;
+
+	if (dont_expect(session_capture_wanted(s))) {								/* capture before anything gets patched up in place */
+		size_t first = contiguous ? (size_t) lenAccordingToPacketHeader : SCCP_FRAMER_RINGBUFFER_SIZE - rb->head;
+
+		sccp_capture_record(s->serial, SCCP_CAPTURE_IN, view, first, rb->data, lenAccordingToPacketHeader - first);
+	}
+	sccp_framer_peek(rb, &msg_header, SCCP_PACKET_HEADER);
 	int lenAccordingToOurProtocolSpec = session_dissect_header(s, &msg_header);
+	sccp_mid_t mid = letohl(msg_header.lel_messageId);
+
+	sccp_msgstats_in(mid, lenAccordingToPacketHeader);
 	if (dont_expect(lenAccordingToOurProtocolSpec < 0)) {
-		if (lenAccordingToOurProtocolSpec == -2) {
-			return 0;
-		}
-		lenAccordingToOurProtocolSpec = 0;									// unknown message, read it and discard content completely
+		return 0;												// invalid length / unknown message: read it and discard it completely
+	}
+	if (fastpath && mid == KeepAliveMessage && (GLOB(debug) & DEBUGCAT_MESSAGE) == 0) {
+		struct timeval start = pbx_tvnow();
+		int res = session_keepalive_fastpath(s);							// most frequent message, skip sccp_handle_message completely
+
+		sccp_msgstats_handled(mid, ast_tvdiff_us(pbx_tvnow(), start));
+		return res;
 	}
 	if (dont_expect(lenAccordingToPacketHeader > lenAccordingToOurProtocolSpec)) {					// show out discarded bytes
 		pbx_log(LOG_WARNING, "%s: (session_dissect_msg) Incoming message is bigger(%d) than known size(%d). Packet looks like!\n", DEV_ID_LOG(s->device), lenAccordingToPacketHeader, lenAccordingToOurProtocolSpec);
-		buffer[lenAccordingToPacketHeader + 1] = '\0';								// terminate buffer
-		sccp_dump_packet(buffer, lenAccordingToPacketHeader);
+		if (!contiguous) {
+			sccp_framer_peek(rb, &rb->bounce, lenAccordingToPacketHeader);
+			view = (unsigned char *) &rb->bounce;
+		}
+		sccp_dump_packet(view, lenAccordingToPacketHeader);
 	}
 	
 	if (((unsigned int)lenAccordingToPacketHeader) < ((unsigned int)lenAccordingToOurProtocolSpec)){
 		sccp_log_and((DEBUGCAT_SOCKET + DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: (session_dissect_msg) Incoming message is smaller(%d) than known size(%d).\n", DEV_ID_LOG(s->device), lenAccordingToPacketHeader, lenAccordingToOurProtocolSpec);
-		lenAccordingToOurProtocolSpec = lenAccordingToPacketHeader;
 	}
-
-	memset(msg, 0, SCCP_MAX_PACKET);
-	memcpy(msg, buffer, lenAccordingToOurProtocolSpec);
-	msg->header.length = lenAccordingToOurProtocolSpec;								// patch up msg->header.length to new size
-	return sccp_handle_message(msg, s);
+	return handler(sccp_framer_getmsg(rb, lenAccordingToPacketHeader, lenAccordingToOurProtocolSpec), s);
 }
 
-static gcc_inline int process_buffer(sccp_session_t * s, sccp_msg_t *msg, unsigned char *buffer, size_t *len)
+static gcc_inline int process_buffer(sccp_session_t * s, sccp_framer_ringbuffer_t * rb, sccp_session_msghandler_t handler, boolean_t fastpath)
 {
 	int res = 0;
-	while (*len >= SCCP_PACKET_HEADER && *len <= SCCP_MAX_PACKET * 2) {										// We have at least SCCP_PACKET_HEADER, so we have the payload length
-		uint32_t hdr_len = buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | (buffer[3] << 24);
-		uint32_t payload_len = letohl(hdr_len) + (SCCP_PACKET_HEADER - 4);
-		if (*len < payload_len) {
-			break;												// Too short - haven't received whole payload yet, go poll for more
-		}
+	int payload_len = 0;
 
-		if (dont_expect(payload_len < SCCP_PACKET_HEADER || payload_len > SCCP_MAX_PACKET)) {
+	while ((payload_len = sccp_framer_next(rb)) != 0) {							// 0: too short - haven't received whole payload yet, go poll for more
+		rb->last = NULL;
+		if (dont_expect(payload_len == SCCP_FRAMER_INVALID_LENGTH)) {
 			pbx_log(LOG_ERROR, "%s: (process_buffer) Size of the data payload in the packet is bigger than max packet, close connection !\n", DEV_ID_LOG(s->device));
 			res = -1;
 			break;
 		}
-		if (dont_expect(session_buffer2msg(s, buffer, payload_len, msg) != 0)) {
+		if (dont_expect(session_buffer2msg(s, rb, payload_len, handler, fastpath) != 0)) {
 			res = -2;
 			break;
 		}
-
-		*len -= payload_len;
-		if (*len > 0) {												// Now shuffle the remaining data in the buffer back to the start
-			memmove(buffer + 0, buffer + payload_len, *len);
-		}
+		sccp_framer_consume(rb, payload_len);								// no need to shuffle the remaining data
 	}
 	return res;
 }
@@ -403,6 +446,7 @@ static sccp_device_t *__sccp_session_removeDevice(sessionPtr session)
 	sccp_session_lock(session);
 	sccp_copy_string(session->designator, sccp_netsock_stringify(&session->ourip), sizeof(session->designator));
 	session->device = NULL;
+	session->capture_generation = 0;									/* re-evaluate the capture filter */
 	sccp_session_unlock(session);
 	return return_device;
 }
@@ -428,6 +472,7 @@ static int __sccp_session_addDevice(sessionPtr session, constDevicePtr device)
 			if (new_device) {
 				session->device = new_device;				/* keep newly retained device */
 				session->device->session = session;			/* update device session pointer */
+				session->capture_generation = 0;			/* re-evaluate the capture filter */
 
 				char buf[16] = "";
 				snprintf(buf,16, "%s:%d", device->id, session->fds[0].fd);
@@ -511,7 +556,17 @@ static void destroy_session(sccp_session_t * s, uint8_t cleanupTime)
 		}
 		sccp_session_unlock(s);
 
+		/* wait for threads still having a batch open on this session (sccp_session_endBatch) */
+		pbx_mutex_lock(&s->write_lock);
+		while (s->batchesOpen) {
+			pbx_mutex_unlock(&s->write_lock);
+			usleep(1000);
+			pbx_mutex_lock(&s->write_lock);
+		}
+		pbx_mutex_unlock(&s->write_lock);
+
 		/* destroying mutex and cleaning the session */
+		sccp_mutex_destroy(&s->write_lock);
 		sccp_mutex_destroy(&s->lock);
 		sccp_free(s);
 		s = NULL;
@@ -595,9 +650,9 @@ void *sccp_netsock_device_thread(void *session)
 
 	boolean_t oncall = TRUE;
 	boolean_t tokenThread = FALSE;
-	unsigned char recv_buffer[SCCP_MAX_PACKET * 2] = "";
-	size_t recv_len = 0;
-	sccp_msg_t msg = { {0,} };
+	sccp_framer_ringbuffer_t *rb = &s->recv;
+	unsigned char *recv_ptr = NULL;
+	size_t recv_space = 0;
 
 	pthread_cleanup_push(sccp_netsock_device_thread_exit, session);
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
@@ -645,17 +700,20 @@ void *sccp_netsock_device_thread(void *session)
 			}
 		} else if (res > 0) {										/* poll data processing */
 			if (s->fds[0].revents & POLLIN || s->fds[0].revents & POLLPRI) {			/* POLLIN | POLLPRI */
-				//sccp_log_and((DEBUGCAT_SOCKET + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_2 "%s: Session New Data Arriving at buffer position:%lu\n", DEV_ID_LOG(s->device), recv_len);
-				int result = recv(s->fds[0].fd, recv_buffer + recv_len, (SCCP_MAX_PACKET * 2) - recv_len, 0);
+				//sccp_log_and((DEBUGCAT_SOCKET + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_2 "%s: Session New Data Arriving at buffer position:%lu\n", DEV_ID_LOG(s->device), rb->used);
+				recv_space = sccp_framer_writable(rb, &recv_ptr);
+				int result = recv_space ? recv(s->fds[0].fd, recv_ptr, recv_space, 0) : -1;
 				s->lastKeepAlive = time(0);
 				if (result <= 0) {
 					if (result < 0 || (errno != EINTR || errno != EAGAIN)) {
 						socket_get_error(s, __FILE__, __LINE__, __PRETTY_FUNCTION__, errno);
 						break;
 					}				
-				} else if (!((recv_len += result) && ((SCCP_MAX_PACKET * 2) - recv_len) && process_buffer(s, &msg, recv_buffer, &recv_len) == 0)) {
+				} else if (!((rb->used += result) && process_buffer(s, rb, sccp_handle_message, TRUE) == 0)) {
 					pbx_log(LOG_ERROR, "%s: (netsock_device_thread) Received a packet or message (with result:%d) which we could not handle, giving up session: %p!\n", s->designator, result, s);
-					sccp_dump_msg(&msg);
+					if (rb->last) {
+						sccp_dump_msg(rb->last);
+					}
 					if (s->device) {
 						sccp_device_sendReset(s->device, SKINNY_DEVICE_RESTART);
 					}
@@ -737,6 +795,8 @@ gcc_inline void sccp_session_stopthread(constSessionPtr session, uint8_t newRegi
 	}
 }
 
+static uint32_t session_serial = 0;
+
 /*!
  * \brief Socket Accept Connection
  *
@@ -767,6 +827,8 @@ static void sccp_accept_connection(void)
 	
 	memcpy(&s->sin, &incoming, sizeof(s->sin));
 	sccp_mutex_init(&s->lock);
+	sccp_mutex_init(&s->write_lock);
+	s->serial = ++session_serial;										/* only called from the netsock thread */
 
 	s->fds[0].events = POLLIN | POLLPRI;
 	s->fds[0].revents = 0;
@@ -941,21 +1003,197 @@ int sccp_session_send(constDevicePtr device, const sccp_msg_t * msg_in)
 	return -1;
 }
 
+/* =================================================================================================================== Send Batch */
+/*!
+ * \brief Send Batch
+ * \note While a batch is open on a session, all messages sent to that session (by any thread) are queued behind each other in the session's
+ * batch buffer, and are written using a single send() when the batch gets closed or the buffer is full, instead of one send() (and
+ * write_lock round trip) per message. Queueing, writing and recording the messages all happen under write_lock, so messages go out in the
+ * order they were sent. The session is not destroyed before all threads have closed their batch.
+ */
+#define SCCP_SESSION_BATCH_SIZE (SCCP_MAX_PACKET * 4)
+struct sccp_session_batch {
+	sccp_session_t *session;										/*!< Session this thread has a batch open on (NULL when none) */
+};
+AST_THREADSTORAGE(sccp_session_batch_buf);
+
+/*!
+ * \brief Record messages which have been written to the socket (capture and message statistics)
+ * \return Number of messages in the buffer
+ */
+static uint32_t __sccp_session_recordSent(sccp_session_t * const s, const uint8_t * bufAddr, ssize_t bufLen)
+{
+	sccp_header_t header = {0};
+	boolean_t capture = session_capture_wanted(s);
+	ssize_t offset = 0;
+	ssize_t len = 0;
+	uint32_t messages = 0;
+
+	for (offset = 0; offset + SCCP_PACKET_HEADER <= bufLen; offset += len, messages++) {
+		memcpy(&header, bufAddr + offset, SCCP_PACKET_HEADER);					/* messages in a batch are not aligned */
+		len = (ssize_t) letohl(header.length) + 8;
+		sccp_msgstats_out(letohl(header.lel_messageId), len);
+		if (dont_expect(capture)) {
+			sccp_capture_record(s->serial, SCCP_CAPTURE_OUT, bufAddr + offset, len, NULL, 0);
+		}
+	}
+	return messages;
+}
+
+/*!
+ * \brief Write a buffer holding one or more complete messages to the session socket
+ * \note Called with write_lock held, which is kept until the whole buffer has been written, so that the messages of different writers never
+ * get interleaved on the wire. An interrupted send() is therefore retried right away, instead of backing off with the lock held.
+ * \return Bytes written, -1 on failure (the caller has to stop the session, after releasing write_lock)
+ */
+static int __sccp_session_write(sccp_session_t * const s, const uint8_t * bufAddr, ssize_t bufLen)
+{
+	int mysocket = s->fds[0].fd;
+	uint retries = 0;
+	ssize_t bytesSent = 0;
+	ssize_t res = 0;
+
+	while (bytesSent < bufLen && !s->session_stop && mysocket > 0) {
+		res = send(mysocket, bufAddr + bytesSent, bufLen - bytesSent, 0);
+		s->socketWrites++;
+		if (res <= 0) {
+			if (errno == EINTR && retries++ < WRITE_RETRIES) {
+				continue;
+			}
+			socket_get_error(s, __FILE__, __LINE__, __PRETTY_FUNCTION__, errno);
+			break;
+		}
+		bytesSent += res;
+	}
+
+	if (bytesSent < bufLen) {
+		pbx_log(LOG_ERROR, "%s: Could only send %d of %d bytes!\n", DEV_ID_LOG(s->device), (int) bytesSent, (int) bufLen);
+		return -1;
+	}
+	s->messagesSent += __sccp_session_recordSent(s, bufAddr, bufLen);
+	return (int) bytesSent;
+}
+
+/*!
+ * \brief Write the messages queued in the session batch
+ * \note Called with write_lock held
+ * \return Bytes written, -1 on failure
+ */
+static int __sccp_session_flushBatch(sccp_session_t * const s)
+{
+	int res = 0;
+
+	if (s->batchLen) {
+		if (!s->session_stop && s->fds[0].fd > 0) {
+			sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Send batch of %d messages (%d bytes)\n", DEV_ID_LOG(s->device), s->batchMessages, (int) s->batchLen);
+			res = __sccp_session_write(s, s->batch, (ssize_t) s->batchLen);
+		} else {
+			res = -1;
+		}
+		s->batchLen = 0;
+		s->batchMessages = 0;
+	}
+	return res;
+}
+
+/*!
+ * \brief Write a message to the session socket, or queue it behind the messages in the open batch
+ * \return Bytes written or queued, -1 on failure (the session is being stopped)
+ */
+static int __sccp_session_put(sccp_session_t * const s, const uint8_t * bufAddr, ssize_t bufLen)
+{
+	int res = 0;
+
+	pbx_mutex_lock(&s->write_lock);										/* prevent two threads writing at the same time. That should happen in a synchronized way */
+	if (s->batch) {
+		if (s->batchLen + bufLen > SCCP_SESSION_BATCH_SIZE) {
+			res = __sccp_session_flushBatch(s);
+		}
+		if (res >= 0) {
+			memcpy(s->batch + s->batchLen, bufAddr, bufLen);
+			s->batchLen += bufLen;
+			s->batchMessages++;
+			res = (int) bufLen;
+		}
+	} else {
+		res = __sccp_session_write(s, bufAddr, bufLen);
+	}
+	pbx_mutex_unlock(&s->write_lock);
+
+	if (res < 0 && !s->session_stop) {
+		__sccp_session_stopthread(s, SKINNY_DEVICE_RS_FAILED);
+	}
+	return res;
+}
+
+/*!
+ * \brief Start collecting the messages sent to session, until this thread calls sccp_session_endBatch
+ * \note Batches do not nest, opening a new batch closes the previous one
+ */
+void sccp_session_beginBatch(constSessionPtr session)
+{
+	sccp_session_t * const s = (sessionPtr) session;								/* discard const */
+	struct sccp_session_batch *batch = NULL;
+
+	if (!s || !(batch = ast_threadstorage_get(&sccp_session_batch_buf, sizeof(struct sccp_session_batch)))) {
+		return;
+	}
+	if (batch->session) {
+		sccp_session_endBatch();
+	}
+	pbx_mutex_lock(&s->write_lock);
+	if (!s->session_stop && (s->batch || (s->batch = sccp_malloc(SCCP_SESSION_BATCH_SIZE)))) {
+		s->batchesOpen++;
+		batch->session = s;
+	}
+	pbx_mutex_unlock(&s->write_lock);
+}
+
+/*!
+ * \brief Write the messages queued since sccp_session_beginBatch and close this thread's batch
+ * \return Bytes written, -1 on failure
+ */
+int sccp_session_endBatch(void)
+{
+	struct sccp_session_batch *batch = NULL;
+	sccp_session_t *s = NULL;
+	int res = 0;
+
+	if (!(batch = ast_threadstorage_get(&sccp_session_batch_buf, sizeof(struct sccp_session_batch))) || !(s = batch->session)) {
+		return 0;
+	}
+	batch->session = NULL;
+
+	pbx_mutex_lock(&s->write_lock);
+	res = __sccp_session_flushBatch(s);
+	if (res < 0 && !s->session_stop) {
+		pbx_mutex_unlock(&s->write_lock);
+		__sccp_session_stopthread(s, SKINNY_DEVICE_RS_FAILED);					/* our batch is still open, s can not be destroyed yet */
+		pbx_mutex_lock(&s->write_lock);
+	}
+	if (--s->batchesOpen == 0) {
+		sccp_free(s->batch);
+		s->batch = NULL;
+	}
+	pbx_mutex_unlock(&s->write_lock);									/* s might be destroyed from here on */
+	return res;
+}
+
 /*!
  * \brief Socket Send Message
  * \param session Session SCCP Session (can't be null)
- * \param msg Message Data Structure (sccp_msg_t) (Will be freed automatically at the end)
+ * \param msg Message Data Structure (sccp_msg_t)
+ * \param release Free the message at the end
  * \return Result as Int
  *
  * \lock
  *      - session
  */
-int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
+static int __sccp_session_send(constSessionPtr session, sccp_msg_t * msg, boolean_t release)
 {
 	sccp_session_t * const s = (sessionPtr) session;								/* discard const */
-	ssize_t res = 0;
+	int res = 0;
 	uint32_t msgid = letohl(msg->header.lel_messageId);
-	ssize_t bytesSent;
 	ssize_t bufLen;
 	uint8_t *bufAddr;
 
@@ -968,11 +1206,11 @@ int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
 		if (s) {
 			__sccp_session_stopthread(s, SKINNY_DEVICE_RS_FAILED);
 		}
-		sccp_free(msg);
-		msg = NULL;
+		if (release) {
+			sccp_free(msg);
+		}
 		return -1;
 	}
-	int mysocket = s->fds[0].fd;
 
 	if (msgid == KeepAliveAckMessage || msgid == RegisterAckMessage || msgid == UnregisterAckMessage) {
 		msg->header.lel_protocolVer = 0;
@@ -989,41 +1227,40 @@ int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
 		sccp_dump_msg(msg);
 	}
 
-	uint backoff = WRITE_BACKOFF;
-	bytesSent = 0;
 	bufAddr = ((uint8_t *) msg);
 	bufLen = (ssize_t) (letohl(msg->header.length) + 8);
-	do {
-		pbx_mutex_lock(&s->write_lock);									/* prevent two threads writing at the same time. That should happen in a synchronized way */
-		res = send(mysocket, bufAddr + bytesSent, bufLen - bytesSent, 0);
-		pbx_mutex_unlock(&s->write_lock);
-		if (res <= 0) {
-			if (errno == EINTR) {
-				usleep(backoff);								/* back off to give network/other threads some time */
-				backoff *= 2;
-				continue;
-			}
-			socket_get_error(s, __FILE__, __LINE__, __PRETTY_FUNCTION__, errno);
-			if (s) {
-				__sccp_session_stopthread(s, SKINNY_DEVICE_RS_FAILED);
-			}
-			res = -1;
-			break;
-		}
-		bytesSent += res;
-	} while (bytesSent < bufLen && s && !s->session_stop && mysocket > 0);
+	res = __sccp_session_put(s, bufAddr, bufLen);
 
-	sccp_free(msg);
-	msg = NULL;
-
-	if (bytesSent < bufLen) {
-		pbx_log(LOG_ERROR, "%s: Could only send %d of %d bytes!\n", DEV_ID_LOG(s->device), (int) bytesSent, (int) bufLen);
-		res = -1;
+	if (release) {
+		sccp_free(msg);
 	}
+	msg = NULL;
 
 	return res;
 }
 
+/*!
+ * \brief Send a Message to a Session
+ * \param session Session
+ * \param msg Message (freed after sending)
+ * \return Result as Int
+ */
+int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
+{
+	return __sccp_session_send(session, msg, TRUE);
+}
+
+/*!
+ * \brief Send a Message which is not owned by the send path (for example an encoder scratch buffer) to a Session
+ * \param session Session
+ * \param msg Message (not freed, still owned by the caller)
+ * \return Result as Int
+ */
+int sccp_session_sendStatic(constSessionPtr session, sccp_msg_t * msg)
+{
+	return __sccp_session_send(session, msg, FALSE);
+}
+
 /*!
  * \brief Send a Reject Message to Device.
  * \param session SCCP Session Pointer
@@ -1132,6 +1369,7 @@ gcc_inline void sccp_session_setProtocol(constSessionPtr session, uint16_t proto
 
 	if (s) {
 		s->protocolType = protocolType;
+		s->protocolVersion = 0;
 	}
 }
 
@@ -1243,7 +1481,9 @@ int sccp_cli_show_sessions(int fd, sccp_cli_totals_t *totals, struct mansession
 		CLI_AMI_TABLE_FIELD(State,		"-14.14",	s,	14,	(d) ? sccp_devicestate2str(sccp_device_getDeviceState(d)) : "--")		\
 		CLI_AMI_TABLE_FIELD(Type,		"-15.15",	s,	15,	(d) ? skinny_devicetype2str(d->skinny_type) : "--")	\
 		CLI_AMI_TABLE_FIELD(RegState,		"-10.10",	s,	10,	(d) ? skinny_registrationstate2str(sccp_device_getRegistrationState(d)) : "--")	\
-		CLI_AMI_TABLE_FIELD(Token,		"-10.10",	s,	10,	d ? sccp_tokenstate2str(d->status.token) : "--")
+		CLI_AMI_TABLE_FIELD(Token,		"-10.10",	s,	10,	d ? sccp_tokenstate2str(d->status.token) : "--")		\
+		CLI_AMI_TABLE_FIELD(Msgs,		"-8",		d,	8,	session->messagesSent)					\
+		CLI_AMI_TABLE_FIELD(Writes,		"-8",		d,	8,	session->socketWrites)
 #include "sccp_cli_table.h"
 
 	if (s) {
@@ -1253,4 +1493,109 @@ int sccp_cli_show_sessions(int fd, sccp_cli_totals_t *totals, struct mansession
 	return RESULT_SUCCESS;
 }
 
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+static const sccp_mid_t framer_test_mids[] = { KeepAliveMessage, KeypadButtonMessage, StimulusMessage, OffHookMessage, CapabilitiesResMessage, OnHookMessage, RegisterMessage };
+#define FRAMER_TEST_MSGCOUNT (ARRAY_LEN(framer_test_mids) * 5)
+static uint32_t framer_test_handled = 0;
+static uint32_t framer_test_errors = 0;
+
+static int sccp_session_framer_test_handler(constMessagePtr msg, constSessionPtr s)
+{
+	sccp_mid_t expected = framer_test_mids[framer_test_handled % ARRAY_LEN(framer_test_mids)];
+	const unsigned char *data = (const unsigned char *) &msg->data;
+
+	if (letohl(msg->header.lel_messageId) != expected || (msg->header.length > SCCP_PACKET_HEADER && data[0] != (unsigned char) (framer_test_handled % FRAMER_TEST_MSGCOUNT))) {
+		framer_test_errors++;
+	}
+	framer_test_handled++;
+	return 0;
+}
+
+AST_TEST_DEFINE(sccp_session_framer)
+{
+	static const size_t chunks[] = { 1460, 97, 512, 3, 1460, 2048 };
+	const uint32_t rounds = 20000;
+	sccp_session_t *s = NULL;
+	unsigned char *stream = NULL, *ptr = NULL;
+	size_t streamlen = 0, offset = 0, space = 0, chunk = 0, todo = 0;
+	uint32_t i = 0, round = 0, msgcount = FRAMER_TEST_MSGCOUNT;
+	uint64_t total_bytes = 0;
+	int64_t elapsed_us = 0;
+	struct timeval start;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "framer";
+			info->category = "/channels/chan_sccp/session/";
+			info->summary = "chan-sccp-b session framer test";
+			info->description = "Verifies message framing through the session receive ring buffer and measures its throughput";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	if (!(s = sccp_calloc(1, sizeof(sccp_session_t))) || !(stream = sccp_calloc(FRAMER_TEST_MSGCOUNT, SCCP_MAX_PACKET))) {
+		sccp_free(s);
+		return AST_TEST_FAIL;
+	}
+	s->protocolType = SCCP_PROTOCOL;
+
+	/* build a stream of messages of mixed sizes, each payload tagged with its sequence number */
+	for (i = 0; i < msgcount; i++) {
+		sccp_mid_t mid = framer_test_mids[i % ARRAY_LEN(framer_test_mids)];
+		sccp_header_t header = { htolel(sccp_messagetypes[mid].size + 4), 0, htolel(mid) };
+		memcpy(stream + streamlen, &header, SCCP_PACKET_HEADER);
+		memset(stream + streamlen + SCCP_PACKET_HEADER, (unsigned char) i, sccp_messagetypes[mid].size);
+		streamlen += SCCP_PACKET_HEADER + sccp_messagetypes[mid].size;
+	}
+
+	pbx_test_status_update(test, "Feeding %u x %d bytes through the framer...\n", rounds, (int) streamlen);
+	framer_test_handled = 0;
+	framer_test_errors = 0;
+	start = pbx_tvnow();
+	for (round = 0; round < rounds; round++) {
+		offset = 0;
+		while (offset < streamlen) {
+			space = sccp_framer_writable(&s->recv, &ptr);
+			todo = chunks[chunk++ % ARRAY_LEN(chunks)];
+			todo = MIN(MIN(todo, space), streamlen - offset);
+			memcpy(ptr, stream + offset, todo);						/* what recv() would do */
+			s->recv.used += todo;
+			offset += todo;
+			if (process_buffer(s, &s->recv, sccp_session_framer_test_handler, FALSE) != 0) {
+				res = AST_TEST_FAIL;
+				break;
+			}
+		}
+		total_bytes += streamlen;
+	}
+	elapsed_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Framed %u messages, %llu bytes in %lld us (%.1f MB/s), %llu handled in place, %llu copied\n",
+		rounds * msgcount, (unsigned long long) total_bytes, (long long) elapsed_us, elapsed_us ? (double) total_bytes / elapsed_us : 0.0,
+		(unsigned long long) s->recv.inplace, (unsigned long long) s->recv.copied);
+	pbx_test_validate(test, res == AST_TEST_PASS);
+	pbx_test_validate(test, framer_test_errors == 0);
+	pbx_test_validate(test, s->recv.used == 0);
+	pbx_test_validate(test, s->recv.inplace + s->recv.copied == (uint64_t) rounds * msgcount);
+	pbx_test_validate(test, s->recv.inplace > s->recv.copied);
+
+	sccp_free(stream);
+	sccp_free(s);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_session_framer);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_session_framer);
+}
+#endif
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -717,32 +717,19 @@ boolean_t sccp_util_matchSubscriptionId(const sccp_channel_t * channel, const ch
  */
 sccp_msg_t *sccp_utils_buildLineStatDynamicMessage(uint32_t lineInstance, uint32_t type, const char *dirNum, const char *fqdn, const char *lineDisplayName)
 {
-	int dirNumLen = dirNum ? sccp_strlen(dirNum) : 0;
-	int fqdnLen = fqdn ? sccp_strlen(fqdn) : 0;
-	int lineDisplayNameLen = lineDisplayName ? sccp_strlen(lineDisplayName) : 0;
-	int dummyLen = dirNumLen + fqdnLen + lineDisplayNameLen;
+	sccp_msg_encoder_t enc;
+	sccp_msg_t *msg = sccp_msg_encoder_begin(&enc, LineStatDynamicMessage);
 
- 	int pktLen = SCCP_PACKET_HEADER + dummyLen;
-	sccp_msg_t *msg = sccp_build_packet(LineStatDynamicMessage, pktLen);
+	if (!msg) {
+		return NULL;
+	}
 	msg->data.LineStatDynamicMessage.lel_lineNumber = htolel(lineInstance);
 	msg->data.LineStatDynamicMessage.lel_lineType = htolel(type);
-	if (dummyLen) {
-		char *dummyPtr = msg->data.LineStatDynamicMessage.dummy;
-		if (dirNumLen) {
-			memcpy(dummyPtr, dirNum, dirNumLen);
-			dummyPtr += dirNumLen + 1;
-		}
-		if (fqdnLen) {
-			memcpy(dummyPtr, fqdn, fqdnLen);
-			dummyPtr += fqdnLen + 1;
-		}
-		if (lineDisplayNameLen) {
-			memcpy(dummyPtr, lineDisplayName, lineDisplayNameLen);
-			dummyPtr += lineDisplayNameLen + 1;
-		}
-	}
+	sccp_msg_encoder_putString(&enc, dirNum);
+	sccp_msg_encoder_putString(&enc, fqdn);
+	sccp_msg_encoder_putString(&enc, lineDisplayName);
 
-	return msg;
+	return sccp_msg_encoder_dup(&enc);
 }
 
 /*!
@@ -1636,6 +1623,106 @@ AST_TEST_DEFINE(chan_sccp_combine_codec_sets)
 			pbx_test_validate(test, baseCodecArray[x] == result[x]);
 		}
 	}
+	pbx_test_status_update(test, "Executing combineCodecSet on an empty and a codecArray containing duplicates...\n");
+	{
+		uint8_t x = 0;
+		skinny_codec_t baseCodecArray[SKINNY_MAX_CAPABILITIES] = {0};
+		const skinny_codec_t duplicates[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G722_64K,SKINNY_CODEC_G722_64K,SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_G722_64K,SKINNY_CODEC_NONE};
+		const skinny_codec_t result[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G722_64K,SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_NONE};
+		sccp_codec_combineSets(baseCodecArray, duplicates);
+		for (x = 0; x < SKINNY_MAX_CAPABILITIES; x++) {
+			pbx_test_validate(test, baseCodecArray[x] == result[x]);
+		}
+	}
+	return AST_TEST_PASS;
+}
+
+/* reference implementation of the previous nested loop codec matching, used to verify and benchmark sccp_codec_findBestJoint */
+static skinny_codec_t codec_findBestJoint_nested(const skinny_codec_t ourPreferences[], int pLength, const skinny_codec_t ourCapabilities[], int cLength, const skinny_codec_t remotePeerCapabilities[], int rLength)
+{
+	int r = 0, c = 0, p = 0;
+	skinny_codec_t firstJointCapability = SKINNY_CODEC_NONE;
+
+	for (p = 0; p < pLength && ourPreferences[p] != SKINNY_CODEC_NONE; p++) {
+		for (c = 0; c < cLength && ourCapabilities[c] != SKINNY_CODEC_NONE; c++) {
+			if (ourPreferences[p] == ourCapabilities[c]) {
+				if (firstJointCapability == SKINNY_CODEC_NONE) {
+					firstJointCapability = ourPreferences[p];
+				}
+				if (rLength == 0 || remotePeerCapabilities[0] == SKINNY_CODEC_NONE) {
+					return firstJointCapability;
+				}
+				for (r = 0; r < rLength && remotePeerCapabilities[r] != SKINNY_CODEC_NONE; r++) {
+					if (ourPreferences[p] == remotePeerCapabilities[r]) {
+						return ourPreferences[p];
+					}
+				}
+			}
+		}
+	}
+	return firstJointCapability;
+}
+
+AST_TEST_DEFINE(chan_sccp_codec_find_best_joint)
+{
+	int loop = 0;
+	int loops = 100000;
+	uint8_t x = 0, y = 0, z = 0;
+	struct timeval start;
+	int64_t nested_us = 0;
+	int64_t codecset_us = 0;
+	skinny_codec_t codec = SKINNY_CODEC_NONE;
+
+	switch (cmd) {
+	case TEST_INIT:
+		info->name = "findBestJoint";
+		info->category = "/channels/chan_sccp/codec/";
+		info->summary = "findBestJoint unit test/benchmark";
+		info->description = "findBestJoint compared to the nested loop matching";
+		return AST_TEST_NOT_RUN;
+	case TEST_EXECUTE:
+		break;
+	}
+
+	const skinny_codec_t empty[SKINNY_MAX_CAPABILITIES] = {0};
+	const skinny_codec_t prefs[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G722_64K,SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_G711_ALAW_64K,SKINNY_CODEC_G729_A,SKINNY_CODEC_NONE};
+	const skinny_codec_t short1[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_NONSTANDARD,SKINNY_CODEC_G711_ALAW_64K,SKINNY_CODEC_G711_ALAW_56K,SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_G711_ULAW_56K,0};
+	const skinny_codec_t short2[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_G722_64K,SKINNY_CODEC_G711_ULAW_56K,SKINNY_CODEC_G722_56K,SKINNY_CODEC_G711_ALAW_64K,SKINNY_CODEC_G722_48K,SKINNY_CODEC_G711_ALAW_56K,SKINNY_CODEC_G722_56K,SKINNY_CODEC_NONE};
+	const skinny_codec_t long1[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G729_A,SKINNY_CODEC_G729,SKINNY_CODEC_G728,SKINNY_CODEC_G723_1,SKINNY_CODEC_G722_48K,SKINNY_CODEC_G722_56K,SKINNY_CODEC_G722_64K,SKINNY_CODEC_G711_ULAW_56K,SKINNY_CODEC_G711_ULAW_64K,SKINNY_CODEC_G711_ALAW_56K,SKINNY_CODEC_G711_ALAW_64K,SKINNY_CODEC_IS11172,SKINNY_CODEC_IS13818,SKINNY_CODEC_G729_B,SKINNY_CODEC_G729_AB,SKINNY_CODEC_GSM_FULLRATE,SKINNY_CODEC_GSM_HALFRATE,SKINNY_CODEC_WIDEBAND_256K};
+	const skinny_codec_t g729[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G729_A,SKINNY_CODEC_NONE};
+	const skinny_codec_t *sets[] = {empty, prefs, short1, short2, long1, g729};
+
+	pbx_test_status_update(test, "Executing findBestJoint on known codecArrays...\n");
+	pbx_test_validate(test, sccp_codec_findBestJoint(empty, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_NONE);
+	pbx_test_validate(test, sccp_codec_findBestJoint(prefs, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES, empty, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_G722_64K);	/* no remote capabilities: first capable preference */
+	pbx_test_validate(test, sccp_codec_findBestJoint(prefs, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES, short1, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_G711_ULAW_64K);	/* first preference shared with remote */
+	pbx_test_validate(test, sccp_codec_findBestJoint(prefs, SKINNY_MAX_CAPABILITIES, short1, SKINNY_MAX_CAPABILITIES, g729, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_G711_ULAW_64K);	/* nothing shared with remote: first capable preference */
+	pbx_test_validate(test, sccp_codec_findBestJoint(prefs, SKINNY_MAX_CAPABILITIES, g729, SKINNY_MAX_CAPABILITIES, g729, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_G729_A);
+	pbx_test_validate(test, sccp_codec_findBestJoint(g729, SKINNY_MAX_CAPABILITIES, short1, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES) == SKINNY_CODEC_NONE);	/* no capable preference */
+
+	pbx_test_status_update(test, "Verify findBestJoint against nested loop matching for all combinations...\n");
+	for (x = 0; x < ARRAY_LEN(sets); x++) {
+		for (y = 0; y < ARRAY_LEN(sets); y++) {
+			for (z = 0; z < ARRAY_LEN(sets); z++) {
+				pbx_test_validate(test, sccp_codec_findBestJoint(sets[x], SKINNY_MAX_CAPABILITIES, sets[y], SKINNY_MAX_CAPABILITIES, sets[z], SKINNY_MAX_CAPABILITIES) == codec_findBestJoint_nested(sets[x], SKINNY_MAX_CAPABILITIES, sets[y], SKINNY_MAX_CAPABILITIES, sets[z], SKINNY_MAX_CAPABILITIES));
+			}
+		}
+	}
+
+	pbx_test_status_update(test, "Benchmark findBestJoint (%d loops)...\n", loops);
+	start = pbx_tvnow();
+	for (loop = 0; loop < loops; loop++) {
+		codec = codec_findBestJoint_nested(prefs, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES, g729, SKINNY_MAX_CAPABILITIES);
+	}
+	nested_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	start = pbx_tvnow();
+	for (loop = 0; loop < loops; loop++) {
+		codec = sccp_codec_findBestJoint(prefs, SKINNY_MAX_CAPABILITIES, long1, SKINNY_MAX_CAPABILITIES, g729, SKINNY_MAX_CAPABILITIES);
+	}
+	codecset_us = ast_tvdiff_us(pbx_tvnow(), start);
+	pbx_test_validate(test, codec == SKINNY_CODEC_G729_A);
+	pbx_test_status_update(test, "nested loops: %" PRId64 " us, codec sets: %" PRId64 " us\n", nested_us, codecset_us);
 	return AST_TEST_PASS;
 }
 #endif
@@ -1953,6 +2040,7 @@ static void __attribute__((constructor)) sccp_register_tests(void)
 	AST_TEST_REGISTER(chan_sccp_acl_invalid_tests);
 	AST_TEST_REGISTER(chan_sccp_reduce_codec_set);
 	AST_TEST_REGISTER(chan_sccp_combine_codec_sets);
+	AST_TEST_REGISTER(chan_sccp_codec_find_best_joint);
 }
 
 static void __attribute__((destructor)) sccp_unregister_tests(void)
@@ -1961,6 +2049,7 @@ static void __attribute__((destructor)) sccp_unregister_tests(void)
 	AST_TEST_UNREGISTER(chan_sccp_acl_invalid_tests);
 	AST_TEST_UNREGISTER(chan_sccp_reduce_codec_set);
 	AST_TEST_UNREGISTER(chan_sccp_combine_codec_sets);
+	AST_TEST_UNREGISTER(chan_sccp_codec_find_best_joint);
 }
 #endif
 